@@ -27,6 +27,15 @@
 
 #define LZMA_HEADER_SIZE (LZMA_PROPS_SIZE + 8)
 
+//
+// Multi-block output of --parallel, matching LZMA_PARALLEL_HEADER in
+// MdeModulePkg/Include/Guid/LzmaDecompress.h: a 16 byte header, BlockCount + 1
+// offsets to the blocks, then each block as an independent LZMA stream.
+//
+#define LZMA_PARALLEL_SIGNATURE   0x504D5A4C  // "LZMP"
+#define LZMA_PARALLEL_HEADER_SIZE 16
+#define LZMA_PARALLEL_BLOCK_SIZE  (1 << 20)
+
 typedef enum {
   NoConverter,
   X86Converter,
@@ -40,6 +49,7 @@ const char *kDataErrorMessage = "Data error";
 const char *kInvalidParamValMessage = "Invalid parameter value";
 
 static Bool mQuietMode = False;
+static Bool mParallel = False;
 static CONVERTER_TYPE mConType = NoConverter;
 
 UINT64 mDictionarySize = 28;
@@ -60,6 +70,7 @@ void PrintHelp(char *buffer)
              "  -d: decode file\n"
              "  -o FileName, --output FileName: specify the output filename\n"
              "  --f86: enable converter for x86 code\n"
+             "  --parallel: encode 1MB blocks as independent LZMA streams\n"
              "  -v, --verbose: increase output messages\n"
              "  -q, --quiet: reduce output messages\n"
              "  --debug [0-9]: set debug level\n"
@@ -174,6 +185,176 @@ Done:
   return res;
 }
 
+static void SetUInt32(Byte *buffer, UInt32 value)
+{
+  int i;
+  for (i = 0; i < 4; i++)
+    buffer[i] = (Byte)(value >> (8 * i));
+}
+
+static UInt32 GetUInt32(const Byte *buffer)
+{
+  return (UInt32)buffer[0] | ((UInt32)buffer[1] << 8) |
+         ((UInt32)buffer[2] << 16) | ((UInt32)buffer[3] << 24);
+}
+
+static SRes EncodeParallel(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize, CLzmaEncProps *props)
+{
+  SRes res;
+  size_t inSize = (size_t)fileSize;
+  Byte *inBuffer = 0;
+  Byte *outBuffer = 0;
+  size_t outSize;
+  size_t outPos;
+  size_t blockSize;
+  UInt32 blockCount;
+  UInt32 index;
+
+  if (inSize == 0)
+    return SZ_ERROR_INPUT_EOF;
+  if (fileSize > 0xFFFFFFFF)
+    return SZ_ERROR_PARAM;
+
+  inBuffer = (Byte *)MyAlloc(inSize);
+  if (inBuffer == 0)
+    return SZ_ERROR_MEM;
+
+  if (SeqInStream_Read(inStream, inBuffer, inSize) != SZ_OK) {
+    res = SZ_ERROR_READ;
+    goto Done;
+  }
+
+  blockCount = (UInt32)((inSize + LZMA_PARALLEL_BLOCK_SIZE - 1) / LZMA_PARALLEL_BLOCK_SIZE);
+
+  // we allocate 105% of original size + 64KB per block for output buffer
+  outSize = LZMA_PARALLEL_HEADER_SIZE + 4 * ((size_t)blockCount + 1) +
+            inSize / 20 * 21 + (size_t)blockCount * (1 << 16);
+  outBuffer = (Byte *)MyAlloc(outSize);
+  if (outBuffer == 0) {
+    res = SZ_ERROR_MEM;
+    goto Done;
+  }
+
+  SetUInt32(outBuffer, LZMA_PARALLEL_SIGNATURE);
+  SetUInt32(outBuffer + 4, blockCount);
+  SetUInt32(outBuffer + 8, LZMA_PARALLEL_BLOCK_SIZE);
+  SetUInt32(outBuffer + 12, (UInt32)inSize);
+  outPos = LZMA_PARALLEL_HEADER_SIZE + 4 * ((size_t)blockCount + 1);
+
+  props->reduceSize = LZMA_PARALLEL_BLOCK_SIZE;
+  res = SZ_OK;
+  for (index = 0; index < blockCount; index++) {
+    size_t outSizeProcessed;
+    size_t outPropsSize = LZMA_PROPS_SIZE;
+    int i;
+
+    blockSize = inSize - (size_t)index * LZMA_PARALLEL_BLOCK_SIZE;
+    if (blockSize > LZMA_PARALLEL_BLOCK_SIZE)
+      blockSize = LZMA_PARALLEL_BLOCK_SIZE;
+
+    SetUInt32(outBuffer + LZMA_PARALLEL_HEADER_SIZE + 4 * index, (UInt32)outPos);
+    for (i = 0; i < 8; i++)
+      outBuffer[outPos + LZMA_PROPS_SIZE + i] = (Byte)((UInt64)blockSize >> (8 * i));
+
+    outSizeProcessed = outSize - outPos - LZMA_HEADER_SIZE;
+    res = LzmaEncode(outBuffer + outPos + LZMA_HEADER_SIZE, &outSizeProcessed,
+        inBuffer + (size_t)index * LZMA_PARALLEL_BLOCK_SIZE, blockSize,
+        props, outBuffer + outPos, &outPropsSize, 0,
+        NULL, &g_Alloc, &g_Alloc);
+    if (res != SZ_OK)
+      goto Done;
+
+    outPos += LZMA_HEADER_SIZE + outSizeProcessed;
+  }
+  SetUInt32(outBuffer + LZMA_PARALLEL_HEADER_SIZE + 4 * blockCount, (UInt32)outPos);
+
+  if (outStream->Write(outStream, outBuffer, outPos) != outPos)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  MyFree(outBuffer);
+  MyFree(inBuffer);
+
+  return res;
+}
+
+static SRes DecodeParallel(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
+{
+  SRes res;
+  size_t inSize = (size_t)fileSize;
+  Byte *inBuffer = 0;
+  Byte *outBuffer = 0;
+  size_t outSize;
+  UInt32 blockCount;
+  UInt32 blockSize;
+  UInt32 index;
+  ELzmaStatus status;
+
+  if (inSize < LZMA_PARALLEL_HEADER_SIZE)
+    return SZ_ERROR_INPUT_EOF;
+
+  inBuffer = (Byte *)MyAlloc(inSize);
+  if (inBuffer == 0)
+    return SZ_ERROR_MEM;
+
+  if (SeqInStream_Read(inStream, inBuffer, inSize) != SZ_OK) {
+    res = SZ_ERROR_READ;
+    goto Done;
+  }
+
+  blockCount = GetUInt32(inBuffer + 4);
+  blockSize  = GetUInt32(inBuffer + 8);
+  outSize    = GetUInt32(inBuffer + 12);
+  if (GetUInt32(inBuffer) != LZMA_PARALLEL_SIGNATURE || blockSize == 0 ||
+      blockCount != (outSize + (size_t)blockSize - 1) / blockSize ||
+      inSize < LZMA_PARALLEL_HEADER_SIZE + 4 * ((size_t)blockCount + 1)) {
+    res = SZ_ERROR_DATA;
+    goto Done;
+  }
+
+  res = SZ_OK;
+  if (outSize == 0)
+    goto Done;
+
+  outBuffer = (Byte *)MyAlloc(outSize);
+  if (outBuffer == 0) {
+    res = SZ_ERROR_MEM;
+    goto Done;
+  }
+
+  for (index = 0; index < blockCount; index++) {
+    size_t start = GetUInt32(inBuffer + LZMA_PARALLEL_HEADER_SIZE + 4 * index);
+    size_t end = GetUInt32(inBuffer + LZMA_PARALLEL_HEADER_SIZE + 4 * (index + 1));
+    size_t inSizePure;
+    size_t outSizeBlock;
+
+    if (start > end || end > inSize || end - start < LZMA_HEADER_SIZE) {
+      res = SZ_ERROR_DATA;
+      goto Done;
+    }
+
+    inSizePure = end - start - LZMA_HEADER_SIZE;
+    outSizeBlock = outSize - (size_t)index * blockSize;
+    if (outSizeBlock > blockSize)
+      outSizeBlock = blockSize;
+
+    res = LzmaDecode(outBuffer + (size_t)index * blockSize, &outSizeBlock,
+        inBuffer + start + LZMA_HEADER_SIZE, &inSizePure,
+        inBuffer + start, LZMA_PROPS_SIZE, LZMA_FINISH_END, &status, &g_Alloc);
+    if (res != SZ_OK)
+      goto Done;
+  }
+
+  if (outStream->Write(outStream, outBuffer, outSize) != outSize)
+    res = SZ_ERROR_WRITE;
+
+Done:
+  MyFree(outBuffer);
+  MyFree(inBuffer);
+
+  return res;
+}
+
 static SRes Decode(ISeqOutStream *outStream, ISeqInStream *inStream, UInt64 fileSize)
 {
   SRes res;
@@ -272,6 +453,8 @@ int main2(int numArgs, const char *args[], char *rs)
       modeWasSet = True;
     } else if (strcmp(args[param], "--f86") == 0) {
       mConType = X86Converter;
+    } else if (strcmp(args[param], "--parallel") == 0) {
+      mParallel = True;
     } else if (strcmp(args[param], "-o") == 0 ||
                strcmp(args[param], "--output") == 0) {
       if (numArgs < (param + 2)) {
@@ -342,6 +525,10 @@ int main2(int numArgs, const char *args[], char *rs)
     return PrintUserError(rs);
   }
 
+  if (mParallel && (mConType != NoConverter)) {
+    return PrintError(rs, "--parallel can not be combined with a converter");
+  }
+
   {
     size_t t4 = sizeof(UInt32);
     size_t t8 = sizeof(UInt64);
@@ -364,14 +551,22 @@ int main2(int numArgs, const char *args[], char *rs)
     if (!mQuietMode) {
       printf("Encoding\n");
     }
-    res = Encode(&outStream.vt, &inStream.vt, fileSize, &props);
+    if (mParallel) {
+      res = EncodeParallel(&outStream.vt, &inStream.vt, fileSize, &props);
+    } else {
+      res = Encode(&outStream.vt, &inStream.vt, fileSize, &props);
+    }
   }
   else
   {
     if (!mQuietMode) {
       printf("Decoding\n");
     }
-    res = Decode(&outStream.vt, &inStream.vt, fileSize);
+    if (mParallel) {
+      res = DecodeParallel(&outStream.vt, &inStream.vt, fileSize);
+    } else {
+      res = Decode(&outStream.vt, &inStream.vt, fileSize);
+    }
   }
 
   File_Close(&outStream.file);
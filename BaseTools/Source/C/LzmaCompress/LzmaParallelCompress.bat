@@ -0,0 +1,25 @@
+@REM @file
+@REM This script will exec LzmaCompress tool with --parallel option that splits
+@REM the input into independently decodable blocks.
+@REM
+@REM SPDX-License-Identifier: BSD-2-Clause-Patent
+@REM
+
+@echo off
+@setlocal
+
+:Begin
+if "%1"=="" goto End
+if "%1"=="-e" (
+  set FLAG=--parallel
+)
+if "%1"=="-d" (
+  set FLAG=--parallel
+)
+set ARGS=%ARGS% %1
+shift
+goto Begin
+
+:End
+LzmaCompress %ARGS% %FLAG%
+@echo on
@@ -18,6 +18,11 @@ EFI_LOCK FatFsLock   = EFI_INITIALIZE_LOCK_VARIABLE (TPL_CALLBACK);
 
 EFI_LOCK FatTaskLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 
+//
+// FatDataCacheSize - Total size of the data caches of all the mounted volumes.
+//
+UINTN    FatDataCacheSize = 0;
+
 //
 // Filesystem interface functions
 //
@@ -10,73 +10,88 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 /**
 
-  This function is used by the Data Cache.
+  Find the cache tag holding the specified page.
 
-  When this function is called by write command, all entries in this range
-  are older than the contents in disk, so they are invalid; just mark them invalid.
+  @param  DiskCache             - The disk cache to search.
+  @param  PageNo                - PageNo to match with the cache.
 
-  When this function is called by read command, if any entry in this range
-  is dirty, it means that the relative info directly read from media is older than
-  than the info in the cache; So need to update the relative info in the Buffer.
-
-  @param  Volume                - FAT file system volume.
-  @param  IoMode                - This function is called by read command or write command
-  @param  StartPageNo           - First PageNo to be checked in the cache.
-  @param  EndPageNo             - Last PageNo to be checked in the cache.
-  @param  Buffer                - The user buffer need to update. Only when doing the read command
-                          and there is dirty cache in the cache range, this parameter will be used.
+  @return The cache tag holding the page, or NULL if the page is not cached.
 
 **/
 STATIC
-VOID
-FatFlushDataCacheRange (
-  IN  FAT_VOLUME         *Volume,
-  IN  IO_MODE            IoMode,
-  IN  UINTN              StartPageNo,
-  IN  UINTN              EndPageNo,
-  OUT UINT8              *Buffer
+CACHE_TAG *
+FatLookupCachePage (
+  IN DISK_CACHE         *DiskCache,
+  IN UINTN              PageNo
   )
 {
-  UINTN       PageNo;
-  UINTN       GroupNo;
-  UINTN       GroupMask;
-  UINTN       PageSize;
-  UINT8       PageAlignment;
-  DISK_CACHE  *DiskCache;
+  LIST_ENTRY  *Bucket;
+  LIST_ENTRY  *Link;
   CACHE_TAG   *CacheTag;
-  UINT8       *BaseAddress;
-
-  DiskCache     = &Volume->DiskCache[CacheData];
-  BaseAddress   = DiskCache->CacheBase;
-  GroupMask     = DiskCache->GroupMask;
-  PageAlignment = DiskCache->PageAlignment;
-  PageSize      = (UINTN)1 << PageAlignment;
 
-  for (PageNo = StartPageNo; PageNo < EndPageNo; PageNo++) {
-    GroupNo   = PageNo & GroupMask;
-    CacheTag  = &DiskCache->CacheTag[GroupNo];
-    if (CacheTag->RealSize > 0 && CacheTag->PageNo == PageNo) {
-      //
-      // When reading data form disk directly, if some dirty data
-      // in cache is in this rang, this data in the Buffer need to
-      // be updated with the cache's dirty data.
-      //
-      if (IoMode == ReadDisk) {
-        if (CacheTag->Dirty) {
-          CopyMem (
-            Buffer + ((PageNo - StartPageNo) << PageAlignment),
-            BaseAddress + (GroupNo << PageAlignment),
-            PageSize
-            );
-        }
-      } else {
-        //
-        // Make all valid entries in this range invalid.
-        //
-        CacheTag->RealSize = 0;
-      }
+  Bucket = &DiskCache->HashTable[PageNo & DiskCache->HashMask];
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    CacheTag = CACHE_TAG_FROM_HASHLINK (Link);
+    if (CacheTag->PageNo == PageNo) {
+      return CacheTag;
     }
   }
+
+  return NULL;
+}
+
+/**
+
+  Make the cache tag hold a valid page and mark it as the most recently used one.
+
+  @param  DiskCache             - The disk cache that owns the cache tag.
+  @param  CacheTag              - The free cache tag.
+  @param  PageNo                - PageNo now held by the cache tag.
+  @param  RealSize              - The valid size of the page.
+
+**/
+STATIC
+VOID
+FatInsertCachePage (
+  IN DISK_CACHE         *DiskCache,
+  IN CACHE_TAG          *CacheTag,
+  IN UINTN              PageNo,
+  IN UINTN              RealSize
+  )
+{
+  ASSERT (CacheTag->RealSize == 0);
+
+  CacheTag->PageNo    = PageNo;
+  CacheTag->RealSize  = RealSize;
+  CacheTag->Dirty     = FALSE;
+  CacheTag->ReadAhead = FALSE;
+  InsertHeadList (&DiskCache->HashTable[PageNo & DiskCache->HashMask], &CacheTag->HashLink);
+  RemoveEntryList (&CacheTag->LruLink);
+  InsertHeadList (&DiskCache->LruList, &CacheTag->LruLink);
+}
+
+/**
+
+  Drop the page held by the cache tag, the cache tag becomes the first one to be reused.
+
+  @param  DiskCache             - The disk cache that owns the cache tag.
+  @param  CacheTag              - The cache tag holding a valid page.
+
+**/
+STATIC
+VOID
+FatInvalidateCachePage (
+  IN DISK_CACHE         *DiskCache,
+  IN CACHE_TAG          *CacheTag
+  )
+{
+  ASSERT (CacheTag->RealSize > 0);
+
+  CacheTag->RealSize = 0;
+  CacheTag->Dirty    = FALSE;
+  RemoveEntryList (&CacheTag->HashLink);
+  RemoveEntryList (&CacheTag->LruLink);
+  InsertTailList (&DiskCache->LruList, &CacheTag->LruLink);
 }
 
 /**
@@ -104,7 +119,6 @@ FatExchangeCachePage (
   )
 {
   EFI_STATUS  Status;
-  UINTN       GroupNo;
   UINTN       PageNo;
   UINTN       WriteCount;
   UINTN       RealSize;
@@ -116,9 +130,8 @@ FatExchangeCachePage (
 
   DiskCache     = &Volume->DiskCache[DataType];
   PageNo        = CacheTag->PageNo;
-  GroupNo       = PageNo & DiskCache->GroupMask;
   PageAlignment = DiskCache->PageAlignment;
-  PageAddress   = DiskCache->CacheBase + (GroupNo << PageAlignment);
+  PageAddress   = CacheTag->PageAddress;
   EntryPos      = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
   RealSize      = CacheTag->RealSize;
   if (IoMode == ReadDisk) {
@@ -152,6 +165,261 @@ FatExchangeCachePage (
   return EFI_SUCCESS;
 }
 
+/**
+
+  Reconcile one data cache page with a direct disk access that covers it.
+
+  @param  Volume                - FAT file system volume.
+  @param  IoMode                - The direct access is a read command or write command
+  @param  CacheTag              - The cache tag of the page covered by the access.
+  @param  StartPageNo           - First PageNo of the access.
+  @param  Buffer                - The user buffer of the access, starting at StartPageNo.
+  @param  Task                    point to task instance.
+
+  @retval EFI_SUCCESS           - The page is reconciled with the access.
+  @return Others                - An error occurred when writing the dirty page back.
+
+**/
+STATIC
+EFI_STATUS
+FatFlushDataCachePage (
+  IN  FAT_VOLUME         *Volume,
+  IN  IO_MODE            IoMode,
+  IN  CACHE_TAG          *CacheTag,
+  IN  UINTN              StartPageNo,
+  OUT UINT8              *Buffer,
+  IN  FAT_TASK           *Task
+  )
+{
+  DISK_CACHE  *DiskCache;
+
+  DiskCache = &Volume->DiskCache[CacheData];
+  if (IoMode == ReadDisk) {
+    if (CacheTag->Dirty) {
+      if (Task != NULL) {
+        //
+        // A non-blocking read only fills the Buffer after this function returns,
+        // so write the dirty page back before the read is submitted instead.
+        //
+        return FatExchangeCachePage (Volume, CacheData, WriteDisk, CacheTag, NULL);
+      }
+      //
+      // When reading data form disk directly, if some dirty data
+      // in cache is in this rang, this data in the Buffer need to
+      // be updated with the cache's dirty data.
+      //
+      CopyMem (
+        Buffer + ((CacheTag->PageNo - StartPageNo) << DiskCache->PageAlignment),
+        CacheTag->PageAddress,
+        (UINTN)1 << DiskCache->PageAlignment
+        );
+    }
+  } else {
+    //
+    // Make all valid entries in this range invalid.
+    //
+    FatInvalidateCachePage (DiskCache, CacheTag);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+
+  This function is used by the Data Cache.
+
+  When this function is called by write command, all entries in this range
+  are older than the contents in disk, so they are invalid; just mark them invalid.
+
+  When this function is called by read command, if any entry in this range
+  is dirty, it means that the relative info directly read from media is older than
+  than the info in the cache; So need to update the relative info in the Buffer.
+
+  @param  Volume                - FAT file system volume.
+  @param  IoMode                - This function is called by read command or write command
+  @param  StartPageNo           - First PageNo to be checked in the cache.
+  @param  EndPageNo             - Last PageNo to be checked in the cache.
+  @param  Buffer                - The user buffer need to update. Only when doing the read command
+                          and there is dirty cache in the cache range, this parameter will be used.
+  @param  Task                    point to task instance.
+
+  @retval EFI_SUCCESS           - The cache range is reconciled with the access.
+  @return Others                - An error occurred when writing a dirty page back.
+
+**/
+STATIC
+EFI_STATUS
+FatFlushDataCacheRange (
+  IN  FAT_VOLUME         *Volume,
+  IN  IO_MODE            IoMode,
+  IN  UINTN              StartPageNo,
+  IN  UINTN              EndPageNo,
+  OUT UINT8              *Buffer,
+  IN  FAT_TASK           *Task
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       PageNo;
+  UINTN       Index;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+
+  Status    = EFI_SUCCESS;
+  DiskCache = &Volume->DiskCache[CacheData];
+
+  //
+  // Either look up every page of the range or check every cache tag,
+  // whichever touches less entries.
+  //
+  if (EndPageNo - StartPageNo <= DiskCache->PageCount) {
+    for (PageNo = StartPageNo; PageNo < EndPageNo; PageNo++) {
+      CacheTag = FatLookupCachePage (DiskCache, PageNo);
+      if (CacheTag != NULL) {
+        Status = FatFlushDataCachePage (Volume, IoMode, CacheTag, StartPageNo, Buffer, Task);
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+      }
+    }
+  } else {
+    for (Index = 0; Index < DiskCache->PageCount; Index++) {
+      CacheTag = &DiskCache->CacheTag[Index];
+      if (CacheTag->RealSize > 0 && CacheTag->PageNo >= StartPageNo && CacheTag->PageNo < EndPageNo) {
+        Status = FatFlushDataCachePage (Volume, IoMode, CacheTag, StartPageNo, Buffer, Task);
+        if (EFI_ERROR (Status)) {
+          break;
+        }
+      }
+    }
+  }
+
+  return Status;
+}
+
+/**
+
+  Take the least recently used cache tag for reuse, writing its page back to
+  disk first if the page is dirty.
+
+  @param  Volume                - FAT file system volume.
+  @param  CacheDataType         - The cache type: CACHE_FAT or CACHE_DATA.
+  @param  CacheTag              - The free cache tag.
+
+  @retval EFI_SUCCESS           - A free cache tag is returned.
+  @return other                 - An error occurred when writing the dirty page back.
+
+**/
+STATIC
+EFI_STATUS
+FatAllocateCachePage (
+  IN  FAT_VOLUME        *Volume,
+  IN  CACHE_DATA_TYPE   CacheDataType,
+  OUT CACHE_TAG         **CacheTag
+  )
+{
+  EFI_STATUS  Status;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *Victim;
+
+  DiskCache = &Volume->DiskCache[CacheDataType];
+  Victim    = CACHE_TAG_FROM_LRULINK (DiskCache->LruList.BackLink);
+  if (Victim->RealSize > 0) {
+    //
+    // Write dirty cache page back to disk
+    //
+    if (Victim->Dirty) {
+      Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, Victim, NULL);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    FatInvalidateCachePage (DiskCache, Victim);
+  }
+
+  *CacheTag = Victim;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Load the page that missed in the data cache together with the pages following it,
+  with a single disk read. The pages past the first one are marked as read-ahead pages.
+
+  @param  Volume                - FAT file system volume.
+  @param  PageNo                - PageNo that missed in the data cache.
+
+  @retval EFI_SUCCESS           - The pages are loaded into the data cache.
+  @return other                 - An error occurred when accessing the disk.
+
+**/
+STATIC
+EFI_STATUS
+FatReadAheadCachePages (
+  IN FAT_VOLUME         *Volume,
+  IN UINTN              PageNo
+  )
+{
+  EFI_STATUS  Status;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
+  UINTN       PageCount;
+  UINTN       PageSize;
+  UINTN       ReadSize;
+  UINTN       RealSize;
+  UINTN       Offset;
+  UINT64      EntryPos;
+  UINT64      MaxSize;
+  UINT8       PageAlignment;
+
+  DiskCache     = &Volume->DiskCache[CacheData];
+  PageAlignment = DiskCache->PageAlignment;
+  PageSize      = (UINTN)1 << PageAlignment;
+  EntryPos      = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
+
+  //
+  // Stop the read-ahead at the first page already cached, which may be dirty
+  //
+  PageCount = 1;
+  while (PageCount < DiskCache->ReadAheadPages &&
+         FatLookupCachePage (DiskCache, PageNo + PageCount) == NULL) {
+    PageCount++;
+  }
+
+  ReadSize = PageCount << PageAlignment;
+  MaxSize  = DiskCache->LimitAddress - EntryPos;
+  if (MaxSize < ReadSize) {
+    ReadSize = (UINTN) MaxSize;
+  }
+
+  Status = FatDiskIo (Volume, ReadDisk, EntryPos, ReadSize, DiskCache->ReadAheadBuffer, NULL);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Offset = 0; Offset < ReadSize; Offset += PageSize, PageNo++) {
+    Status = FatAllocateCachePage (Volume, CacheData, &CacheTag);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    RealSize = MIN (ReadSize - Offset, PageSize);
+    CopyMem (CacheTag->PageAddress, DiskCache->ReadAheadBuffer + Offset, RealSize);
+    FatInsertCachePage (DiskCache, CacheTag, PageNo, RealSize);
+    if (Offset > 0) {
+      CacheTag->ReadAhead = TRUE;
+      DiskCache->Statistics.ReadAheadPages++;
+    }
+  }
+
+  //
+  // Keep reading further ahead while the access stays sequential
+  //
+  DiskCache->ReadAheadPages = MIN (DiskCache->ReadAheadPages * 2, FAT_READAHEAD_MAX_PAGES);
+  DiskCache->ReadAheadPages = MIN (DiskCache->ReadAheadPages, DiskCache->PageCount / 4);
+  return EFI_SUCCESS;
+}
+
 /**
 
   Get one cache page by specified PageNo.
@@ -168,39 +436,63 @@ FatExchangeCachePage (
 STATIC
 EFI_STATUS
 FatGetCachePage (
-  IN FAT_VOLUME         *Volume,
-  IN CACHE_DATA_TYPE    CacheDataType,
-  IN UINTN              PageNo,
-  IN CACHE_TAG          *CacheTag
+  IN  FAT_VOLUME        *Volume,
+  IN  CACHE_DATA_TYPE   CacheDataType,
+  IN  UINTN             PageNo,
+  OUT CACHE_TAG         **CacheTag
   )
 {
   EFI_STATUS  Status;
-  UINTN       OldPageNo;
+  DISK_CACHE  *DiskCache;
+  CACHE_TAG   *Tag;
+  UINTN       RealSize;
 
-  OldPageNo = CacheTag->PageNo;
-  if (CacheTag->RealSize > 0 && OldPageNo == PageNo) {
+  DiskCache = &Volume->DiskCache[CacheDataType];
+  Tag       = FatLookupCachePage (DiskCache, PageNo);
+  if (Tag != NULL) {
     //
     // Cache Hit occurred
     //
+    DiskCache->Statistics.Hits++;
+    if (Tag->ReadAhead) {
+      Tag->ReadAhead = FALSE;
+      DiskCache->Statistics.ReadAheadHits++;
+    }
+
+    RemoveEntryList (&Tag->LruLink);
+    InsertHeadList (&DiskCache->LruList, &Tag->LruLink);
+    *CacheTag = Tag;
     return EFI_SUCCESS;
   }
 
-  //
-  // Write dirty cache page back to disk
-  //
-  if (CacheTag->RealSize > 0 && CacheTag->Dirty) {
-    Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, CacheTag, NULL);
-    if (EFI_ERROR (Status)) {
-      return Status;
+  DiskCache->Statistics.Misses++;
+  if (CacheDataType == CacheData && DiskCache->ReadAheadPages > 0) {
+    Status = FatReadAheadCachePages (Volume, PageNo);
+    if (!EFI_ERROR (Status)) {
+      *CacheTag = FatLookupCachePage (DiskCache, PageNo);
     }
+
+    return Status;
+  }
+
+  Status = FatAllocateCachePage (Volume, CacheDataType, &Tag);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
   //
   // Load new data from disk;
   //
-  CacheTag->PageNo  = PageNo;
-  Status            = FatExchangeCachePage (Volume, CacheDataType, ReadDisk, CacheTag, NULL);
+  Tag->PageNo = PageNo;
+  Status      = FatExchangeCachePage (Volume, CacheDataType, ReadDisk, Tag, NULL);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
-  return Status;
+  RealSize      = Tag->RealSize;
+  Tag->RealSize = 0;
+  FatInsertCachePage (DiskCache, Tag, PageNo, RealSize);
+  *CacheTag = Tag;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -237,14 +529,11 @@ FatAccessUnalignedCachePage (
   VOID        *Destination;
   DISK_CACHE  *DiskCache;
   CACHE_TAG   *CacheTag;
-  UINTN       GroupNo;
 
   DiskCache = &Volume->DiskCache[CacheDataType];
-  GroupNo   = PageNo & DiskCache->GroupMask;
-  CacheTag  = &DiskCache->CacheTag[GroupNo];
-  Status    = FatGetCachePage (Volume, CacheDataType, PageNo, CacheTag);
+  Status    = FatGetCachePage (Volume, CacheDataType, PageNo, &CacheTag);
   if (!EFI_ERROR (Status)) {
-    Source      = DiskCache->CacheBase + (GroupNo << DiskCache->PageAlignment) + Offset;
+    Source      = CacheTag->PageAddress + Offset;
     Destination = Buffer;
     if (IoMode != ReadDisk) {
       CacheTag->Dirty   = TRUE;
@@ -259,6 +548,35 @@ FatAccessUnalignedCachePage (
   return Status;
 }
 
+/**
+
+  Track whether the data cache is read sequentially, and open or close the
+  read-ahead window accordingly.
+
+  @param  DiskCache             - The data cache.
+  @param  StartPageNo           - First page touched by the read.
+  @param  LastPageNo            - Last page touched by the read.
+
+**/
+STATIC
+VOID
+FatTrackSequentialRead (
+  IN DISK_CACHE         *DiskCache,
+  IN UINTN              StartPageNo,
+  IN UINTN              LastPageNo
+  )
+{
+  if (StartPageNo == DiskCache->LastPageNo || StartPageNo == DiskCache->LastPageNo + 1) {
+    if (DiskCache->ReadAheadPages == 0) {
+      DiskCache->ReadAheadPages = MIN (FAT_READAHEAD_MIN_PAGES, DiskCache->PageCount / 4);
+    }
+  } else {
+    DiskCache->ReadAheadPages = 0;
+  }
+
+  DiskCache->LastPageNo = LastPageNo;
+}
+
 /**
 
   Read BufferSize bytes from the position of Offset into Buffer,
@@ -273,7 +591,8 @@ FatAccessUnalignedCachePage (
   2. Access of Data cache (CACHE_DATA):
      The access data will be divided into UnderRun data, Aligned data and OverRun data;
      The UnderRun data and OverRun data will be accessed by the Data cache,
-     but the Aligned data will be accessed with disk directly.
+     but the Aligned data will be accessed with disk directly, except the leading
+     pages of a read that are already cached (e.g. by read-ahead).
 
   @param  Volume                - FAT file system volume.
   @param  CacheDataType         - The type of cache: CACHE_DATA or CACHE_FAT.
@@ -309,6 +628,7 @@ FatAccessCache (
   UINTN       AlignedPageCount;
   UINTN       OverRunPageNo;
   DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
   UINT64      EntryPos;
   UINT8       PageAlignment;
 
@@ -322,6 +642,14 @@ FatAccessCache (
   PageNo        = (UINTN) RShiftU64 (EntryPos, PageAlignment);
   UnderRun      = ((UINTN) EntryPos) & (PageSize - 1);
 
+  if (CacheDataType == CacheData && IoMode == ReadDisk && BufferSize > 0) {
+    FatTrackSequentialRead (
+      DiskCache,
+      PageNo,
+      (UINTN) RShiftU64 (EntryPos + BufferSize - 1, PageAlignment)
+      );
+  }
+
   if (UnderRun > 0) {
     Length = PageSize - UnderRun;
     if (Length > BufferSize) {
@@ -341,6 +669,27 @@ FatAccessCache (
   AlignedPageCount  = BufferSize >> PageAlignment;
   OverRunPageNo     = PageNo + AlignedPageCount;
   //
+  // Serve the leading aligned pages of a read from the cache while they are cached
+  //
+  if (IoMode == ReadDisk) {
+    while (AlignedPageCount > 0) {
+      CacheTag = FatLookupCachePage (DiskCache, PageNo);
+      if (CacheTag == NULL || CacheTag->RealSize != PageSize) {
+        break;
+      }
+
+      Status = FatAccessUnalignedCachePage (Volume, CacheDataType, IoMode, PageNo, 0, PageSize, Buffer);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      Buffer     += PageSize;
+      BufferSize -= PageSize;
+      PageNo++;
+      AlignedPageCount--;
+    }
+  }
+  //
   // The access of the Aligned data
   //
   if (AlignedPageCount > 0) {
@@ -359,7 +708,10 @@ FatAccessCache (
     // If these access data over laps the relative cache range, these cache pages need
     // to be updated.
     //
-    FatFlushDataCacheRange (Volume, IoMode, PageNo, OverRunPageNo, Buffer);
+    Status = FatFlushDataCacheRange (Volume, IoMode, PageNo, OverRunPageNo, Buffer, Task);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
     Buffer      += AlignedSize;
     BufferSize  -= AlignedSize;
   }
@@ -397,7 +749,6 @@ FatVolumeFlushCache (
   EFI_STATUS      Status;
   CACHE_DATA_TYPE CacheDataType;
   UINTN           GroupIndex;
-  UINTN           GroupMask;
   DISK_CACHE      *DiskCache;
   CACHE_TAG       *CacheTag;
 
@@ -407,8 +758,7 @@ FatVolumeFlushCache (
       //
       // Data cache or fat cache is dirty, write the dirty data back
       //
-      GroupMask = DiskCache->GroupMask;
-      for (GroupIndex = 0; GroupIndex <= GroupMask; GroupIndex++) {
+      for (GroupIndex = 0; GroupIndex < DiskCache->PageCount; GroupIndex++) {
         CacheTag = &DiskCache->CacheTag[GroupIndex];
         if (CacheTag->RealSize > 0 && CacheTag->Dirty) {
           //
@@ -431,6 +781,140 @@ FatVolumeFlushCache (
   return Status;
 }
 
+/**
+
+  Get the number of data cache pages to allocate, based on the free memory
+  in the system and on the size of the data caches already allocated.
+
+  @param  PageAlignment         - The alignment of the data cache pages.
+
+  @return The number of data cache pages.
+
+**/
+STATIC
+UINTN
+FatGetDataCacheGroupCount (
+  IN UINT8              PageAlignment
+  )
+{
+  EFI_STATUS            Status;
+  EFI_MEMORY_DESCRIPTOR *MemoryMap;
+  EFI_MEMORY_DESCRIPTOR *MemoryMapEnd;
+  EFI_MEMORY_DESCRIPTOR *Entry;
+  UINTN                 MemoryMapSize;
+  UINTN                 MapKey;
+  UINTN                 DescriptorSize;
+  UINT32                DescriptorVersion;
+  UINT64                FreePages;
+  UINT64                GroupCount;
+  UINTN                 BudgetCount;
+
+  MemoryMapSize = 0;
+  MemoryMap     = NULL;
+  Status = gBS->GetMemoryMap (&MemoryMapSize, MemoryMap, &MapKey, &DescriptorSize, &DescriptorVersion);
+  while (Status == EFI_BUFFER_TOO_SMALL) {
+    //
+    // Allocating the buffer may split a memory map entry
+    //
+    MemoryMapSize += 2 * DescriptorSize;
+    MemoryMap = AllocatePool (MemoryMapSize);
+    if (MemoryMap == NULL) {
+      return FAT_DATACACHE_GROUP_MIN_COUNT;
+    }
+
+    Status = gBS->GetMemoryMap (&MemoryMapSize, MemoryMap, &MapKey, &DescriptorSize, &DescriptorVersion);
+    if (EFI_ERROR (Status)) {
+      FreePool (MemoryMap);
+      MemoryMap = NULL;
+    }
+  }
+
+  if (MemoryMap == NULL) {
+    return FAT_DATACACHE_GROUP_MIN_COUNT;
+  }
+
+  FreePages    = 0;
+  MemoryMapEnd = (EFI_MEMORY_DESCRIPTOR *) ((UINT8 *) MemoryMap + MemoryMapSize);
+  for (Entry = MemoryMap; Entry < MemoryMapEnd; Entry = NEXT_MEMORY_DESCRIPTOR (Entry, DescriptorSize)) {
+    if (Entry->Type == EfiConventionalMemory) {
+      FreePages += Entry->NumberOfPages;
+    }
+  }
+
+  FreePool (MemoryMap);
+
+  GroupCount = RShiftU64 (FreePages, FAT_DATACACHE_MEMORY_SHIFT + PageAlignment - EFI_PAGE_SHIFT);
+
+  //
+  // Keep the data caches of all the volumes within the driver-wide budget
+  //
+  BudgetCount = 0;
+  if (FatDataCacheSize < FAT_DATACACHE_TOTAL_MAX_SIZE) {
+    BudgetCount = (FAT_DATACACHE_TOTAL_MAX_SIZE - FatDataCacheSize) >> PageAlignment;
+  }
+
+  if (GroupCount > BudgetCount) {
+    GroupCount = BudgetCount;
+  }
+
+  if (GroupCount < FAT_DATACACHE_GROUP_MIN_COUNT) {
+    GroupCount = FAT_DATACACHE_GROUP_MIN_COUNT;
+  } else if (GroupCount > FAT_DATACACHE_GROUP_MAX_COUNT) {
+    GroupCount = FAT_DATACACHE_GROUP_MAX_COUNT;
+  }
+
+  return (UINTN) GroupCount;
+}
+
+/**
+
+  Allocate the cache tags and the hash table of one disk cache, and link all
+  the cache tags as free pages.
+
+  @param  DiskCache             - The disk cache to set up.
+  @param  PageCount             - The number of cache pages.
+  @param  CacheBase             - The buffer holding the cache pages.
+
+  @retval EFI_SUCCESS           - The cache tags are successfully initialized.
+  @retval EFI_OUT_OF_RESOURCES  - Not enough memory to allocate the cache tags.
+
+**/
+STATIC
+EFI_STATUS
+FatInitializeCacheTags (
+  IN DISK_CACHE         *DiskCache,
+  IN UINTN              PageCount,
+  IN UINT8              *CacheBase
+  )
+{
+  UINTN       Index;
+  UINTN       BucketCount;
+  CACHE_TAG   *CacheTag;
+
+  BucketCount = GetPowerOfTwo32 ((UINT32) PageCount);
+  CacheTag    = AllocateZeroPool (PageCount * sizeof (CACHE_TAG) + BucketCount * sizeof (LIST_ENTRY));
+  if (CacheTag == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  DiskCache->CacheBase  = CacheBase;
+  DiskCache->PageCount  = PageCount;
+  DiskCache->HashMask   = BucketCount - 1;
+  DiskCache->CacheTag   = CacheTag;
+  DiskCache->HashTable  = (LIST_ENTRY *) (CacheTag + PageCount);
+  for (Index = 0; Index < BucketCount; Index++) {
+    InitializeListHead (&DiskCache->HashTable[Index]);
+  }
+
+  InitializeListHead (&DiskCache->LruList);
+  for (Index = 0; Index < PageCount; Index++) {
+    CacheTag[Index].PageAddress = CacheBase + (Index << DiskCache->PageAlignment);
+    InsertTailList (&DiskCache->LruList, &CacheTag[Index].LruLink);
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
 
   Initialize the disk cache according to Volume's FatType.
@@ -446,10 +930,13 @@ FatInitializeDiskCache (
   IN FAT_VOLUME         *Volume
   )
 {
+  EFI_STATUS  Status;
   DISK_CACHE  *DiskCache;
   UINTN       FatCacheGroupCount;
+  UINTN       DataCacheGroupCount;
   UINTN       DataCacheSize;
   UINTN       FatCacheSize;
+  UINTN       ReadAheadSize;
   UINT8       *CacheBuffer;
 
   DiskCache = Volume->DiskCache;
@@ -466,24 +953,81 @@ FatInitializeDiskCache (
     DiskCache[CacheData].PageAlignment = FAT_DATACACHE_PAGE_MAX_ALIGNMENT;
   }
 
-  DiskCache[CacheData].GroupMask     = FAT_DATACACHE_GROUP_COUNT - 1;
+  DataCacheGroupCount                 = FatGetDataCacheGroupCount (DiskCache[CacheData].PageAlignment);
   DiskCache[CacheData].BaseAddress   = Volume->RootPos;
   DiskCache[CacheData].LimitAddress  = Volume->VolumeSize;
-  DiskCache[CacheFat].GroupMask      = FatCacheGroupCount - 1;
   DiskCache[CacheFat].BaseAddress    = Volume->FatPos;
   DiskCache[CacheFat].LimitAddress   = Volume->FatPos + Volume->FatSize;
   FatCacheSize                        = FatCacheGroupCount << DiskCache[CacheFat].PageAlignment;
-  DataCacheSize                       = FAT_DATACACHE_GROUP_COUNT << DiskCache[CacheData].PageAlignment;
+  DataCacheSize                       = DataCacheGroupCount << DiskCache[CacheData].PageAlignment;
+  ReadAheadSize                       = FAT_READAHEAD_MAX_PAGES << DiskCache[CacheData].PageAlignment;
   //
   // Allocate the Fat Cache buffer
   //
-  CacheBuffer = AllocateZeroPool (FatCacheSize + DataCacheSize);
+  CacheBuffer = AllocateZeroPool (FatCacheSize + DataCacheSize + ReadAheadSize);
   if (CacheBuffer == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  Volume->CacheBuffer             = CacheBuffer;
-  DiskCache[CacheFat].CacheBase  = CacheBuffer;
-  DiskCache[CacheData].CacheBase = CacheBuffer + FatCacheSize;
+  Volume->CacheBuffer = CacheBuffer;
+  Status = FatInitializeCacheTags (&DiskCache[CacheFat], FatCacheGroupCount, CacheBuffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = FatInitializeCacheTags (&DiskCache[CacheData], DataCacheGroupCount, CacheBuffer + FatCacheSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  FatDataCacheSize += DataCacheSize;
+  DiskCache[CacheData].ReadAheadBuffer = CacheBuffer + FatCacheSize + DataCacheSize;
+  DEBUG ((
+    EFI_D_INFO,
+    "FatDiskCache: %Lu data cache pages of %Lu bytes, 0x%Lx bytes for all volumes\n",
+    (UINT64) DataCacheGroupCount,
+    (UINT64) LShiftU64 (1, DiskCache[CacheData].PageAlignment),
+    (UINT64) FatDataCacheSize
+    ));
   return EFI_SUCCESS;
 }
+
+/**
+
+  Report the disk cache counters and free the disk cache of the volume.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+VOID
+FatFreeDiskCache (
+  IN FAT_VOLUME         *Volume
+  )
+{
+  DISK_CACHE  *DiskCache;
+
+  DiskCache = Volume->DiskCache;
+  if (Volume->CacheBuffer != NULL) {
+    DEBUG ((
+      EFI_D_INFO,
+      "FatDiskCache: FAT cache %Lu hits %Lu misses, data cache %Lu hits %Lu misses, "
+      "read-ahead %Lu pages %Lu used\n",
+      DiskCache[CacheFat].Statistics.Hits,
+      DiskCache[CacheFat].Statistics.Misses,
+      DiskCache[CacheData].Statistics.Hits,
+      DiskCache[CacheData].Statistics.Misses,
+      DiskCache[CacheData].Statistics.ReadAheadPages,
+      DiskCache[CacheData].Statistics.ReadAheadHits
+      ));
+    FreePool (Volume->CacheBuffer);
+  }
+
+  if (DiskCache[CacheFat].CacheTag != NULL) {
+    FreePool (DiskCache[CacheFat].CacheTag);
+  }
+
+  if (DiskCache[CacheData].CacheTag != NULL) {
+    FatDataCacheSize -= DiskCache[CacheData].PageCount << DiskCache[CacheData].PageAlignment;
+    FreePool (DiskCache[CacheData].CacheTag);
+  }
+}
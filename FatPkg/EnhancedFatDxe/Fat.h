@@ -80,10 +80,27 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define FAT_FATCACHE_PAGE_MAX_ALIGNMENT   15
 #define FAT_DATACACHE_PAGE_MIN_ALIGNMENT  13
 #define FAT_DATACACHE_PAGE_MAX_ALIGNMENT  16
-#define FAT_DATACACHE_GROUP_COUNT         64
 #define FAT_FATCACHE_GROUP_MIN_COUNT      1
 #define FAT_FATCACHE_GROUP_MAX_COUNT      16
 
+//
+// The data cache takes 1/2^FAT_DATACACHE_MEMORY_SHIFT of the free memory at
+// mount time, bounded by the minimum and maximum number of cache pages.
+// Beyond their minimum size, the data caches of all the mounted volumes
+// together stay within FAT_DATACACHE_TOTAL_MAX_SIZE.
+//
+#define FAT_DATACACHE_GROUP_MIN_COUNT     64
+#define FAT_DATACACHE_GROUP_MAX_COUNT     1024
+#define FAT_DATACACHE_MEMORY_SHIFT        6
+#define FAT_DATACACHE_TOTAL_MAX_SIZE      SIZE_32MB
+
+//
+// Read-ahead window for sequential data cache reads, in cache pages.
+// The window starts at the minimum and doubles on every read-ahead.
+//
+#define FAT_READAHEAD_MIN_PAGES           2
+#define FAT_READAHEAD_MAX_PAGES           16
+
 //
 // Used in 8.3 generation algorithm
 //
@@ -144,19 +161,46 @@ typedef enum {
 // Disk cache tag
 //
 typedef struct {
-  UINTN   PageNo;
-  UINTN   RealSize;
-  BOOLEAN Dirty;
+  LIST_ENTRY  LruLink;          // Linked in DISK_CACHE.LruList, most recently used first
+  LIST_ENTRY  HashLink;         // Linked in DISK_CACHE.HashTable while the page is valid
+  UINT8       *PageAddress;
+  UINTN       PageNo;
+  UINTN       RealSize;
+  BOOLEAN     Dirty;
+  BOOLEAN     ReadAhead;        // Loaded by read-ahead and not accessed since
 } CACHE_TAG;
 
+#define CACHE_TAG_FROM_LRULINK(a)   BASE_CR (a, CACHE_TAG, LruLink)
+#define CACHE_TAG_FROM_HASHLINK(a)  BASE_CR (a, CACHE_TAG, HashLink)
+
+//
+// Disk cache counters, reported when the volume is freed
+//
 typedef struct {
-  UINT64    BaseAddress;
-  UINT64    LimitAddress;
-  UINT8     *CacheBase;
-  BOOLEAN   Dirty;
-  UINT8     PageAlignment;
-  UINTN     GroupMask;
-  CACHE_TAG CacheTag[FAT_DATACACHE_GROUP_COUNT];
+  UINT64      Hits;
+  UINT64      Misses;
+  UINT64      ReadAheadPages;   // Pages loaded ahead of a sequential reader
+  UINT64      ReadAheadHits;    // Read-ahead pages that were accessed afterwards
+} CACHE_STATISTICS;
+
+typedef struct {
+  UINT64            BaseAddress;
+  UINT64            LimitAddress;
+  UINT8             *CacheBase;
+  BOOLEAN           Dirty;
+  UINT8             PageAlignment;
+  UINTN             PageCount;
+  UINTN             HashMask;
+  CACHE_TAG         *CacheTag;
+  LIST_ENTRY        *HashTable;
+  LIST_ENTRY        LruList;
+  //
+  // Sequential read detection, only used by the data cache
+  //
+  UINT8             *ReadAheadBuffer;
+  UINTN             LastPageNo;       // Last page touched by the previous read
+  UINTN             ReadAheadPages;   // Current read-ahead window, 0 if not sequential
+  CACHE_STATISTICS  Statistics;
 } DISK_CACHE;
 
 //
@@ -711,6 +755,18 @@ FatInitializeDiskCache (
   IN FAT_VOLUME              *Volume
   );
 
+/**
+
+  Report the disk cache counters and free the disk cache of the volume.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+VOID
+FatFreeDiskCache (
+  IN FAT_VOLUME              *Volume
+  );
+
 /**
 
   Read BufferSize bytes from the position of Offset into Buffer,
@@ -2003,6 +2059,7 @@ extern EFI_COMPONENT_NAME_PROTOCOL     gFatComponentName;
 extern EFI_COMPONENT_NAME2_PROTOCOL    gFatComponentName2;
 extern EFI_LOCK                        FatFsLock;
 extern EFI_LOCK                        FatTaskLock;
+extern UINTN                           FatDataCacheSize;
 extern EFI_FILE_PROTOCOL               FatFileInterface;
 
 #endif
@@ -339,6 +339,11 @@ Done:
 
   Get the file info.
 
+  Reads that can span more than one run of clusters are issued through DiskIo2
+  when the device supports it: every run is submitted before any is waited
+  for, and the function returns when all of them have completed. Whether the
+  runs are then serviced concurrently is up to the Block I/O 2 driver below.
+
   @param  FHand                 - The handle of the file.
   @param  BufferSize            - Size of Buffer.
   @param  Buffer                - Buffer containing read data.
@@ -358,7 +363,49 @@ FatRead (
      OUT VOID               *Buffer
   )
 {
-  return FatIFileAccess (FHand, ReadData, BufferSize, Buffer, NULL);
+  EFI_STATUS          Status;
+  FAT_IFILE           *IFile;
+  FAT_OFILE           *OFile;
+  EFI_FILE_IO_TOKEN   Token;
+
+  IFile = IFILE_FROM_FHAND (FHand);
+  OFile = IFile->OFile;
+
+  //
+  // Only the aligned part of a read bypasses the data cache, so a read smaller
+  // than two data cache pages has nothing to overlap.
+  //
+  if (FHand->Revision < EFI_FILE_PROTOCOL_REVISION2 || OFile->ODir != NULL ||
+      *BufferSize < ((UINTN)2 << OFile->Volume->DiskCache[CacheData].PageAlignment)) {
+    return FatIFileAccess (FHand, ReadData, BufferSize, Buffer, NULL);
+  }
+
+  Status = gBS->CreateEvent (0, 0, NULL, NULL, &Token.Event);
+  if (EFI_ERROR (Status)) {
+    return FatIFileAccess (FHand, ReadData, BufferSize, Buffer, NULL);
+  }
+
+  //
+  // Keep the ordering of the blocking interface with the pending non-blocking requests
+  //
+  FatWaitNonblockingTask (IFile);
+
+  Token.Status     = EFI_SUCCESS;
+  Token.BufferSize = *BufferSize;
+  Token.Buffer     = Buffer;
+  Status = FatIFileAccess (FHand, ReadData, &Token.BufferSize, Token.Buffer, &Token);
+
+  //
+  // Wait for the subtasks that were submitted, also when the submission failed part way
+  //
+  FatWaitNonblockingTask (IFile);
+  if (!EFI_ERROR (Status)) {
+    Status = Token.Status;
+  }
+
+  gBS->CloseEvent (Token.Event);
+  *BufferSize = Token.BufferSize;
+  return Status;
 }
 
 /**
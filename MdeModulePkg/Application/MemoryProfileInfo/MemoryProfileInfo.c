@@ -620,6 +620,52 @@ DumpMemoryProfileMemoryRange (
   return (VOID *) Descriptor;
 }
 
+/**
+  Dump memory profile pool allocator information.
+
+  @param[in] PoolInfo           Pointer to memory profile pool information.
+
+  @return Pointer to the end of memory profile pool information buffer.
+
+**/
+VOID *
+DumpMemoryProfilePoolInfo (
+  IN MEMORY_PROFILE_POOL_INFO   *PoolInfo
+  )
+{
+  MEMORY_PROFILE_POOL_BUCKET    *Bucket;
+  UINTN                         BucketIndex;
+
+  if (PoolInfo->Header.Signature != MEMORY_PROFILE_POOL_INFO_SIGNATURE) {
+    return NULL;
+  }
+  if ((PoolInfo->UsedSize == 0) && (PoolInfo->PoolPages == 0)) {
+    return (VOID *) ((UINTN) PoolInfo + PoolInfo->Header.Length);
+  }
+  Print (L"MEMORY_PROFILE_POOL_INFO\n");
+  Print (L"  Signature                     - 0x%08x\n", PoolInfo->Header.Signature);
+  Print (L"  Length                        - 0x%04x\n", PoolInfo->Header.Length);
+  Print (L"  Revision                      - 0x%04x\n", PoolInfo->Header.Revision);
+  Print (L"  MemoryType                    - 0x%08x (%a)\n", PoolInfo->MemoryType, ProfileMemoryTypeToStr (PoolInfo->MemoryType));
+  Print (L"  UsedSize                      - 0x%016lx\n", PoolInfo->UsedSize);
+  Print (L"  PoolPages                     - 0x%016lx\n", PoolInfo->PoolPages);
+  Print (L"  CachedPages                   - 0x%016lx\n", PoolInfo->CachedPages);
+  Print (L"  CachedPageReuseCount          - 0x%016lx\n", PoolInfo->CachedPageReuseCount);
+
+  Bucket = (MEMORY_PROFILE_POOL_BUCKET *) (PoolInfo + 1);
+  for (BucketIndex = 0; BucketIndex < PoolInfo->BucketCount; BucketIndex++) {
+    Print (L"  Bucket[0x%02x] - BlockSize 0x%05x, Hit 0x%lx, Miss 0x%lx, Free 0x%lx\n",
+      BucketIndex,
+      Bucket[BucketIndex].BlockSize,
+      Bucket[BucketIndex].HitCount,
+      Bucket[BucketIndex].MissCount,
+      Bucket[BucketIndex].FreeBlockCount
+      );
+  }
+
+  return (VOID *) ((UINTN) PoolInfo + PoolInfo->Header.Length);
+}
+
 /**
   Scan memory profile by Signature.
 
@@ -678,6 +724,8 @@ DumpMemoryProfile (
   MEMORY_PROFILE_CONTEXT        *Context;
   MEMORY_PROFILE_FREE_MEMORY    *FreeMemory;
   MEMORY_PROFILE_MEMORY_RANGE   *MemoryRange;
+  MEMORY_PROFILE_POOL_INFO      *PoolInfo;
+  UINTN                         ProfileEnd;
 
   Context = (MEMORY_PROFILE_CONTEXT *) ScanMemoryProfileBySignature (ProfileBuffer, ProfileSize, MEMORY_PROFILE_CONTEXT_SIGNATURE);
   if (Context != NULL) {
@@ -693,6 +741,15 @@ DumpMemoryProfile (
   if (MemoryRange != NULL) {
     DumpMemoryProfileMemoryRange (MemoryRange);
   }
+
+  //
+  // The pool information records of all memory types are consecutive.
+  //
+  ProfileEnd = (UINTN) (ProfileBuffer + ProfileSize);
+  PoolInfo = (MEMORY_PROFILE_POOL_INFO *) ScanMemoryProfileBySignature (ProfileBuffer, ProfileSize, MEMORY_PROFILE_POOL_INFO_SIGNATURE);
+  while ((PoolInfo != NULL) && ((UINTN) PoolInfo < ProfileEnd)) {
+    PoolInfo = DumpMemoryProfilePoolInfo (PoolInfo);
+  }
 }
 
 /**
@@ -648,15 +648,13 @@ ProcessAsyncTaskList (
         if (AsyncRequest->MapMeta != NULL) {
           PciIo->Unmap (PciIo, AsyncRequest->MapMeta);
         }
-        if (AsyncRequest->MapPrpList != NULL) {
-          PciIo->Unmap (PciIo, AsyncRequest->MapPrpList);
-        }
         if (AsyncRequest->PrpListHost != NULL) {
-          PciIo->FreeBuffer (
-                   PciIo,
-                   AsyncRequest->PrpListNo,
-                   AsyncRequest->PrpListHost
-                   );
+          NvmeFreePrpList (
+            Private,
+            AsyncRequest->PrpListHost,
+            AsyncRequest->PrpListNo,
+            AsyncRequest->MapPrpList
+            );
         }
 
         RemoveEntryList (Link);
@@ -950,21 +948,23 @@ NvmExpressDriverBindingStart (
     }
 
     //
-    // 6 x 4kB aligned buffers will be carved out of this buffer.
+    // NVME_QUEUE_BUFFER_PAGES x 4kB aligned buffers will be carved out of this buffer.
     // 1st 4kB boundary is the start of the admin submission queue.
     // 2nd 4kB boundary is the start of the admin completion queue.
     // 3rd 4kB boundary is the start of I/O submission queue #1.
     // 4th 4kB boundary is the start of I/O completion queue #1.
-    // 5th 4kB boundary is the start of I/O submission queue #2.
-    // 6th 4kB boundary is the start of I/O completion queue #2.
+    // 5th 4kB boundary is the start of I/O submission queue #2, which spans
+    // NVME_ASYNC_CSQ_PAGES pages.
+    // The last 4kB boundary is the start of I/O completion queue #2.
     //
-    // Allocate 6 pages of memory, then map it for bus master read and write.
+    // Allocate NVME_QUEUE_BUFFER_PAGES pages of memory, then map it for bus
+    // master read and write.
     //
     Status = PciIo->AllocateBuffer (
                       PciIo,
                       AllocateAnyPages,
                       EfiBootServicesData,
-                      6,
+                      NVME_QUEUE_BUFFER_PAGES,
                       (VOID**)&Private->Buffer,
                       0
                       );
@@ -972,7 +972,7 @@ NvmExpressDriverBindingStart (
       goto Exit;
     }
 
-    Bytes = EFI_PAGES_TO_SIZE (6);
+    Bytes = EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES);
     Status = PciIo->Map (
                       PciIo,
                       EfiPciIoOperationBusMasterCommonBuffer,
@@ -982,12 +982,51 @@ NvmExpressDriverBindingStart (
                       &Private->Mapping
                       );
 
-    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (6))) {
+    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (NVME_QUEUE_BUFFER_PAGES))) {
       goto Exit;
     }
 
     Private->BufferPciAddr = (UINT8 *)(UINTN)MappedAddr;
 
+    //
+    // Pre-allocate the PRP lists so that the data transfers do not need to
+    // allocate and map one per command. The pool is optional, PRP lists are
+    // allocated on demand if it cannot be set up.
+    //
+    Status = PciIo->AllocateBuffer (
+                      PciIo,
+                      AllocateAnyPages,
+                      EfiBootServicesData,
+                      NVME_PRP_LIST_POOL_PAGES,
+                      (VOID**)&Private->PrpListPool,
+                      0
+                      );
+    if (!EFI_ERROR (Status)) {
+      Bytes = EFI_PAGES_TO_SIZE (NVME_PRP_LIST_POOL_PAGES);
+      Status = PciIo->Map (
+                        PciIo,
+                        EfiPciIoOperationBusMasterCommonBuffer,
+                        Private->PrpListPool,
+                        &Bytes,
+                        &MappedAddr,
+                        &Private->PrpListPoolMapping
+                        );
+      if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (NVME_PRP_LIST_POOL_PAGES))) {
+        if (!EFI_ERROR (Status)) {
+          PciIo->Unmap (PciIo, Private->PrpListPoolMapping);
+        }
+        PciIo->FreeBuffer (PciIo, NVME_PRP_LIST_POOL_PAGES, Private->PrpListPool);
+        Private->PrpListPool        = NULL;
+        Private->PrpListPoolMapping = NULL;
+      } else {
+        Private->PrpListPoolPciAddr = (UINT8 *)(UINTN)MappedAddr;
+      }
+    }
+
+    if (Private->PrpListPool == NULL) {
+      DEBUG ((DEBUG_WARN, "NvmExpressDriverBindingStart: PRP list pool unavailable, allocating on demand\n"));
+    }
+
     Private->Signature = NVME_CONTROLLER_PRIVATE_DATA_SIGNATURE;
     Private->ControllerHandle          = Controller;
     Private->ImageHandle               = This->DriverBindingHandle;
@@ -1093,7 +1132,15 @@ Exit:
   }
 
   if ((Private != NULL) && (Private->Buffer != NULL)) {
-    PciIo->FreeBuffer (PciIo, 6, Private->Buffer);
+    PciIo->FreeBuffer (PciIo, NVME_QUEUE_BUFFER_PAGES, Private->Buffer);
+  }
+
+  if ((Private != NULL) && (Private->PrpListPoolMapping != NULL)) {
+    PciIo->Unmap (PciIo, Private->PrpListPoolMapping);
+  }
+
+  if ((Private != NULL) && (Private->PrpListPool != NULL)) {
+    PciIo->FreeBuffer (PciIo, NVME_PRP_LIST_POOL_PAGES, Private->PrpListPool);
   }
 
   if ((Private != NULL) && (Private->ControllerData != NULL)) {
@@ -1216,7 +1263,15 @@ NvmExpressDriverBindingStop (
       }
 
       if (Private->Buffer != NULL) {
-        Private->PciIo->FreeBuffer (Private->PciIo, 6, Private->Buffer);
+        Private->PciIo->FreeBuffer (Private->PciIo, NVME_QUEUE_BUFFER_PAGES, Private->Buffer);
+      }
+
+      if (Private->PrpListPoolMapping != NULL) {
+        Private->PciIo->Unmap (Private->PciIo, Private->PrpListPoolMapping);
+      }
+
+      if (Private->PrpListPool != NULL) {
+        Private->PciIo->FreeBuffer (Private->PciIo, NVME_PRP_LIST_POOL_PAGES, Private->PrpListPool);
       }
 
       FreePool (Private->ControllerData);
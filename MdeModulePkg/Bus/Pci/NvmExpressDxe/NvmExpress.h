@@ -64,15 +64,28 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 
 //
 // Number of asynchronous I/O submission queue entries, which is 0-based.
-// The asynchronous I/O submission queue size is 4kB in total.
+// The asynchronous I/O submission queue size is 16kB in total. The depth
+// actually used is further limited by CAP.MQES of the controller.
 //
-#define NVME_ASYNC_CSQ_SIZE                       63
+#define NVME_ASYNC_CSQ_SIZE                       255
+#define NVME_ASYNC_CSQ_PAGES                      4
 //
 // Number of asynchronous I/O completion queue entries, which is 0-based.
 // The asynchronous I/O completion queue size is 4kB in total.
 //
 #define NVME_ASYNC_CCQ_SIZE                       255
 
+//
+// Number of pages holding the admin, synchronous and asynchronous I/O queues.
+//
+#define NVME_QUEUE_BUFFER_PAGES                   (5 + NVME_ASYNC_CSQ_PAGES)
+
+//
+// Number of single page PRP lists pre-allocated for the data transfers.
+// A single page PRP list describes up to 2MB of data.
+//
+#define NVME_PRP_LIST_POOL_PAGES                  64
+
 #define NVME_MAX_QUEUES                           3     // Number of queues supported by the driver
 
 #define NVME_CONTROLLER_ID                        0
@@ -116,13 +129,14 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   NVME_ADMIN_CONTROLLER_DATA          *ControllerData;
 
   //
-  // 6 x 4kB aligned buffers will be carved out of this buffer.
+  // NVME_QUEUE_BUFFER_PAGES x 4kB aligned buffers will be carved out of this buffer.
   // 1st 4kB boundary is the start of the admin submission queue.
   // 2nd 4kB boundary is the start of the admin completion queue.
   // 3rd 4kB boundary is the start of I/O submission queue #1.
   // 4th 4kB boundary is the start of I/O completion queue #1.
-  // 5th 4kB boundary is the start of I/O submission queue #2.
-  // 6th 4kB boundary is the start of I/O completion queue #2.
+  // 5th 4kB boundary is the start of I/O submission queue #2, which spans
+  // NVME_ASYNC_CSQ_PAGES pages.
+  // The last 4kB boundary is the start of I/O completion queue #2.
   //
   UINT8                               *Buffer;
   UINT8                               *BufferPciAddr;
@@ -163,6 +177,15 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   EFI_EVENT                           TimerEvent;
   LIST_ENTRY                          AsyncPassThruQueue;
   LIST_ENTRY                          UnsubmittedSubtasks;
+
+  //
+  // Pre-allocated single page PRP lists, a set bit in PrpListPoolUsed
+  // marks the corresponding page as in use.
+  //
+  UINT8                               *PrpListPool;
+  UINT8                               *PrpListPoolPciAddr;
+  VOID                                *PrpListPoolMapping;
+  UINT64                              PrpListPoolUsed;
 };
 
 #define NVME_CONTROLLER_PRIVATE_DATA_FROM_PASS_THRU(a) \
@@ -722,6 +745,85 @@ NvmeDumpStatus (
   IN NVME_CQ             *Cq
   );
 
+/**
+  Release the PRP lists created for a data transfer.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+  @param[in] PrpListHost    The host base address of PRP lists.
+  @param[in] PrpListNo      The number of PRP List.
+  @param[in] Mapping        The mapping value returned from PciIo.Map(), or
+                            NULL if the PRP list comes from the pool.
+
+**/
+VOID
+NvmeFreePrpList (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN VOID                          *PrpListHost,
+  IN UINTN                         PrpListNo,
+  IN VOID                          *Mapping
+  );
+
+/**
+  Read or write some blocks by queuing all the MDTS-sized chunks of the
+  transfer on the asynchronous I/O queue at once, then wait for them to
+  complete.
+
+  @param[in]      Device             The pointer to the NVME_DEVICE_PRIVATE_DATA
+                                     data structure.
+  @param[in, out] Buffer             The buffer used to store the data read from
+                                     or written to the device.
+  @param[in]      Lba                The start block number.
+  @param[in]      Blocks             Total block number to be transferred.
+  @param[in]      MaxTransferBlocks  The maximum block number of a single command.
+  @param[in]      IsWrite            Indicates a write or a read operation.
+
+  @retval EFI_SUCCESS                Datum are transferred.
+  @retval EFI_TIMEOUT                The transfer did not complete in time and
+                                     the controller was reset.
+  @retval Others                     Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmeConcurrentReadWrite (
+  IN     NVME_DEVICE_PRIVATE_DATA       *Device,
+  IN OUT VOID                           *Buffer,
+  IN     UINT64                         Lba,
+  IN     UINTN                          Blocks,
+  IN     UINT32                         MaxTransferBlocks,
+  IN     BOOLEAN                        IsWrite
+  );
+
+/**
+  Aborts the asynchronous PassThru requests.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+
+  @retval EFI_SUCCESS       The asynchronous PassThru requests have been aborted.
+  @return EFI_DEVICE_ERROR  Fail to abort all the asynchronous PassThru requests.
+
+**/
+EFI_STATUS
+AbortAsyncPassThruTasks (
+  IN NVME_CONTROLLER_PRIVATE_DATA    *Private
+  );
+
+/**
+  Call back function when the timer event is signaled.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   Pointer to the context data registered to the
+                        Event.
+
+**/
+VOID
+EFIAPI
+ProcessAsyncTaskList (
+  IN EFI_EVENT                    Event,
+  IN VOID*                        Context
+  );
+
 /**
   Register the shutdown notification through the ResetNotification protocol.
 
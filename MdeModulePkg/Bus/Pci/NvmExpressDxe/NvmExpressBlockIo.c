@@ -195,21 +195,18 @@ NvmeRead (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
-    if (Blocks > MaxTransferBlocks) {
-      Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
-
-      Blocks -= MaxTransferBlocks;
-      Buffer  = (VOID *)(UINTN)((UINT64)(UINTN)Buffer + MaxTransferBlocks * BlockSize);
-      Lba    += MaxTransferBlocks;
-    } else {
-      Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
-      Blocks = 0;
-    }
+  //
+  // A transfer larger than MDTS is split into subtasks which are issued
+  // concurrently on the asynchronous I/O queue.
+  //
+  if (Blocks > MaxTransferBlocks) {
+    Status = NvmeConcurrentReadWrite (Device, Buffer, Lba, Blocks, MaxTransferBlocks, FALSE);
+  } else {
+    Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
+  }
 
-    if (EFI_ERROR(Status)) {
-      break;
-    }
+  if (!EFI_ERROR (Status)) {
+    Blocks = 0;
   }
 
   DEBUG ((DEBUG_BLKIO, "%a: Lba = 0x%08Lx, Original = 0x%08Lx, "
@@ -273,21 +270,18 @@ NvmeWrite (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
-    if (Blocks > MaxTransferBlocks) {
-      Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
-
-      Blocks -= MaxTransferBlocks;
-      Buffer  = (VOID *)(UINTN)((UINT64)(UINTN)Buffer + MaxTransferBlocks * BlockSize);
-      Lba    += MaxTransferBlocks;
-    } else {
-      Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
-      Blocks = 0;
-    }
+  //
+  // A transfer larger than MDTS is split into subtasks which are issued
+  // concurrently on the asynchronous I/O queue.
+  //
+  if (Blocks > MaxTransferBlocks) {
+    Status = NvmeConcurrentReadWrite (Device, Buffer, Lba, Blocks, MaxTransferBlocks, TRUE);
+  } else {
+    Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, (UINT32)Blocks);
+  }
 
-    if (EFI_ERROR(Status)) {
-      break;
-    }
+  if (!EFI_ERROR (Status)) {
+    Blocks = 0;
   }
 
   DEBUG ((DEBUG_BLKIO, "%a: Lba = 0x%08Lx, Original = 0x%08Lx, "
@@ -923,6 +917,140 @@ NvmeAsyncWrite (
   return Status;
 }
 
+/**
+  Read or write some blocks by queuing all the MDTS-sized chunks of the
+  transfer on the asynchronous I/O queue at once, then wait for them to
+  complete. This keeps the controller busy with several commands instead of
+  waiting for each chunk in turn.
+
+  @param  Device             The pointer to the NVME_DEVICE_PRIVATE_DATA data
+                             structure.
+  @param  Buffer             The buffer used to store the data read from or
+                             written to the device.
+  @param  Lba                The start block number.
+  @param  Blocks             Total block number to be transferred.
+  @param  MaxTransferBlocks  The maximum block number of a single command.
+  @param  IsWrite            Indicates a write or a read operation.
+
+  @retval EFI_SUCCESS        Datum are transferred.
+  @retval EFI_TIMEOUT        The transfer did not complete in time and the
+                             controller was reset.
+  @retval Others             Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmeConcurrentReadWrite (
+  IN     NVME_DEVICE_PRIVATE_DATA       *Device,
+  IN OUT VOID                           *Buffer,
+  IN     UINT64                         Lba,
+  IN     UINTN                          Blocks,
+  IN     UINT32                         MaxTransferBlocks,
+  IN     BOOLEAN                        IsWrite
+  )
+{
+  EFI_STATUS                       Status;
+  NVME_CONTROLLER_PRIVATE_DATA     *Private;
+  EFI_BLOCK_IO2_TOKEN              *Token;
+  EFI_EVENT                        TimerEvent;
+  UINT64                           Timeout;
+  EFI_TPL                          OldTpl;
+
+  Private    = Device->Controller;
+  TimerEvent = NULL;
+
+  //
+  // The token is taken from pool rather than the stack, so it can be
+  // abandoned safely should the controller fail to recover from a timeout.
+  //
+  Token = AllocateZeroPool (sizeof (EFI_BLOCK_IO2_TOKEN));
+  if (Token == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gBS->CreateEvent (0, 0, NULL, NULL, &Token->Event);
+  if (EFI_ERROR (Status)) {
+    FreePool (Token);
+    return Status;
+  }
+
+  Status = gBS->CreateEvent (EVT_TIMER, TPL_CALLBACK, NULL, NULL, &TimerEvent);
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  Timeout = MultU64x64 (
+              NVME_GENERIC_TIMEOUT,
+              (Blocks + MaxTransferBlocks - 1) / MaxTransferBlocks
+              );
+  Status = gBS->SetTimer (TimerEvent, TimerRelative, Timeout);
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  Token->TransactionStatus = EFI_SUCCESS;
+  if (IsWrite) {
+    Status = NvmeAsyncWrite (Device, Buffer, Lba, Blocks, Token);
+  } else {
+    Status = NvmeAsyncRead (Device, Buffer, Lba, Blocks, Token);
+  }
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  while (EFI_ERROR (gBS->CheckEvent (Token->Event))) {
+    if (!EFI_ERROR (gBS->CheckEvent (TimerEvent))) {
+      break;
+    }
+
+    //
+    // Reap the completions and feed the submission queue right away rather
+    // than waiting for the next tick of the asynchronous I/O timer.
+    //
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    ProcessAsyncTaskList (Private->TimerEvent, Private);
+    gBS->RestoreTPL (OldTpl);
+  }
+
+  if (EFI_ERROR (gBS->CheckEvent (Token->Event))) {
+    //
+    // Timeout occurs. Reset the NVMe controller to abort the outstanding
+    // commands, the aborted subtasks complete the token with an error.
+    //
+    DEBUG ((DEBUG_ERROR, "%a: Timeout occurs for an NVMe transfer.\n", __FUNCTION__));
+
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    Token->TransactionStatus = EFI_TIMEOUT;
+    gBS->RestoreTPL (OldTpl);
+
+    gBS->SetTimer (Private->TimerEvent, TimerCancel, 0);
+    Status = NvmeControllerInit (Private);
+    if (!EFI_ERROR (Status)) {
+      Status = AbortAsyncPassThruTasks (Private);
+    }
+    gBS->SetTimer (Private->TimerEvent, TimerPeriodic, NVME_HC_ASYNC_TIMER);
+
+    if (EFI_ERROR (Status) || EFI_ERROR (gBS->CheckEvent (Token->Event))) {
+      //
+      // The subtasks may still reference the token, leave it behind.
+      //
+      gBS->CloseEvent (TimerEvent);
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
+  Status = Token->TransactionStatus;
+
+Exit:
+  if (TimerEvent != NULL) {
+    gBS->CloseEvent (TimerEvent);
+  }
+
+  gBS->CloseEvent (Token->Event);
+  FreePool (Token);
+
+  return Status;
+}
+
 /**
   Reset the Block Device.
 
@@ -192,23 +192,103 @@ NvmeDumpStatus (
   }
 }
 
+/**
+  Take a single page PRP list from the pre-allocated PRP list pool.
+
+  @param[in]  Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                             data structure.
+  @param[out] PrpListPhyAddr The device address of the PRP list page.
+
+  @return The host address of the PRP list page, or NULL if the pool is
+          unavailable or exhausted.
+
+**/
+VOID *
+NvmeAllocatePoolPrpList (
+  IN     NVME_CONTROLLER_PRIVATE_DATA *Private,
+     OUT EFI_PHYSICAL_ADDRESS         *PrpListPhyAddr
+  )
+{
+  UINTN                       Index;
+  EFI_TPL                     OldTpl;
+
+  if (Private->PrpListPool == NULL) {
+    return NULL;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  if (Private->PrpListPoolUsed == MAX_UINT64) {
+    gBS->RestoreTPL (OldTpl);
+    return NULL;
+  }
+
+  Index = (UINTN)LowBitSet64 (~Private->PrpListPoolUsed);
+  Private->PrpListPoolUsed |= LShiftU64 (1, Index);
+  gBS->RestoreTPL (OldTpl);
+
+  *PrpListPhyAddr = (EFI_PHYSICAL_ADDRESS)(UINTN)(Private->PrpListPoolPciAddr + Index * EFI_PAGE_SIZE);
+  return Private->PrpListPool + Index * EFI_PAGE_SIZE;
+}
+
+/**
+  Release the PRP lists created for a data transfer.
+
+  @param[in] Private        The pointer to the NVME_CONTROLLER_PRIVATE_DATA
+                            data structure.
+  @param[in] PrpListHost    The host base address of PRP lists.
+  @param[in] PrpListNo      The number of PRP List.
+  @param[in] Mapping        The mapping value returned from PciIo.Map(), or
+                            NULL if the PRP list comes from the pool.
+
+**/
+VOID
+NvmeFreePrpList (
+  IN NVME_CONTROLLER_PRIVATE_DATA  *Private,
+  IN VOID                          *PrpListHost,
+  IN UINTN                         PrpListNo,
+  IN VOID                          *Mapping
+  )
+{
+  UINTN                       Index;
+  EFI_TPL                     OldTpl;
+
+  if ((Private->PrpListPool != NULL) &&
+      ((UINT8 *)PrpListHost >= Private->PrpListPool) &&
+      ((UINT8 *)PrpListHost < Private->PrpListPool + EFI_PAGES_TO_SIZE (NVME_PRP_LIST_POOL_PAGES))) {
+    Index  = ((UINT8 *)PrpListHost - Private->PrpListPool) / EFI_PAGE_SIZE;
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    ASSERT ((Private->PrpListPoolUsed & LShiftU64 (1, Index)) != 0);
+    Private->PrpListPoolUsed &= ~LShiftU64 (1, Index);
+    gBS->RestoreTPL (OldTpl);
+    return;
+  }
+
+  if (Mapping != NULL) {
+    Private->PciIo->Unmap (Private->PciIo, Mapping);
+  }
+  Private->PciIo->FreeBuffer (Private->PciIo, PrpListNo, PrpListHost);
+}
+
 /**
   Create PRP lists for data transfer which is larger than 2 memory pages.
   Note here we calcuate the number of required PRP lists and allocate them at one time.
+  A transfer which needs a single PRP list is served from the pre-allocated
+  PRP list pool when possible.
 
-  @param[in]     PciIo               A pointer to the EFI_PCI_IO_PROTOCOL instance.
+  @param[in]     Private             The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
   @param[in]     PhysicalAddr        The physical base address of data buffer.
   @param[in]     Pages               The number of pages to be transfered.
   @param[out]    PrpListHost         The host base address of PRP lists.
   @param[in,out] PrpListNo           The number of PRP List.
-  @param[out]    Mapping             The mapping value returned from PciIo.Map().
+  @param[out]    Mapping             The mapping value returned from PciIo.Map(),
+                                     NULL if the PRP list comes from the pool.
 
   @retval The pointer to the first PRP List of the PRP lists.
 
 **/
 VOID*
 NvmeCreatePrpList (
-  IN     EFI_PCI_IO_PROTOCOL          *PciIo,
+  IN     NVME_CONTROLLER_PRIVATE_DATA *Private,
   IN     EFI_PHYSICAL_ADDRESS         PhysicalAddr,
   IN     UINTN                        Pages,
      OUT VOID                         **PrpListHost,
@@ -216,6 +296,7 @@ NvmeCreatePrpList (
      OUT VOID                         **Mapping
   )
 {
+  EFI_PCI_IO_PROTOCOL         *PciIo;
   UINTN                       PrpEntryNo;
   UINT64                      PrpListBase;
   UINTN                       PrpListIndex;
@@ -225,6 +306,9 @@ NvmeCreatePrpList (
   UINTN                       Bytes;
   EFI_STATUS                  Status;
 
+  PciIo    = Private->PciIo;
+  *Mapping = NULL;
+
   //
   // The number of Prp Entry in a memory page.
   //
@@ -244,32 +328,41 @@ NvmeCreatePrpList (
     Remainder = PrpEntryNo - 1;
   }
 
-  Status = PciIo->AllocateBuffer (
-                    PciIo,
-                    AllocateAnyPages,
-                    EfiBootServicesData,
-                    *PrpListNo,
-                    PrpListHost,
-                    0
-                    );
-
-  if (EFI_ERROR (Status)) {
-    return NULL;
+  *PrpListHost = NULL;
+  if (*PrpListNo == 1) {
+    *PrpListHost = NvmeAllocatePoolPrpList (Private, &PrpListPhyAddr);
   }
 
-  Bytes = EFI_PAGES_TO_SIZE (*PrpListNo);
-  Status = PciIo->Map (
-                    PciIo,
-                    EfiPciIoOperationBusMasterCommonBuffer,
-                    *PrpListHost,
-                    &Bytes,
-                    &PrpListPhyAddr,
-                    Mapping
-                    );
-
-  if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (*PrpListNo))) {
-    DEBUG ((EFI_D_ERROR, "NvmeCreatePrpList: create PrpList failure!\n"));
-    goto EXIT;
+  if (*PrpListHost != NULL) {
+    Bytes = EFI_PAGE_SIZE;
+  } else {
+    Status = PciIo->AllocateBuffer (
+                      PciIo,
+                      AllocateAnyPages,
+                      EfiBootServicesData,
+                      *PrpListNo,
+                      PrpListHost,
+                      0
+                      );
+
+    if (EFI_ERROR (Status)) {
+      return NULL;
+    }
+
+    Bytes = EFI_PAGES_TO_SIZE (*PrpListNo);
+    Status = PciIo->Map (
+                      PciIo,
+                      EfiPciIoOperationBusMasterCommonBuffer,
+                      *PrpListHost,
+                      &Bytes,
+                      &PrpListPhyAddr,
+                      Mapping
+                      );
+
+    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (*PrpListNo))) {
+      DEBUG ((EFI_D_ERROR, "NvmeCreatePrpList: create PrpList failure!\n"));
+      goto EXIT;
+    }
   }
   //
   // Fill all PRP lists except of last one.
@@ -305,6 +398,10 @@ NvmeCreatePrpList (
   return (VOID*)(UINTN)PrpListPhyAddr;
 
 EXIT:
+  if (!EFI_ERROR (Status)) {
+    PciIo->Unmap (PciIo, *Mapping);
+  }
+  *Mapping = NULL;
   PciIo->FreeBuffer (PciIo, *PrpListNo, *PrpListHost);
   return NULL;
 }
@@ -375,15 +472,13 @@ AbortAsyncPassThruTasks (
     if (AsyncRequest->MapMeta != NULL) {
       PciIo->Unmap (PciIo, AsyncRequest->MapMeta);
     }
-    if (AsyncRequest->MapPrpList != NULL) {
-      PciIo->Unmap (PciIo, AsyncRequest->MapPrpList);
-    }
     if (AsyncRequest->PrpListHost != NULL) {
-      PciIo->FreeBuffer (
-               PciIo,
-               AsyncRequest->PrpListNo,
-               AsyncRequest->PrpListHost
-               );
+      NvmeFreePrpList (
+        Private,
+        AsyncRequest->PrpListHost,
+        AsyncRequest->PrpListNo,
+        AsyncRequest->MapPrpList
+        );
     }
 
     RemoveEntryList (Link);
@@ -662,7 +757,7 @@ NvmExpressPassThru (
     // Create PrpList for remaining data buffer.
     //
     PhyAddr = (Sq->Prp[0] + EFI_PAGE_SIZE) & ~(EFI_PAGE_SIZE - 1);
-    Prp = NvmeCreatePrpList (PciIo, PhyAddr, EFI_SIZE_TO_PAGES(Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
+    Prp = NvmeCreatePrpList (Private, PhyAddr, EFI_SIZE_TO_PAGES(Offset + Bytes) - 1, &PrpListHost, &PrpListNo, &MapPrpList);
     if (Prp == NULL) {
       Status = EFI_OUT_OF_RESOURCES;
       goto EXIT;
@@ -878,15 +973,8 @@ EXIT:
              );
   }
 
-  if (MapPrpList != NULL) {
-    PciIo->Unmap (
-             PciIo,
-             MapPrpList
-             );
-  }
-
   if (Prp != NULL) {
-    PciIo->FreeBuffer (PciIo, PrpListNo, PrpListHost);
+    NvmeFreePrpList (Private, PrpListHost, PrpListNo, MapPrpList);
   }
 
   if (TimerEvent != NULL) {
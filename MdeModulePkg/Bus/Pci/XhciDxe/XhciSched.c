@@ -1272,8 +1272,7 @@ XhcExecTransfer (
   )
 {
   EFI_STATUS              Status;
-  UINTN                   Index;
-  UINT64                  Loop;
+  EFI_EVENT               TimeoutEvent;
   UINT8                   SlotId;
   UINT8                   Dci;
   BOOLEAN                 Finished;
@@ -1290,27 +1289,52 @@ XhcExecTransfer (
     ASSERT (Dci < 32);
   }
 
-  Status = EFI_SUCCESS;
-  Loop   = Timeout * XHC_1_MILLISECOND;
-  if (Timeout == 0) {
-    Loop = 0xFFFFFFFF;
+  //
+  // Measure the timeout with a timer event rather than by counting the
+  // iterations of the polling loop, which get much longer than the stall
+  // between them once large transfers produce many events to process.
+  //
+  TimeoutEvent = NULL;
+  if (Timeout != 0) {
+    Status = gBS->CreateEvent (EVT_TIMER, 0, NULL, NULL, &TimeoutEvent);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = gBS->SetTimer (
+                    TimeoutEvent,
+                    TimerRelative,
+                    EFI_TIMER_PERIOD_MILLISECONDS (Timeout)
+                    );
+    if (EFI_ERROR (Status)) {
+      gBS->CloseEvent (TimeoutEvent);
+      return Status;
+    }
   }
 
   XhcRingDoorBell (Xhc, SlotId, Dci);
 
-  for (Index = 0; Index < Loop; Index++) {
+  Status = EFI_SUCCESS;
+  while (TRUE) {
     Finished = XhcCheckUrbResult (Xhc, Urb);
     if (Finished) {
+      if (Urb->Result != EFI_USB_NOERROR) {
+        Status = EFI_DEVICE_ERROR;
+      }
       break;
     }
+
+    if ((TimeoutEvent != NULL) && !EFI_ERROR (gBS->CheckEvent (TimeoutEvent))) {
+      Urb->Result = EFI_USB_ERR_TIMEOUT;
+      Status      = EFI_TIMEOUT;
+      break;
+    }
+
     gBS->Stall (XHC_1_MICROSECOND);
   }
 
-  if (Index == Loop) {
-    Urb->Result = EFI_USB_ERR_TIMEOUT;
-    Status      = EFI_TIMEOUT;
-  } else if (Urb->Result != EFI_USB_NOERROR) {
-    Status      = EFI_DEVICE_ERROR;
+  if (TimeoutEvent != NULL) {
+    gBS->CloseEvent (TimeoutEvent);
   }
 
   return Status;
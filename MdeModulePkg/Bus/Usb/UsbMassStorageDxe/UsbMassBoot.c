@@ -767,6 +767,12 @@ UsbBootDetectMedia (
            &UsbMass->BlockIo,
            &UsbMass->BlockIo
            );
+    gBS->ReinstallProtocolInterface (
+           UsbMass->Controller,
+           &gEfiBlockIo2ProtocolGuid,
+           &UsbMass->BlockIo2,
+           &UsbMass->BlockIo2
+           );
 
     //
     // Reset MediaId after reinstalling Block I/O Protocol.
@@ -823,7 +829,7 @@ UsbBootReadWriteBlocks (
   UINT32                     Timeout;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
-  CountMax  = USB_BOOT_MAX_CARRY_SIZE / BlockSize;
+  CountMax  = UsbMass->MaxCarrySize / BlockSize;
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -906,7 +912,7 @@ UsbBootReadWriteBlocks16 (
   UINT32                    Timeout;
 
   BlockSize = UsbMass->BlockIoMedia.BlockSize;
-  CountMax  = USB_BOOT_MAX_CARRY_SIZE / BlockSize;
+  CountMax  = UsbMass->MaxCarrySize / BlockSize;
   Status    = EFI_SUCCESS;
 
   while (TotalBlock > 0) {
@@ -63,6 +63,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 #define USB_BOOT_MAX_CARRY_SIZE         SIZE_64KB
 
+//
+// Max carried size for SuperSpeed devices, whose bulk endpoints have a
+// 1024-byte max packet size. Carrying up to 1MB per READ/WRITE command needs
+// 16 times fewer commands, each with its CBW and CSW stage, than 64KB.
+//
+#define USB_BOOT_MAX_CARRY_SIZE_SUPER_SPEED  SIZE_1MB
+#define USB_BOOT_SUPER_SPEED_BULK_PACKET     1024
+
 //
 // Retry mass command times, set by experience
 //
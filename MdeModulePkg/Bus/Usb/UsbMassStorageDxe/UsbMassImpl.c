@@ -324,6 +324,175 @@ UsbMassFlushBlocks (
   return EFI_SUCCESS;
 }
 
+/**
+  Reset the block device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.Reset().
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  ExtendedVerification   Indicates that the driver may perform a more exhaustive
+                                 verification operation of the device during reset.
+
+  @retval EFI_SUCCESS            The block device was reset.
+  @retval EFI_DEVICE_ERROR       The block device is not functioning correctly and could not be reset.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN BOOLEAN                  ExtendedVerification
+  )
+{
+  USB_MASS_DEVICE *UsbMass;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+  return UsbMassReset (&UsbMass->BlockIo, ExtendedVerification);
+}
+
+/**
+  Reads the requested number of blocks from the device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+  The USB I/O Protocol has no asynchronous bulk transfer, so the read is
+  always completed before returning. If Token->Event is not NULL, the event
+  is signaled with the transaction status.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  MediaId                The media ID that the read request is for.
+  @param  Lba                    The starting logical block address to read from on the device.
+  @param  Token                  A pointer to the token associated with the transaction.
+  @param  BufferSize             The size of the Buffer in bytes.
+                                 This must be a multiple of the intrinsic block size of the device.
+  @param  Buffer                 A pointer to the destination buffer for the data. The caller is
+                                 responsible for either having implicit or explicit ownership of the buffer.
+
+  @retval EFI_SUCCESS            The data was read correctly from the device.
+  @retval EFI_DEVICE_ERROR       The device reported an error while attempting to perform the read operation.
+  @retval EFI_NO_MEDIA           There is no media in the device.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_BAD_BUFFER_SIZE    The BufferSize parameter is not a multiple of the intrinsic block size of the device.
+  @retval EFI_INVALID_PARAMETER  The read request contains LBAs that are not valid,
+                                 or the buffer is not on proper alignment.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN     UINT32                   MediaId,
+  IN     EFI_LBA                  Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token,
+  IN     UINTN                    BufferSize,
+     OUT VOID                     *Buffer
+  )
+{
+  USB_MASS_DEVICE *UsbMass;
+  EFI_STATUS      Status;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+  Status  = UsbMassReadBlocks (&UsbMass->BlockIo, MediaId, Lba, BufferSize, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // If caller's event is given, signal it after the transfer completes.
+  //
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Writes a specified number of blocks to the device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+  The USB I/O Protocol has no asynchronous bulk transfer, so the write is
+  always completed before returning. If Token->Event is not NULL, the event
+  is signaled with the transaction status.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  MediaId                The media ID that the write request is for.
+  @param  Lba                    The starting logical block address to be written.
+  @param  Token                  A pointer to the token associated with the transaction.
+  @param  BufferSize             The size of the Buffer in bytes.
+                                 This must be a multiple of the intrinsic block size of the device.
+  @param  Buffer                 Pointer to the source buffer for the data.
+
+  @retval EFI_SUCCESS            The data were written correctly to the device.
+  @retval EFI_WRITE_PROTECTED    The device cannot be written to.
+  @retval EFI_NO_MEDIA           There is no media in the device.
+  @retval EFI_MEDIA_CHANGED      The MediaId is not for the current media.
+  @retval EFI_DEVICE_ERROR       The device reported an error while attempting to perform the write operation.
+  @retval EFI_BAD_BUFFER_SIZE    The BufferSize parameter is not a multiple of the intrinsic
+                                 block size of the device.
+  @retval EFI_INVALID_PARAMETER  The write request contains LBAs that are not valid,
+                                 or the buffer is not on proper alignment.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN     UINT32                   MediaId,
+  IN     EFI_LBA                  Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token,
+  IN     UINTN                    BufferSize,
+  IN     VOID                     *Buffer
+  )
+{
+  USB_MASS_DEVICE *UsbMass;
+  EFI_STATUS      Status;
+
+  UsbMass = USB_MASS_DEVICE_FROM_BLOCK_IO2 (This);
+  Status  = UsbMassWriteBlocks (&UsbMass->BlockIo, MediaId, Lba, BufferSize, Buffer);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // If caller's event is given, signal it after the transfer completes.
+  //
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Flushes all modified data to a physical block device.
+
+  This function implements EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+  USB mass storage device doesn't support write cache,
+  so the token is signaled and EFI_SUCCESS is returned directly.
+
+  @param  This                   Indicates a pointer to the calling context.
+  @param  Token                  A pointer to the token associated with the transaction.
+
+  @retval EFI_SUCCESS            All outstanding data were written correctly to the device.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbMassFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL   *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN      *Token
+  )
+{
+  if ((Token != NULL) && (Token->Event != NULL)) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
 
@@ -366,6 +535,44 @@ UsbMassInitMedia (
   return Status;
 }
 
+/**
+  Get the max number of bytes carried by one READ/WRITE command.
+
+  SuperSpeed devices are recognized by the 1024-byte max packet size of
+  their bulk endpoints, and are allowed much larger requests, so that a large
+  transfer needs fewer commands with their CBW and CSW stages.
+
+  @param  UsbIo           The USB I/O Protocol of the device.
+  @param  Interface       The interface descriptor of the device.
+
+  @return The max number of bytes carried by one READ/WRITE command.
+
+**/
+UINT32
+UsbMassGetMaxCarrySize (
+  IN EFI_USB_IO_PROTOCOL           *UsbIo,
+  IN EFI_USB_INTERFACE_DESCRIPTOR  *Interface
+  )
+{
+  EFI_USB_ENDPOINT_DESCRIPTOR   EndPoint;
+  UINT8                         Index;
+  EFI_STATUS                    Status;
+
+  for (Index = 0; Index < Interface->NumEndpoints; Index++) {
+    Status = UsbIo->UsbGetEndpointDescriptor (UsbIo, Index, &EndPoint);
+    if (EFI_ERROR (Status)) {
+      continue;
+    }
+
+    if (USB_IS_BULK_ENDPOINT (EndPoint.Attributes) &&
+        (EndPoint.MaxPacketSize >= USB_BOOT_SUPER_SPEED_BULK_PACKET)) {
+      return USB_BOOT_MAX_CARRY_SIZE_SUPER_SPEED;
+    }
+  }
+
+  return USB_BOOT_MAX_CARRY_SIZE;
+}
+
 /**
   Initialize the USB Mass Storage transport.
 
@@ -377,6 +584,7 @@ UsbMassInitMedia (
   @param  Transport       The pointer to pointer to USB_MASS_TRANSPORT.
   @param  Context         The parameter for USB_MASS_DEVICE.Context.
   @param  MaxLun          Get the MaxLun if is BOT dev.
+  @param  MaxCarrySize    Get the max bytes carried by one READ/WRITE command.
 
   @retval EFI_SUCCESS     The initialization is successful.
   @retval EFI_UNSUPPORTED No matching transport protocol is found.
@@ -389,7 +597,8 @@ UsbMassInitTransport (
   IN  EFI_HANDLE                   Controller,
   OUT USB_MASS_TRANSPORT           **Transport,
   OUT VOID                         **Context,
-  OUT UINT8                        *MaxLun
+  OUT UINT8                        *MaxLun,
+  OUT UINT32                       *MaxCarrySize
   )
 {
   EFI_USB_IO_PROTOCOL           *UsbIo;
@@ -445,6 +654,8 @@ UsbMassInitTransport (
     (*Transport)->GetMaxLun (*Context, MaxLun);
   }
 
+  *MaxCarrySize = UsbMassGetMaxCarrySize (UsbIo, &Interface);
+
 ON_EXIT:
   gBS->CloseProtocol (
          Controller,
@@ -464,6 +675,7 @@ ON_EXIT:
   @param  Context              Parameter for USB_MASS_DEVICE.Context.
   @param  DevicePath           The remaining device path.
   @param  MaxLun               The max LUN number.
+  @param  MaxCarrySize         The max bytes carried by one READ/WRITE command.
 
   @retval EFI_SUCCESS          At least one LUN is initialized successfully.
   @retval EFI_NOT_FOUND        Fail to initialize any of multiple LUNs.
@@ -476,7 +688,8 @@ UsbMassInitMultiLun (
   IN USB_MASS_TRANSPORT            *Transport,
   IN VOID                          *Context,
   IN EFI_DEVICE_PATH_PROTOCOL      *DevicePath,
-  IN UINT8                         MaxLun
+  IN UINT8                         MaxLun,
+  IN UINT32                        MaxCarrySize
   )
 {
   USB_MASS_DEVICE                  *UsbMass;
@@ -504,10 +717,16 @@ UsbMassInitMultiLun (
     UsbMass->BlockIo.ReadBlocks   = UsbMassReadBlocks;
     UsbMass->BlockIo.WriteBlocks  = UsbMassWriteBlocks;
     UsbMass->BlockIo.FlushBlocks  = UsbMassFlushBlocks;
+    UsbMass->BlockIo2.Media         = &UsbMass->BlockIoMedia;
+    UsbMass->BlockIo2.Reset         = UsbMassResetEx;
+    UsbMass->BlockIo2.ReadBlocksEx  = UsbMassReadBlocksEx;
+    UsbMass->BlockIo2.WriteBlocksEx = UsbMassWriteBlocksEx;
+    UsbMass->BlockIo2.FlushBlocksEx = UsbMassFlushBlocksEx;
     UsbMass->OpticalStorage       = FALSE;
     UsbMass->Transport            = Transport;
     UsbMass->Context              = Context;
     UsbMass->Lun                  = Index;
+    UsbMass->MaxCarrySize         = MaxCarrySize;
 
     //
     // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
@@ -548,6 +767,8 @@ UsbMassInitMultiLun (
                     UsbMass->DevicePath,
                     &gEfiBlockIoProtocolGuid,
                     &UsbMass->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &UsbMass->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &UsbMass->DiskInfo,
                     NULL
@@ -580,6 +801,8 @@ UsbMassInitMultiLun (
              UsbMass->DevicePath,
              &gEfiBlockIoProtocolGuid,
              &UsbMass->BlockIo,
+             &gEfiBlockIo2ProtocolGuid,
+             &UsbMass->BlockIo2,
              &gEfiDiskInfoProtocolGuid,
              &UsbMass->DiskInfo,
              NULL
@@ -602,6 +825,7 @@ UsbMassInitMultiLun (
   @param  Controller      The device to initialize.
   @param  Transport       Pointer to USB_MASS_TRANSPORT.
   @param  Context         Parameter for USB_MASS_DEVICE.Context.
+  @param  MaxCarrySize    The max bytes carried by one READ/WRITE command.
 
   @retval EFI_SUCCESS     Initialization succeeds.
   @retval Other           Initialization fails.
@@ -612,7 +836,8 @@ UsbMassInitNonLun (
   IN EFI_DRIVER_BINDING_PROTOCOL   *This,
   IN EFI_HANDLE                    Controller,
   IN USB_MASS_TRANSPORT            *Transport,
-  IN VOID                          *Context
+  IN VOID                          *Context,
+  IN UINT32                        MaxCarrySize
   )
 {
   USB_MASS_DEVICE             *UsbMass;
@@ -645,9 +870,15 @@ UsbMassInitNonLun (
   UsbMass->BlockIo.ReadBlocks   = UsbMassReadBlocks;
   UsbMass->BlockIo.WriteBlocks  = UsbMassWriteBlocks;
   UsbMass->BlockIo.FlushBlocks  = UsbMassFlushBlocks;
+  UsbMass->BlockIo2.Media         = &UsbMass->BlockIoMedia;
+  UsbMass->BlockIo2.Reset         = UsbMassResetEx;
+  UsbMass->BlockIo2.ReadBlocksEx  = UsbMassReadBlocksEx;
+  UsbMass->BlockIo2.WriteBlocksEx = UsbMassWriteBlocksEx;
+  UsbMass->BlockIo2.FlushBlocksEx = UsbMassFlushBlocksEx;
   UsbMass->OpticalStorage       = FALSE;
   UsbMass->Transport            = Transport;
   UsbMass->Context              = Context;
+  UsbMass->MaxCarrySize         = MaxCarrySize;
 
   //
   // Initialize the media parameter data for EFI_BLOCK_IO_MEDIA of Block I/O Protocol.
@@ -664,6 +895,8 @@ UsbMassInitNonLun (
                   &Controller,
                   &gEfiBlockIoProtocolGuid,
                   &UsbMass->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid,
+                  &UsbMass->BlockIo2,
                   &gEfiDiskInfoProtocolGuid,
                   &UsbMass->DiskInfo,
                   NULL
@@ -797,6 +1030,7 @@ USBMassDriverBindingStart (
   EFI_DEVICE_PATH_PROTOCOL      *DevicePath;
   VOID                          *Context;
   UINT8                         MaxLun;
+  UINT32                        MaxCarrySize;
   EFI_STATUS                    Status;
   EFI_USB_IO_PROTOCOL           *UsbIo;
   EFI_TPL                       OldTpl;
@@ -806,8 +1040,9 @@ USBMassDriverBindingStart (
   Transport = NULL;
   Context   = NULL;
   MaxLun    = 0;
+  MaxCarrySize = USB_BOOT_MAX_CARRY_SIZE;
 
-  Status = UsbMassInitTransport (This, Controller, &Transport, &Context, &MaxLun);
+  Status = UsbMassInitTransport (This, Controller, &Transport, &Context, &MaxLun, &MaxCarrySize);
 
   if (EFI_ERROR (Status)) {
     DEBUG ((EFI_D_ERROR, "USBMassDriverBindingStart: UsbMassInitTransport (%r)\n", Status));
@@ -817,7 +1052,7 @@ USBMassDriverBindingStart (
     //
     // Initialize data for device that does not support multiple LUNSs.
     //
-    Status = UsbMassInitNonLun (This, Controller, Transport, Context);
+    Status = UsbMassInitNonLun (This, Controller, Transport, Context, MaxCarrySize);
     if (EFI_ERROR (Status)) {
       DEBUG ((EFI_D_ERROR, "USBMassDriverBindingStart: UsbMassInitNonLun (%r)\n", Status));
     }
@@ -863,7 +1098,7 @@ USBMassDriverBindingStart (
     // Initialize data for device that supports multiple LUNs.
     // EFI_SUCCESS is returned if at least 1 LUN is initialized successfully.
     //
-    Status = UsbMassInitMultiLun (This, Controller, Transport, Context, DevicePath, MaxLun);
+    Status = UsbMassInitMultiLun (This, Controller, Transport, Context, DevicePath, MaxLun, MaxCarrySize);
     if (EFI_ERROR (Status)) {
       gBS->CloseProtocol (
               Controller,
@@ -971,6 +1206,8 @@ USBMassDriverBindingStop (
                     Controller,
                     &gEfiBlockIoProtocolGuid,
                     &UsbMass->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &UsbMass->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &UsbMass->DiskInfo,
                     NULL
@@ -1031,6 +1268,8 @@ USBMassDriverBindingStop (
                     UsbMass->DevicePath,
                     &gEfiBlockIoProtocolGuid,
                     &UsbMass->BlockIo,
+                    &gEfiBlockIo2ProtocolGuid,
+                    &UsbMass->BlockIo2,
                     &gEfiDiskInfoProtocolGuid,
                     &UsbMass->DiskInfo,
                     NULL
@@ -148,6 +148,71 @@ PopBool (
 
 
 
+/**
+  Walk the dependency expression and register DriverEntry to be re-evaluated
+  when any protocol it pushes gets installed. A Depex result can then only
+  change from FALSE to TRUE when one of those protocols is installed, so the
+  dispatcher does not need to evaluate it again until then. A Depex that uses
+  NOT may become TRUE when a protocol is uninstalled, and is marked volatile
+  along with any Depex whose waits cannot be registered.
+
+  @param  DriverEntry           DriverEntry element to update.
+
+**/
+VOID
+CoreCompileDepex (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Iterator;
+  UINT8       *End;
+  EFI_GUID    DriverGuid;
+
+  Iterator = DriverEntry->Depex;
+  End      = Iterator + DriverEntry->DepexSize;
+
+  while (Iterator < End) {
+    switch (*Iterator) {
+    case EFI_DEP_PUSH:
+      if ((UINTN)(End - Iterator) <= sizeof (EFI_GUID)) {
+        // Truncated PUSH, CoreIsSchedulable() will reject the Depex.
+        return;
+      }
+      CopyMem (&DriverGuid, Iterator + 1, sizeof (EFI_GUID));
+      Status = CoreAddDepexProtocolWait (DriverEntry, &DriverGuid);
+      if (EFI_ERROR (Status)) {
+        DriverEntry->DepexVolatile = TRUE;
+      }
+      Iterator += sizeof (EFI_GUID);
+      break;
+
+    case EFI_DEP_REPLACE_TRUE:
+      Iterator += sizeof (EFI_GUID);
+      break;
+
+    case EFI_DEP_NOT:
+      DriverEntry->DepexVolatile = TRUE;
+      break;
+
+    case EFI_DEP_AND:
+    case EFI_DEP_OR:
+    case EFI_DEP_TRUE:
+    case EFI_DEP_FALSE:
+    case EFI_DEP_SOR:
+      break;
+
+    default:
+      // END, or an opcode CoreIsSchedulable() never gets past.
+      return;
+    }
+
+    Iterator++;
+  }
+}
+
+
+
 /**
   Preprocess dependency expression and update DriverEntry to reflect the
   state of  Before, After, and SOR dependencies. If DriverEntry->Before
@@ -182,6 +247,8 @@ CorePreProcessDepex (
 
   if (DriverEntry->Before || DriverEntry->After) {
     CopyMem (&DriverEntry->BeforeAfterGuid, Iterator + 1, sizeof (EFI_GUID));
+  } else {
+    CoreCompileDepex (DriverEntry);
   }
 
   return EFI_SUCCESS;
@@ -61,6 +61,18 @@ EFI_LOCK  mDispatcherLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL);
 //
 BOOLEAN  gDispatcherRunning = FALSE;
 
+//
+// Hash table of DEPEX_PROTOCOL_NOTIFY, one per protocol GUID pushed by any
+// discovered driver's Depex.
+//
+LIST_ENTRY  mDepexProtocolNotifyTable[DEPEX_PROTOCOL_NOTIFY_BUCKET_COUNT];
+
+//
+// Number of Depex evaluations and dispatcher passes, reported in debug builds
+//
+UINTN  mDepexEvaluationCount = 0;
+UINTN  mDispatcherPassCount  = 0;
+
 //
 // Module globals to manage the FwVol registration notification event
 //
@@ -222,6 +234,185 @@ CoreReleaseDispatcherLock (
 }
 
 
+/**
+  Event notification that is fired every time a protocol waited on by one or
+  more Depex is installed. Mark the waiting drivers that are still in the
+  Dependent state for re-evaluation on the next dispatcher pass.
+
+  @param  Event                 The Event that is being processed, not used.
+  @param  Context               The DEPEX_PROTOCOL_NOTIFY of the protocol.
+
+**/
+VOID
+EFIAPI
+CoreDepexProtocolNotify (
+  IN  EFI_EVENT       Event,
+  IN  VOID            *Context
+  )
+{
+  DEPEX_PROTOCOL_NOTIFY   *Notify;
+  DEPEX_PROTOCOL_WAIT     *Wait;
+  LIST_ENTRY              *Link;
+
+  Notify = (DEPEX_PROTOCOL_NOTIFY *)Context;
+  ASSERT (Notify->Signature == DEPEX_PROTOCOL_NOTIFY_SIGNATURE);
+
+  CoreAcquireDispatcherLock ();
+  for (Link = Notify->WaitList.ForwardLink; Link != &Notify->WaitList; Link = Link->ForwardLink) {
+    Wait = CR (Link, DEPEX_PROTOCOL_WAIT, Link, DEPEX_PROTOCOL_WAIT_SIGNATURE);
+    if (Wait->DriverEntry->Dependent) {
+      Wait->DriverEntry->DepexReevaluate = TRUE;
+    }
+  }
+  CoreReleaseDispatcherLock ();
+}
+
+
+/**
+  Register DriverEntry to be marked for Depex re-evaluation whenever
+  Protocol is installed.
+
+  @param  DriverEntry           The driver whose Depex pushes Protocol.
+  @param  Protocol              The protocol GUID the Depex waits on.
+
+  @retval EFI_SUCCESS           The wait was registered.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to register the wait.
+
+**/
+EFI_STATUS
+CoreAddDepexProtocolWait (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry,
+  IN  EFI_GUID                *Protocol
+  )
+{
+  EFI_STATUS              Status;
+  LIST_ENTRY              *Bucket;
+  LIST_ENTRY              *Link;
+  DEPEX_PROTOCOL_NOTIFY   *Notify;
+  DEPEX_PROTOCOL_WAIT     *Wait;
+
+  Bucket = &mDepexProtocolNotifyTable[CoreHashGuid (Protocol) & (DEPEX_PROTOCOL_NOTIFY_BUCKET_COUNT - 1)];
+  if (Bucket->ForwardLink == NULL) {
+    InitializeListHead (Bucket);
+  }
+
+  Notify = NULL;
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    Notify = CR (Link, DEPEX_PROTOCOL_NOTIFY, Link, DEPEX_PROTOCOL_NOTIFY_SIGNATURE);
+    if (CompareGuid (&Notify->ProtocolGuid, Protocol)) {
+      break;
+    }
+    Notify = NULL;
+  }
+
+  if (Notify == NULL) {
+    //
+    // First Depex to wait on this protocol, register for its installation.
+    //
+    Notify = AllocateZeroPool (sizeof (DEPEX_PROTOCOL_NOTIFY));
+    if (Notify == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Notify->Signature = DEPEX_PROTOCOL_NOTIFY_SIGNATURE;
+    CopyGuid (&Notify->ProtocolGuid, Protocol);
+    InitializeListHead (&Notify->WaitList);
+
+    Status = CoreCreateEvent (
+               EVT_NOTIFY_SIGNAL,
+               TPL_CALLBACK,
+               CoreDepexProtocolNotify,
+               Notify,
+               &Notify->Event
+               );
+    if (EFI_ERROR (Status)) {
+      CoreFreePool (Notify);
+      return Status;
+    }
+
+    Status = CoreRegisterProtocolNotify (
+               &Notify->ProtocolGuid,
+               Notify->Event,
+               &Notify->Registration
+               );
+    if (EFI_ERROR (Status)) {
+      CoreCloseEvent (Notify->Event);
+      CoreFreePool (Notify);
+      return Status;
+    }
+
+    InsertTailList (Bucket, &Notify->Link);
+  }
+
+  Wait = AllocatePool (sizeof (DEPEX_PROTOCOL_WAIT));
+  if (Wait == NULL) {
+    if (IsListEmpty (&Notify->WaitList)) {
+      RemoveEntryList (&Notify->Link);
+      CoreCloseEvent (Notify->Event);
+      CoreFreePool (Notify);
+    }
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Wait->Signature   = DEPEX_PROTOCOL_WAIT_SIGNATURE;
+  Wait->Notify      = Notify;
+  Wait->DriverEntry = DriverEntry;
+
+  CoreAcquireDispatcherLock ();
+  InsertTailList (&Notify->WaitList, &Wait->Link);
+  InsertTailList (&DriverEntry->DepexWaitList, &Wait->DriverLink);
+  CoreReleaseDispatcherLock ();
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Free the Depex protocol waits of DriverEntry. A protocol notify that no
+  driver waits on any more is unregistered and freed along with its event.
+
+  @param  DriverEntry           The driver whose waits are freed.
+
+**/
+VOID
+CoreRemoveDepexProtocolWaits (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry
+  )
+{
+  DEPEX_PROTOCOL_WAIT     *Wait;
+  DEPEX_PROTOCOL_NOTIFY   *Notify;
+  BOOLEAN                 Unused;
+
+  while (!IsListEmpty (&DriverEntry->DepexWaitList)) {
+    Wait = CR (
+             DriverEntry->DepexWaitList.ForwardLink,
+             DEPEX_PROTOCOL_WAIT,
+             DriverLink,
+             DEPEX_PROTOCOL_WAIT_SIGNATURE
+             );
+    Notify = Wait->Notify;
+
+    CoreAcquireDispatcherLock ();
+    RemoveEntryList (&Wait->Link);
+    RemoveEntryList (&Wait->DriverLink);
+    Unused = IsListEmpty (&Notify->WaitList);
+    if (Unused) {
+      RemoveEntryList (&Notify->Link);
+    }
+    CoreReleaseDispatcherLock ();
+
+    CoreFreePool (Wait);
+    if (Unused) {
+      //
+      // Closing the event also unregisters the protocol notify.
+      //
+      CoreCloseEvent (Notify->Event);
+      CoreFreePool (Notify);
+    }
+  }
+}
+
+
 /**
   Read Depex and pre-process the Depex for Before and After. If Section Extraction
   protocol returns an error via ReadSection defer the reading of the Depex.
@@ -273,6 +464,12 @@ CoreGetDepexSectionAndPreProccess (
       DriverEntry->Depex = NULL;
       DriverEntry->Dependent = TRUE;
       DriverEntry->DepexProtocolError = FALSE;
+
+      //
+      // The UEFI 2.0 driver model check is not tied to a single protocol
+      //
+      DriverEntry->DepexVolatile = TRUE;
+      DriverEntry->DepexReevaluate = TRUE;
     }
   } else {
     //
@@ -281,6 +478,7 @@ CoreGetDepexSectionAndPreProccess (
     //
     CorePreProcessDepex (DriverEntry);
     DriverEntry->DepexProtocolError = FALSE;
+    DriverEntry->DepexReevaluate = TRUE;
   }
 
   return Status;
@@ -323,8 +521,9 @@ CoreSchedule (
       // Move the driver from the Unrequested to the Dependent state
       //
       CoreAcquireDispatcherLock ();
-      DriverEntry->Unrequested  = FALSE;
-      DriverEntry->Dependent    = TRUE;
+      DriverEntry->Unrequested     = FALSE;
+      DriverEntry->Dependent       = TRUE;
+      DriverEntry->DepexReevaluate = TRUE;
       CoreReleaseDispatcherLock ();
 
       DEBUG ((DEBUG_DISPATCH, "Schedule FFS(%g) - EFI_SUCCESS\n", DriverName));
@@ -389,7 +588,9 @@ CoreTrust (
   This is the main Dispatcher for DXE and it exits when there are no more
   drivers to run. Drain the mScheduledQueue and load and start a PE
   image for each driver. Search the mDiscoveredList to see if any driver can
-  be placed on the mScheduledQueue. If no drivers are placed on the
+  be placed on the mScheduledQueue. Only drivers whose Depex waits on a
+  protocol installed since their last evaluation, or whose Depex is volatile,
+  are evaluated again. If no drivers are placed on the
   mScheduledQueue exit the function. On exit it is assumed the Bds()
   will be called, and when the Bds() exits the Dispatcher will be called
   again.
@@ -545,6 +746,8 @@ CoreDispatcher (
     //
     // Search DriverList for items to place on Scheduled Queue
     //
+    PERF_INMODULE_BEGIN ("DepexEval");
+    mDispatcherPassCount++;
     ReadyToRun = FALSE;
     for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
       DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
@@ -557,6 +760,18 @@ CoreDispatcher (
       }
 
       if (DriverEntry->Dependent) {
+        if (!DriverEntry->DepexReevaluate && !DriverEntry->DepexVolatile) {
+          //
+          // Nothing the Depex waits on was installed since it evaluated to FALSE
+          //
+          continue;
+        }
+
+        CoreAcquireDispatcherLock ();
+        DriverEntry->DepexReevaluate = FALSE;
+        CoreReleaseDispatcherLock ();
+
+        mDepexEvaluationCount++;
         if (CoreIsSchedulable (DriverEntry)) {
           CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (DriverEntry);
           ReadyToRun = TRUE;
@@ -569,8 +784,30 @@ CoreDispatcher (
         }
       }
     }
+    PERF_INMODULE_END ("DepexEval");
   } while (ReadyToRun);
 
+  DEBUG ((
+    DEBUG_DISPATCH,
+    "DXE Dispatcher: %Lu Depex evaluations in %Lu passes\n",
+    (UINT64) mDepexEvaluationCount,
+    (UINT64) mDispatcherPassCount
+    ));
+
+  //
+  // The drivers still waiting for a protocol may only be dispatched by a
+  // later call, after BDS has connected devices. Drop their protocol waits
+  // rather than keep the notifies firing for the rest of boot, and evaluate
+  // them on every pass from now on.
+  //
+  for (Link = mDiscoveredList.ForwardLink; Link != &mDiscoveredList; Link = Link->ForwardLink) {
+    DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, Link, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    if (!IsListEmpty (&DriverEntry->DepexWaitList)) {
+      CoreRemoveDepexProtocolWaits (DriverEntry);
+      DriverEntry->DepexVolatile = TRUE;
+    }
+  }
+
   //
   // Close DXE dispatch Event
   //
@@ -634,6 +871,8 @@ CoreInsertOnScheduledQueueWhileProcessingBeforeAndAfter (
 
   CoreReleaseDispatcherLock ();
 
+  CoreRemoveDepexProtocolWaits (InsertedDriverEntry);
+
   //
   // Process After Dependency
   //
@@ -881,6 +1120,7 @@ CoreAddToDriverList (
   }
 
   DriverEntry->Signature        = EFI_CORE_DRIVER_ENTRY_SIGNATURE;
+  InitializeListHead (&DriverEntry->DepexWaitList);
   CopyGuid (&DriverEntry->FileName, DriverName);
   DriverEntry->FvHandle         = FvHandle;
   DriverEntry->Fv               = Fv;
@@ -1423,6 +1663,7 @@ CoreFwVolEventProtocolNotify (
           DriverEntry->Scheduled = TRUE;
           InsertTailList (&mScheduledQueue, &DriverEntry->ScheduledLink);
           CoreReleaseDispatcherLock ();
+          CoreRemoveDepexProtocolWaits (DriverEntry);
           DEBUG ((DEBUG_DISPATCH, "Evaluate DXE DEPEX for FFS(%g)\n", &DriverEntry->FileName));
           DEBUG ((DEBUG_DISPATCH, "  RESULT = TRUE (Apriori)\n"));
           break;
@@ -137,8 +137,41 @@ typedef struct {
 } KNOWN_HANDLE;
 
 
-#define EFI_CORE_DRIVER_ENTRY_SIGNATURE SIGNATURE_32('d','r','v','r')
+///
+/// Number of hash buckets used to look up DEPEX_PROTOCOL_NOTIFY by GUID.
+/// Must be a power of 2.
+///
+#define DEPEX_PROTOCOL_NOTIFY_BUCKET_COUNT  64
+
+//
+// Every protocol GUID referenced by an EFI_DEP_PUSH in a discovered driver's
+// DEPEX gets one DEPEX_PROTOCOL_NOTIFY. When the protocol is installed the
+// drivers on WaitList are marked for re-evaluation. A DEPEX_PROTOCOL_WAIT is
+// freed when its driver leaves the Dependent state or the dispatcher stops,
+// and the DEPEX_PROTOCOL_NOTIFY along with its event when its WaitList
+// becomes empty.
+//
+#define DEPEX_PROTOCOL_NOTIFY_SIGNATURE  SIGNATURE_32('d','p','n','t')
+typedef struct {
+  UINTN           Signature;
+  LIST_ENTRY      Link;         // mDepexProtocolNotifyTable bucket
+  EFI_GUID        ProtocolGuid;
+  EFI_EVENT       Event;
+  VOID            *Registration;
+  LIST_ENTRY      WaitList;     // list of DEPEX_PROTOCOL_WAIT
+} DEPEX_PROTOCOL_NOTIFY;
+
+#define DEPEX_PROTOCOL_WAIT_SIGNATURE  SIGNATURE_32('d','p','w','t')
 typedef struct {
+  UINTN                           Signature;
+  LIST_ENTRY                      Link;         // DEPEX_PROTOCOL_NOTIFY.WaitList
+  LIST_ENTRY                      DriverLink;   // EFI_CORE_DRIVER_ENTRY.DepexWaitList
+  DEPEX_PROTOCOL_NOTIFY           *Notify;
+  struct _EFI_CORE_DRIVER_ENTRY   *DriverEntry;
+} DEPEX_PROTOCOL_WAIT;
+
+#define EFI_CORE_DRIVER_ENTRY_SIGNATURE SIGNATURE_32('d','r','v','r')
+typedef struct _EFI_CORE_DRIVER_ENTRY {
   UINTN                           Signature;
   LIST_ENTRY                      Link;             // mDriverList
 
@@ -163,6 +196,15 @@ typedef struct {
   BOOLEAN                         Initialized;
   BOOLEAN                         DepexProtocolError;
 
+  //
+  // DepexReevaluate is set when a protocol the Depex waits on is installed.
+  // DepexVolatile is set when the Depex cannot be reduced to a set of waited
+  // on protocols, and must be evaluated on every dispatcher pass.
+  //
+  BOOLEAN                         DepexReevaluate;
+  BOOLEAN                         DepexVolatile;
+  LIST_ENTRY                      DepexWaitList;    // list of DEPEX_PROTOCOL_WAIT
+
   EFI_HANDLE                      ImageHandle;
   BOOLEAN                         IsFvImage;
 
@@ -502,6 +544,24 @@ CoreIsSchedulable (
   );
 
 
+/**
+  Register DriverEntry to be marked for Depex re-evaluation whenever
+  Protocol is installed.
+
+  @param  DriverEntry           The driver whose Depex pushes Protocol.
+  @param  Protocol              The protocol GUID the Depex waits on.
+
+  @retval EFI_SUCCESS           The wait was registered.
+  @retval EFI_OUT_OF_RESOURCES  There is not enough memory to register the wait.
+
+**/
+EFI_STATUS
+CoreAddDepexProtocolWait (
+  IN  EFI_CORE_DRIVER_ENTRY   *DriverEntry,
+  IN  EFI_GUID                *Protocol
+  );
+
+
 /**
   Preprocess dependency expression and update DriverEntry to reflect the
   state of  Before, After, and SOR dependencies. If DriverEntry->Before
@@ -2650,6 +2710,20 @@ CoreReleaseLock (
   IN EFI_LOCK  *Lock
   );
 
+/**
+  Fold a GUID into a 32-bit hash value. The low bits of the result depend on
+  every byte of the GUID, so it can be masked to any power of 2 bucket count.
+
+  @param  Guid               The GUID to hash
+
+  @return The hash value of Guid
+
+**/
+UINT32
+CoreHashGuid (
+  IN CONST EFI_GUID  *Guid
+  );
+
 /**
   Read data from Firmware Block by FVB protocol Read.
   The data may cross the multi block ranges.
@@ -28,12 +28,21 @@ extern  UINTN                   gEventPending;
 //
 
 ///
-/// Timer event information
+/// Timer event information. Armed timers are kept in a pairing heap ordered
+/// by TriggerTime, then by Sequence so that timers with the same TriggerTime
+/// are signaled in the order they were armed.
 ///
-typedef struct {
-  LIST_ENTRY      Link;
-  UINT64          TriggerTime;
-  UINT64          Period;
+typedef struct _TIMER_EVENT_INFO {
+  ///
+  /// First child, next sibling and parent (or previous sibling) in the heap
+  ///
+  struct _TIMER_EVENT_INFO  *Child;
+  struct _TIMER_EVENT_INFO  *Next;
+  struct _TIMER_EVENT_INFO  *Prev;
+  BOOLEAN                   Queued;
+  UINT64                    Sequence;
+  UINT64                    TriggerTime;
+  UINT64                    Period;
 } TIMER_EVENT_INFO;
 
 #define EVENT_SIGNATURE         SIGNATURE_32('e','v','n','t')
@@ -14,7 +14,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // Internal data
 //
 
-LIST_ENTRY       mEfiTimerList = INITIALIZE_LIST_HEAD_VARIABLE (mEfiTimerList);
+//
+// mEfiTimerHeap is the root of the pairing heap of armed timers, it is the
+// timer that expires first. mEfiTimerSequence orders timers armed with the
+// same trigger time.
+//
+TIMER_EVENT_INFO *mEfiTimerHeap = NULL;
+UINT64           mEfiTimerSequence = 0;
 EFI_LOCK         mEfiTimerLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_HIGH_LEVEL - 1);
 EFI_EVENT        mEfiCheckTimerEvent = NULL;
 
@@ -24,6 +30,109 @@ UINT64           mEfiSystemTime = 0;
 //
 // Timer functions
 //
+/**
+  Melds two timer heaps into one.
+
+  @param  Heap1                  Root of the first heap, may be NULL
+  @param  Heap2                  Root of the second heap, may be NULL
+
+  @return Root of the melded heap
+
+**/
+TIMER_EVENT_INFO *
+CoreMeldTimerHeap (
+  IN TIMER_EVENT_INFO   *Heap1,
+  IN TIMER_EVENT_INFO   *Heap2
+  )
+{
+  TIMER_EVENT_INFO  *Root;
+  TIMER_EVENT_INFO  *Child;
+
+  if (Heap1 == NULL) {
+    return Heap2;
+  }
+  if (Heap2 == NULL) {
+    return Heap1;
+  }
+
+  //
+  // The root with the earlier trigger time becomes the parent
+  //
+  if ((Heap2->TriggerTime < Heap1->TriggerTime) ||
+      ((Heap2->TriggerTime == Heap1->TriggerTime) && (Heap2->Sequence < Heap1->Sequence))) {
+    Root  = Heap2;
+    Child = Heap1;
+  } else {
+    Root  = Heap1;
+    Child = Heap2;
+  }
+
+  Child->Prev = Root;
+  Child->Next = Root->Child;
+  if (Root->Child != NULL) {
+    Root->Child->Prev = Child;
+  }
+  Root->Child = Child;
+
+  return Root;
+}
+
+/**
+  Combines a list of sibling sub-heaps into a single heap using the two-pass
+  pairing scheme.
+
+  @param  First                  First sub-heap of the sibling list, may be NULL
+
+  @return Root of the combined heap
+
+**/
+TIMER_EVENT_INFO *
+CoreMergeTimerHeapPairs (
+  IN TIMER_EVENT_INFO   *First
+  )
+{
+  TIMER_EVENT_INFO  *Heap1;
+  TIMER_EVENT_INFO  *Heap2;
+  TIMER_EVENT_INFO  *Next;
+  TIMER_EVENT_INFO  *Pairs;
+  TIMER_EVENT_INFO  *Root;
+
+  //
+  // Meld the sub-heaps in pairs from left to right, stacking the results
+  //
+  Pairs = NULL;
+  while (First != NULL) {
+    Heap1 = First;
+    Heap2 = Heap1->Next;
+    Next  = (Heap2 != NULL) ? Heap2->Next : NULL;
+
+    Heap1->Next = NULL;
+    Heap1->Prev = NULL;
+    if (Heap2 != NULL) {
+      Heap2->Next = NULL;
+      Heap2->Prev = NULL;
+      Heap1 = CoreMeldTimerHeap (Heap1, Heap2);
+    }
+
+    Heap1->Next = Pairs;
+    Pairs = Heap1;
+    First = Next;
+  }
+
+  //
+  // Meld the stacked pairs from right to left into a single heap
+  //
+  Root = NULL;
+  while (Pairs != NULL) {
+    Heap1 = Pairs;
+    Pairs = Heap1->Next;
+    Heap1->Next = NULL;
+    Root = CoreMeldTimerHeap (Root, Heap1);
+  }
+
+  return Root;
+}
+
 /**
   Inserts the timer event.
 
@@ -36,29 +145,64 @@ CoreInsertEventTimer (
   IN IEVENT   *Event
   )
 {
-  UINT64          TriggerTime;
-  LIST_ENTRY      *Link;
-  IEVENT          *Event2;
+  TIMER_EVENT_INFO  *Timer;
 
   ASSERT_LOCKED (&mEfiTimerLock);
 
-  //
-  // Get the timer's trigger time
-  //
-  TriggerTime = Event->Timer.TriggerTime;
+  Timer = &Event->Timer;
+  Timer->Child    = NULL;
+  Timer->Next     = NULL;
+  Timer->Prev     = NULL;
+  Timer->Queued   = TRUE;
+  Timer->Sequence = mEfiTimerSequence++;
 
-  //
-  // Insert the timer into the timer database in assending sorted order
-  //
-  for (Link = mEfiTimerList.ForwardLink; Link != &mEfiTimerList; Link = Link->ForwardLink) {
-    Event2 = CR (Link, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  mEfiTimerHeap = CoreMeldTimerHeap (mEfiTimerHeap, Timer);
+}
 
-    if (Event2->Timer.TriggerTime > TriggerTime) {
-      break;
+/**
+  Removes the timer event from the timer heap.
+
+  @param  Event                  Points to the internal structure of timer event
+                                 to be removed
+
+**/
+VOID
+CoreRemoveEventTimer (
+  IN IEVENT   *Event
+  )
+{
+  TIMER_EVENT_INFO  *Timer;
+  TIMER_EVENT_INFO  *SubHeap;
+
+  ASSERT_LOCKED (&mEfiTimerLock);
+
+  Timer = &Event->Timer;
+  ASSERT (Timer->Queued);
+
+  SubHeap = CoreMergeTimerHeapPairs (Timer->Child);
+
+  if (Timer == mEfiTimerHeap) {
+    mEfiTimerHeap = SubHeap;
+  } else {
+    //
+    // Unlink the timer from its parent or previous sibling, then meld its
+    // children back into the heap
+    //
+    if (Timer->Prev->Child == Timer) {
+      Timer->Prev->Child = Timer->Next;
+    } else {
+      Timer->Prev->Next = Timer->Next;
     }
+    if (Timer->Next != NULL) {
+      Timer->Next->Prev = Timer->Prev;
+    }
+    mEfiTimerHeap = CoreMeldTimerHeap (mEfiTimerHeap, SubHeap);
   }
 
-  InsertTailList (Link, &Event->Timer.Link);
+  Timer->Child  = NULL;
+  Timer->Next   = NULL;
+  Timer->Prev   = NULL;
+  Timer->Queued = FALSE;
 }
 
 /**
@@ -82,7 +226,7 @@ CoreCurrentSystemTime (
 }
 
 /**
-  Checks the sorted timer list against the current system time.
+  Checks the timer heap against the current system time.
   Signals any expired event timer.
 
   @param  CheckEvent             Not used
@@ -105,8 +249,8 @@ CoreCheckTimers (
   CoreAcquireLock (&mEfiTimerLock);
   SystemTime = CoreCurrentSystemTime ();
 
-  while (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
+  while (mEfiTimerHeap != NULL) {
+    Event = CR (mEfiTimerHeap, IEVENT, Timer, EVENT_SIGNATURE);
 
     //
     // If this timer is not expired, then we're done
@@ -119,8 +263,7 @@ CoreCheckTimers (
     // Remove this timer from the timer queue
     //
 
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+    CoreRemoveEventTimer (Event);
 
     //
     // Signal it
@@ -191,7 +334,7 @@ CoreTimerTick (
   IN UINT64   Duration
   )
 {
-  IEVENT          *Event;
+  TIMER_EVENT_INFO  *Timer;
 
   //
   // Check runtiem flag in case there are ticks while exiting boot services
@@ -204,13 +347,12 @@ CoreTimerTick (
   mEfiSystemTime += Duration;
 
   //
-  // If the head of the list is expired, fire the timer event
+  // If the root of the heap is expired, fire the timer event
   // to process it
   //
-  if (!IsListEmpty (&mEfiTimerList)) {
-    Event = CR (mEfiTimerList.ForwardLink, IEVENT, Timer.Link, EVENT_SIGNATURE);
-
-    if (Event->Timer.TriggerTime <= mEfiSystemTime) {
+  Timer = mEfiTimerHeap;
+  if (Timer != NULL) {
+    if (Timer->TriggerTime <= mEfiSystemTime) {
       CoreSignalEvent (mEfiCheckTimerEvent);
     }
   }
@@ -264,9 +406,8 @@ CoreSetTimer (
   //
   // If the timer is queued to the timer database, remove it
   //
-  if (Event->Timer.Link.ForwardLink != NULL) {
-    RemoveEntryList (&Event->Timer.Link);
-    Event->Timer.Link.ForwardLink = NULL;
+  if (Event->Timer.Queued) {
+    CoreRemoveEventTimer (Event);
   }
 
   Event->Timer.TriggerTime = 0;
@@ -11,17 +11,72 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 
 //
-// mProtocolDatabase     - A list of all protocols in the system.  (simple list for now)
+// mProtocolDatabase     - A list of all protocols in the system.
+// mProtocolHashTable    - The protocols in mProtocolDatabase, hashed by GUID
 // gHandleList           - A list of all the handles in the system
+// mHandleHashTable      - The handles in gHandleList, hashed by address
 // gProtocolDatabaseLock - Lock to protect the mProtocolDatabase
 // gHandleDatabaseKey    -  The Key to show that the handle has been created/modified
 //
 LIST_ENTRY      mProtocolDatabase     = INITIALIZE_LIST_HEAD_VARIABLE (mProtocolDatabase);
+LIST_ENTRY      mProtocolHashTable[PROTOCOL_HASH_BUCKET_COUNT];
 LIST_ENTRY      gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleList);
+LIST_ENTRY      mHandleHashTable[HANDLE_HASH_BUCKET_COUNT];
 EFI_LOCK        gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64          gHandleDatabaseKey    = 0;
 
 
+/**
+  Return the hash bucket for a handle. The handle is only used as a key and
+  is never dereferenced, so the function is safe on invalid handles.
+
+  @param  UserHandle             The handle to look up
+
+  @return The list head of the bucket the handle belongs to
+
+**/
+LIST_ENTRY *
+CoreGetHandleHashBucket (
+  IN  EFI_HANDLE                UserHandle
+  )
+{
+  LIST_ENTRY          *Bucket;
+
+  //
+  // Handles come from the pool, which is 8-byte aligned, so the low
+  // address bits carry no information.
+  //
+  Bucket = &mHandleHashTable[((UINTN) UserHandle >> 3) & (HANDLE_HASH_BUCKET_COUNT - 1)];
+  if (Bucket->ForwardLink == NULL) {
+    InitializeListHead (Bucket);
+  }
+  return Bucket;
+}
+
+
+/**
+  Return the hash bucket for a protocol GUID.
+
+  @param  Protocol               The ID of the protocol
+
+  @return The list head of the bucket the protocol belongs to
+
+**/
+LIST_ENTRY *
+CoreGetProtocolHashBucket (
+  IN EFI_GUID   *Protocol
+  )
+{
+  LIST_ENTRY          *Bucket;
+
+  Bucket = &mProtocolHashTable[CoreHashGuid (Protocol) & (PROTOCOL_HASH_BUCKET_COUNT - 1)];
+  if (Bucket->ForwardLink == NULL) {
+    InitializeListHead (Bucket);
+  }
+  return Bucket;
+}
+
+
 
 /**
   Acquire lock on gProtocolDatabaseLock.
@@ -51,6 +106,46 @@ CoreReleaseProtocolLock (
 
 
 
+/**
+  Add a newly created handle to gHandleList and to the handle hash index.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to add
+
+**/
+VOID
+CoreInsertHandle (
+  IN IHANDLE        *Handle
+  )
+{
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  InsertTailList (&gHandleList, &Handle->AllHandles);
+  InsertTailList (CoreGetHandleHashBucket (Handle), &Handle->HashLink);
+}
+
+
+
+/**
+  Remove a handle from gHandleList and from the handle hash index.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to remove
+
+**/
+VOID
+CoreRemoveHandle (
+  IN IHANDLE        *Handle
+  )
+{
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  RemoveEntryList (&Handle->AllHandles);
+  RemoveEntryList (&Handle->HashLink);
+}
+
+
+
 /**
   Check whether a handle is a valid EFI_HANDLE
 
@@ -66,14 +161,20 @@ CoreValidateHandle (
   )
 {
   IHANDLE             *Handle;
+  LIST_ENTRY          *Bucket;
   LIST_ENTRY          *Link;
 
   if (UserHandle == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  for (Link = gHandleList.BackLink; Link != &gHandleList; Link = Link->BackLink) {
-    Handle = CR (Link, IHANDLE, AllHandles, EFI_HANDLE_SIGNATURE);
+  //
+  // Only the handles in the matching bucket need to be compared; the
+  // candidate itself is not dereferenced until it is known to be valid.
+  //
+  Bucket = CoreGetHandleHashBucket (UserHandle);
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    Handle = CR (Link, IHANDLE, HashLink, EFI_HANDLE_SIGNATURE);
     if (Handle == (IHANDLE *) UserHandle) {
       return EFI_SUCCESS;
     }
@@ -100,6 +201,7 @@ CoreFindProtocolEntry (
   IN BOOLEAN    Create
   )
 {
+  LIST_ENTRY          *Bucket;
   LIST_ENTRY          *Link;
   PROTOCOL_ENTRY      *Item;
   PROTOCOL_ENTRY      *ProtEntry;
@@ -107,15 +209,16 @@ CoreFindProtocolEntry (
   ASSERT_LOCKED(&gProtocolDatabaseLock);
 
   //
-  // Search the database for the matching GUID
+  // Search the hash bucket of the database for the matching GUID
   //
 
   ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
+  Bucket = CoreGetProtocolHashBucket (Protocol);
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR(Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+    Item = CR(Link, PROTOCOL_ENTRY, HashLink, PROTOCOL_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->ProtocolID, Protocol)) {
 
       //
@@ -147,6 +250,7 @@ CoreFindProtocolEntry (
       // Add it to protocol database
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      InsertTailList (Bucket, &ProtEntry->HashLink);
     }
   }
 
@@ -426,7 +530,7 @@ CoreInstallProtocolInterfaceNotify (
     // Add this handle to the list global list of all handles
     // in the system
     //
-    InsertTailList (&gHandleList, &Handle->AllHandles);
+    CoreInsertHandle (Handle);
   } else {
     Status = CoreValidateHandle (Handle);
     if (EFI_ERROR (Status)) {
@@ -788,7 +892,7 @@ CoreUninstallProtocolInterface (
   //
   if (IsListEmpty (&Handle->Protocols)) {
     Handle->Signature = 0;
-    RemoveEntryList (&Handle->AllHandles);
+    CoreRemoveHandle (Handle);
     CoreFreePool (Handle);
   }
 
@@ -12,6 +12,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #define EFI_HANDLE_SIGNATURE            SIGNATURE_32('h','n','d','l')
 
+///
+/// Number of buckets in the hash indexes kept alongside gHandleList and
+/// mProtocolDatabase. Both must be a power of 2.
+///
+#define HANDLE_HASH_BUCKET_COUNT        1024
+#define PROTOCOL_HASH_BUCKET_COUNT      256
+
 ///
 /// IHANDLE - contains a list of protocol handles
 ///
@@ -24,6 +31,8 @@ typedef struct {
   UINTN               LocateRequest;
   /// The Handle Database Key value when this handle was last created or modified
   UINT64              Key;
+  /// Link on the handle hash bucket used by CoreValidateHandle()
+  LIST_ENTRY          HashLink;
 } IHANDLE;
 
 #define ASSERT_IS_HANDLE(a)  ASSERT((a)->Signature == EFI_HANDLE_SIGNATURE)
@@ -45,6 +54,8 @@ typedef struct {
   LIST_ENTRY          Protocols;
   /// Registerd notification handlers
   LIST_ENTRY          Notify;
+  /// Link on the protocol hash bucket used by CoreFindProtocolEntry()
+  LIST_ENTRY          HashLink;
 } PROTOCOL_ENTRY;
 
 
@@ -240,6 +251,32 @@ CoreReleaseProtocolLock (
   );
 
 
+/**
+  Add a newly created handle to gHandleList and to the handle hash index.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to add
+
+**/
+VOID
+CoreInsertHandle (
+  IN IHANDLE        *Handle
+  );
+
+
+/**
+  Remove a handle from gHandleList and from the handle hash index.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to remove
+
+**/
+VOID
+CoreRemoveHandle (
+  IN IHANDLE        *Handle
+  );
+
+
 /**
   Check whether a handle is a valid EFI_HANDLE
 
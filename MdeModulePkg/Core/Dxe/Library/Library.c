@@ -98,3 +98,31 @@ CoreReleaseLock (
 
 
 
+/**
+  Fold a GUID into a 32-bit hash value. The low bits of the result depend on
+  every byte of the GUID, so it can be masked to any power of 2 bucket count.
+
+  @param  Guid               The GUID to hash
+
+  @return The hash value of Guid
+
+**/
+UINT32
+CoreHashGuid (
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINT32  Hash;
+
+  Hash = ReadUnaligned32 ((CONST UINT32 *) Guid) ^
+         ReadUnaligned32 ((CONST UINT32 *) Guid + 1) ^
+         ReadUnaligned32 ((CONST UINT32 *) Guid + 2) ^
+         ReadUnaligned32 ((CONST UINT32 *) Guid + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+
+  return Hash;
+}
+
+
+
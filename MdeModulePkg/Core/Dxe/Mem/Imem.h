@@ -25,6 +25,25 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MEMORY_TYPE_OEM_RESERVED_MIN                0x70000000
 #define MEMORY_TYPE_OEM_RESERVED_MAX                0x7FFFFFFF
 
+//
+// MEMORY_MAP_NODE
+//
+// Red-black tree node embedded in a memory map entry.  The nodes index the
+// entries of gMemoryMap by start address without allocating any memory.
+//
+typedef struct _MEMORY_MAP_NODE MEMORY_MAP_NODE;
+struct _MEMORY_MAP_NODE {
+  MEMORY_MAP_NODE *Parent;
+  MEMORY_MAP_NODE *Left;
+  MEMORY_MAP_NODE *Right;
+  BOOLEAN         Red;
+};
+
+typedef struct {
+  MEMORY_MAP_NODE *Root;
+  UINTN           NodeOffset;   // Offset of the node in MEMORY_MAP
+} MEMORY_MAP_INDEX;
+
 //
 // MEMORY_MAP_ENTRY
 //
@@ -41,6 +60,9 @@ typedef struct {
 
   UINT64          VirtualStart;
   UINT64          Attribute;
+
+  MEMORY_MAP_NODE AddressNode;  // Node in mMemoryMapAddressIndex
+  MEMORY_MAP_NODE FreeNode;     // Node in mMemoryMapFreeIndex, free entries only
 } MEMORY_MAP;
 
 //
@@ -123,6 +145,22 @@ CoreFreePoolI (
   );
 
 
+/**
+  Get the pool allocator statistics of the memory types below
+  EfiMaxMemoryType, as MEMORY_PROFILE_POOL_INFO records.
+
+  @param  PoolInfo               Buffer to receive the records, or NULL to only
+                                 return the size of the records.
+
+  @return The size in bytes of the records.
+
+**/
+UINTN
+CoreGetPoolProfileInfo (
+  OUT MEMORY_PROFILE_POOL_INFO  *PoolInfo OPTIONAL
+  );
+
+
 
 /**
   Enter critical section by gaining lock on gMemoryLock.
@@ -1455,6 +1455,8 @@ MemoryProfileGetDataSize (
     }
   }
 
+  TotalSize += CoreGetPoolProfileInfo (NULL);
+
   return TotalSize;
 }
 
@@ -1528,6 +1530,8 @@ MemoryProfileCopyData (
 
     DriverInfo = (MEMORY_PROFILE_DRIVER_INFO *)  AllocInfo;
   }
+
+  CoreGetPoolProfileInfo ((MEMORY_PROFILE_POOL_INFO *) DriverInfo);
 }
 
 /**
@@ -44,6 +44,14 @@ UINTN         mFreeMapStack = 0;
 ///
 LIST_ENTRY   mFreeMemoryMapEntryList = INITIALIZE_LIST_HEAD_VARIABLE (mFreeMemoryMapEntryList);
 BOOLEAN      mMemoryTypeInformationInitialized = FALSE;
+///
+/// Indexes of gMemoryMap ordered by start address.  gMemoryMap itself keeps
+/// its order, which is the order GetMemoryMap() reports the descriptors in.
+/// mMemoryMapAddressIndex holds all entries, mMemoryMapFreeIndex only the
+/// EfiConventionalMemory ones.
+///
+MEMORY_MAP_INDEX mMemoryMapAddressIndex = { NULL, OFFSET_OF (MEMORY_MAP, AddressNode) };
+MEMORY_MAP_INDEX mMemoryMapFreeIndex    = { NULL, OFFSET_OF (MEMORY_MAP, FreeNode) };
 
 EFI_MEMORY_TYPE_STATISTICS mMemoryTypeStatistics[EfiMaxMemoryType + 1] = {
   { 0, MAX_ALLOC_ADDRESS, 0, 0, EfiMaxMemoryType, TRUE,  FALSE },  // EfiReservedMemoryType
@@ -120,6 +128,521 @@ CoreReleaseMemoryLock (
 
 
 
+/**
+  Internal function.  Returns the memory map entry that contains a node of
+  the given index.
+
+  @param  Index                  The memory map index the node belongs to
+  @param  Node                   The node of the index
+
+  @return The memory map entry that contains Node
+
+**/
+STATIC
+MEMORY_MAP *
+MemoryMapIndexEntry (
+  IN MEMORY_MAP_INDEX  *Index,
+  IN MEMORY_MAP_NODE   *Node
+  )
+{
+  return (MEMORY_MAP *)((UINT8 *)Node - Index->NodeOffset);
+}
+
+/**
+  Internal function.  Returns the node of the given index that is embedded in
+  a memory map entry.
+
+  @param  Index                  The memory map index
+  @param  Entry                  The memory map entry
+
+  @return The node of Index embedded in Entry
+
+**/
+STATIC
+MEMORY_MAP_NODE *
+MemoryMapIndexNode (
+  IN MEMORY_MAP_INDEX  *Index,
+  IN MEMORY_MAP        *Entry
+  )
+{
+  return (MEMORY_MAP_NODE *)((UINT8 *)Entry + Index->NodeOffset);
+}
+
+/**
+  Internal function.  Makes NewChild take the place of OldChild below Parent.
+
+  @param  Index                  The memory map index
+  @param  Parent                 The parent of OldChild, or NULL if OldChild is
+                                 the root
+  @param  OldChild               The node being replaced
+  @param  NewChild               The node replacing OldChild, may be NULL
+
+**/
+STATIC
+VOID
+MemoryMapIndexReplaceChild (
+  IN OUT MEMORY_MAP_INDEX  *Index,
+  IN OUT MEMORY_MAP_NODE   *Parent,
+  IN     MEMORY_MAP_NODE   *OldChild,
+  IN     MEMORY_MAP_NODE   *NewChild
+  )
+{
+  if (Parent == NULL) {
+    Index->Root = NewChild;
+  } else if (Parent->Left == OldChild) {
+    Parent->Left = NewChild;
+  } else {
+    Parent->Right = NewChild;
+  }
+}
+
+/**
+  Internal function.  Rotates the subtree rooted at Node to the left.
+
+  @param  Index                  The memory map index
+  @param  Node                   The root of the subtree, must have a right child
+
+**/
+STATIC
+VOID
+MemoryMapIndexRotateLeft (
+  IN OUT MEMORY_MAP_INDEX  *Index,
+  IN OUT MEMORY_MAP_NODE   *Node
+  )
+{
+  MEMORY_MAP_NODE  *Pivot;
+
+  Pivot       = Node->Right;
+  Node->Right = Pivot->Left;
+  if (Pivot->Left != NULL) {
+    Pivot->Left->Parent = Node;
+  }
+  Pivot->Parent = Node->Parent;
+  MemoryMapIndexReplaceChild (Index, Node->Parent, Node, Pivot);
+  Pivot->Left  = Node;
+  Node->Parent = Pivot;
+}
+
+/**
+  Internal function.  Rotates the subtree rooted at Node to the right.
+
+  @param  Index                  The memory map index
+  @param  Node                   The root of the subtree, must have a left child
+
+**/
+STATIC
+VOID
+MemoryMapIndexRotateRight (
+  IN OUT MEMORY_MAP_INDEX  *Index,
+  IN OUT MEMORY_MAP_NODE   *Node
+  )
+{
+  MEMORY_MAP_NODE  *Pivot;
+
+  Pivot      = Node->Left;
+  Node->Left = Pivot->Right;
+  if (Pivot->Right != NULL) {
+    Pivot->Right->Parent = Node;
+  }
+  Pivot->Parent = Node->Parent;
+  MemoryMapIndexReplaceChild (Index, Node->Parent, Node, Pivot);
+  Pivot->Right = Node;
+  Node->Parent = Pivot;
+}
+
+/**
+  Internal function.  Adds a memory map entry to an index. The entries of an
+  index never overlap, so they are ordered by their start address.
+
+  @param  Index                  The memory map index
+  @param  Entry                  The entry to add
+
+**/
+STATIC
+VOID
+MemoryMapIndexInsert (
+  IN OUT MEMORY_MAP_INDEX  *Index,
+  IN OUT MEMORY_MAP        *Entry
+  )
+{
+  MEMORY_MAP_NODE  *Node;
+  MEMORY_MAP_NODE  *Parent;
+  MEMORY_MAP_NODE  *GrandParent;
+  MEMORY_MAP_NODE  *Uncle;
+  MEMORY_MAP_NODE  **Link;
+
+  Node   = MemoryMapIndexNode (Index, Entry);
+  Parent = NULL;
+  Link   = &Index->Root;
+  while (*Link != NULL) {
+    Parent = *Link;
+    if (Entry->Start < MemoryMapIndexEntry (Index, Parent)->Start) {
+      Link = &Parent->Left;
+    } else {
+      Link = &Parent->Right;
+    }
+  }
+
+  Node->Parent = Parent;
+  Node->Left   = NULL;
+  Node->Right  = NULL;
+  Node->Red    = TRUE;
+  *Link        = Node;
+
+  //
+  // Restore the red-black properties
+  //
+  while ((Parent = Node->Parent) != NULL && Parent->Red) {
+    GrandParent = Parent->Parent;
+    if (Parent == GrandParent->Left) {
+      Uncle = GrandParent->Right;
+      if (Uncle != NULL && Uncle->Red) {
+        Parent->Red      = FALSE;
+        Uncle->Red       = FALSE;
+        GrandParent->Red = TRUE;
+        Node             = GrandParent;
+        continue;
+      }
+      if (Node == Parent->Right) {
+        MemoryMapIndexRotateLeft (Index, Parent);
+        Node   = Parent;
+        Parent = Node->Parent;
+      }
+      Parent->Red      = FALSE;
+      GrandParent->Red = TRUE;
+      MemoryMapIndexRotateRight (Index, GrandParent);
+    } else {
+      Uncle = GrandParent->Left;
+      if (Uncle != NULL && Uncle->Red) {
+        Parent->Red      = FALSE;
+        Uncle->Red       = FALSE;
+        GrandParent->Red = TRUE;
+        Node             = GrandParent;
+        continue;
+      }
+      if (Node == Parent->Left) {
+        MemoryMapIndexRotateRight (Index, Parent);
+        Node   = Parent;
+        Parent = Node->Parent;
+      }
+      Parent->Red      = FALSE;
+      GrandParent->Red = TRUE;
+      MemoryMapIndexRotateLeft (Index, GrandParent);
+    }
+  }
+
+  Index->Root->Red = FALSE;
+}
+
+/**
+  Internal function.  Removes a memory map entry from an index.
+
+  @param  Index                  The memory map index
+  @param  Entry                  The entry to remove
+
+**/
+STATIC
+VOID
+MemoryMapIndexRemove (
+  IN OUT MEMORY_MAP_INDEX  *Index,
+  IN OUT MEMORY_MAP        *Entry
+  )
+{
+  MEMORY_MAP_NODE  *Node;
+  MEMORY_MAP_NODE  *Target;
+  MEMORY_MAP_NODE  *Child;
+  MEMORY_MAP_NODE  *Parent;
+  MEMORY_MAP_NODE  *Sibling;
+  BOOLEAN          Red;
+
+  //
+  // Target is the node that is unlinked from the tree: Node itself, or its
+  // successor when Node has two children.
+  //
+  Node   = MemoryMapIndexNode (Index, Entry);
+  Target = Node;
+  if (Node->Left != NULL && Node->Right != NULL) {
+    Target = Node->Right;
+    while (Target->Left != NULL) {
+      Target = Target->Left;
+    }
+  }
+
+  Child  = (Target->Left != NULL) ? Target->Left : Target->Right;
+  Parent = Target->Parent;
+  Red    = Target->Red;
+  if (Child != NULL) {
+    Child->Parent = Parent;
+  }
+  MemoryMapIndexReplaceChild (Index, Parent, Target, Child);
+
+  if (Target != Node) {
+    //
+    // Move the successor into the place of Node
+    //
+    if (Parent == Node) {
+      Parent = Target;
+    }
+    Target->Parent = Node->Parent;
+    Target->Left   = Node->Left;
+    Target->Right  = Node->Right;
+    Target->Red    = Node->Red;
+    MemoryMapIndexReplaceChild (Index, Node->Parent, Node, Target);
+    if (Target->Left != NULL) {
+      Target->Left->Parent = Target;
+    }
+    if (Target->Right != NULL) {
+      Target->Right->Parent = Target;
+    }
+  }
+
+  if (Red) {
+    return;
+  }
+
+  //
+  // A black node was unlinked, restore the red-black properties
+  //
+  Node = Child;
+  while (Node != Index->Root && (Node == NULL || !Node->Red)) {
+    if (Node == Parent->Left) {
+      Sibling = Parent->Right;
+      if (Sibling->Red) {
+        Sibling->Red = FALSE;
+        Parent->Red  = TRUE;
+        MemoryMapIndexRotateLeft (Index, Parent);
+        Sibling = Parent->Right;
+      }
+      if ((Sibling->Left == NULL || !Sibling->Left->Red) &&
+          (Sibling->Right == NULL || !Sibling->Right->Red)) {
+        Sibling->Red = TRUE;
+        Node         = Parent;
+        Parent       = Node->Parent;
+      } else {
+        if (Sibling->Right == NULL || !Sibling->Right->Red) {
+          Sibling->Left->Red = FALSE;
+          Sibling->Red       = TRUE;
+          MemoryMapIndexRotateRight (Index, Sibling);
+          Sibling = Parent->Right;
+        }
+        Sibling->Red        = Parent->Red;
+        Parent->Red         = FALSE;
+        Sibling->Right->Red = FALSE;
+        MemoryMapIndexRotateLeft (Index, Parent);
+        Node = Index->Root;
+      }
+    } else {
+      Sibling = Parent->Left;
+      if (Sibling->Red) {
+        Sibling->Red = FALSE;
+        Parent->Red  = TRUE;
+        MemoryMapIndexRotateRight (Index, Parent);
+        Sibling = Parent->Left;
+      }
+      if ((Sibling->Left == NULL || !Sibling->Left->Red) &&
+          (Sibling->Right == NULL || !Sibling->Right->Red)) {
+        Sibling->Red = TRUE;
+        Node         = Parent;
+        Parent       = Node->Parent;
+      } else {
+        if (Sibling->Left == NULL || !Sibling->Left->Red) {
+          Sibling->Right->Red = FALSE;
+          Sibling->Red        = TRUE;
+          MemoryMapIndexRotateLeft (Index, Sibling);
+          Sibling = Parent->Left;
+        }
+        Sibling->Red       = Parent->Red;
+        Parent->Red        = FALSE;
+        Sibling->Left->Red = FALSE;
+        MemoryMapIndexRotateRight (Index, Parent);
+        Node = Index->Root;
+      }
+    }
+  }
+
+  if (Node != NULL) {
+    Node->Red = FALSE;
+  }
+}
+
+/**
+  Internal function.  Makes NewEntry take the place of OldEntry in an index.
+  NewEntry must be a copy of OldEntry, as done when an entry moves from the
+  temporary descriptor stack to heap.
+
+  @param  Index                  The memory map index
+  @param  OldEntry               The entry that is on the index
+  @param  NewEntry               The copy of OldEntry that replaces it
+
+**/
+STATIC
+VOID
+MemoryMapIndexReplace (
+  IN OUT MEMORY_MAP_INDEX  *Index,
+  IN     MEMORY_MAP        *OldEntry,
+  IN OUT MEMORY_MAP        *NewEntry
+  )
+{
+  MEMORY_MAP_NODE  *Node;
+
+  Node = MemoryMapIndexNode (Index, NewEntry);
+  MemoryMapIndexReplaceChild (Index, Node->Parent, MemoryMapIndexNode (Index, OldEntry), Node);
+  if (Node->Left != NULL) {
+    Node->Left->Parent = Node;
+  }
+  if (Node->Right != NULL) {
+    Node->Right->Parent = Node;
+  }
+}
+
+/**
+  Internal function.  Finds the entry of an index with the highest start
+  address that is not above Address.
+
+  @param  Index                  The memory map index
+  @param  Address                The address to look up
+
+  @return The entry found, or NULL if all entries start above Address
+
+**/
+STATIC
+MEMORY_MAP *
+MemoryMapIndexFloor (
+  IN MEMORY_MAP_INDEX      *Index,
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  MEMORY_MAP_NODE  *Node;
+  MEMORY_MAP       *Entry;
+  MEMORY_MAP       *Found;
+
+  Found = NULL;
+  Node  = Index->Root;
+  while (Node != NULL) {
+    Entry = MemoryMapIndexEntry (Index, Node);
+    if (Entry->Start <= Address) {
+      Found = Entry;
+      Node  = Node->Right;
+    } else {
+      Node = Node->Left;
+    }
+  }
+
+  return Found;
+}
+
+/**
+  Internal function.  Returns the entry of an index that precedes Entry in
+  address order.
+
+  @param  Index                  The memory map index
+  @param  Entry                  An entry on the index
+
+  @return The previous entry, or NULL if Entry is the lowest one
+
+**/
+STATIC
+MEMORY_MAP *
+MemoryMapIndexPrevious (
+  IN MEMORY_MAP_INDEX  *Index,
+  IN MEMORY_MAP        *Entry
+  )
+{
+  MEMORY_MAP_NODE  *Node;
+
+  Node = MemoryMapIndexNode (Index, Entry);
+  if (Node->Left != NULL) {
+    Node = Node->Left;
+    while (Node->Right != NULL) {
+      Node = Node->Right;
+    }
+    return MemoryMapIndexEntry (Index, Node);
+  }
+
+  while (Node->Parent != NULL && Node == Node->Parent->Left) {
+    Node = Node->Parent;
+  }
+
+  return (Node->Parent != NULL) ? MemoryMapIndexEntry (Index, Node->Parent) : NULL;
+}
+
+/**
+  Internal function.  Returns the entry of an index that follows Entry in
+  address order.
+
+  @param  Index                  The memory map index
+  @param  Entry                  An entry on the index
+
+  @return The next entry, or NULL if Entry is the highest one
+
+**/
+STATIC
+MEMORY_MAP *
+MemoryMapIndexNext (
+  IN MEMORY_MAP_INDEX  *Index,
+  IN MEMORY_MAP        *Entry
+  )
+{
+  MEMORY_MAP_NODE  *Node;
+
+  Node = MemoryMapIndexNode (Index, Entry);
+  if (Node->Right != NULL) {
+    Node = Node->Right;
+    while (Node->Left != NULL) {
+      Node = Node->Left;
+    }
+    return MemoryMapIndexEntry (Index, Node);
+  }
+
+  while (Node->Parent != NULL && Node == Node->Parent->Right) {
+    Node = Node->Parent;
+  }
+
+  return (Node->Parent != NULL) ? MemoryMapIndexEntry (Index, Node->Parent) : NULL;
+}
+
+/**
+  Internal function.  Adds a descriptor entry to the end of the memory map
+  and to the memory map indexes.
+
+  @param  Entry                  The entry to add
+
+**/
+VOID
+InsertMemoryMapEntry (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  InsertTailList (&gMemoryMap, &Entry->Link);
+
+  MemoryMapIndexInsert (&mMemoryMapAddressIndex, Entry);
+  if (Entry->Type == EfiConventionalMemory) {
+    MemoryMapIndexInsert (&mMemoryMapFreeIndex, Entry);
+  }
+}
+
+/**
+  Internal function.  Finds the descriptor entry that covers an address.
+
+  @param  Address                The address to look up
+
+  @return The entry covering Address, or NULL if there is none
+
+**/
+MEMORY_MAP *
+FindMemoryMapEntry (
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  MEMORY_MAP      *Entry;
+
+  Entry = MemoryMapIndexFloor (&mMemoryMapAddressIndex, Address);
+  if (Entry != NULL && Entry->End > Address) {
+    return Entry;
+  }
+
+  return NULL;
+}
 
 /**
   Internal function.  Removes a descriptor entry.
@@ -132,6 +655,11 @@ RemoveMemoryMapEntry (
   IN OUT MEMORY_MAP      *Entry
   )
 {
+  MemoryMapIndexRemove (&mMemoryMapAddressIndex, Entry);
+  if (Entry->Type == EfiConventionalMemory) {
+    MemoryMapIndexRemove (&mMemoryMapFreeIndex, Entry);
+  }
+
   RemoveEntryList (&Entry->Link);
   Entry->Link.ForwardLink = NULL;
 
@@ -163,7 +691,6 @@ CoreAddRange (
   IN UINT64                   Attribute
   )
 {
-  LIST_ENTRY        *Link;
   MEMORY_MAP        *Entry;
 
   ASSERT ((Start & EFI_PAGE_MASK) == 0);
@@ -209,32 +736,26 @@ CoreAddRange (
   //
 
   // Two memory descriptors can only be merged if they have the same Type
-  // and the same Attribute
+  // and the same Attribute.  The only candidates are the descriptors that
+  // cover the page just below Start and the page just above End.
   //
 
-  Link = gMemoryMap.ForwardLink;
-  while (Link != &gMemoryMap) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    Link  = Link->ForwardLink;
-
-    if (Entry->Type != Type) {
-      continue;
-    }
-
-    if (Entry->Attribute != Attribute) {
-      continue;
-    }
-
-    if (Entry->End + 1 == Start) {
+  Entry = MemoryMapIndexFloor (&mMemoryMapAddressIndex, Start - 1);
+  if (Start != 0 && Entry != NULL &&
+      Entry->Type == Type && Entry->Attribute == Attribute &&
+      Entry->End + 1 == Start) {
 
-      Start = Entry->Start;
-      RemoveMemoryMapEntry (Entry);
+    Start = Entry->Start;
+    RemoveMemoryMapEntry (Entry);
+  }
 
-    } else if (Entry->Start == End + 1) {
+  Entry = MemoryMapIndexFloor (&mMemoryMapAddressIndex, End + 1);
+  if (End != MAX_UINT64 && Entry != NULL &&
+      Entry->Type == Type && Entry->Attribute == Attribute &&
+      Entry->Start == End + 1) {
 
-      End = Entry->End;
-      RemoveMemoryMapEntry (Entry);
-    }
+    End = Entry->End;
+    RemoveMemoryMapEntry (Entry);
   }
 
   //
@@ -248,7 +769,7 @@ CoreAddRange (
   mMapStack[mMapDepth].End           = End;
   mMapStack[mMapDepth].VirtualStart  = 0;
   mMapStack[mMapDepth].Attribute     = Attribute;
-  InsertTailList (&gMemoryMap, &mMapStack[mMapDepth].Link);
+  InsertMemoryMapEntry (&mMapStack[mMapDepth]);
 
   mMapDepth += 1;
   ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -362,12 +883,22 @@ CoreFreeMemoryMapStack (
       CopyMem (Entry , &mMapStack[mMapDepth], sizeof (MEMORY_MAP));
       Entry->FromPages = TRUE;
 
+      MemoryMapIndexReplace (&mMemoryMapAddressIndex, &mMapStack[mMapDepth], Entry);
+      if (Entry->Type == EfiConventionalMemory) {
+        MemoryMapIndexReplace (&mMemoryMapFreeIndex, &mMapStack[mMapDepth], Entry);
+      }
+
       //
-      // Find insertion location
+      // Find insertion location.  The entries from pages are kept sorted in
+      // gMemoryMap, so the entry goes before the next one from pages in
+      // address order.
       //
-      for (Link2 = gMemoryMap.ForwardLink; Link2 != &gMemoryMap; Link2 = Link2->ForwardLink) {
-        Entry2 = CR (Link2, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-        if (Entry2->FromPages && Entry2->Start > Entry->Start) {
+      Link2 = &gMemoryMap;
+      for (Entry2 = MemoryMapIndexNext (&mMemoryMapAddressIndex, Entry);
+           Entry2 != NULL;
+           Entry2 = MemoryMapIndexNext (&mMemoryMapAddressIndex, Entry2)) {
+        if (Entry2->FromPages) {
+          Link2 = &Entry2->Link;
           break;
         }
       }
@@ -736,7 +1267,6 @@ CoreConvertPagesEx (
   UINT64          RangeEnd;
   UINT64          Attribute;
   EFI_MEMORY_TYPE MemType;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
 
   Entry = NULL;
@@ -762,15 +1292,8 @@ CoreConvertPagesEx (
     //
     // Find the entry that the covers the range
     //
-    for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-      Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-
-      if (Entry->Start <= Start && Entry->End > Start) {
-        break;
-      }
-    }
-
-    if (Link == &gMemoryMap) {
+    Entry = FindMemoryMapEntry (Start);
+    if (Entry == NULL) {
       DEBUG ((DEBUG_ERROR | DEBUG_PAGE, "ConvertPages: failed to find range %lx - %lx\n", Start, End));
       return EFI_NOT_FOUND;
     }
@@ -884,7 +1407,7 @@ CoreConvertPagesEx (
       ASSERT (Entry->Start < Entry->End);
 
       Entry = &mMapStack[mMapDepth];
-      InsertTailList (&gMemoryMap, &Entry->Link);
+      InsertMemoryMapEntry (Entry);
 
       mMapDepth += 1;
       ASSERT (mMapDepth < MAX_MAP_DEPTH);
@@ -1038,7 +1561,6 @@ CoreFindFreePagesI (
   UINT64          DescStart;
   UINT64          DescEnd;
   UINT64          DescNumberOfBytes;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
 
   if ((MaxAddress < EFI_PAGE_MASK) ||(NumberOfPages == 0)) {
@@ -1070,23 +1592,29 @@ CoreFindFreePagesI (
   NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
   Target = 0;
 
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+  //
+  // Walk the free entries downwards from MaxAddress.  The entries do not
+  // overlap, so the first one that fits gives the highest possible Target.
+  //
+  for (Entry = MemoryMapIndexFloor (&mMemoryMapFreeIndex, MaxAddress);
+       Entry != NULL;
+       Entry = MemoryMapIndexPrevious (&mMemoryMapFreeIndex, Entry)) {
+    ASSERT (Entry->Type == EfiConventionalMemory);
+
+    DescStart = Entry->Start;
+    DescEnd = Entry->End;
 
     //
-    // If it's not a free entry, don't bother with it
+    // If desc is below min allowed address, so are all the remaining ones
     //
-    if (Entry->Type != EfiConventionalMemory) {
-      continue;
+    if (DescEnd < MinAddress) {
+      break;
     }
 
-    DescStart = Entry->Start;
-    DescEnd = Entry->End;
-
     //
-    // If desc is past max allowed address or below min allowed address, skip it
+    // If desc is past max allowed address, skip it
     //
-    if ((DescStart >= MaxAddress) || (DescEnd < MinAddress)) {
+    if (DescStart >= MaxAddress) {
       continue;
     }
 
@@ -1112,29 +1640,26 @@ CoreFindFreePagesI (
 
     if (DescNumberOfBytes >= NumberOfBytes) {
       //
-      // If the start of the allocated range is below the min address allowed, skip it
+      // If the start of the allocated range is below the min address allowed,
+      // it is for all the remaining descriptors too
       //
       if ((DescEnd - NumberOfBytes + 1) < MinAddress) {
-        continue;
+        break;
       }
 
-      //
-      // If this is the best match so far remember it
-      //
-      if (DescEnd > Target) {
-        if (NeedGuard) {
-          DescEnd = AdjustMemoryS (
-                      DescEnd + 1 - DescNumberOfBytes,
-                      DescNumberOfBytes,
-                      NumberOfBytes
-                      );
-          if (DescEnd == 0) {
-            continue;
-          }
+      if (NeedGuard) {
+        DescEnd = AdjustMemoryS (
+                    DescEnd + 1 - DescNumberOfBytes,
+                    DescNumberOfBytes,
+                    NumberOfBytes
+                    );
+        if (DescEnd == 0) {
+          continue;
         }
-
-        Target = DescEnd;
       }
+
+      Target = DescEnd;
+      break;
     }
   }
 
@@ -1477,7 +2002,6 @@ CoreInternalFreePages (
   )
 {
   EFI_STATUS      Status;
-  LIST_ENTRY      *Link;
   MEMORY_MAP      *Entry;
   UINTN           Alignment;
   BOOLEAN         IsGuarded;
@@ -1491,14 +2015,8 @@ CoreInternalFreePages (
   // Find the entry that the covers the range
   //
   IsGuarded = FALSE;
-  Entry = NULL;
-  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
-    Entry = CR(Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
-    if (Entry->Start <= Memory && Entry->End > Memory) {
-        break;
-    }
-  }
-  if (Link == &gMemoryMap) {
+  Entry = FindMemoryMapEntry (Memory);
+  if (Entry == NULL) {
     Status = EFI_NOT_FOUND;
     goto Done;
   }
@@ -13,6 +13,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 STATIC EFI_LOCK mPoolMemoryLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 
 #define POOL_FREE_SIGNATURE   SIGNATURE_32('p','f','r','0')
+#define POOL_PAGE_SIGNATURE   SIGNATURE_32('p','f','p','0')
 typedef struct {
   UINT32          Signature;
   UINT32          Index;
@@ -60,6 +61,19 @@ STATIC CONST UINT16 mPoolSizeTable[] = {
 
 #define MAX_POOL_SIZE     (MAX_ADDRESS - POOL_OVERHEAD)
 
+//
+// Maximum number of empty pool pages (in units of the allocation granularity)
+// each memory type keeps for reuse, instead of freeing them to the memory map.
+// Only boot services and loader pages are cached. Pages of the types that
+// survive ExitBootServices() are freed right away, so the OS does not inherit
+// empty runtime, ACPI or OEM pages.
+//
+#define MAX_POOL_CACHED_PAGES   4
+
+#define POOL_PAGE_CACHEABLE(Type) \
+  (((Type) == EfiBootServicesData) || ((Type) == EfiBootServicesCode) || \
+   ((Type) == EfiLoaderData) || ((Type) == EfiLoaderCode))
+
 //
 // Globals
 //
@@ -71,6 +85,18 @@ typedef struct {
     EFI_MEMORY_TYPE  MemoryType;
     LIST_ENTRY       FreeList[MAX_POOL_LIST];
     LIST_ENTRY       Link;
+    ///
+    /// Empty pool pages kept for reuse, list of POOL_FREE with POOL_PAGE_SIGNATURE
+    ///
+    LIST_ENTRY       FreePages;
+    UINTN            FreePageCount;
+    ///
+    /// Allocation statistics reported through the memory profile
+    ///
+    UINTN            Pages;
+    UINT64           PageReuseCount;
+    UINT64           Hits[MAX_POOL_LIST];
+    UINT64           Misses[MAX_POOL_LIST];
 } POOL;
 
 //
@@ -120,12 +146,12 @@ CoreInitializePool (
   UINTN  Index;
 
   for (Type=0; Type < EfiMaxMemoryType; Type++) {
-    mPoolHead[Type].Signature  = 0;
-    mPoolHead[Type].Used       = 0;
+    ZeroMem (&mPoolHead[Type], sizeof (POOL));
     mPoolHead[Type].MemoryType = (EFI_MEMORY_TYPE) Type;
     for (Index=0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&mPoolHead[Type].FreeList[Index]);
     }
+    InitializeListHead (&mPoolHead[Type].FreePages);
   }
 }
 
@@ -170,12 +196,13 @@ LookupPoolHead (
       return NULL;
     }
 
+    ZeroMem (Pool, sizeof (POOL));
     Pool->Signature = POOL_SIGNATURE;
-    Pool->Used      = 0;
     Pool->MemoryType = MemoryType;
     for (Index=0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&Pool->FreeList[Index]);
     }
+    InitializeListHead (&Pool->FreePages);
 
     InsertHeadList (&mPoolHeadList, &Pool->Link);
 
@@ -421,6 +448,7 @@ CoreAllocatePoolI (
   //
   if (IsListEmpty (&Pool->FreeList[Index])) {
 
+    Pool->Misses[Index]++;
     Offset = LIST_TO_SIZE (Index);
     MaxOffset = Granularity;
 
@@ -437,6 +465,19 @@ CoreAllocatePoolI (
       }
     }
 
+    //
+    // Reuse a cached empty page if there is one, this avoids a round trip
+    // through the memory map
+    //
+    if (!IsListEmpty (&Pool->FreePages)) {
+      Free = CR (Pool->FreePages.ForwardLink, POOL_FREE, Link, POOL_PAGE_SIGNATURE);
+      RemoveEntryList (&Free->Link);
+      Pool->FreePageCount--;
+      Pool->PageReuseCount++;
+      NewPage = (VOID *) Free;
+      goto Carve;
+    }
+
     //
     // Get another page
     //
@@ -445,6 +486,7 @@ CoreAllocatePoolI (
     if (NewPage == NULL) {
       goto Done;
     }
+    Pool->Pages += EFI_SIZE_TO_PAGES (Granularity);
 
     //
     // Serve the allocation request from the head of the allocated block
@@ -477,6 +519,7 @@ Carve:
   //
   // Remove entry from free pool list
   //
+  Pool->Hits[Index]++;
   Free = CR (Pool->FreeList[Index].ForwardLink, POOL_FREE, Link, POOL_FREE_SIGNATURE);
   RemoveEntryList (&Free->Link);
 
@@ -834,10 +877,21 @@ CoreFreePoolI (
         }
 
         //
-        // Free the page
+        // Keep the page for reuse by this memory type, or free it if the type
+        // is not cached or there are enough cached pages already
         //
-        CoreFreePoolPagesI (Pool->MemoryType, (EFI_PHYSICAL_ADDRESS) (UINTN)NewPage,
-          EFI_SIZE_TO_PAGES (Granularity));
+        if (POOL_PAGE_CACHEABLE (Pool->MemoryType) &&
+            (Pool->FreePageCount < MAX_POOL_CACHED_PAGES)) {
+          Free = (POOL_FREE *) &NewPage[0];
+          Free->Signature = POOL_PAGE_SIGNATURE;
+          Free->Index     = 0;
+          InsertHeadList (&Pool->FreePages, &Free->Link);
+          Pool->FreePageCount++;
+        } else {
+          Pool->Pages -= EFI_SIZE_TO_PAGES (Granularity);
+          CoreFreePoolPagesI (Pool->MemoryType, (EFI_PHYSICAL_ADDRESS) (UINTN)NewPage,
+            EFI_SIZE_TO_PAGES (Granularity));
+        }
       }
     }
   }
@@ -848,6 +902,7 @@ CoreFreePoolI (
   // list entry for that memory type
   //
   if (((UINT32) Pool->MemoryType >= MEMORY_TYPE_OEM_RESERVED_MIN) && Pool->Used == 0) {
+    ASSERT (IsListEmpty (&Pool->FreePages));
     RemoveEntryList (&Pool->Link);
     CoreFreePoolI (Pool, NULL);
   }
@@ -855,3 +910,65 @@ CoreFreePoolI (
   return EFI_SUCCESS;
 }
 
+/**
+  Get the pool allocator statistics of the memory types below
+  EfiMaxMemoryType, as MEMORY_PROFILE_POOL_INFO records.
+
+  @param  PoolInfo               Buffer to receive the records, or NULL to only
+                                 return the size of the records.
+
+  @return The size in bytes of the records.
+
+**/
+UINTN
+CoreGetPoolProfileInfo (
+  OUT MEMORY_PROFILE_POOL_INFO  *PoolInfo OPTIONAL
+  )
+{
+  POOL                        *Pool;
+  MEMORY_PROFILE_POOL_BUCKET  *Bucket;
+  LIST_ENTRY                  *Link;
+  UINTN                       RecordSize;
+  UINTN                       Type;
+  UINTN                       Index;
+
+  RecordSize = sizeof (MEMORY_PROFILE_POOL_INFO) +
+               MAX_POOL_LIST * sizeof (MEMORY_PROFILE_POOL_BUCKET);
+  if (PoolInfo == NULL) {
+    return EfiMaxMemoryType * RecordSize;
+  }
+
+  CoreAcquireLock (&mPoolMemoryLock);
+  for (Type = 0; Type < EfiMaxMemoryType; Type++) {
+    Pool = &mPoolHead[Type];
+
+    PoolInfo->Header.Signature      = MEMORY_PROFILE_POOL_INFO_SIGNATURE;
+    PoolInfo->Header.Length         = (UINT16) RecordSize;
+    PoolInfo->Header.Revision       = MEMORY_PROFILE_POOL_INFO_REVISION;
+    PoolInfo->MemoryType            = (UINT32) Type;
+    PoolInfo->BucketCount           = MAX_POOL_LIST;
+    PoolInfo->UsedSize              = Pool->Used;
+    PoolInfo->PoolPages             = Pool->Pages;
+    PoolInfo->CachedPages           = Pool->FreePageCount;
+    PoolInfo->CachedPageReuseCount  = Pool->PageReuseCount;
+
+    Bucket = (MEMORY_PROFILE_POOL_BUCKET *) (PoolInfo + 1);
+    for (Index = 0; Index < MAX_POOL_LIST; Index++) {
+      Bucket[Index].BlockSize      = LIST_TO_SIZE (Index);
+      Bucket[Index].Reserved       = 0;
+      Bucket[Index].HitCount       = Pool->Hits[Index];
+      Bucket[Index].MissCount      = Pool->Misses[Index];
+      Bucket[Index].FreeBlockCount = 0;
+      for (Link = Pool->FreeList[Index].ForwardLink;
+           Link != &Pool->FreeList[Index];
+           Link = Link->ForwardLink) {
+        Bucket[Index].FreeBlockCount++;
+      }
+    }
+
+    PoolInfo = (MEMORY_PROFILE_POOL_INFO *) ((UINTN) PoolInfo + RecordSize);
+  }
+  CoreReleaseLock (&mPoolMemoryLock);
+
+  return EfiMaxMemoryType * RecordSize;
+}
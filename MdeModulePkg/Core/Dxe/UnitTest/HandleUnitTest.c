@@ -0,0 +1,562 @@
+/** @file
+  Host based unit tests of the DXE Core handle and protocol database lookups.
+
+  The real Hand/Handle.c is linked against the stubs below, so the hash
+  indexes used by CoreValidateHandle() and CoreFindProtocolEntry() are
+  exercised exactly as they are in the DXE Core.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "DxeMain.h"
+#include "Hand/Handle.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "DxeCore Handle Database Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define HANDLE_TEST_COUNT         10000
+#define PROTOCOL_TEST_COUNT       1000
+
+EFI_HANDLE  gDxeCoreImageHandle = NULL;
+EFI_GUID    gEfiDevicePathProtocolGuid = EFI_DEVICE_PATH_PROTOCOL_GUID;
+
+//
+// Handles created by the tests, and the GUIDs installed on them
+//
+EFI_HANDLE  mTestHandles[HANDLE_TEST_COUNT];
+EFI_GUID    mTestGuids[PROTOCOL_TEST_COUNT];
+UINT32      mTestInterface;
+
+/**
+  Stub of CoreRaiseTpl(). The host tests run at a single TPL.
+
+  @param  NewTpl  New, higher, task priority level
+
+  @return The previous task priority level
+
+**/
+EFI_TPL
+EFIAPI
+CoreRaiseTpl (
+  IN EFI_TPL      NewTpl
+  )
+{
+  return TPL_APPLICATION;
+}
+
+/**
+  Stub of CoreRestoreTpl().
+
+  @param  NewTpl  New, lower, task priority level
+
+**/
+VOID
+EFIAPI
+CoreRestoreTpl (
+  IN EFI_TPL NewTpl
+  )
+{
+}
+
+/**
+  Stub of CoreFreePool() that returns the buffer to the host heap.
+
+  @param  Buffer  The allocated pool entry to free
+
+  @retval EFI_SUCCESS  Pool successfully freed.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of CoreNotifyProtocolEntry(). No protocol notify is registered by the
+  tests.
+
+  @param  ProtEntry  The protocol to notify
+
+**/
+VOID
+CoreNotifyProtocolEntry (
+  IN PROTOCOL_ENTRY   *ProtEntry
+  )
+{
+}
+
+/**
+  Stub of CoreRemoveInterfaceFromProtocol(). No protocol notify is registered
+  by the tests, so there is no notify position to update.
+
+  @param  Handle     The handle to remove the interface from
+  @param  Protocol   The protocol to remove
+  @param  Interface  The interface to remove
+
+  @return The protocol interface removed from the handle
+
+**/
+PROTOCOL_INTERFACE *
+CoreRemoveInterfaceFromProtocol (
+  IN IHANDLE        *Handle,
+  IN EFI_GUID       *Protocol,
+  IN VOID           *Interface
+  )
+{
+  PROTOCOL_INTERFACE  *Prot;
+
+  Prot = CoreFindProtocolInterface (Handle, Protocol, Interface);
+  if (Prot != NULL) {
+    RemoveEntryList (&Prot->ByProtocol);
+  }
+  return Prot;
+}
+
+/**
+  Stub of CoreConnectController(). No driver is connected by the tests.
+
+  @param  ControllerHandle     The handle of the controller
+  @param  DriverImageHandle    Not used
+  @param  RemainingDevicePath  Not used
+  @param  Recursive            Not used
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreConnectController (
+  IN  EFI_HANDLE                ControllerHandle,
+  IN  EFI_HANDLE                *DriverImageHandle    OPTIONAL,
+  IN  EFI_DEVICE_PATH_PROTOCOL  *RemainingDevicePath  OPTIONAL,
+  IN  BOOLEAN                   Recursive
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of CoreDisconnectController(). No driver is connected by the tests.
+
+  @param  ControllerHandle   The handle of the controller
+  @param  DriverImageHandle  Not used
+  @param  ChildHandle        Not used
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreDisconnectController (
+  IN  EFI_HANDLE  ControllerHandle,
+  IN  EFI_HANDLE  DriverImageHandle  OPTIONAL,
+  IN  EFI_HANDLE  ChildHandle        OPTIONAL
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of CoreLocateDevicePath(). The tests never install a device path.
+
+  @param  Protocol    Not used
+  @param  DevicePath  Not used
+  @param  Device      Not used
+
+  @retval EFI_NOT_FOUND  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreLocateDevicePath (
+  IN     EFI_GUID                       *Protocol,
+  IN OUT EFI_DEVICE_PATH_PROTOCOL       **DevicePath,
+  OUT    EFI_HANDLE                     *Device
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Stub of IsDevicePathEnd(). The tests never install a device path.
+
+  @param  Node  Not used
+
+  @retval TRUE  Always.
+
+**/
+BOOLEAN
+EFIAPI
+IsDevicePathEnd (
+  IN CONST VOID  *Node
+  )
+{
+  return TRUE;
+}
+
+/**
+  Fill mTestGuids with distinct GUIDs that differ only in a few bytes, which
+  is the worst case for a GUID hash.
+
+**/
+VOID
+InitTestGuids (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < PROTOCOL_TEST_COUNT; Index++) {
+    ZeroMem (&mTestGuids[Index], sizeof (EFI_GUID));
+    mTestGuids[Index].Data1    = 0x12345678;
+    mTestGuids[Index].Data4[6] = (UINT8) Index;
+    mTestGuids[Index].Data4[7] = (UINT8) (Index >> 8);
+  }
+}
+
+/**
+  Install one protocol on HANDLE_TEST_COUNT new handles, cycling through the
+  test GUIDs.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             All handles were created.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A handle could not be created.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CreateTestHandles (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+
+  for (Index = 0; Index < HANDLE_TEST_COUNT; Index++) {
+    mTestHandles[Index] = NULL;
+    Status = CoreInstallProtocolInterface (
+               &mTestHandles[Index],
+               &mTestGuids[Index % PROTOCOL_TEST_COUNT],
+               EFI_NATIVE_INTERFACE,
+               &mTestInterface
+               );
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_NOT_NULL (mTestHandles[Index]);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Every created handle is found by CoreValidateHandle(), and pointers that are
+  not handles are rejected.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The lookups returned the expected results.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ValidateHandleShouldFindAllHandles (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+  VOID   *NotAHandle;
+
+  for (Index = 0; Index < HANDLE_TEST_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreValidateHandle (mTestHandles[Index]));
+  }
+
+  NotAHandle = AllocateZeroPool (sizeof (IHANDLE));
+  UT_ASSERT_NOT_NULL (NotAHandle);
+  UT_ASSERT_STATUS_EQUAL (CoreValidateHandle (NotAHandle), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (CoreValidateHandle (&mTestInterface), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (CoreValidateHandle (NULL), EFI_INVALID_PARAMETER);
+  FreePool (NotAHandle);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  CoreFindProtocolEntry() finds every installed GUID, returns the same entry
+  on every lookup, and only creates entries when asked to.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The lookups returned the expected results.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FindProtocolEntryShouldFindAllProtocols (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN           Index;
+  PROTOCOL_ENTRY  *ProtEntry;
+  PROTOCOL_ENTRY  *Again;
+  EFI_GUID        Unknown;
+
+  CoreAcquireProtocolLock ();
+  for (Index = 0; Index < PROTOCOL_TEST_COUNT; Index++) {
+    ProtEntry = CoreFindProtocolEntry (&mTestGuids[Index], FALSE);
+    UT_ASSERT_NOT_NULL (ProtEntry);
+    UT_ASSERT_TRUE (CompareGuid (&ProtEntry->ProtocolID, &mTestGuids[Index]));
+    Again = CoreFindProtocolEntry (&mTestGuids[Index], TRUE);
+    UT_ASSERT_TRUE (Again == ProtEntry);
+  }
+
+  CopyGuid (&Unknown, &mTestGuids[0]);
+  Unknown.Data1 = 0x87654321;
+  UT_ASSERT_TRUE (CoreFindProtocolEntry (&Unknown, FALSE) == NULL);
+  ProtEntry = CoreFindProtocolEntry (&Unknown, TRUE);
+  UT_ASSERT_NOT_NULL (ProtEntry);
+  UT_ASSERT_TRUE (CoreFindProtocolEntry (&Unknown, FALSE) == ProtEntry);
+  CoreReleaseProtocolLock ();
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Uninstall the protocol from every other handle. The handles lose their last
+  protocol and are freed, so they must no longer validate, while the other
+  handles and all protocol entries must still be found.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The lookups returned the expected results.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RemovedHandlesShouldNotValidate (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  VOID        *Interface;
+
+  for (Index = 0; Index < HANDLE_TEST_COUNT; Index += 2) {
+    Status = CoreUninstallProtocolInterface (
+               mTestHandles[Index],
+               &mTestGuids[Index % PROTOCOL_TEST_COUNT],
+               &mTestInterface
+               );
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+
+  //
+  // The removed handles have been freed. CoreValidateHandle() only compares
+  // the pointer against the index, so it is safe to pass them in.
+  //
+  for (Index = 0; Index < HANDLE_TEST_COUNT; Index++) {
+    if ((Index % 2) == 0) {
+      UT_ASSERT_STATUS_EQUAL (CoreValidateHandle (mTestHandles[Index]), EFI_INVALID_PARAMETER);
+    } else {
+      UT_ASSERT_NOT_EFI_ERROR (CoreValidateHandle (mTestHandles[Index]));
+      Status = CoreHandleProtocol (
+                 mTestHandles[Index],
+                 &mTestGuids[Index % PROTOCOL_TEST_COUNT],
+                 &Interface
+                 );
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+      UT_ASSERT_TRUE (Interface == &mTestInterface);
+    }
+  }
+
+  CoreAcquireProtocolLock ();
+  for (Index = 0; Index < PROTOCOL_TEST_COUNT; Index++) {
+    UT_ASSERT_NOT_NULL (CoreFindProtocolEntry (&mTestGuids[Index], FALSE));
+  }
+  CoreReleaseProtocolLock ();
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Uninstalling an interface that is still on a handle with other protocols
+  keeps the handle, and the removed protocol is no longer reported on it.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The lookups returned the expected results.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RemovedProtocolShouldNotBeFoundOnHandle (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  EFI_HANDLE  Handle;
+  VOID        *Interface;
+
+  Handle = mTestHandles[1];
+  Status = CoreInstallProtocolInterface (&Handle, &mTestGuids[2], EFI_NATIVE_INTERFACE, &mTestInterface);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (Handle == mTestHandles[1]);
+
+  Status = CoreUninstallProtocolInterface (Handle, &mTestGuids[1], &mTestInterface);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_NOT_EFI_ERROR (CoreValidateHandle (Handle));
+  UT_ASSERT_STATUS_EQUAL (CoreHandleProtocol (Handle, &mTestGuids[1], &Interface), EFI_UNSUPPORTED);
+  UT_ASSERT_NOT_EFI_ERROR (CoreHandleProtocol (Handle, &mTestGuids[2], &Interface));
+
+  Status = CoreUninstallProtocolInterface (Handle, &mTestGuids[2], &mTestInterface);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_STATUS_EQUAL (CoreValidateHandle (Handle), EFI_INVALID_PARAMETER);
+  mTestHandles[1] = NULL;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Time CoreValidateHandle() and CoreHandleProtocol() over a database of
+  HANDLE_TEST_COUNT handles, and log the lookup rate.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The lookups succeeded.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+HandleLookupBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINTN       Round;
+  UINTN       Lookups;
+  VOID        *Interface;
+  clock_t     Start;
+  double      Seconds;
+
+  for (Index = 0; Index < HANDLE_TEST_COUNT; Index++) {
+    if (mTestHandles[Index] == NULL || (Index % 2) == 0) {
+      mTestHandles[Index] = NULL;
+      Status = CoreInstallProtocolInterface (
+                 &mTestHandles[Index],
+                 &mTestGuids[Index % PROTOCOL_TEST_COUNT],
+                 EFI_NATIVE_INTERFACE,
+                 &mTestInterface
+                 );
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+    }
+  }
+
+  Lookups = 0;
+  Start   = clock ();
+  for (Round = 0; Round < 10; Round++) {
+    for (Index = 0; Index < HANDLE_TEST_COUNT; Index++) {
+      Status = CoreHandleProtocol (
+                 mTestHandles[Index],
+                 &mTestGuids[Index % PROTOCOL_TEST_COUNT],
+                 &Interface
+                 );
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+      Lookups++;
+    }
+  }
+  Seconds = (double) (clock () - Start) / CLOCKS_PER_SEC;
+
+  UT_LOG_INFO (
+    "%d HandleProtocol() lookups on %d handles in %d us\n",
+    (INT32) Lookups,
+    HANDLE_TEST_COUNT,
+    (INT32) (Seconds * 1000000)
+    );
+  printf (
+    "HandleProtocol: %u lookups on %u handles, %.0f lookups/s\n",
+    (unsigned) Lookups,
+    (unsigned) HANDLE_TEST_COUNT,
+    Seconds > 0 ? Lookups / Seconds : 0
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the DXE Core
+  handle database and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      HandleTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  InitTestGuids ();
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&HandleTests, Framework, "DxeCore Handle Database Tests", "DxeCore.Handle", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for HandleTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // The test cases build on each other and must run in this order.
+  //
+  AddTestCase (HandleTests, "Install a protocol on 10000 handles", "Create", CreateTestHandles, NULL, NULL, NULL);
+  AddTestCase (HandleTests, "CoreValidateHandle should find all handles", "Validate", ValidateHandleShouldFindAllHandles, NULL, NULL, NULL);
+  AddTestCase (HandleTests, "CoreFindProtocolEntry should find all protocols", "FindProtocol", FindProtocolEntryShouldFindAllProtocols, NULL, NULL, NULL);
+  AddTestCase (HandleTests, "Removed handles should not validate", "RemoveHandle", RemovedHandlesShouldNotValidate, NULL, NULL, NULL);
+  AddTestCase (HandleTests, "Removed protocol should not be found on handle", "RemoveProtocol", RemovedProtocolShouldNotBeFoundOnHandle, NULL, NULL, NULL);
+  AddTestCase (HandleTests, "HandleProtocol lookup rate on 10000 handles", "Benchmark", HandleLookupBenchmark, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,936 @@
+/** @file
+  Host based unit tests of the DXE Core page allocator.
+
+  The real Mem/Page.c is linked against the stubs below and given a host
+  buffer as system memory. The tests check the red-black indexes of the
+  memory map against its list, check the free range search against a linear
+  scan of the list, and check that freed ranges coalesce again.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "DxeMain.h"
+#include "Imem.h"
+#include "HeapGuard.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "DxeCore Page Allocator Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// 64MB of host memory, split by a reserved range into two free ranges
+//
+#define TEST_MEMORY_PAGES         0x4000
+#define TEST_RESERVED_PAGE        0x1800
+#define TEST_RESERVED_PAGES       0x10
+
+#define TEST_ALLOCATION_COUNT     4000
+#define TEST_SEARCH_COUNT         2000
+#define TEST_BENCHMARK_COUNT      20000
+
+EFI_HANDLE                                  gDxeCoreImageHandle = NULL;
+EFI_GUID                                    gEfiEventMemoryMapChangeGuid = EFI_EVENT_GROUP_MEMORY_MAP_CHANGE;
+EFI_LOAD_FIXED_ADDRESS_CONFIGURATION_TABLE  gLoadModuleAtFixAddressConfigurationTable;
+LIST_ENTRY                                  mGcdMemorySpaceMap = INITIALIZE_LIST_HEAD_VARIABLE (mGcdMemorySpaceMap);
+BOOLEAN                                     mOnGuarding = FALSE;
+
+extern MEMORY_MAP_INDEX  mMemoryMapAddressIndex;
+extern MEMORY_MAP_INDEX  mMemoryMapFreeIndex;
+
+MEMORY_MAP *
+FindMemoryMapEntry (
+  IN EFI_PHYSICAL_ADDRESS  Address
+  );
+
+UINT64
+CoreFindFreePagesI (
+  IN UINT64           MaxAddress,
+  IN UINT64           MinAddress,
+  IN UINT64           NumberOfPages,
+  IN EFI_MEMORY_TYPE  NewType,
+  IN UINTN            Alignment,
+  IN BOOLEAN          NeedGuard
+  );
+
+//
+// The host memory given to the page allocator, and the allocations made
+//
+EFI_PHYSICAL_ADDRESS  mTestMemory;
+EFI_PHYSICAL_ADDRESS  mTestAllocations[TEST_ALLOCATION_COUNT];
+UINTN                 mTestPages[TEST_ALLOCATION_COUNT];
+UINT32                mTestRandom = 1;
+
+/**
+  Stub of CoreRaiseTpl(). The host tests run at a single TPL.
+
+  @param  NewTpl  New, higher, task priority level
+
+  @return The previous task priority level
+
+**/
+EFI_TPL
+EFIAPI
+CoreRaiseTpl (
+  IN EFI_TPL      NewTpl
+  )
+{
+  return TPL_APPLICATION;
+}
+
+/**
+  Stub of CoreRestoreTpl().
+
+  @param  NewTpl  New, lower, task priority level
+
+**/
+VOID
+EFIAPI
+CoreRestoreTpl (
+  IN EFI_TPL NewTpl
+  )
+{
+}
+
+/**
+  Stub of CoreAcquireGcdMemoryLock(). The tests have no GCD memory map.
+
+**/
+VOID
+CoreAcquireGcdMemoryLock (
+  VOID
+  )
+{
+}
+
+/**
+  Stub of CoreReleaseGcdMemoryLock(). The tests have no GCD memory map.
+
+**/
+VOID
+CoreReleaseGcdMemoryLock (
+  VOID
+  )
+{
+}
+
+/**
+  Stub of CoreGetMemorySpaceDescriptor(). The tests have no GCD memory map.
+
+  @param  BaseAddress  Not used
+  @param  Descriptor   Not used
+
+  @retval EFI_NOT_FOUND  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreGetMemorySpaceDescriptor (
+  IN  EFI_PHYSICAL_ADDRESS             BaseAddress,
+  OUT EFI_GCD_MEMORY_SPACE_DESCRIPTOR  *Descriptor
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Stub of CoreNotifySignalList(). No event is registered by the tests.
+
+  @param  EventGroup  Not used
+
+**/
+VOID
+CoreNotifySignalList (
+  IN EFI_GUID     *EventGroup
+  )
+{
+}
+
+/**
+  Stub of CoreUpdateProfile(). Memory profiling is disabled.
+
+  @param  CallerAddress  Not used
+  @param  Action         Not used
+  @param  MemoryType     Not used
+  @param  Size           Not used
+  @param  Buffer         Not used
+  @param  ActionString   Not used
+
+  @retval EFI_UNSUPPORTED  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreUpdateProfile (
+  IN EFI_PHYSICAL_ADDRESS   CallerAddress,
+  IN MEMORY_PROFILE_ACTION  Action,
+  IN EFI_MEMORY_TYPE        MemoryType,
+  IN UINTN                  Size,
+  IN VOID                   *Buffer,
+  IN CHAR8                  *ActionString OPTIONAL
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Stub of InstallMemoryAttributesTableOnMemoryAllocation().
+
+  @param  MemoryType  Not used
+
+**/
+VOID
+InstallMemoryAttributesTableOnMemoryAllocation (
+  IN EFI_MEMORY_TYPE    MemoryType
+  )
+{
+}
+
+/**
+  Stub of ApplyMemoryProtectionPolicy(). Memory protection is disabled.
+
+  @param  OldType  Not used
+  @param  NewType  Not used
+  @param  Memory   Not used
+  @param  Length   Not used
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+ApplyMemoryProtectionPolicy (
+  IN  EFI_MEMORY_TYPE       OldType,
+  IN  EFI_MEMORY_TYPE       NewType,
+  IN  EFI_PHYSICAL_ADDRESS  Memory,
+  IN  UINT64                Length
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of MergeMemoryMap(). The tests check the descriptors as the page
+  allocator returns them.
+
+  @param  MemoryMap       Not used
+  @param  MemoryMapSize   Not used
+  @param  DescriptorSize  Not used
+
+**/
+VOID
+MergeMemoryMap (
+  IN OUT EFI_MEMORY_DESCRIPTOR  *MemoryMap,
+  IN OUT UINTN                  *MemoryMapSize,
+  IN UINTN                      DescriptorSize
+  )
+{
+}
+
+/**
+  Stub of IsHeapGuardEnabled(). Heap guard is disabled.
+
+  @param  GuardType  Not used
+
+  @retval FALSE  Always.
+
+**/
+BOOLEAN
+IsHeapGuardEnabled (
+  UINT8           GuardType
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of IsPageTypeToGuard(). Heap guard is disabled.
+
+  @param  MemoryType      Not used
+  @param  AllocateType    Not used
+
+  @retval FALSE  Always.
+
+**/
+BOOLEAN
+IsPageTypeToGuard (
+  IN EFI_MEMORY_TYPE        MemoryType,
+  IN EFI_ALLOCATE_TYPE      AllocateType
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of IsMemoryGuarded(). Heap guard is disabled.
+
+  @param  Address  Not used
+
+  @retval FALSE  Always.
+
+**/
+BOOLEAN
+EFIAPI
+IsMemoryGuarded (
+  IN EFI_PHYSICAL_ADDRESS    Address
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of AdjustMemoryS(). Heap guard is disabled, so it is never called.
+
+  @param  Start          Not used
+  @param  Size           Not used
+  @param  SizeRequested  Not used
+
+  @retval 0  Always.
+
+**/
+UINT64
+AdjustMemoryS (
+  IN UINT64                  Start,
+  IN UINT64                  Size,
+  IN UINT64                  SizeRequested
+  )
+{
+  ASSERT (FALSE);
+  return 0;
+}
+
+/**
+  Stub of CoreConvertPagesWithGuard(). Heap guard is disabled, so it is never
+  called.
+
+  @param  Start          Not used
+  @param  NumberOfPages  Not used
+  @param  NewType        Not used
+
+  @retval EFI_UNSUPPORTED  Always.
+
+**/
+EFI_STATUS
+CoreConvertPagesWithGuard (
+  IN UINT64           Start,
+  IN UINTN            NumberOfPages,
+  IN EFI_MEMORY_TYPE  NewType
+  )
+{
+  ASSERT (FALSE);
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Stub of SetGuardForMemory(). Heap guard is disabled, so it is never called.
+
+  @param  Memory         Not used
+  @param  NumberOfPages  Not used
+
+**/
+VOID
+SetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS   Memory,
+  IN UINTN                  NumberOfPages
+  )
+{
+  ASSERT (FALSE);
+}
+
+/**
+  Stub of GuardFreedPagesChecked(). Heap guard is disabled.
+
+  @param  BaseAddress  Not used
+  @param  Pages        Not used
+
+**/
+VOID
+EFIAPI
+GuardFreedPagesChecked (
+  IN  EFI_PHYSICAL_ADDRESS    BaseAddress,
+  IN  UINTN                   Pages
+  )
+{
+}
+
+/**
+  Stub of PromoteGuardedFreePages(). Heap guard is disabled.
+
+  @param  StartAddress  Not used
+  @param  EndAddress    Not used
+
+  @retval FALSE  Always.
+
+**/
+BOOLEAN
+PromoteGuardedFreePages (
+  OUT EFI_PHYSICAL_ADDRESS      *StartAddress,
+  OUT EFI_PHYSICAL_ADDRESS      *EndAddress
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of DumpGuardedMemoryBitmap(). Heap guard is disabled.
+
+**/
+VOID
+EFIAPI
+DumpGuardedMemoryBitmap (
+  VOID
+  )
+{
+}
+
+/**
+  Returns the next value of a fixed seed pseudo random sequence, so every
+  run of the tests makes the same allocations.
+
+  @return A pseudo random number
+
+**/
+UINT32
+TestRandom (
+  VOID
+  )
+{
+  mTestRandom = mTestRandom * 1103515245 + 12345;
+  return mTestRandom >> 8;
+}
+
+/**
+  Returns the memory map entry a red-black tree node is embedded in.
+
+  @param  Index  The index the node belongs to
+  @param  Node   The node
+
+  @return The memory map entry
+
+**/
+MEMORY_MAP *
+TestIndexEntry (
+  IN MEMORY_MAP_INDEX  *Index,
+  IN MEMORY_MAP_NODE   *Node
+  )
+{
+  return (MEMORY_MAP *) ((UINT8 *) Node - Index->NodeOffset);
+}
+
+/**
+  Checks a red-black sub-tree: the links, the address order, that a red
+  node has no red child and that every path has the same number of black
+  nodes.
+
+  @param  Index       The index the sub-tree belongs to
+  @param  Node        Root of the sub-tree, may be NULL
+  @param  Parent      Expected parent of Node
+  @param  Count       Incremented by the number of nodes in the sub-tree
+  @param  Previous    Last entry visited in address order, updated
+
+  @return The black height of the sub-tree, or -1 if it is not valid
+
+**/
+INTN
+TestCheckIndexNode (
+  IN     MEMORY_MAP_INDEX  *Index,
+  IN     MEMORY_MAP_NODE   *Node,
+  IN     MEMORY_MAP_NODE   *Parent,
+  IN OUT UINTN             *Count,
+  IN OUT MEMORY_MAP        **Previous
+  )
+{
+  INTN        LeftHeight;
+  INTN        RightHeight;
+  MEMORY_MAP  *Entry;
+
+  if (Node == NULL) {
+    return 1;
+  }
+  if (Node->Parent != Parent) {
+    return -1;
+  }
+  if (Node->Red && (((Node->Left != NULL) && Node->Left->Red) || ((Node->Right != NULL) && Node->Right->Red))) {
+    return -1;
+  }
+
+  LeftHeight = TestCheckIndexNode (Index, Node->Left, Node, Count, Previous);
+
+  Entry = TestIndexEntry (Index, Node);
+  if ((Entry->Signature != MEMORY_MAP_SIGNATURE) || (Entry->Link.ForwardLink == NULL)) {
+    return -1;
+  }
+  if ((*Previous != NULL) && ((*Previous)->End >= Entry->Start)) {
+    return -1;
+  }
+  *Previous = Entry;
+  (*Count)++;
+
+  RightHeight = TestCheckIndexNode (Index, Node->Right, Node, Count, Previous);
+  if ((LeftHeight < 0) || (LeftHeight != RightHeight)) {
+    return -1;
+  }
+
+  return LeftHeight + (Node->Red ? 0 : 1);
+}
+
+/**
+  Checks both memory map indexes against gMemoryMap.
+
+  @retval TRUE   The indexes are valid red-black trees holding exactly the
+                 entries of gMemoryMap, and the free entries.
+  @retval FALSE  An index is corrupted.
+
+**/
+BOOLEAN
+TestCheckIndexes (
+  VOID
+  )
+{
+  LIST_ENTRY   *Link;
+  MEMORY_MAP   *Entry;
+  MEMORY_MAP   *Previous;
+  UINTN        EntryCount;
+  UINTN        FreeCount;
+  UINTN        Count;
+
+  EntryCount = 0;
+  FreeCount  = 0;
+  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    if (FindMemoryMapEntry (Entry->Start) != Entry) {
+      return FALSE;
+    }
+    if (FindMemoryMapEntry (Entry->End - EFI_PAGE_MASK) != Entry) {
+      return FALSE;
+    }
+    EntryCount++;
+    if (Entry->Type == EfiConventionalMemory) {
+      FreeCount++;
+    }
+  }
+
+  if ((mMemoryMapAddressIndex.Root != NULL) && mMemoryMapAddressIndex.Root->Red) {
+    return FALSE;
+  }
+  Count    = 0;
+  Previous = NULL;
+  if ((TestCheckIndexNode (&mMemoryMapAddressIndex, mMemoryMapAddressIndex.Root, NULL, &Count, &Previous) < 0) ||
+      (Count != EntryCount)) {
+    return FALSE;
+  }
+
+  if ((mMemoryMapFreeIndex.Root != NULL) && mMemoryMapFreeIndex.Root->Red) {
+    return FALSE;
+  }
+  Count    = 0;
+  Previous = NULL;
+  if ((TestCheckIndexNode (&mMemoryMapFreeIndex, mMemoryMapFreeIndex.Root, NULL, &Count, &Previous) < 0) ||
+      (Count != FreeCount)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Finds the highest free range the way CoreFindFreePagesI() did before the
+  memory map was indexed, by scanning all of gMemoryMap.
+
+  @param  MaxAddress     The address that the range must be below, the last
+                         byte of a page
+  @param  NumberOfPages  Number of pages needed
+  @param  Alignment      Bits to align with
+
+  @return The base address of the range, or 0 if the range was not found.
+
+**/
+UINT64
+TestLinearFindFreePages (
+  IN UINT64  MaxAddress,
+  IN UINT64  NumberOfPages,
+  IN UINTN   Alignment
+  )
+{
+  LIST_ENTRY  *Link;
+  MEMORY_MAP  *Entry;
+  UINT64      NumberOfBytes;
+  UINT64      Target;
+  UINT64      DescStart;
+  UINT64      DescEnd;
+
+  NumberOfBytes = LShiftU64 (NumberOfPages, EFI_PAGE_SHIFT);
+  Target        = 0;
+
+  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    if ((Entry->Type != EfiConventionalMemory) || (Entry->Start >= MaxAddress)) {
+      continue;
+    }
+
+    DescStart = Entry->Start;
+    DescEnd   = MIN (Entry->End, MaxAddress);
+    DescEnd   = ((DescEnd + 1) & (~(Alignment - 1))) - 1;
+    if ((DescEnd < DescStart) || (DescEnd - DescStart + 1 < NumberOfBytes)) {
+      continue;
+    }
+    if (DescEnd > Target) {
+      Target = DescEnd;
+    }
+  }
+
+  Target -= NumberOfBytes - 1;
+  if ((Target & EFI_PAGE_MASK) != 0) {
+    return 0;
+  }
+
+  return Target;
+}
+
+/**
+  Returns a random address in the test memory, at the end of a page.
+
+  @return The address
+
+**/
+UINT64
+TestRandomMaxAddress (
+  VOID
+  )
+{
+  return mTestMemory + EFI_PAGES_TO_SIZE ((UINTN) (TestRandom () % TEST_MEMORY_PAGES) + 1) - 1;
+}
+
+/**
+  Give the host buffer to the page allocator as two free ranges around a
+  reserved range.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The memory map was built.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The memory map or its indexes are wrong.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+AddMemoryShouldBuildIndex (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VOID  *Buffer;
+
+  Buffer = aligned_alloc (RUNTIME_PAGE_ALLOCATION_GRANULARITY, EFI_PAGES_TO_SIZE (TEST_MEMORY_PAGES));
+  UT_ASSERT_NOT_NULL (Buffer);
+  mTestMemory = (EFI_PHYSICAL_ADDRESS) (UINTN) Buffer;
+
+  CoreAddMemoryDescriptor (
+    EfiConventionalMemory,
+    mTestMemory,
+    TEST_RESERVED_PAGE,
+    EFI_MEMORY_WB
+    );
+  CoreAddMemoryDescriptor (
+    EfiReservedMemoryType,
+    mTestMemory + EFI_PAGES_TO_SIZE (TEST_RESERVED_PAGE),
+    TEST_RESERVED_PAGES,
+    EFI_MEMORY_WB
+    );
+  CoreAddMemoryDescriptor (
+    EfiConventionalMemory,
+    mTestMemory + EFI_PAGES_TO_SIZE (TEST_RESERVED_PAGE + TEST_RESERVED_PAGES),
+    TEST_MEMORY_PAGES - TEST_RESERVED_PAGE - TEST_RESERVED_PAGES,
+    EFI_MEMORY_WB
+    );
+
+  UT_ASSERT_TRUE (TestCheckIndexes ());
+  UT_ASSERT_EQUAL (FindMemoryMapEntry (mTestMemory + EFI_PAGES_TO_SIZE (TEST_RESERVED_PAGE))->Type, EfiReservedMemoryType);
+  UT_ASSERT_TRUE (FindMemoryMapEntry (mTestMemory + EFI_PAGES_TO_SIZE (TEST_MEMORY_PAGES)) == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Fragment the memory map with TEST_ALLOCATION_COUNT allocations of
+  alternating types. Every allocation must return the range a linear scan of
+  the memory map picks, and the indexes must stay valid as entries are split,
+  merged and freed.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The allocations matched the linear scan.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  An allocation or an index is wrong.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+AllocationsShouldMatchLinearScan (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN                 Index;
+  UINTN                 Pages;
+  UINTN                 Alignment;
+  UINT64                MaxAddress;
+  UINT64                Expected;
+  EFI_ALLOCATE_TYPE     Type;
+  EFI_MEMORY_TYPE       MemoryType;
+
+  for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+    Pages      = 1 + (TestRandom () % 3);
+    MemoryType = ((Index % 2) == 0) ? EfiBootServicesData : EfiLoaderData;
+    if ((Index % 8) == 0) {
+      Type       = AllocateMaxAddress;
+      MaxAddress = TestRandomMaxAddress ();
+    } else {
+      Type       = AllocateAnyPages;
+      MaxAddress = MAX_ALLOC_ADDRESS;
+    }
+
+    Expected = TestLinearFindFreePages (MaxAddress, Pages, DEFAULT_PAGE_ALLOCATION_GRANULARITY);
+    mTestAllocations[Index] = MaxAddress;
+    mTestPages[Index]       = 0;
+    if (Expected == 0) {
+      UT_ASSERT_STATUS_EQUAL (CoreAllocatePages (Type, MemoryType, Pages, &mTestAllocations[Index]), EFI_OUT_OF_RESOURCES);
+      continue;
+    }
+
+    UT_ASSERT_NOT_EFI_ERROR (CoreAllocatePages (Type, MemoryType, Pages, &mTestAllocations[Index]));
+    UT_ASSERT_EQUAL (mTestAllocations[Index], Expected);
+    UT_ASSERT_EQUAL (FindMemoryMapEntry (mTestAllocations[Index])->Type, MemoryType);
+    mTestPages[Index] = Pages;
+
+    //
+    // Free the first page of some earlier allocations again, to leave holes
+    // and split entries
+    //
+    Pages = TestRandom () % (Index + 1);
+    if (((TestRandom () % 3) == 0) && (mTestPages[Pages] != 0)) {
+      UT_ASSERT_NOT_EFI_ERROR (CoreFreePages (mTestAllocations[Pages], 1));
+      mTestAllocations[Pages] += EFI_PAGE_SIZE;
+      mTestPages[Pages]--;
+    }
+  }
+
+  UT_ASSERT_TRUE (TestCheckIndexes ());
+
+  for (Index = 0; Index < TEST_SEARCH_COUNT; Index++) {
+    Pages      = 1 + (TestRandom () % 32);
+    Alignment  = ((Index % 4) == 0) ? RUNTIME_PAGE_ALLOCATION_GRANULARITY : DEFAULT_PAGE_ALLOCATION_GRANULARITY;
+    MaxAddress = TestRandomMaxAddress ();
+    UT_ASSERT_EQUAL (
+      CoreFindFreePagesI (MaxAddress, 0, Pages, EfiBootServicesData, Alignment, FALSE),
+      TestLinearFindFreePages (MaxAddress, Pages, Alignment)
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free every allocation in random order. Freed pages must merge with their
+  free neighbours, so only free ranges split by the reserved range and by
+  the pages taken for memory map entries are left.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The free ranges coalesced.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A range was not freed or not merged.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FreedPagesShouldCoalesce (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN         Index;
+  UINTN         Swap;
+  UINTN         Order[TEST_ALLOCATION_COUNT];
+  LIST_ENTRY    *Link;
+  MEMORY_MAP    *Entry;
+  UINTN         FreeCount;
+  UINTN         FreePages;
+  UINTN         MapPages;
+  MEMORY_MAP    *Next;
+
+  for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+    Order[Index] = Index;
+  }
+  for (Index = TEST_ALLOCATION_COUNT - 1; Index > 0; Index--) {
+    Swap         = TestRandom () % (Index + 1);
+    FreeCount    = Order[Index];
+    Order[Index] = Order[Swap];
+    Order[Swap]  = FreeCount;
+  }
+
+  for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+    if (mTestPages[Order[Index]] == 0) {
+      continue;
+    }
+    UT_ASSERT_NOT_EFI_ERROR (CoreFreePages (mTestAllocations[Order[Index]], mTestPages[Order[Index]]));
+    UT_ASSERT_STATUS_EQUAL (CoreFreePages (mTestAllocations[Order[Index]], 1), EFI_NOT_FOUND);
+    mTestPages[Order[Index]] = 0;
+    if ((Index % 256) == 0) {
+      UT_ASSERT_TRUE (TestCheckIndexes ());
+    }
+  }
+
+  UT_ASSERT_TRUE (TestCheckIndexes ());
+
+  FreeCount = 0;
+  FreePages = 0;
+  MapPages  = 0;
+  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+    Entry = CR (Link, MEMORY_MAP, Link, MEMORY_MAP_SIGNATURE);
+    if (Entry->Type == EfiConventionalMemory) {
+      FreeCount++;
+      FreePages += (UINTN) EFI_SIZE_TO_PAGES (Entry->End + 1 - Entry->Start);
+      Next = FindMemoryMapEntry (Entry->End + 1);
+      UT_ASSERT_TRUE ((Next == NULL) || (Next->Type != EfiConventionalMemory));
+    } else if (Entry->Type == EfiBootServicesData) {
+      MapPages += (UINTN) EFI_SIZE_TO_PAGES (Entry->End + 1 - Entry->Start);
+    } else {
+      UT_ASSERT_EQUAL (Entry->Type, EfiReservedMemoryType);
+    }
+  }
+
+  UT_ASSERT_EQUAL (FreePages + MapPages, TEST_MEMORY_PAGES - TEST_RESERVED_PAGES);
+  UT_ASSERT_TRUE (FreeCount <= MapPages + 2);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Time single page AllocatePages() and FreePages() calls on a memory map
+  fragmented into about TEST_ALLOCATION_COUNT entries, and log the rate.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             All allocations succeeded.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  An allocation failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PageAllocationBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN                 Index;
+  UINTN                 EntryCount;
+  LIST_ENTRY            *Link;
+  EFI_PHYSICAL_ADDRESS  Memory;
+  clock_t               Start;
+  double                Seconds;
+
+  //
+  // Leave a one page hole after every allocation, so no entry can merge
+  //
+  for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreAllocatePages (AllocateAnyPages, EfiBootServicesData, 2, &mTestAllocations[Index]));
+  }
+  for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreFreePages (mTestAllocations[Index], 1));
+  }
+
+  EntryCount = 0;
+  for (Link = gMemoryMap.ForwardLink; Link != &gMemoryMap; Link = Link->ForwardLink) {
+    EntryCount++;
+  }
+  UT_ASSERT_TRUE (EntryCount > TEST_ALLOCATION_COUNT);
+
+  Start = clock ();
+  for (Index = 0; Index < TEST_BENCHMARK_COUNT; Index++) {
+    Memory = mTestMemory + EFI_PAGES_TO_SIZE (TEST_MEMORY_PAGES / 2) - 1;
+    UT_ASSERT_NOT_EFI_ERROR (CoreAllocatePages (AllocateMaxAddress, EfiLoaderData, 1, &Memory));
+    UT_ASSERT_NOT_EFI_ERROR (CoreFreePages (Memory, 1));
+  }
+  Seconds = (double) (clock () - Start) / CLOCKS_PER_SEC;
+
+  UT_ASSERT_TRUE (TestCheckIndexes ());
+  for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreFreePages (mTestAllocations[Index] + EFI_PAGE_SIZE, 1));
+  }
+  UT_ASSERT_TRUE (TestCheckIndexes ());
+
+  UT_LOG_INFO (
+    "%d AllocatePages/FreePages pairs on a %d entry memory map in %d us\n",
+    TEST_BENCHMARK_COUNT,
+    (INT32) EntryCount,
+    (INT32) (Seconds * 1000000)
+    );
+  printf (
+    "AllocatePages/FreePages: %u pairs on a %u entry memory map, %.0f pairs/s\n",
+    (unsigned) TEST_BENCHMARK_COUNT,
+    (unsigned) EntryCount,
+    Seconds > 0 ? TEST_BENCHMARK_COUNT / Seconds : 0
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the DXE Core
+  page allocator and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      PageTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&PageTests, Framework, "DxeCore Page Allocator Tests", "DxeCore.Page", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for PageTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // The test cases build on each other and must run in this order.
+  //
+  AddTestCase (PageTests, "Added memory should be indexed", "AddMemory", AddMemoryShouldBuildIndex, NULL, NULL, NULL);
+  AddTestCase (PageTests, "Allocations should match a linear scan", "Allocate", AllocationsShouldMatchLinearScan, NULL, NULL, NULL);
+  AddTestCase (PageTests, "Freed pages should coalesce", "Free", FreedPagesShouldCoalesce, NULL, NULL, NULL);
+  AddTestCase (PageTests, "AllocatePages/FreePages rate on a fragmented memory map", "Benchmark", PageAllocationBenchmark, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,452 @@
+/** @file
+  Host based unit tests of the DXE Core timer heap.
+
+  The real Event/Timer.c is linked against the stubs below. The tests arm,
+  cancel and expire thousands of timers through CoreSetTimer(),
+  CoreTimerTick() and CoreCheckTimers(), and check that every armed timer
+  is signaled exactly once, in trigger time order.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "DxeMain.h"
+#include "Event.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "DxeCore Timer Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TIMER_TEST_COUNT          10000
+#define TIMER_TEST_SPAN           100000
+#define TIMER_TEST_TICK           1000
+
+EFI_TIMER_ARCH_PROTOCOL  *gTimer = NULL;
+
+extern TIMER_EVENT_INFO  *mEfiTimerHeap;
+extern UINT64            mEfiSystemTime;
+extern EFI_EVENT         mEfiCheckTimerEvent;
+
+VOID
+EFIAPI
+CoreCheckTimers (
+  IN EFI_EVENT            CheckEvent,
+  IN VOID                 *Context
+  );
+
+//
+// Timer events used by the tests, and what the stubs observed about them
+//
+IEVENT   mTestEvents[TIMER_TEST_COUNT];
+BOOLEAN  mTestArmed[TIMER_TEST_COUNT];
+UINTN    mTestSignalCount[TIMER_TEST_COUNT];
+IEVENT   mTestCheckTimerEvent;
+BOOLEAN  mTestCheckTimerSignaled;
+IEVENT   *mTestLastSignaled;
+BOOLEAN  mTestOutOfOrder;
+BOOLEAN  mTestSignaledEarly;
+UINT32   mTestRandom;
+
+/**
+  Stub of CoreRaiseTpl(). The host tests run at a single TPL.
+
+  @param  NewTpl  New, higher, task priority level
+
+  @return The previous task priority level
+
+**/
+EFI_TPL
+EFIAPI
+CoreRaiseTpl (
+  IN EFI_TPL      NewTpl
+  )
+{
+  return TPL_APPLICATION;
+}
+
+/**
+  Stub of CoreRestoreTpl().
+
+  @param  NewTpl  New, lower, task priority level
+
+**/
+VOID
+EFIAPI
+CoreRestoreTpl (
+  IN EFI_TPL NewTpl
+  )
+{
+}
+
+/**
+  Stub of CoreCreateEventInternal(). Timer.c only creates the check timer
+  event.
+
+  @param  Type            Not used
+  @param  NotifyTpl       Not used
+  @param  NotifyFunction  Not used
+  @param  NotifyContext   Not used
+  @param  EventGroup      Not used
+  @param  Event           Returns mTestCheckTimerEvent
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreCreateEventInternal (
+  IN UINT32                   Type,
+  IN EFI_TPL                  NotifyTpl,
+  IN EFI_EVENT_NOTIFY         NotifyFunction, OPTIONAL
+  IN CONST VOID               *NotifyContext, OPTIONAL
+  IN CONST EFI_GUID           *EventGroup,    OPTIONAL
+  OUT EFI_EVENT               *Event
+  )
+{
+  mTestCheckTimerEvent.Signature = EVENT_SIGNATURE;
+  *Event = &mTestCheckTimerEvent;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of CoreSignalEvent(). Records the signal of a test timer, and checks
+  that it has expired and that it does not fire before the timer signaled
+  last.
+
+  @param  UserEvent  The event to signal
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreSignalEvent (
+  IN EFI_EVENT    UserEvent
+  )
+{
+  IEVENT  *Event;
+
+  Event = UserEvent;
+  if (Event == &mTestCheckTimerEvent) {
+    mTestCheckTimerSignaled = TRUE;
+    return EFI_SUCCESS;
+  }
+
+  if (Event->Timer.TriggerTime > mEfiSystemTime) {
+    mTestSignaledEarly = TRUE;
+  }
+  if ((mTestLastSignaled != NULL) &&
+      ((Event->Timer.TriggerTime < mTestLastSignaled->Timer.TriggerTime) ||
+       ((Event->Timer.TriggerTime == mTestLastSignaled->Timer.TriggerTime) &&
+        (Event->Timer.Sequence < mTestLastSignaled->Timer.Sequence)))) {
+    mTestOutOfOrder = TRUE;
+  }
+  mTestLastSignaled = Event;
+  mTestSignalCount[Event - mTestEvents]++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Returns the next value of a fixed seed pseudo random sequence, so every
+  run of the tests arms the same timers.
+
+  @return A pseudo random number
+
+**/
+UINT32
+TestRandom (
+  VOID
+  )
+{
+  mTestRandom = mTestRandom * 1103515245 + 12345;
+  return mTestRandom >> 8;
+}
+
+/**
+  Advance the system time by Duration in TIMER_TEST_TICK steps, running
+  CoreCheckTimers() whenever CoreTimerTick() signals the check timer event.
+
+  @param  Duration  The number of 100ns units to advance
+
+**/
+VOID
+AdvanceSystemTime (
+  IN UINT64  Duration
+  )
+{
+  UINT64  Elapsed;
+
+  for (Elapsed = 0; Elapsed < Duration; Elapsed += TIMER_TEST_TICK) {
+    CoreTimerTick (TIMER_TEST_TICK);
+    while (mTestCheckTimerSignaled) {
+      mTestCheckTimerSignaled = FALSE;
+      CoreCheckTimers (&mTestCheckTimerEvent, NULL);
+    }
+  }
+}
+
+/**
+  Reset the test timers and the state recorded by the stubs.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED  Always.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ResetTestTimers (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  if (mEfiCheckTimerEvent == NULL) {
+    CoreInitializeTimer ();
+  }
+
+  for (Index = 0; Index < TIMER_TEST_COUNT; Index++) {
+    if (mTestEvents[Index].Timer.Queued) {
+      CoreSetTimer (&mTestEvents[Index], TimerCancel, 0);
+    }
+    ZeroMem (&mTestEvents[Index], sizeof (IEVENT));
+    mTestEvents[Index].Signature = EVENT_SIGNATURE;
+    mTestEvents[Index].Type      = EVT_TIMER | EVT_NOTIFY_SIGNAL;
+  }
+  ZeroMem (mTestArmed, sizeof (mTestArmed));
+  ZeroMem (mTestSignalCount, sizeof (mTestSignalCount));
+  mTestCheckTimerSignaled = FALSE;
+  mTestLastSignaled       = NULL;
+  mTestOutOfOrder         = FALSE;
+  mTestSignaledEarly      = FALSE;
+  mTestRandom             = 1;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Arm TIMER_TEST_COUNT one-shot timers, many of them with the same trigger
+  time, then cancel and re-arm some of them. Every timer still armed must be
+  signaled exactly once, in trigger time order, and never before it expires.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The timers were signaled as expected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A timer was lost, signaled twice, early
+                                       or out of order.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+OneShotTimersShouldExpireInOrder (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN   Index;
+  UINT64  Delay;
+
+  for (Index = 0; Index < TIMER_TEST_COUNT; Index++) {
+    Delay = ((Index % 10) == 0) ? TIMER_TEST_SPAN / 2 : TestRandom () % TIMER_TEST_SPAN;
+    UT_ASSERT_NOT_EFI_ERROR (CoreSetTimer (&mTestEvents[Index], TimerRelative, Delay));
+    mTestArmed[Index] = TRUE;
+  }
+
+  for (Index = 0; Index < TIMER_TEST_COUNT; Index++) {
+    switch (TestRandom () % 4) {
+    case 0:
+      UT_ASSERT_NOT_EFI_ERROR (CoreSetTimer (&mTestEvents[Index], TimerCancel, 0));
+      UT_ASSERT_FALSE (mTestEvents[Index].Timer.Queued);
+      mTestArmed[Index] = FALSE;
+      break;
+    case 1:
+      Delay = TestRandom () % TIMER_TEST_SPAN;
+      UT_ASSERT_NOT_EFI_ERROR (CoreSetTimer (&mTestEvents[Index], TimerRelative, Delay));
+      break;
+    default:
+      break;
+    }
+  }
+
+  //
+  // Expire the first half, then arm more timers behind the ones already
+  // pending before expiring the rest
+  //
+  AdvanceSystemTime (TIMER_TEST_SPAN / 2);
+  for (Index = 0; Index < TIMER_TEST_COUNT; Index++) {
+    if (!mTestArmed[Index] && ((Index % 2) == 0)) {
+      Delay = TestRandom () % TIMER_TEST_SPAN;
+      UT_ASSERT_NOT_EFI_ERROR (CoreSetTimer (&mTestEvents[Index], TimerRelative, Delay));
+      mTestArmed[Index] = TRUE;
+    }
+  }
+  AdvanceSystemTime (TIMER_TEST_SPAN * 2);
+
+  UT_ASSERT_FALSE (mTestSignaledEarly);
+  UT_ASSERT_FALSE (mTestOutOfOrder);
+  UT_ASSERT_TRUE (mEfiTimerHeap == NULL);
+  for (Index = 0; Index < TIMER_TEST_COUNT; Index++) {
+    UT_ASSERT_EQUAL (mTestSignalCount[Index], mTestArmed[Index] ? 1 : 0);
+    UT_ASSERT_FALSE (mTestEvents[Index].Timer.Queued);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Periodic timers with different periods are re-armed after every expiry
+  and are signaled once per period.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             The timers were signaled as expected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A timer was signaled too often or too
+                                       rarely.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PeriodicTimersShouldRearm (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN   Index;
+  UINT64  Period;
+
+  for (Index = 0; Index < 100; Index++) {
+    Period = (Index + 1) * TIMER_TEST_TICK;
+    UT_ASSERT_NOT_EFI_ERROR (CoreSetTimer (&mTestEvents[Index], TimerPeriodic, Period));
+  }
+
+  AdvanceSystemTime (TIMER_TEST_SPAN);
+
+  UT_ASSERT_FALSE (mTestSignaledEarly);
+  for (Index = 0; Index < 100; Index++) {
+    Period = (Index + 1) * TIMER_TEST_TICK;
+    UT_ASSERT_EQUAL (mTestSignalCount[Index], TIMER_TEST_SPAN / Period);
+    UT_ASSERT_TRUE (mTestEvents[Index].Timer.Queued);
+    UT_ASSERT_NOT_EFI_ERROR (CoreSetTimer (&mTestEvents[Index], TimerCancel, 0));
+  }
+  UT_ASSERT_TRUE (mEfiTimerHeap == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Time arming, cancelling and expiring TIMER_TEST_COUNT timers, and log the
+  rate.
+
+  @param  Context  Not used
+
+  @retval UNIT_TEST_PASSED             All timers were signaled.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A timer operation failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+TimerHeapBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN    Index;
+  UINTN    Round;
+  UINTN    Operations;
+  clock_t  Start;
+  double   Seconds;
+
+  Operations = 0;
+  Start      = clock ();
+  for (Round = 0; Round < 10; Round++) {
+    for (Index = 0; Index < TIMER_TEST_COUNT; Index++) {
+      UT_ASSERT_NOT_EFI_ERROR (CoreSetTimer (&mTestEvents[Index], TimerRelative, TestRandom () % TIMER_TEST_SPAN));
+      Operations++;
+    }
+    for (Index = 0; Index < TIMER_TEST_COUNT; Index += 2) {
+      UT_ASSERT_NOT_EFI_ERROR (CoreSetTimer (&mTestEvents[Index], TimerCancel, 0));
+      Operations++;
+    }
+    AdvanceSystemTime (TIMER_TEST_SPAN);
+    Operations += TIMER_TEST_COUNT / 2;
+  }
+  Seconds = (double) (clock () - Start) / CLOCKS_PER_SEC;
+
+  UT_ASSERT_TRUE (mEfiTimerHeap == NULL);
+  for (Index = 0; Index < TIMER_TEST_COUNT; Index++) {
+    UT_ASSERT_EQUAL (mTestSignalCount[Index], (Index % 2) == 0 ? 0 : 10);
+  }
+
+  UT_LOG_INFO (
+    "%d timer arm, cancel and expire operations on %d timers in %d us\n",
+    (INT32) Operations,
+    TIMER_TEST_COUNT,
+    (INT32) (Seconds * 1000000)
+    );
+  printf (
+    "Timer heap: %u operations on %u timers, %.0f operations/s\n",
+    (unsigned) Operations,
+    (unsigned) TIMER_TEST_COUNT,
+    Seconds > 0 ? Operations / Seconds : 0
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the DXE Core
+  timer heap and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      TimerTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&TimerTests, Framework, "DxeCore Timer Heap Tests", "DxeCore.Timer", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for TimerTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (TimerTests, "10000 one-shot timers should expire in order", "OneShot", OneShotTimersShouldExpireInOrder, ResetTestTimers, NULL, NULL);
+  AddTestCase (TimerTests, "Periodic timers should be re-armed", "Periodic", PeriodicTimersShouldRearm, ResetTestTimers, NULL, NULL);
+  AddTestCase (TimerTests, "Arm, cancel and expire rate on 10000 timers", "Benchmark", TimerHeapBenchmark, ResetTestTimers, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -23,7 +23,35 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define LZMAF86_CUSTOM_DECOMPRESS_GUID  \
   { 0xD42AE6BD, 0x1352, 0x4bfb, { 0x90, 0x9A, 0xCA, 0x72, 0xA6, 0xEA, 0xE8, 0x89 } }
 
+///
+/// The Global ID used to identify a section of an FFS file of type
+/// EFI_SECTION_GUID_DEFINED, whose contents have been split into blocks that
+/// are compressed using LZMA independently of each other, so that they can be
+/// decompressed in parallel.
+///
+#define LZMA_PARALLEL_CUSTOM_DECOMPRESS_GUID  \
+  { 0x78022A56, 0xAEEA, 0x44A7, { 0xBE, 0x1C, 0x73, 0x7F, 0x00, 0xE2, 0x47, 0xA6 } }
+
+///
+/// Header of the data in a section of LZMA_PARALLEL_CUSTOM_DECOMPRESS_GUID.
+///
+/// The header is followed by BlockCount + 1 UINT32 offsets, relative to the
+/// start of the header. Block N is the LZMA stream, with its usual 13 byte
+/// header, from offset N up to offset N + 1. It decodes to BlockSize bytes,
+/// at BlockSize * N in the output, except for the last block that holds the
+/// rest of DecodedSize.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT32    BlockCount;
+  UINT32    BlockSize;
+  UINT32    DecodedSize;
+} LZMA_PARALLEL_HEADER;
+
+#define LZMA_PARALLEL_SIGNATURE  SIGNATURE_32 ('L', 'Z', 'M', 'P')
+
 extern GUID gLzmaCustomDecompressGuid;
 extern GUID gLzmaF86CustomDecompressGuid;
+extern GUID gLzmaParallelCustomDecompressGuid;
 
 #endif
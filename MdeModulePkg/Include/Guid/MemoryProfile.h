@@ -179,6 +179,43 @@ typedef struct {
   //MEMORY_PROFILE_DESCRIPTOR     MemoryDescriptor[MemoryRangeCount];
 } MEMORY_PROFILE_MEMORY_RANGE;
 
+typedef struct {
+  UINT32                        BlockSize;
+  UINT32                        Reserved;
+  //
+  // Allocations served straight from the free list of this bucket.
+  //
+  UINT64                        HitCount;
+  //
+  // Allocations that had to split a larger free block or take a new page.
+  //
+  UINT64                        MissCount;
+  UINT64                        FreeBlockCount;
+} MEMORY_PROFILE_POOL_BUCKET;
+
+#define MEMORY_PROFILE_POOL_INFO_SIGNATURE SIGNATURE_32 ('M','P','P','L')
+#define MEMORY_PROFILE_POOL_INFO_REVISION 0x0001
+
+typedef struct {
+  MEMORY_PROFILE_COMMON_HEADER  Header;
+  UINT32                        MemoryType;
+  UINT32                        BucketCount;
+  //
+  // Bytes of pool in use for this memory type, including pool headers.
+  //
+  UINT64                        UsedSize;
+  //
+  // Pages carved into pool buckets, including the cached empty pages.
+  //
+  UINT64                        PoolPages;
+  //
+  // Empty pool pages held for reuse instead of being freed to the memory map.
+  //
+  UINT64                        CachedPages;
+  UINT64                        CachedPageReuseCount;
+  //MEMORY_PROFILE_POOL_BUCKET    Bucket[BucketCount];
+} MEMORY_PROFILE_POOL_INFO;
+
 //
 // UEFI memory profile layout:
 // +--------------------------------+
@@ -196,6 +233,10 @@ typedef struct {
 // +--------------------------------+
 // | ALLOC_INFO(n, mn)              |
 // +--------------------------------+
+// | POOL_INFO(0)                   |
+// +--------------------------------+
+// | POOL_INFO(EfiMaxMemoryType - 1)|
+// +--------------------------------+
 //
 
 typedef struct _EDKII_MEMORY_PROFILE_PROTOCOL EDKII_MEMORY_PROFILE_PROTOCOL;
@@ -77,6 +77,10 @@ typedef struct {
 // The payload for this function is SMM_VARIABLE_COMMUNICATE_GET_RUNTIME_CACHE_INFO
 //
 #define SMM_VARIABLE_FUNCTION_GET_RUNTIME_CACHE_INFO                14
+//
+// The payload for this function is SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH
+//
+#define SMM_VARIABLE_FUNCTION_SET_VARIABLE_BATCH                    15
 
 ///
 /// Size of SMM communicate header, without including the payload.
@@ -140,6 +144,27 @@ typedef struct {
   VARIABLE_STORE_HEADER   *RuntimeVolatileCache;
 } SMM_VARIABLE_COMMUNICATE_RUNTIME_VARIABLE_CACHE_CONTEXT;
 
+///
+/// This structure is used to communicate with SMI handler by the batched SetVariable.
+/// It is followed by VariableCount SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM,
+/// each one starting at a SMM_VARIABLE_BATCH_ITEM_ALIGNMENT aligned offset from the
+/// start of this structure.
+///
+typedef struct {
+  UINTN                   VariableCount;
+} SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH;
+
+///
+/// One variable of a batched SetVariable. ReturnStatus is the output of
+/// SetVariable() for this variable.
+///
+typedef struct {
+  EFI_STATUS                                ReturnStatus;
+  SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE  Variable;
+} SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM;
+
+#define SMM_VARIABLE_BATCH_ITEM_ALIGNMENT  sizeof (UINT64)
+
 typedef struct {
   UINTN                   TotalHobStorageSize;
   UINTN                   TotalNvStorageSize;
@@ -0,0 +1,66 @@
+/** @file
+  Variable Batch Protocol is related to EDK II-specific implementation of variables
+  and intended for use as a means to set several variables at once, so that a
+  variable driver running in SMM needs fewer SMIs to set them.
+
+  Copyright (c) 2020, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __VARIABLE_BATCH_H__
+#define __VARIABLE_BATCH_H__
+
+#define EDKII_VARIABLE_BATCH_PROTOCOL_GUID \
+  { \
+    0x360f4029, 0x50ce, 0x4527, { 0xab, 0xd8, 0xe4, 0x3c, 0x83, 0x9d, 0x43, 0x9e } \
+  }
+
+typedef struct _EDKII_VARIABLE_BATCH_PROTOCOL  EDKII_VARIABLE_BATCH_PROTOCOL;
+
+///
+/// One variable to set with SetVariables(). The fields other than Status are
+/// the parameters of SetVariable(), Status returns its result.
+///
+typedef struct {
+  CHAR16                        *VariableName;
+  EFI_GUID                      *VendorGuid;
+  UINT32                        Attributes;
+  UINTN                         DataSize;
+  VOID                          *Data;
+  EFI_STATUS                    Status;
+} EDKII_VARIABLE_BATCH_ENTRY;
+
+/**
+  Set several variables, in the order of Entries, as if SetVariable() was
+  called for each of them.
+
+  @param[in]      This          The EDKII_VARIABLE_BATCH_PROTOCOL instance.
+  @param[in]      EntryCount    Number of entries in Entries.
+  @param[in, out] Entries       The variables to set. On return, the Status
+                                field of every entry holds the result of
+                                setting it.
+
+  @retval EFI_SUCCESS           All the entries were processed, their result is
+                                in their Status field.
+  @retval EFI_INVALID_PARAMETER Entries is NULL and EntryCount is not 0.
+**/
+typedef
+EFI_STATUS
+(EFIAPI * EDKII_VARIABLE_BATCH_SET_VARIABLES) (
+  IN CONST EDKII_VARIABLE_BATCH_PROTOCOL  *This,
+  IN       UINTN                          EntryCount,
+  IN OUT   EDKII_VARIABLE_BATCH_ENTRY     *Entries
+  );
+
+///
+/// Variable Batch Protocol is related to EDK II-specific implementation of variables
+/// and intended for use as a means to set several variables at once.
+///
+struct _EDKII_VARIABLE_BATCH_PROTOCOL {
+  EDKII_VARIABLE_BATCH_SET_VARIABLES  SetVariables;
+};
+
+extern EFI_GUID gEdkiiVariableBatchProtocolGuid;
+
+#endif
@@ -86,5 +86,85 @@ LzmaUefiDecompress (
   IN OUT VOID    *Scratch
   );
 
+/**
+  Given a multi-block LZMA compressed source buffer, this function retrieves
+  the size of the uncompressed buffer and the size of the scratch buffer
+  required to decompress the compressed source buffer.
+
+  @param  Source          The source buffer containing the compressed data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+  @param  DestinationSize A pointer to the size, in bytes, of the uncompressed buffer
+                          that will be generated when the compressed buffer specified
+                          by Source and SourceSize is decompressed.
+  @param  ScratchSize     A pointer to the size, in bytes, of the scratch buffer that
+                          is required to decompress the compressed buffer specified
+                          by Source and SourceSize.
+
+  @retval  RETURN_SUCCESS           The size of the uncompressed data was returned
+                                    in DestinationSize and the size of the scratch
+                                    buffer was returned in ScratchSize.
+  @retval  RETURN_INVALID_PARAMETER The source buffer is corrupted.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaParallelDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  );
+
+/**
+  Decompresses a multi-block LZMA compressed source buffer.
+
+  @param  Source      The source buffer containing the compressed data.
+  @param  SourceSize  The size of source buffer.
+  @param  Destination The destination buffer to store the decompressed data
+  @param  Scratch     A temporary scratch buffer that is used to perform the decompression,
+                      of the size returned by LzmaParallelDecompressGetInfo().
+
+  @retval  RETURN_SUCCESS Decompression completed successfully, and
+                          the uncompressed buffer is returned in Destination.
+  @retval  RETURN_INVALID_PARAMETER
+                          The source buffer specified by Source is corrupted
+                          (not in a valid compressed format).
+**/
+RETURN_STATUS
+EFIAPI
+LzmaParallelDecompress (
+  IN CONST VOID  *Source,
+  IN UINTN       SourceSize,
+  IN OUT VOID    *Destination,
+  IN OUT VOID    *Scratch
+  );
+
+/**
+  Decode the blocks of a multi-block LZMA buffer described by Context,
+  taking blocks from Context until all of them have been decoded.
+
+  This function may run on several processors at the same time.
+
+  @param[in, out]  Context        Pointer to the LZMA_PARALLEL_CONTEXT.
+
+**/
+VOID
+EFIAPI
+LzmaParallelWorker (
+  IN OUT VOID  *Context
+  );
+
+/**
+  Run LzmaParallelWorker() with Context on the processors available to
+  the caller, and return when all blocks have been decoded.
+
+  @param[in, out]  Context        Pointer to the LZMA_PARALLEL_CONTEXT.
+
+**/
+VOID
+LzmaParallelDispatch (
+  IN OUT VOID  *Context
+  );
+
 #endif
 
@@ -0,0 +1,264 @@
+/** @file
+  Multi-block LZMA Decompress interfaces
+
+  The blocks of a multi-block LZMA buffer are independent LZMA streams, so
+  they are decoded by LzmaParallelWorker() on as many processors as
+  LzmaParallelDispatch() makes available.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "LzmaDecompressLibInternal.h"
+
+#include <Library/SynchronizationLib.h>
+#include "Sdk/C/7zTypes.h"
+#include "Sdk/C/LzmaDec.h"
+
+#define LZMA_HEADER_SIZE (LZMA_PROPS_SIZE + 8)
+
+//
+// Maximum number of processors decoding blocks at the same time. Each one
+// needs its own scratch buffer.
+//
+#define LZMA_PARALLEL_MAX_WORKERS  16
+
+typedef struct {
+  CONST LZMA_PARALLEL_HEADER  *Header;
+  CONST UINT32                *BlockOffset;
+  UINT8                       *Destination;
+  UINT8                       *Scratch;
+  UINT32                      ScratchSize;
+  UINT32                      WorkerCount;
+  volatile UINT32             NextWorker;
+  volatile UINT32             NextBlock;
+  volatile UINT32             FailedBlocks;
+} LZMA_PARALLEL_CONTEXT;
+
+/**
+  Check the header and the block table of a multi-block LZMA buffer.
+
+  @param  Source          The source buffer containing the compressed data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+
+  @retval  RETURN_SUCCESS           The header and block table are valid.
+  @retval  RETURN_INVALID_PARAMETER The source buffer is corrupted.
+
+**/
+RETURN_STATUS
+LzmaParallelCheckHeader (
+  IN CONST VOID  *Source,
+  IN UINTN       SourceSize
+  )
+{
+  CONST LZMA_PARALLEL_HEADER  *Header;
+  CONST UINT32                *BlockOffset;
+  UINT64                      TableEnd;
+  UINT32                      Index;
+  UINT32                      BlockDecodedSize;
+  UINT32                      DestinationSize;
+  UINT32                      ScratchSize;
+
+  Header = Source;
+  if ((SourceSize < sizeof (LZMA_PARALLEL_HEADER)) ||
+      (Header->Signature != LZMA_PARALLEL_SIGNATURE) ||
+      (Header->BlockCount == 0) ||
+      (Header->BlockSize == 0) ||
+      (DivU64x32 ((UINT64) Header->DecodedSize + Header->BlockSize - 1, Header->BlockSize) != Header->BlockCount)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  TableEnd = sizeof (LZMA_PARALLEL_HEADER) + MultU64x32 ((UINT64) Header->BlockCount + 1, sizeof (UINT32));
+  if (TableEnd > SourceSize) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  BlockOffset = (CONST UINT32 *) (Header + 1);
+  if ((BlockOffset[0] < TableEnd) || (BlockOffset[Header->BlockCount] > SourceSize)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < Header->BlockCount; Index++) {
+    if ((BlockOffset[Index] > BlockOffset[Index + 1]) ||
+        (BlockOffset[Index + 1] - BlockOffset[Index] < LZMA_HEADER_SIZE)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    BlockDecodedSize = Header->BlockSize;
+    if (Index == Header->BlockCount - 1) {
+      BlockDecodedSize = Header->DecodedSize - Index * Header->BlockSize;
+    }
+
+    LzmaUefiDecompressGetInfo (
+      (CONST UINT8 *) Header + BlockOffset[Index],
+      BlockOffset[Index + 1] - BlockOffset[Index],
+      &DestinationSize,
+      &ScratchSize
+      );
+    if (DestinationSize != BlockDecodedSize) {
+      return RETURN_INVALID_PARAMETER;
+    }
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Given a multi-block LZMA compressed source buffer, this function retrieves
+  the size of the uncompressed buffer and the size of the scratch buffer
+  required to decompress the compressed source buffer.
+
+  The scratch buffer holds one single-stream scratch buffer for each
+  processor that may decode blocks at the same time.
+
+  @param  Source          The source buffer containing the compressed data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+  @param  DestinationSize A pointer to the size, in bytes, of the uncompressed buffer
+                          that will be generated when the compressed buffer specified
+                          by Source and SourceSize is decompressed.
+  @param  ScratchSize     A pointer to the size, in bytes, of the scratch buffer that
+                          is required to decompress the compressed buffer specified
+                          by Source and SourceSize.
+
+  @retval  RETURN_SUCCESS           The size of the uncompressed data was returned
+                                    in DestinationSize and the size of the scratch
+                                    buffer was returned in ScratchSize.
+  @retval  RETURN_INVALID_PARAMETER The source buffer is corrupted.
+
+**/
+RETURN_STATUS
+EFIAPI
+LzmaParallelDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32      SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  )
+{
+  CONST LZMA_PARALLEL_HEADER  *Header;
+  CONST UINT32                *BlockOffset;
+  UINT32                      BlockDecodedSize;
+  UINT32                      BlockScratchSize;
+  RETURN_STATUS               Status;
+
+  Status = LzmaParallelCheckHeader (Source, SourceSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  Header      = Source;
+  BlockOffset = (CONST UINT32 *) (Header + 1);
+  LzmaUefiDecompressGetInfo (
+    (CONST UINT8 *) Header + BlockOffset[0],
+    BlockOffset[1] - BlockOffset[0],
+    &BlockDecodedSize,
+    &BlockScratchSize
+    );
+
+  *DestinationSize = Header->DecodedSize;
+  *ScratchSize     = BlockScratchSize * MIN (Header->BlockCount, LZMA_PARALLEL_MAX_WORKERS);
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decode the blocks of a multi-block LZMA buffer described by Context,
+  taking blocks from Context until all of them have been decoded.
+
+  This function may run on several processors at the same time.
+
+  @param[in, out]  Context        Pointer to the LZMA_PARALLEL_CONTEXT.
+
+**/
+VOID
+EFIAPI
+LzmaParallelWorker (
+  IN OUT VOID  *Context
+  )
+{
+  LZMA_PARALLEL_CONTEXT  *Parallel;
+  UINT32                 Worker;
+  UINT32                 Index;
+  RETURN_STATUS          Status;
+
+  Parallel = Context;
+
+  //
+  // Claim a scratch buffer; processors beyond the number of scratch buffers
+  // have nothing to do.
+  //
+  Worker = InterlockedIncrement (&Parallel->NextWorker) - 1;
+  if (Worker >= Parallel->WorkerCount) {
+    return;
+  }
+
+  for (;;) {
+    Index = InterlockedIncrement (&Parallel->NextBlock) - 1;
+    if (Index >= Parallel->Header->BlockCount) {
+      break;
+    }
+
+    Status = LzmaUefiDecompress (
+               (CONST UINT8 *) Parallel->Header + Parallel->BlockOffset[Index],
+               Parallel->BlockOffset[Index + 1] - Parallel->BlockOffset[Index],
+               Parallel->Destination + Index * Parallel->Header->BlockSize,
+               Parallel->Scratch + Worker * Parallel->ScratchSize
+               );
+    if (RETURN_ERROR (Status)) {
+      InterlockedIncrement (&Parallel->FailedBlocks);
+    }
+  }
+}
+
+/**
+  Decompresses a multi-block LZMA compressed source buffer.
+
+  @param  Source      The source buffer containing the compressed data.
+  @param  SourceSize  The size of source buffer.
+  @param  Destination The destination buffer to store the decompressed data
+  @param  Scratch     A temporary scratch buffer that is used to perform the decompression,
+                      of the size returned by LzmaParallelDecompressGetInfo().
+
+  @retval  RETURN_SUCCESS Decompression completed successfully, and
+                          the uncompressed buffer is returned in Destination.
+  @retval  RETURN_INVALID_PARAMETER
+                          The source buffer specified by Source is corrupted
+                          (not in a valid compressed format).
+**/
+RETURN_STATUS
+EFIAPI
+LzmaParallelDecompress (
+  IN CONST VOID  *Source,
+  IN UINTN       SourceSize,
+  IN OUT VOID    *Destination,
+  IN OUT VOID    *Scratch
+  )
+{
+  LZMA_PARALLEL_CONTEXT  Parallel;
+  UINT32                 BlockDecodedSize;
+  RETURN_STATUS          Status;
+
+  Status = LzmaParallelCheckHeader (Source, SourceSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (&Parallel, sizeof (Parallel));
+  Parallel.Header      = Source;
+  Parallel.BlockOffset = (CONST UINT32 *) (Parallel.Header + 1);
+  Parallel.Destination = Destination;
+  Parallel.Scratch     = Scratch;
+  Parallel.WorkerCount = MIN (Parallel.Header->BlockCount, LZMA_PARALLEL_MAX_WORKERS);
+  LzmaUefiDecompressGetInfo (
+    (CONST UINT8 *) Source + Parallel.BlockOffset[0],
+    Parallel.BlockOffset[1] - Parallel.BlockOffset[0],
+    &BlockDecodedSize,
+    &Parallel.ScratchSize
+    );
+
+  LzmaParallelDispatch (&Parallel);
+
+  if ((Parallel.NextBlock < Parallel.Header->BlockCount) || (Parallel.FailedBlocks != 0)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  return RETURN_SUCCESS;
+}
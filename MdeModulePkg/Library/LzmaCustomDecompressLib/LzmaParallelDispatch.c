@@ -0,0 +1,25 @@
+/** @file
+  Run the multi-block LZMA decoder on the calling processor only.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "LzmaDecompressLibInternal.h"
+
+/**
+  Run LzmaParallelWorker() with Context on the processors available to
+  the caller, and return when all blocks have been decoded.
+
+  This instance decodes all blocks on the calling processor.
+
+  @param[in, out]  Context        Pointer to the LZMA_PARALLEL_CONTEXT.
+
+**/
+VOID
+LzmaParallelDispatch (
+  IN OUT VOID  *Context
+  )
+{
+  LzmaParallelWorker (Context);
+}
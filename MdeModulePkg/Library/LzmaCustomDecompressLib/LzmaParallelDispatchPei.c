@@ -0,0 +1,56 @@
+/** @file
+  Run the multi-block LZMA decoder on all processors in PEI.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "LzmaDecompressLibInternal.h"
+
+#include <Library/PeiServicesLib.h>
+#include <Library/PeiServicesTablePointerLib.h>
+#include <Ppi/MpServices.h>
+
+/**
+  Run LzmaParallelWorker() with Context on the processors available to
+  the caller, and return when all blocks have been decoded.
+
+  If the MP Services PPI is installed, the APs decode blocks while the BSP
+  waits for them; the BSP then decodes whatever is left, which is all of
+  the blocks if the APs could not be started.
+
+  The BSP doesn't decode blocks while the APs run: StartupAllAPs() of
+  EFI_PEI_MP_SERVICES_PPI only supports blocking mode. EDKII_PEI_MP_SERVICES2_PPI
+  can also run the procedure on the BSP, but it is defined in UefiCpuPkg,
+  which MdeModulePkg doesn't depend on.
+
+  @param[in, out]  Context        Pointer to the LZMA_PARALLEL_CONTEXT.
+
+**/
+VOID
+LzmaParallelDispatch (
+  IN OUT VOID  *Context
+  )
+{
+  EFI_STATUS               Status;
+  EFI_PEI_MP_SERVICES_PPI  *MpServices;
+
+  Status = PeiServicesLocatePpi (
+             &gEfiPeiMpServicesPpiGuid,
+             0,
+             NULL,
+             (VOID **) &MpServices
+             );
+  if (!EFI_ERROR (Status)) {
+    MpServices->StartupAllAPs (
+                  GetPeiServicesTablePointer (),
+                  MpServices,
+                  LzmaParallelWorker,
+                  FALSE,
+                  0,
+                  Context
+                  );
+  }
+
+  LzmaParallelWorker (Context);
+}
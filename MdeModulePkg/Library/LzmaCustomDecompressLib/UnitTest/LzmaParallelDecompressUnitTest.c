@@ -0,0 +1,584 @@
+/** @file
+  Host based unit tests of the multi-block LZMA decompression.
+
+  The test buffer was produced with "LzmaCompress -e --parallel" from the
+  2.5MB output of TestPattern(), so it holds two full 1MB blocks and a
+  shorter last block. The corrupted buffers are built from copies of it.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../LzmaDecompressLibInternal.h"
+
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../Sdk/C/7zTypes.h"
+#include "../Sdk/C/LzmaDec.h"
+
+#define UNIT_TEST_APP_NAME     "LZMA Parallel Decompress Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define TEST_DECODED_SIZE      (SIZE_2MB + SIZE_512KB)
+#define TEST_BLOCK_SIZE        SIZE_1MB
+#define TEST_BLOCK_COUNT       3
+#define TEST_CORRUPTIONS       300
+
+//
+// "LzmaCompress -e --parallel" output for TEST_DECODED_SIZE bytes of
+// TestPattern().
+//
+GLOBAL_REMOVE_IF_UNREFERENCED CONST UINT8  mTestCompressed[] = {
+  0x4c, 0x5a, 0x4d, 0x50, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x28, 0x00,
+  0x20, 0x00, 0x00, 0x00, 0x7e, 0x03, 0x00, 0x00, 0xdc, 0x06, 0x00, 0x00, 0x30, 0x09, 0x00, 0x00,
+  0x5d, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+  0x0f, 0x57, 0x02, 0x68, 0xc6, 0x78, 0xce, 0xd8, 0x0f, 0x90, 0xe6, 0xeb, 0xb6, 0xdd, 0x1f, 0x70,
+  0x62, 0xb0, 0x21, 0x27, 0x14, 0xf9, 0xb1, 0x95, 0x8a, 0x58, 0x60, 0x21, 0x7a, 0x2c, 0xac, 0xe7,
+  0x77, 0x98, 0xdf, 0x45, 0x86, 0xda, 0xac, 0x69, 0x34, 0x69, 0x0d, 0x38, 0x64, 0x55, 0xe2, 0xb7,
+  0x18, 0x16, 0xaa, 0x44, 0x15, 0x99, 0xbe, 0xa2, 0x90, 0x8b, 0x09, 0xd6, 0x1f, 0xc9, 0x47, 0xff,
+  0xef, 0xde, 0x9a, 0xc6, 0x8d, 0xbf, 0x33, 0xd9, 0xb5, 0xd4, 0x6a, 0xaf, 0x16, 0xed, 0xf4, 0x83,
+  0xbc, 0x69, 0x74, 0xd1, 0x23, 0xe6, 0xc7, 0x84, 0x1e, 0x12, 0x9b, 0xa6, 0x75, 0x90, 0x56, 0x90,
+  0x89, 0x72, 0x1a, 0x58, 0x7f, 0x5a, 0x3e, 0x80, 0x06, 0x4c, 0x56, 0x65, 0x3f, 0x78, 0xeb, 0xad,
+  0xd7, 0xc6, 0x55, 0x3b, 0x1f, 0x67, 0xe3, 0xa8, 0x37, 0x8a, 0x19, 0x99, 0xf2, 0x4c, 0xe6, 0xa5,
+  0xcb, 0x00, 0x71, 0x89, 0x5b, 0xcf, 0x16, 0x23, 0x81, 0x92, 0xf1, 0xf7, 0x07, 0xbf, 0x9b, 0xee,
+  0xdc, 0xfa, 0x16, 0x13, 0x0e, 0x51, 0xd0, 0x10, 0x69, 0x88, 0x3e, 0xde, 0xe4, 0xbd, 0xc3, 0xa6,
+  0xe0, 0x95, 0x83, 0x2b, 0x4b, 0xa8, 0x95, 0x75, 0x98, 0x7a, 0x1b, 0x8a, 0x02, 0x74, 0x78, 0xa6,
+  0xa1, 0xfc, 0x6a, 0x60, 0xf0, 0xa5, 0xad, 0x2a, 0xc8, 0x55, 0xc4, 0xcf, 0x2f, 0x06, 0x0f, 0x62,
+  0x1b, 0x9d, 0x85, 0xb9, 0x15, 0x1c, 0xc8, 0x9b, 0x94, 0x19, 0x66, 0xd4, 0x06, 0x20, 0x86, 0x26,
+  0xa3, 0xad, 0x7c, 0x68, 0x84, 0x02, 0x2f, 0x7b, 0x8f, 0x2b, 0x57, 0x72, 0x32, 0x56, 0xb3, 0xd8,
+  0x88, 0x0f, 0x4d, 0x7f, 0x03, 0x56, 0x3d, 0xc3, 0xd5, 0x98, 0x37, 0xc3, 0xea, 0xe0, 0xfd, 0xc6,
+  0xdc, 0x99, 0x4c, 0x25, 0x30, 0x12, 0x48, 0x62, 0xb8, 0xa9, 0x46, 0xf3, 0xed, 0x3b, 0xfa, 0x37,
+  0x5a, 0x95, 0xa0, 0x0c, 0x16, 0xfa, 0x15, 0xbe, 0x24, 0x6f, 0x40, 0x14, 0xf3, 0x9e, 0xb5, 0x8b,
+  0x69, 0x49, 0x3b, 0x6f, 0x4f, 0xc3, 0xa8, 0xc4, 0xb5, 0x18, 0x32, 0x3b, 0x0f, 0x52, 0xe5, 0x4d,
+  0x85, 0x27, 0x02, 0xa4, 0xe9, 0x2e, 0x6e, 0x91, 0x7f, 0x9b, 0x7a, 0x07, 0xb3, 0xdf, 0x9b, 0x52,
+  0x09, 0x2c, 0x41, 0xc5, 0xff, 0x3a, 0x4f, 0xf7, 0x00, 0x6b, 0x1a, 0xf9, 0x01, 0x1a, 0x6a, 0xad,
+  0xa6, 0xd4, 0x0e, 0x8f, 0xe9, 0x72, 0xb2, 0x9a, 0xc9, 0xf7, 0x7e, 0x6e, 0xe8, 0xa2, 0x7c, 0xcd,
+  0x57, 0x2f, 0xe5, 0xe7, 0x0c, 0xcb, 0xea, 0x2d, 0xdb, 0xf9, 0x6c, 0x03, 0x06, 0x99, 0xd6, 0x5d,
+  0x67, 0x43, 0x75, 0x1e, 0x93, 0xab, 0xb8, 0x4c, 0x52, 0xf2, 0x96, 0xca, 0x28, 0xc4, 0x87, 0xdd,
+  0xdf, 0xe8, 0xa0, 0xa5, 0x4c, 0x9c, 0xf6, 0x0b, 0x3f, 0x3d, 0x07, 0x52, 0x9f, 0x6e, 0xb9, 0xf9,
+  0x3c, 0x0f, 0x9e, 0x1b, 0xb5, 0x09, 0x8b, 0x0e, 0xf2, 0x13, 0xd8, 0x8b, 0xcb, 0xe9, 0x3e, 0x7e,
+  0xfb, 0x5c, 0x8e, 0x94, 0x8e, 0x4b, 0xd0, 0x5c, 0xe4, 0xcc, 0x1b, 0x53, 0xf9, 0x4f, 0xff, 0x74,
+  0xb5, 0x1b, 0x55, 0x44, 0x86, 0x1f, 0x35, 0x21, 0xdb, 0x50, 0x52, 0x60, 0x7a, 0xe7, 0xe2, 0xdd,
+  0x90, 0x15, 0x92, 0x16, 0x9d, 0xad, 0xe5, 0x84, 0xc1, 0x68, 0x9d, 0xbc, 0x38, 0x1b, 0xfb, 0x7e,
+  0x52, 0xce, 0x79, 0x5e, 0xa4, 0x81, 0x11, 0xd7, 0x63, 0x8c, 0x9e, 0xae, 0xf1, 0x57, 0xc3, 0xe7,
+  0xf5, 0x39, 0x0d, 0x92, 0x43, 0x28, 0xa5, 0x87, 0xe3, 0xb0, 0x81, 0x7e, 0xae, 0x97, 0x06, 0x34,
+  0xec, 0x75, 0x50, 0x4a, 0x90, 0x74, 0xdb, 0xd6, 0x80, 0xb6, 0xb1, 0x1e, 0xf2, 0xfb, 0x67, 0xbb,
+  0xca, 0x05, 0xac, 0xc0, 0x75, 0x08, 0x0a, 0xcd, 0xd7, 0x1b, 0xcd, 0xab, 0xef, 0x56, 0x46, 0xae,
+  0xfd, 0x02, 0xcf, 0x8d, 0x70, 0x5a, 0xde, 0xe9, 0x92, 0xf7, 0xf2, 0x2d, 0xe1, 0x6f, 0x08, 0x58,
+  0x1c, 0x6f, 0xd0, 0x15, 0x1c, 0xa0, 0x53, 0xfa, 0x42, 0x4d, 0x74, 0xfe, 0x20, 0x8b, 0x60, 0x29,
+  0x4b, 0xe7, 0xe9, 0x93, 0x90, 0xbf, 0xe1, 0xff, 0x13, 0x6c, 0x4f, 0x2a, 0xac, 0x9d, 0xfc, 0x49,
+  0x62, 0xa4, 0x50, 0xf0, 0x48, 0xb2, 0x5b, 0x62, 0x14, 0x23, 0x12, 0x0a, 0x28, 0x0d, 0x6f, 0xb4,
+  0xed, 0x07, 0x6c, 0xf3, 0x64, 0xc3, 0x39, 0x12, 0x80, 0x12, 0xab, 0x36, 0xd8, 0xdb, 0xeb, 0xc4,
+  0xb2, 0x78, 0x99, 0xce, 0x7a, 0x94, 0x74, 0xe5, 0xd9, 0x08, 0xd8, 0x42, 0xf0, 0x69, 0x5f, 0xd1,
+  0xad, 0x0b, 0xf2, 0x3f, 0xbc, 0x00, 0x9e, 0x8e, 0xb7, 0x70, 0x71, 0x10, 0xa8, 0xd0, 0xc3, 0x4e,
+  0xa6, 0x3b, 0x61, 0x2a, 0x14, 0x93, 0x25, 0xc9, 0xb4, 0x55, 0x93, 0x27, 0xb1, 0x46, 0xff, 0x72,
+  0x82, 0x87, 0x18, 0x86, 0xd6, 0xac, 0x75, 0x96, 0xfe, 0x15, 0x8c, 0xc2, 0x78, 0xde, 0xfa, 0xf9,
+  0x9d, 0xba, 0x34, 0xfa, 0x30, 0x6a, 0x3e, 0x97, 0x93, 0x79, 0x34, 0xfb, 0xf3, 0xd7, 0x9b, 0x2a,
+  0xaa, 0xaf, 0x2b, 0x2b, 0x77, 0xa9, 0x0d, 0x30, 0xb7, 0xa9, 0xe3, 0x71, 0x1a, 0x60, 0x0a, 0x15,
+  0x37, 0xfe, 0x5f, 0xca, 0x1f, 0x74, 0x72, 0x9b, 0x50, 0x24, 0xce, 0xaf, 0x9c, 0x0f, 0x51, 0x47,
+  0xb9, 0x0d, 0x48, 0x4a, 0x6c, 0xde, 0x37, 0x00, 0xee, 0x1e, 0x9f, 0x87, 0x61, 0x86, 0xc3, 0xd8,
+  0x89, 0xa8, 0xf4, 0x15, 0xd7, 0xdf, 0x9f, 0xdd, 0x8c, 0xdb, 0x0f, 0x49, 0xf5, 0xb1, 0x5d, 0xca,
+  0x77, 0xf2, 0xb5, 0x31, 0x65, 0x68, 0x28, 0x91, 0x81, 0x7b, 0x7d, 0x57, 0x06, 0x8d, 0x36, 0xbf,
+  0xa6, 0x93, 0x57, 0xd5, 0x89, 0x5b, 0xce, 0xfe, 0x9e, 0x51, 0x24, 0xe9, 0x7f, 0xde, 0xe1, 0x54,
+  0x6d, 0xdb, 0x62, 0x4b, 0x48, 0x67, 0xf9, 0x7b, 0x4b, 0x89, 0xa5, 0x58, 0x30, 0xa9, 0x55, 0x28,
+  0x8f, 0x7a, 0xcf, 0x94, 0x11, 0x74, 0x52, 0x16, 0x9b, 0x1c, 0x79, 0xb7, 0x1d, 0x61, 0xc9, 0x2f,
+  0x3f, 0x7b, 0x06, 0x64, 0x39, 0x9b, 0x70, 0x54, 0xd9, 0xff, 0x7d, 0x1e, 0x67, 0x98, 0x75, 0x9a,
+  0xe1, 0x6d, 0x1f, 0x64, 0xcd, 0xb9, 0x1b, 0x8f, 0x22, 0xc8, 0x1f, 0xbc, 0x02, 0x59, 0xf0, 0xa4,
+  0x88, 0x63, 0xee, 0x05, 0xbf, 0x01, 0xae, 0x7b, 0x4d, 0x5f, 0xc4, 0xda, 0x49, 0x00, 0x5d, 0x00,
+  0x00, 0x10, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x0f, 0x57,
+  0x02, 0x68, 0xc6, 0x78, 0xce, 0xd8, 0x0f, 0x90, 0xe6, 0xeb, 0xb6, 0xdd, 0x1f, 0x70, 0x62, 0xb0,
+  0x21, 0x27, 0x14, 0xf9, 0xb1, 0x95, 0x8a, 0x58, 0x60, 0x21, 0x7a, 0x2c, 0xac, 0xe7, 0x77, 0x98,
+  0xdf, 0x45, 0x86, 0xda, 0xac, 0x69, 0x34, 0x69, 0x0d, 0x38, 0x64, 0x55, 0xe2, 0xb7, 0x18, 0x16,
+  0xaa, 0x44, 0x15, 0x99, 0xbe, 0xa2, 0x90, 0x8b, 0x09, 0xd6, 0x1f, 0xc9, 0x47, 0xff, 0xef, 0xde,
+  0x9a, 0xc6, 0x8d, 0xbf, 0x33, 0xd9, 0xb5, 0xd4, 0x6a, 0xaf, 0x16, 0xed, 0xf4, 0x83, 0xbc, 0x69,
+  0x74, 0xd1, 0x23, 0xe6, 0xc7, 0x84, 0x1e, 0x12, 0x9b, 0xa6, 0x75, 0x90, 0x56, 0x90, 0x89, 0x72,
+  0x1a, 0x58, 0x7f, 0x5a, 0x3e, 0x80, 0x06, 0x4c, 0x56, 0x65, 0x3f, 0x78, 0xeb, 0xad, 0xd7, 0xc6,
+  0x55, 0x3b, 0x1f, 0x67, 0xe3, 0xa8, 0x37, 0x8a, 0x19, 0x99, 0xf2, 0x4c, 0xe6, 0xa5, 0xcb, 0x00,
+  0x71, 0x89, 0x5b, 0xcf, 0x16, 0x23, 0x81, 0x92, 0xf1, 0xf7, 0x07, 0xbf, 0x9b, 0xee, 0xdc, 0xfa,
+  0x16, 0x13, 0x0e, 0x51, 0xd0, 0x10, 0x69, 0x88, 0x3e, 0xde, 0xe4, 0xbd, 0xc3, 0xa6, 0xe0, 0x95,
+  0x83, 0x2b, 0x4b, 0xa8, 0x95, 0x75, 0x98, 0x7a, 0x1b, 0x8a, 0x02, 0x74, 0x78, 0xa6, 0xa1, 0xfc,
+  0x6a, 0x60, 0xf0, 0xa5, 0xad, 0x2a, 0xc8, 0x55, 0xc4, 0xcf, 0x2f, 0x06, 0x0f, 0x62, 0x1b, 0x9d,
+  0x85, 0xb9, 0x15, 0x1c, 0xc8, 0x9b, 0x94, 0x19, 0x66, 0xd4, 0x06, 0x20, 0x86, 0x26, 0xa3, 0xad,
+  0x7c, 0x68, 0x84, 0x02, 0x2f, 0x7b, 0x8f, 0x2b, 0x57, 0x72, 0x32, 0x56, 0xb3, 0xd8, 0x88, 0x0f,
+  0x4d, 0x7f, 0x03, 0x56, 0x3d, 0xc3, 0xd5, 0x98, 0x37, 0xc3, 0xea, 0xe0, 0xfd, 0xc6, 0xdc, 0x99,
+  0x4c, 0x25, 0x30, 0x12, 0x48, 0x62, 0xb8, 0xa9, 0x46, 0xf3, 0xed, 0x3b, 0xfa, 0x37, 0x5a, 0x95,
+  0xa0, 0x0c, 0x16, 0xfa, 0x15, 0xbe, 0x24, 0x6f, 0x40, 0x14, 0xf3, 0x9e, 0xb5, 0x8b, 0x69, 0x49,
+  0x3b, 0x6f, 0x4f, 0xc3, 0xa8, 0xc4, 0xb5, 0x18, 0x32, 0x3b, 0x0f, 0x52, 0xe5, 0x4d, 0x85, 0x27,
+  0x02, 0xa4, 0xe9, 0x2e, 0x6e, 0x91, 0x7f, 0x9b, 0x7a, 0x07, 0xb3, 0xdf, 0x9b, 0x52, 0x09, 0x2c,
+  0x41, 0xc5, 0xff, 0x3a, 0x4f, 0xf7, 0x00, 0x6b, 0x1a, 0xf9, 0x01, 0x1a, 0x6a, 0xad, 0xa6, 0xd4,
+  0x0e, 0x8f, 0xe9, 0x72, 0xb2, 0x9a, 0xc9, 0xf7, 0x7e, 0x6e, 0xe8, 0xa2, 0x7c, 0xcd, 0x57, 0x2f,
+  0xe5, 0xe7, 0x0c, 0xcb, 0xea, 0x2d, 0xdb, 0xf9, 0x6c, 0x03, 0x06, 0x99, 0xd6, 0x5d, 0x67, 0x43,
+  0x75, 0x1e, 0x93, 0xab, 0xb8, 0x4c, 0x52, 0xf2, 0x96, 0xca, 0x28, 0xc4, 0x87, 0xdd, 0xdf, 0xe8,
+  0xa0, 0xa5, 0x4c, 0x9c, 0xf6, 0x0b, 0x3f, 0x3d, 0x07, 0x52, 0x9f, 0x6e, 0xb9, 0xf9, 0x3c, 0x0f,
+  0x9e, 0x1b, 0xb5, 0x09, 0x8b, 0x0e, 0xf2, 0x13, 0xd8, 0x8b, 0xcb, 0xe9, 0x3e, 0x7e, 0xfb, 0x5c,
+  0x8e, 0x94, 0x8e, 0x4b, 0xd0, 0x5c, 0xe4, 0xcc, 0x1b, 0x53, 0xf9, 0x4f, 0xff, 0x74, 0xb5, 0x1b,
+  0x55, 0x44, 0x86, 0x1f, 0x35, 0x21, 0xdb, 0x50, 0x52, 0x60, 0x7a, 0xe7, 0xe2, 0xdd, 0x90, 0x15,
+  0x92, 0x16, 0x9d, 0xad, 0xe5, 0x84, 0xc1, 0x68, 0x9d, 0xbc, 0x38, 0x1b, 0xfb, 0x7e, 0x52, 0xce,
+  0x79, 0x5e, 0xa4, 0x81, 0x11, 0xd7, 0x63, 0x8c, 0x9e, 0xae, 0xf1, 0x57, 0xc3, 0xe7, 0xf5, 0x39,
+  0x0d, 0x92, 0x43, 0x28, 0xa5, 0x87, 0xe3, 0xb0, 0x81, 0x7e, 0xae, 0x97, 0x06, 0x34, 0xec, 0x75,
+  0x50, 0x4a, 0x90, 0x74, 0xdb, 0xd6, 0x80, 0xb6, 0xb1, 0x1e, 0xf2, 0xfb, 0x67, 0xbb, 0xca, 0x05,
+  0xac, 0xc0, 0x75, 0x08, 0x0a, 0xcd, 0xd7, 0x1b, 0xcd, 0xab, 0xef, 0x56, 0x46, 0xae, 0xfd, 0x02,
+  0xcf, 0x8d, 0x70, 0x5a, 0xde, 0xe9, 0x92, 0xf7, 0xf2, 0x2d, 0xe1, 0x6f, 0x08, 0x58, 0x1c, 0x6f,
+  0xd0, 0x15, 0x1c, 0xa0, 0x53, 0xfa, 0x42, 0x4d, 0x74, 0xfe, 0x20, 0x8b, 0x60, 0x29, 0x4b, 0xe7,
+  0xe9, 0x93, 0x90, 0xbf, 0xe1, 0xff, 0x13, 0x6c, 0x4f, 0x2a, 0xac, 0x9d, 0xfc, 0x49, 0x62, 0xa4,
+  0x50, 0xf0, 0x48, 0xb2, 0x5b, 0x62, 0x14, 0x23, 0x12, 0x0a, 0x28, 0x0d, 0x6f, 0xb4, 0xed, 0x07,
+  0x6c, 0xf3, 0x64, 0xc3, 0x39, 0x12, 0x80, 0x12, 0xab, 0x36, 0xd8, 0xdb, 0xeb, 0xc4, 0xb2, 0x78,
+  0x99, 0xce, 0x7a, 0x94, 0x74, 0xe5, 0xd9, 0x08, 0xd8, 0x42, 0xf0, 0x69, 0x5f, 0xd1, 0xad, 0x0b,
+  0xf2, 0x3f, 0xbc, 0x00, 0x9e, 0x8e, 0xb7, 0x70, 0x71, 0x10, 0xa8, 0xd0, 0xc3, 0x4e, 0xa6, 0x3b,
+  0x61, 0x2a, 0x14, 0x93, 0x25, 0xc9, 0xb4, 0x55, 0x93, 0x27, 0xb1, 0x46, 0xff, 0x72, 0x82, 0x87,
+  0x18, 0x86, 0xd6, 0xac, 0x75, 0x96, 0xfe, 0x15, 0x8c, 0xc2, 0x78, 0xde, 0xfa, 0xf9, 0x9d, 0xba,
+  0x34, 0xfa, 0x30, 0x6a, 0x3e, 0x97, 0x93, 0x79, 0x34, 0xfb, 0xf3, 0xd7, 0x9b, 0x2a, 0xaa, 0xaf,
+  0x2b, 0x2b, 0x77, 0xa9, 0x0d, 0x30, 0xb7, 0xa9, 0xe3, 0x71, 0x1a, 0x60, 0x0a, 0x15, 0x37, 0xfe,
+  0x5f, 0xca, 0x1f, 0x74, 0x72, 0x9b, 0x50, 0x24, 0xce, 0xaf, 0x9c, 0x0f, 0x51, 0x47, 0xb9, 0x0d,
+  0x48, 0x4a, 0x6c, 0xde, 0x37, 0x00, 0xee, 0x1e, 0x9f, 0x87, 0x61, 0x86, 0xc3, 0xd8, 0x89, 0xa8,
+  0xf4, 0x15, 0xd7, 0xdf, 0x9f, 0xdd, 0x8c, 0xdb, 0x0f, 0x49, 0xf5, 0xb1, 0x5d, 0xca, 0x77, 0xf2,
+  0xb5, 0x31, 0x65, 0x68, 0x28, 0x91, 0x81, 0x7b, 0x7d, 0x57, 0x06, 0x8d, 0x36, 0xbf, 0xa6, 0x93,
+  0x57, 0xd5, 0x89, 0x5b, 0xce, 0xfe, 0x9e, 0x51, 0x24, 0xe9, 0x7f, 0xde, 0xe1, 0x54, 0x6d, 0xdb,
+  0x62, 0x4b, 0x48, 0x67, 0xf9, 0x7b, 0x4b, 0x89, 0xa5, 0x58, 0x30, 0xa9, 0x55, 0x28, 0x8f, 0x7a,
+  0xcf, 0x94, 0x11, 0x74, 0x52, 0x16, 0x9b, 0x1c, 0x79, 0xb7, 0x1d, 0x61, 0xc9, 0x2f, 0x3f, 0x7b,
+  0x06, 0x64, 0x39, 0x9b, 0x70, 0x54, 0xd9, 0xff, 0x7d, 0x1e, 0x67, 0x98, 0x75, 0x9a, 0xe1, 0x6d,
+  0x1f, 0x64, 0xcd, 0xb9, 0x1b, 0x8f, 0x22, 0xc8, 0x1f, 0xbc, 0x02, 0x59, 0xf0, 0xa4, 0x88, 0x63,
+  0xee, 0x05, 0xbf, 0x01, 0xae, 0x7b, 0x4d, 0x5f, 0xc4, 0xda, 0x49, 0x00, 0x5d, 0x00, 0x00, 0x10,
+  0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x0f, 0x57, 0x02, 0x68,
+  0xc6, 0x78, 0xce, 0xd8, 0x0f, 0x90, 0xe6, 0xeb, 0xb6, 0xdd, 0x1f, 0x70, 0x62, 0xb0, 0x21, 0x27,
+  0x14, 0xf9, 0xb1, 0x95, 0x8a, 0x58, 0x60, 0x21, 0x7a, 0x2c, 0xac, 0xe7, 0x77, 0x98, 0xdf, 0x45,
+  0x86, 0xda, 0xac, 0x69, 0x34, 0x69, 0x0d, 0x38, 0x64, 0x55, 0xe2, 0xb7, 0x18, 0x16, 0xaa, 0x44,
+  0x15, 0x99, 0xbe, 0xa2, 0x90, 0x8b, 0x09, 0xd6, 0x1f, 0xc9, 0x47, 0xff, 0xef, 0xde, 0x9a, 0xc6,
+  0x8d, 0xbf, 0x33, 0xd9, 0xb5, 0xd4, 0x6a, 0xaf, 0x16, 0xed, 0xf4, 0x83, 0xbc, 0x69, 0x74, 0xd1,
+  0x23, 0xe6, 0xc7, 0x84, 0x1e, 0x12, 0x9b, 0xa6, 0x75, 0x90, 0x56, 0x90, 0x89, 0x72, 0x1a, 0x58,
+  0x7f, 0x5a, 0x3e, 0x80, 0x06, 0x4c, 0x56, 0x65, 0x3f, 0x78, 0xeb, 0xad, 0xd7, 0xc6, 0x55, 0x3b,
+  0x1f, 0x67, 0xe3, 0xa8, 0x37, 0x8a, 0x19, 0x99, 0xf2, 0x4c, 0xe6, 0xa5, 0xcb, 0x00, 0x71, 0x89,
+  0x5b, 0xcf, 0x16, 0x23, 0x81, 0x92, 0xf1, 0xf7, 0x07, 0xbf, 0x9b, 0xee, 0xdc, 0xfa, 0x16, 0x13,
+  0x0e, 0x51, 0xd0, 0x10, 0x69, 0x88, 0x3e, 0xde, 0xe4, 0xbd, 0xc3, 0xa6, 0xe0, 0x95, 0x83, 0x2b,
+  0x4b, 0xa8, 0x95, 0x75, 0x98, 0x7a, 0x1b, 0x8a, 0x02, 0x74, 0x78, 0xa6, 0xa1, 0xfc, 0x6a, 0x60,
+  0xf0, 0xa5, 0xad, 0x2a, 0xc8, 0x55, 0xc4, 0xcf, 0x2f, 0x06, 0x0f, 0x62, 0x1b, 0x9d, 0x85, 0xb9,
+  0x15, 0x1c, 0xc8, 0x9b, 0x94, 0x19, 0x66, 0xd4, 0x06, 0x20, 0x86, 0x26, 0xa3, 0xad, 0x7c, 0x68,
+  0x84, 0x02, 0x2f, 0x7b, 0x8f, 0x2b, 0x57, 0x72, 0x32, 0x56, 0xb3, 0xd8, 0x88, 0x0f, 0x4d, 0x7f,
+  0x03, 0x56, 0x3d, 0xc3, 0xd5, 0x98, 0x37, 0xc3, 0xea, 0xe0, 0xfd, 0xc6, 0xdc, 0x99, 0x4c, 0x25,
+  0x30, 0x12, 0x48, 0x62, 0xb8, 0xa9, 0x46, 0xf3, 0xed, 0x3b, 0xfa, 0x37, 0x5a, 0x95, 0xa0, 0x0c,
+  0x16, 0xfa, 0x15, 0xbe, 0x24, 0x6f, 0x40, 0x14, 0xf3, 0x9e, 0xb5, 0x8b, 0x69, 0x49, 0x3b, 0x6f,
+  0x4f, 0xc3, 0xa8, 0xc4, 0xb5, 0x18, 0x32, 0x3b, 0x0f, 0x52, 0xe5, 0x4d, 0x85, 0x27, 0x02, 0xa4,
+  0xe9, 0x2e, 0x6e, 0x91, 0x7f, 0x9b, 0x7a, 0x07, 0xb3, 0xdf, 0x9b, 0x52, 0x09, 0x2c, 0x41, 0xc5,
+  0xff, 0x3a, 0x4f, 0xf7, 0x00, 0x6b, 0x1a, 0xf9, 0x01, 0x1a, 0x6a, 0xad, 0xa6, 0xd4, 0x0e, 0x8f,
+  0xe9, 0x72, 0xb2, 0x9a, 0xc9, 0xf7, 0x7e, 0x6e, 0xe8, 0xa2, 0x7c, 0xcd, 0x57, 0x2f, 0xe5, 0xe7,
+  0x0c, 0xcb, 0xea, 0x2d, 0xdb, 0xf9, 0x6c, 0x03, 0x06, 0x99, 0xd6, 0x5d, 0x67, 0x43, 0x75, 0x1e,
+  0x93, 0xab, 0xb8, 0x4c, 0x52, 0xf2, 0x96, 0xca, 0x28, 0xc4, 0x87, 0xdd, 0xdf, 0xe8, 0xa0, 0xa5,
+  0x4c, 0x9c, 0xf6, 0x0b, 0x3f, 0x3d, 0x07, 0x52, 0x9f, 0x6e, 0xb9, 0xf9, 0x3c, 0x0f, 0x9e, 0x1b,
+  0xb5, 0x09, 0x8b, 0x0e, 0xf2, 0x13, 0xd8, 0x8b, 0xcb, 0xe9, 0x3e, 0x7e, 0xfb, 0x5c, 0x8e, 0x94,
+  0x8e, 0x4b, 0xd0, 0x5c, 0xe4, 0xcc, 0x1b, 0x53, 0xf9, 0x4f, 0xff, 0x74, 0xb5, 0x1b, 0x55, 0x44,
+  0x86, 0x1f, 0x35, 0x21, 0xdb, 0x50, 0x52, 0x60, 0x7a, 0xe7, 0xe2, 0xdd, 0x90, 0x15, 0x92, 0x16,
+  0x9d, 0xad, 0xe5, 0x84, 0xc1, 0x68, 0x9d, 0xbc, 0x38, 0x1b, 0xfb, 0x7e, 0x52, 0xce, 0x79, 0x5e,
+  0xa4, 0x81, 0x11, 0xd7, 0x63, 0x8c, 0x9e, 0xae, 0xf1, 0x57, 0xc3, 0xe7, 0xf5, 0x39, 0x0d, 0x92,
+  0x43, 0x28, 0xa5, 0x87, 0xe3, 0xb0, 0x81, 0x7e, 0xae, 0x97, 0x06, 0x34, 0xec, 0x75, 0x50, 0x4a,
+  0x90, 0x74, 0xdb, 0xd6, 0x80, 0xb6, 0xb1, 0x1e, 0xf2, 0xfb, 0x67, 0xbb, 0xca, 0x05, 0xac, 0xc0,
+  0x75, 0x08, 0x0a, 0xcd, 0xd7, 0x1b, 0xcd, 0xab, 0xef, 0x56, 0x46, 0xae, 0xfd, 0x02, 0xcf, 0x8d,
+  0x70, 0x5a, 0xde, 0xe9, 0x92, 0xf7, 0xf2, 0x2d, 0xe1, 0x6f, 0x08, 0x58, 0x1c, 0x6f, 0xd0, 0x15,
+  0x1c, 0xa0, 0x53, 0xfa, 0x42, 0x4d, 0x74, 0xfe, 0x20, 0x8b, 0x60, 0x29, 0x4b, 0xe7, 0xe9, 0x93,
+  0x90, 0xbf, 0xe1, 0xff, 0x13, 0x6c, 0x4f, 0x2a, 0xac, 0x9d, 0xfc, 0x49, 0x62, 0xa4, 0x50, 0xf0,
+  0x48, 0xb2, 0x5b, 0x62, 0x14, 0x23, 0x12, 0x0a, 0x28, 0x0d, 0x6f, 0x62, 0x4f, 0x87, 0x00, 0x00,
+};
+
+UINT32  mTestRandom = 1;
+
+/**
+  Return the next value of a linear congruential generator, so that the
+  corrupted buffers are the same on every run.
+
+  @return A pseudo random 32-bit value.
+
+**/
+UINT32
+TestRandom (
+  VOID
+  )
+{
+  mTestRandom = mTestRandom * 1103515245 + 12345;
+  return mTestRandom;
+}
+
+/**
+  Return the byte at Index of the data that mTestCompressed decodes to. It
+  changes every 4KB, so a block decoded to the wrong place doesn't match.
+
+  @param[in]  Index  Offset in the decoded data.
+
+  @return The byte at Index.
+
+**/
+UINT8
+TestPattern (
+  IN UINTN  Index
+  )
+{
+  return (UINT8) (Index * 7 + (Index >> 12));
+}
+
+/**
+  Decompress Source into buffers of the exact sizes reported by
+  LzmaParallelDecompressGetInfo(), so that the address sanitizer catches
+  any access beyond them.
+
+  @param[in]   Source       The compressed buffer.
+  @param[in]   SourceSize   Size of Source.
+  @param[out]  Destination  The decoded data if RETURN_SUCCESS is returned,
+                            otherwise NULL. The caller frees it.
+
+  @retval RETURN_OUT_OF_RESOURCES  The buffers could not be allocated.
+  @return The status of LzmaParallelDecompressGetInfo() if it fails,
+          otherwise the status of LzmaParallelDecompress().
+
+**/
+RETURN_STATUS
+TestDecompress (
+  IN  CONST UINT8  *Source,
+  IN  UINT32       SourceSize,
+  OUT UINT8        **Destination
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         DestinationSize;
+  UINT32         ScratchSize;
+  VOID           *Scratch;
+
+  *Destination = NULL;
+
+  Status = LzmaParallelDecompressGetInfo (Source, SourceSize, &DestinationSize, &ScratchSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  *Destination = AllocatePool (DestinationSize);
+  Scratch      = AllocatePool (ScratchSize);
+  if ((*Destination == NULL) || (Scratch == NULL)) {
+    Status = RETURN_OUT_OF_RESOURCES;
+  } else {
+    Status = LzmaParallelDecompress (Source, SourceSize, *Destination, Scratch);
+  }
+
+  if (Scratch != NULL) {
+    FreePool (Scratch);
+  }
+
+  if (RETURN_ERROR (Status) && (*Destination != NULL)) {
+    FreePool (*Destination);
+    *Destination = NULL;
+  }
+
+  return Status;
+}
+
+/**
+  Decompress the test buffer and check every byte against TestPattern().
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DecompressShouldMatchPattern (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CONST LZMA_PARALLEL_HEADER  *Header;
+  RETURN_STATUS               Status;
+  UINT32                      DestinationSize;
+  UINT32                      ScratchSize;
+  UINT8                       *Destination;
+  UINTN                       Index;
+
+  Header = (CONST LZMA_PARALLEL_HEADER *) mTestCompressed;
+  UT_ASSERT_EQUAL (Header->Signature, LZMA_PARALLEL_SIGNATURE);
+  UT_ASSERT_EQUAL (Header->BlockCount, TEST_BLOCK_COUNT);
+  UT_ASSERT_EQUAL (Header->BlockSize, TEST_BLOCK_SIZE);
+
+  Status = LzmaParallelDecompressGetInfo (mTestCompressed, sizeof (mTestCompressed), &DestinationSize, &ScratchSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (DestinationSize, TEST_DECODED_SIZE);
+  UT_ASSERT_TRUE (ScratchSize >= TEST_BLOCK_COUNT * SIZE_64KB);
+
+  Status = TestDecompress (mTestCompressed, sizeof (mTestCompressed), &Destination);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  for (Index = 0; Index < TEST_DECODED_SIZE; Index++) {
+    if (Destination[Index] != TestPattern (Index)) {
+      break;
+    }
+  }
+
+  FreePool (Destination);
+  UT_ASSERT_EQUAL (Index, TEST_DECODED_SIZE);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Build a copy of the test buffer with one field of the header, of the
+  block table or of a block's LZMA header changed, and check that both
+  LzmaParallelDecompressGetInfo() and LzmaParallelDecompress() reject it.
+  Each one is passed in a buffer of its exact size, so that the address
+  sanitizer catches reads beyond it.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CorruptedHeaderShouldBeRejected (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8                 *Buffer;
+  UINT8                 *Source;
+  LZMA_PARALLEL_HEADER  *Header;
+  UINT32                *BlockOffset;
+  UINT32                BufferSize;
+  UINT32                DestinationSize;
+  UINT32                ScratchSize;
+  UINTN                 Case;
+  RETURN_STATUS         Status;
+
+  for (Case = 0; ; Case++) {
+    Buffer = AllocateCopyPool (sizeof (mTestCompressed), mTestCompressed);
+    UT_ASSERT_NOT_NULL (Buffer);
+    BufferSize  = sizeof (mTestCompressed);
+    Header      = (LZMA_PARALLEL_HEADER *) Buffer;
+    BlockOffset = (UINT32 *) (Header + 1);
+
+    switch (Case) {
+      case 0:
+        Header->Signature = SIGNATURE_32 ('L', 'Z', 'M', 'A');
+        break;
+      case 1:
+        Header->BlockCount  = 0;
+        Header->DecodedSize = 0;
+        break;
+      case 2:
+        Header->BlockSize = 0;
+        break;
+      case 3:
+        Header->DecodedSize += TEST_BLOCK_SIZE;
+        break;
+      case 4:
+        Header->BlockSize /= 2;
+        break;
+      case 5:
+        //
+        // A block table that runs past the end of the buffer.
+        //
+        Header->BlockCount  = BufferSize / sizeof (UINT32);
+        Header->BlockSize   = 1;
+        Header->DecodedSize = Header->BlockCount;
+        break;
+      case 6:
+        BlockOffset[0] -= sizeof (UINT32);
+        break;
+      case 7:
+        BlockOffset[TEST_BLOCK_COUNT] += 1;
+        break;
+      case 8:
+        BlockOffset[1] = BlockOffset[2] + 1;
+        break;
+      case 9:
+        //
+        // A last block shorter than its LZMA header, at the end of the buffer.
+        //
+        BlockOffset[TEST_BLOCK_COUNT] = BlockOffset[TEST_BLOCK_COUNT - 1] + LZMA_PROPS_SIZE + 7;
+        BufferSize                    = BlockOffset[TEST_BLOCK_COUNT];
+        break;
+      case 10:
+        //
+        // The decoded size in the LZMA header of the middle block.
+        //
+        Buffer[BlockOffset[1] + LZMA_PROPS_SIZE] ^= 1;
+        break;
+      case 11:
+        BufferSize = sizeof (LZMA_PARALLEL_HEADER) - 1;
+        break;
+      case 12:
+        BufferSize = BlockOffset[0] - 1;
+        break;
+      case 13:
+        BufferSize -= 1;
+        break;
+      case 14:
+        //
+        // A last block of twice the block size, with a DecodedSize that
+        // matches it. Its 512KB decoded size is stored in little endian.
+        //
+        Buffer[BlockOffset[TEST_BLOCK_COUNT - 1] + LZMA_PROPS_SIZE + 2] = (UINT8) ((2 * TEST_BLOCK_SIZE) >> 16);
+        Header->DecodedSize = (TEST_BLOCK_COUNT + 1) * TEST_BLOCK_SIZE;
+        break;
+      default:
+        FreePool (Buffer);
+        return UNIT_TEST_PASSED;
+    }
+
+    Source = AllocateCopyPool (BufferSize, Buffer);
+    FreePool (Buffer);
+    UT_ASSERT_NOT_NULL (Source);
+
+    Status = LzmaParallelDecompressGetInfo (Source, BufferSize, &DestinationSize, &ScratchSize);
+    UT_ASSERT_STATUS_EQUAL (Status, RETURN_INVALID_PARAMETER);
+
+    //
+    // LzmaParallelDecompress() checks the header before it touches the
+    // destination or the scratch buffer.
+    //
+    Status = LzmaParallelDecompress (Source, BufferSize, NULL, NULL);
+    UT_ASSERT_STATUS_EQUAL (Status, RETURN_INVALID_PARAMETER);
+
+    FreePool (Source);
+  }
+}
+
+/**
+  Decompress a copy of the test buffer with unsupported LZMA properties in
+  its last block, which has a valid header and block table, and check that
+  the failure of that block is reported.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CorruptedBlockShouldFail (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8          *Buffer;
+  UINT32         *BlockOffset;
+  UINT8          *Destination;
+  RETURN_STATUS  Status;
+
+  Buffer = AllocateCopyPool (sizeof (mTestCompressed), mTestCompressed);
+  UT_ASSERT_NOT_NULL (Buffer);
+  BlockOffset = (UINT32 *) ((LZMA_PARALLEL_HEADER *) Buffer + 1);
+  Buffer[BlockOffset[TEST_BLOCK_COUNT - 1]] = 0xFF;
+
+  Status = TestDecompress (Buffer, sizeof (mTestCompressed), &Destination);
+  FreePool (Buffer);
+  UT_ASSERT_STATUS_EQUAL (Status, RETURN_INVALID_PARAMETER);
+  UT_ASSERT_TRUE (Destination == NULL);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Decompress copies of the test buffer with random bytes changed. Nothing
+  is asserted about the result; the address sanitizer checks that no
+  access goes beyond the buffers sized from the corrupted header.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RandomCorruptionShouldStayInBuffers (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8          *Buffer;
+  UINT8          *Destination;
+  UINT32         Round;
+  UINT32         Offset;
+  RETURN_STATUS  Status;
+
+  Buffer = AllocatePool (sizeof (mTestCompressed));
+  UT_ASSERT_NOT_NULL (Buffer);
+
+  for (Round = 0; Round < TEST_CORRUPTIONS; Round++) {
+    CopyMem (Buffer, mTestCompressed, sizeof (mTestCompressed));
+
+    //
+    // Half of the rounds change the header or the block table.
+    //
+    if ((Round & 1) == 0) {
+      Offset = TestRandom () % (sizeof (LZMA_PARALLEL_HEADER) + (TEST_BLOCK_COUNT + 1) * sizeof (UINT32));
+    } else {
+      Offset = TestRandom () % sizeof (mTestCompressed);
+    }
+
+    Buffer[Offset] ^= (UINT8) ((TestRandom () >> 16) | 1);
+
+    Status = TestDecompress (Buffer, sizeof (mTestCompressed), &Destination);
+    if (!RETURN_ERROR (Status)) {
+      FreePool (Destination);
+    }
+  }
+
+  FreePool (Buffer);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  multi-block LZMA decompression and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      DecompressTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&DecompressTests, Framework, "LZMA Parallel Decompress Tests", "LzmaParallelDecompress", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DecompressTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (DecompressTests, "Decoded blocks should match the original data", "RoundTrip", DecompressShouldMatchPattern, NULL, NULL, NULL);
+  AddTestCase (DecompressTests, "Corrupted header or block table should be rejected", "Header", CorruptedHeaderShouldBeRejected, NULL, NULL, NULL);
+  AddTestCase (DecompressTests, "A block that fails to decode should fail the buffer", "Block", CorruptedBlockShouldFail, NULL, NULL, NULL);
+  AddTestCase (DecompressTests, "Random corruption should stay in the buffers", "Random", RandomCorruptionShouldStayInBuffers, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -8,6 +8,56 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "InternalBm.h"
 
+/**
+  Connect the drivers to the controllers one level at a time.
+
+  Each pass starts the drivers on all the controllers known so far, without
+  descending into the children they produce, and the passes repeat until no
+  more controllers show up. Every controller tree so gets its bus driver
+  started before any other tree is walked to the end, and the work a bus
+  driver completes from timer events (such as USB hub enumeration) proceeds
+  while the remaining trees are being connected.
+
+  The time taken by every driver Start() is recorded by the DXE Core
+  performance measurements of ConnectController().
+**/
+VOID
+BmConnectAllControllersBreadthFirst (
+  VOID
+  )
+{
+  UINTN       HandleCount;
+  UINTN       PreviousHandleCount;
+  EFI_HANDLE  *HandleBuffer;
+  UINTN       Index;
+
+  PreviousHandleCount = 0;
+  while (TRUE) {
+    gBS->LocateHandleBuffer (
+           AllHandles,
+           NULL,
+           NULL,
+           &HandleCount,
+           &HandleBuffer
+           );
+    if (HandleCount == PreviousHandleCount) {
+      if (HandleBuffer != NULL) {
+        FreePool (HandleBuffer);
+      }
+      break;
+    }
+
+    for (Index = 0; Index < HandleCount; Index++) {
+      gBS->ConnectController (HandleBuffer[Index], NULL, NULL, FALSE);
+    }
+
+    if (HandleBuffer != NULL) {
+      FreePool (HandleBuffer);
+    }
+    PreviousHandleCount = HandleCount;
+  }
+}
+
 /**
   Connect all the drivers to all the controllers.
 
@@ -25,7 +75,13 @@ BmConnectAllDriversToAllControllers (
   EFI_HANDLE  *HandleBuffer;
   UINTN       Index;
 
+  PERF_INMODULE_BEGIN ("BdsConnectAll");
+
   do {
+    if (PcdGetBool (PcdConnectAllBreadthFirst)) {
+      BmConnectAllControllersBreadthFirst ();
+    }
+
     //
     // Connect All EFI 1.10 drivers following EFI 1.10 algorithm
     //
@@ -54,6 +110,8 @@ BmConnectAllDriversToAllControllers (
     Status = gDS->Dispatch ();
 
   } while (!EFI_ERROR (Status));
+
+  PERF_INMODULE_END ("BdsConnectAll");
 }
 
 /**
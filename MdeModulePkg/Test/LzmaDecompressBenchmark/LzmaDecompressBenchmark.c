@@ -0,0 +1,361 @@
+/** @file
+  Host based benchmark of the LZMA decompression.
+
+  It decodes a built-in buffer, and the file named on the command line if
+  there is one, and reports the throughput in MB of decoded data per
+  second. The file must be "LzmaCompress -e" output, for example a
+  compressed DXE FV of a platform:
+
+    LzmaCompress -e -o DXEFV.lzma DXEFV.Fv
+    LzmaDecompressBenchmarkHost DXEFV.lzma
+
+  The built-in buffer is very repetitive, so only the file gives numbers
+  that are representative of a firmware volume.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "../../Library/LzmaCustomDecompressLib/LzmaDecompressLibInternal.h"
+
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME         "LZMA Decompress Benchmark"
+#define UNIT_TEST_APP_VERSION      "1.0"
+
+#define BENCHMARK_DECODED_SIZE     (SIZE_2MB + SIZE_512KB)
+#define BENCHMARK_BYTES            (256 * 1024 * 1024)
+
+//
+// The LZMA properties and the 64-bit decoded size. The SDK headers can't be
+// included next to <stdio.h>, they define their own size_t.
+//
+#define BENCHMARK_LZMA_HEADER_SIZE  13
+
+//
+// "LzmaCompress -e" output for BENCHMARK_DECODED_SIZE bytes of
+// BenchmarkPattern().
+//
+GLOBAL_REMOVE_IF_UNREFERENCED CONST UINT8  mBenchmarkCompressed[] = {
+  0x5d, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,
+  0x0f, 0x57, 0x02, 0x68, 0xc6, 0x78, 0xce, 0xd8, 0x0f, 0x90, 0xe6, 0xeb, 0xb6, 0xdd, 0x1f, 0x70,
+  0x62, 0xb0, 0x21, 0x27, 0x14, 0xf9, 0xb1, 0x95, 0x8a, 0x58, 0x60, 0x21, 0x7a, 0x2c, 0xac, 0xe7,
+  0x77, 0x98, 0xdf, 0x45, 0x86, 0xda, 0xac, 0x69, 0x34, 0x69, 0x0d, 0x38, 0x64, 0x55, 0xe2, 0xb7,
+  0x18, 0x16, 0xaa, 0x44, 0x15, 0x99, 0xbe, 0xa2, 0x90, 0x8b, 0x09, 0xd6, 0x1f, 0xc9, 0x47, 0xff,
+  0xef, 0xde, 0x9a, 0xc6, 0x8d, 0xbf, 0x33, 0xd9, 0xb5, 0xd4, 0x6a, 0xaf, 0x16, 0xed, 0xf4, 0x83,
+  0xbc, 0x69, 0x74, 0xd1, 0x23, 0xe6, 0xc7, 0x84, 0x1e, 0x12, 0x9b, 0xa6, 0x75, 0x90, 0x56, 0x90,
+  0x89, 0x72, 0x1a, 0x58, 0x7f, 0x5a, 0x3e, 0x80, 0x06, 0x4c, 0x56, 0x65, 0x3f, 0x78, 0xeb, 0xad,
+  0xd7, 0xc6, 0x55, 0x3b, 0x1f, 0x67, 0xe3, 0xa8, 0x37, 0x8a, 0x19, 0x99, 0xf2, 0x4c, 0xe6, 0xa5,
+  0xcb, 0x00, 0x71, 0x89, 0x5b, 0xcf, 0x16, 0x23, 0x81, 0x92, 0xf1, 0xf7, 0x07, 0xbf, 0x9b, 0xee,
+  0xdc, 0xfa, 0x16, 0x13, 0x0e, 0x51, 0xd0, 0x10, 0x69, 0x88, 0x3e, 0xde, 0xe4, 0xbd, 0xc3, 0xa6,
+  0xe0, 0x95, 0x83, 0x2b, 0x4b, 0xa8, 0x95, 0x75, 0x98, 0x7a, 0x1b, 0x8a, 0x02, 0x74, 0x78, 0xa6,
+  0xa1, 0xfc, 0x6a, 0x60, 0xf0, 0xa5, 0xad, 0x2a, 0xc8, 0x55, 0xc4, 0xcf, 0x2f, 0x06, 0x0f, 0x62,
+  0x1b, 0x9d, 0x85, 0xb9, 0x15, 0x1c, 0xc8, 0x9b, 0x94, 0x19, 0x66, 0xd4, 0x06, 0x20, 0x86, 0x26,
+  0xa3, 0xad, 0x7c, 0x68, 0x84, 0x02, 0x2f, 0x7b, 0x8f, 0x2b, 0x57, 0x72, 0x32, 0x56, 0xb3, 0xd8,
+  0x88, 0x0f, 0x4d, 0x7f, 0x03, 0x56, 0x3d, 0xc3, 0xd5, 0x98, 0x37, 0xc3, 0xea, 0xe0, 0xfd, 0xc6,
+  0xdc, 0x99, 0x4c, 0x25, 0x30, 0x12, 0x48, 0x62, 0xb8, 0xa9, 0x46, 0xf3, 0xed, 0x3b, 0xfa, 0x37,
+  0x5a, 0x95, 0xa0, 0x0c, 0x16, 0xfa, 0x15, 0xbe, 0x24, 0x6f, 0x40, 0x14, 0xf3, 0x9e, 0xb5, 0x8b,
+  0x69, 0x49, 0x3b, 0x6f, 0x4f, 0xc3, 0xa8, 0xc4, 0xb5, 0x18, 0x32, 0x3b, 0x0f, 0x52, 0xe5, 0x4d,
+  0x85, 0x27, 0x02, 0xa4, 0xe9, 0x2e, 0x6e, 0x91, 0x7f, 0x9b, 0x7a, 0x07, 0xb3, 0xdf, 0x9b, 0x52,
+  0x09, 0x2c, 0x41, 0xc5, 0xff, 0x3a, 0x4f, 0xf7, 0x00, 0x6b, 0x1a, 0xf9, 0x01, 0x1a, 0x6a, 0xad,
+  0xa6, 0xd4, 0x0e, 0x8f, 0xe9, 0x72, 0xb2, 0x9a, 0xc9, 0xf7, 0x7e, 0x6e, 0xe8, 0xa2, 0x7c, 0xcd,
+  0x57, 0x2f, 0xe5, 0xe7, 0x0c, 0xcb, 0xea, 0x2d, 0xdb, 0xf9, 0x6c, 0x03, 0x06, 0x99, 0xd6, 0x5d,
+  0x67, 0x43, 0x75, 0x1e, 0x93, 0xab, 0xb8, 0x4c, 0x52, 0xf2, 0x96, 0xca, 0x28, 0xc4, 0x87, 0xdd,
+  0xdf, 0xe8, 0xa0, 0xa5, 0x4c, 0x9c, 0xf6, 0x0b, 0x3f, 0x3d, 0x07, 0x52, 0x9f, 0x6e, 0xb9, 0xf9,
+  0x3c, 0x0f, 0x9e, 0x1b, 0xb5, 0x09, 0x8b, 0x0e, 0xf2, 0x13, 0xd8, 0x8b, 0xcb, 0xe9, 0x3e, 0x7e,
+  0xfb, 0x5c, 0x8e, 0x94, 0x8e, 0x4b, 0xd0, 0x5c, 0xe4, 0xcc, 0x1b, 0x53, 0xf9, 0x4f, 0xff, 0x74,
+  0xb5, 0x1b, 0x55, 0x44, 0x86, 0x1f, 0x35, 0x21, 0xdb, 0x50, 0x52, 0x60, 0x7a, 0xe7, 0xe2, 0xdd,
+  0x90, 0x15, 0x92, 0x16, 0x9d, 0xad, 0xe5, 0x84, 0xc1, 0x68, 0x9d, 0xbc, 0x38, 0x1b, 0xfb, 0x7e,
+  0x52, 0xce, 0x79, 0x5e, 0xa4, 0x81, 0x11, 0xd7, 0x63, 0x8c, 0x9e, 0xae, 0xf1, 0x57, 0xc3, 0xe7,
+  0xf5, 0x39, 0x0d, 0x92, 0x43, 0x28, 0xa5, 0x87, 0xe3, 0xb0, 0x81, 0x7e, 0xae, 0x97, 0x06, 0x34,
+  0xec, 0x75, 0x50, 0x4a, 0x90, 0x74, 0xdb, 0xd6, 0x80, 0xb6, 0xb1, 0x1e, 0xf2, 0xfb, 0x67, 0xbb,
+  0xca, 0x05, 0xac, 0xc0, 0x75, 0x08, 0x0a, 0xcd, 0xd7, 0x1b, 0xcd, 0xab, 0xef, 0x56, 0x46, 0xae,
+  0xfd, 0x02, 0xcf, 0x8d, 0x70, 0x5a, 0xde, 0xe9, 0x92, 0xf7, 0xf2, 0x2d, 0xe1, 0x6f, 0x08, 0x58,
+  0x1c, 0x6f, 0xd0, 0x15, 0x1c, 0xa0, 0x53, 0xfa, 0x42, 0x4d, 0x74, 0xfe, 0x20, 0x8b, 0x60, 0x29,
+  0x4b, 0xe7, 0xe9, 0x93, 0x90, 0xbf, 0xe1, 0xff, 0x13, 0x6c, 0x4f, 0x2a, 0xac, 0x9d, 0xfc, 0x49,
+  0x62, 0xa4, 0x50, 0xf0, 0x48, 0xb2, 0x5b, 0x62, 0x14, 0x23, 0x12, 0x0a, 0x28, 0x0d, 0x6f, 0xb4,
+  0xed, 0x07, 0x6c, 0xf3, 0x64, 0xc3, 0x39, 0x12, 0x80, 0x12, 0xab, 0x36, 0xd8, 0xdb, 0xeb, 0xc4,
+  0xb2, 0x78, 0x99, 0xce, 0x7a, 0x94, 0x74, 0xe5, 0xd9, 0x08, 0xd8, 0x42, 0xf0, 0x69, 0x5f, 0xd1,
+  0xad, 0x0b, 0xf2, 0x3f, 0xbc, 0x00, 0x9e, 0x8e, 0xb7, 0x70, 0x71, 0x10, 0xa8, 0xd0, 0xc3, 0x4e,
+  0xa6, 0x3b, 0x61, 0x2a, 0x14, 0x93, 0x25, 0xc9, 0xb4, 0x55, 0x93, 0x27, 0xb1, 0x46, 0xff, 0x72,
+  0x82, 0x87, 0x18, 0x86, 0xd6, 0xac, 0x75, 0x96, 0xfe, 0x15, 0x8c, 0xc2, 0x78, 0xde, 0xfa, 0xf9,
+  0x9d, 0xba, 0x34, 0xfa, 0x30, 0x6a, 0x3e, 0x97, 0x93, 0x79, 0x34, 0xfb, 0xf3, 0xd7, 0x9b, 0x2a,
+  0xaa, 0xaf, 0x2b, 0x2b, 0x77, 0xa9, 0x0d, 0x30, 0xb7, 0xa9, 0xe3, 0x71, 0x1a, 0x60, 0x0a, 0x15,
+  0x37, 0xfe, 0x5f, 0xca, 0x1f, 0x74, 0x72, 0x9b, 0x50, 0x24, 0xce, 0xaf, 0x9c, 0x0f, 0x51, 0x47,
+  0xb9, 0x0d, 0x48, 0x4a, 0x6c, 0xde, 0x37, 0x00, 0xee, 0x1e, 0x9f, 0x87, 0x61, 0x86, 0xc3, 0xd8,
+  0x89, 0xa8, 0xf4, 0x15, 0xd7, 0xdf, 0x9f, 0xdd, 0x8c, 0xdb, 0x0f, 0x49, 0xf5, 0xb1, 0x5d, 0xca,
+  0x77, 0xf2, 0xb5, 0x31, 0x65, 0x68, 0x28, 0x91, 0x81, 0x7b, 0x7d, 0x57, 0x06, 0x8d, 0x36, 0xbf,
+  0xa6, 0x93, 0x57, 0xd5, 0x89, 0x5b, 0xce, 0xfe, 0x9e, 0x51, 0x24, 0xe9, 0x7f, 0xde, 0xe1, 0x54,
+  0x6d, 0xdb, 0x62, 0x4b, 0x48, 0x67, 0xf9, 0x7b, 0x4b, 0x89, 0xa5, 0x58, 0x30, 0xa9, 0x55, 0x28,
+  0x8f, 0x7a, 0xcf, 0x94, 0x11, 0x74, 0x52, 0x16, 0x9b, 0x1c, 0x79, 0xb7, 0x1d, 0x61, 0xc9, 0x2f,
+  0x3f, 0x7b, 0x06, 0x64, 0x39, 0x9b, 0x70, 0x54, 0xd9, 0xff, 0x7d, 0x1e, 0x67, 0x98, 0x75, 0x9a,
+  0xe1, 0x6d, 0x1f, 0x64, 0xcd, 0xb9, 0x1b, 0x8f, 0x22, 0xc8, 0x1f, 0xbc, 0x02, 0x59, 0xf0, 0xa4,
+  0x88, 0x63, 0xee, 0x05, 0xbf, 0x01, 0xae, 0x7b, 0x4d, 0x80, 0x2e, 0xe2, 0x43, 0xa8, 0x06, 0xdd,
+  0xe0, 0xf0, 0x63, 0x71, 0xb0, 0x29, 0x82, 0x65, 0x0e, 0xfd, 0xad, 0xb6, 0xec, 0x48, 0xe7, 0xf2,
+  0x6d, 0x98, 0x1f, 0xd7, 0xea, 0xf2, 0xa5, 0xbd, 0x2e, 0x5f, 0xaa, 0x0f, 0x3e, 0x4b, 0x66, 0x42,
+  0x90, 0x13, 0x0e, 0xff, 0x10, 0x93, 0xf8, 0x71, 0x78, 0x59, 0xf8, 0x0b, 0xcd, 0xff, 0x95, 0x28,
+  0x46, 0x0f, 0xa9, 0xfc, 0x7c, 0xde, 0xfb, 0x9a, 0x30, 0x2e, 0x56, 0xc0, 0x8f, 0x85, 0xf3, 0x83,
+  0x81, 0xc0, 0x65, 0xc4, 0x25, 0x53, 0xf8, 0xf5, 0x91, 0x36, 0x31, 0x05, 0xa5, 0xb0, 0xee, 0x6f,
+  0xc1, 0x70, 0x4d, 0x47, 0x0c, 0xd1, 0x91, 0x11, 0xaa, 0xad, 0x60, 0x1d, 0xba, 0xce, 0xb1, 0x27,
+  0x18, 0x5c, 0x59, 0x86, 0xe9, 0x66, 0x52, 0x58, 0xbe, 0xe9, 0x76, 0xac, 0x59, 0xe4, 0xe5, 0x5b,
+  0x05, 0x08, 0xf9, 0xc7, 0xda, 0xad, 0xfc, 0xfb, 0x52, 0x2b, 0x74, 0xcd, 0x1e, 0x5b, 0x20, 0x42,
+  0xf9, 0xdd, 0x53, 0x3d, 0xf8, 0x29, 0x64, 0x09, 0x3b, 0x80, 0xcb, 0x2a, 0x6c, 0xdf, 0xb5, 0x3b,
+  0xf0, 0xc4, 0xbd, 0x2e, 0x5f, 0xaa, 0x0f, 0x3e, 0x4b, 0x66, 0x42, 0x90, 0x13, 0x0e, 0xff, 0x10,
+  0x93, 0xf8, 0x71, 0x78, 0x59, 0xf8, 0x0b, 0xcd, 0xff, 0x95, 0x28, 0x46, 0x0f, 0xa9, 0xfc, 0x7c,
+  0xde, 0xfb, 0x9a, 0x30, 0x2e, 0x56, 0xc0, 0x8f, 0x85, 0xf3, 0x83, 0x81, 0xc0, 0x65, 0xc4, 0x25,
+  0x53, 0xf8, 0xf5, 0x91, 0x36, 0x31, 0x05, 0xa5, 0xb0, 0xee, 0x6f, 0xc1, 0x70, 0x4d, 0x47, 0x0c,
+  0xd1, 0x91, 0x11, 0xaa, 0xad, 0x60, 0x1d, 0xba, 0xce, 0xb1, 0x27, 0x18, 0x5c, 0x59, 0x86, 0xe4,
+  0x60, 0x55, 0x10, 0x00, 0x00,
+};
+
+CHAR8  *mBenchmarkFile;
+
+/**
+  Return the byte at Index of the data that mBenchmarkCompressed decodes to.
+
+  @param[in]  Index  Offset in the decoded data.
+
+  @return The byte at Index.
+
+**/
+UINT8
+BenchmarkPattern (
+  IN UINTN  Index
+  )
+{
+  return (UINT8) (Index * 7 + (Index >> 12));
+}
+
+/**
+  Decode Source repeatedly, until about BENCHMARK_BYTES have been decoded,
+  and report the throughput.
+
+  @param[in]   Name         Name of the buffer in the report.
+  @param[in]   Source       The LZMA compressed buffer.
+  @param[in]   SourceSize   Size of Source.
+  @param[out]  Destination  The decoded data. The caller frees it.
+
+  @retval RETURN_SUCCESS           Source was decoded.
+  @retval RETURN_INVALID_PARAMETER Source is corrupted.
+  @retval RETURN_OUT_OF_RESOURCES  The buffers could not be allocated.
+
+**/
+RETURN_STATUS
+BenchmarkDecompress (
+  IN  CONST CHAR8  *Name,
+  IN  CONST UINT8  *Source,
+  IN  UINT32       SourceSize,
+  OUT UINT8        **Destination
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         DestinationSize;
+  UINT32         ScratchSize;
+  VOID           *Scratch;
+  UINT32         Round;
+  UINT32         Rounds;
+  clock_t        Start;
+  double         Seconds;
+
+  *Destination = NULL;
+  Scratch      = NULL;
+  if ((SourceSize < BENCHMARK_LZMA_HEADER_SIZE) ||
+      (ReadUnaligned64 ((CONST UINT64 *) (Source + BENCHMARK_LZMA_HEADER_SIZE - 8)) > MAX_UINT32)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  LzmaUefiDecompressGetInfo (Source, SourceSize, &DestinationSize, &ScratchSize);
+  if (DestinationSize == 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  *Destination = AllocatePool (DestinationSize);
+  Scratch      = AllocatePool (ScratchSize);
+  if ((*Destination == NULL) || (Scratch == NULL)) {
+    Status = RETURN_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Rounds = MAX (BENCHMARK_BYTES / DestinationSize, 1);
+  Start  = clock ();
+  for (Round = 0; Round < Rounds; Round++) {
+    Status = LzmaUefiDecompress (Source, SourceSize, *Destination, Scratch);
+    if (RETURN_ERROR (Status)) {
+      goto Done;
+    }
+  }
+
+  Seconds = (double) (clock () - Start) / CLOCKS_PER_SEC;
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: %u bytes to %u bytes, %u rounds: %u MB/s\n",
+    Name,
+    SourceSize,
+    DestinationSize,
+    Rounds,
+    (UINT32) ((double) DestinationSize * Rounds / Seconds / 1000000)
+    ));
+
+Done:
+  if (Scratch != NULL) {
+    FreePool (Scratch);
+  }
+
+  if (RETURN_ERROR (Status) && (*Destination != NULL)) {
+    FreePool (*Destination);
+    *Destination = NULL;
+  }
+
+  return Status;
+}
+
+/**
+  Report the throughput on the built-in buffer, and check that it decodes
+  to BenchmarkPattern().
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BuiltInBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  RETURN_STATUS  Status;
+  UINT8          *Destination;
+  UINTN          Index;
+
+  Status = BenchmarkDecompress ("Built-in", mBenchmarkCompressed, sizeof (mBenchmarkCompressed), &Destination);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  for (Index = 0; Index < BENCHMARK_DECODED_SIZE; Index++) {
+    if (Destination[Index] != BenchmarkPattern (Index)) {
+      break;
+    }
+  }
+
+  FreePool (Destination);
+  UT_ASSERT_EQUAL (Index, BENCHMARK_DECODED_SIZE);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Report the throughput on the file named on the command line.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED             The test passed.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  The test failed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FileBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FILE           *File;
+  long           FileSize;
+  UINT8          *Source;
+  UINT8          *Destination;
+  RETURN_STATUS  Status;
+
+  File = fopen (mBenchmarkFile, "rb");
+  UT_ASSERT_NOT_NULL (File);
+
+  Source = NULL;
+  if ((fseek (File, 0, SEEK_END) == 0) && ((FileSize = ftell (File)) > 0) && (FileSize <= MAX_UINT32)) {
+    Source = AllocatePool (FileSize);
+    rewind (File);
+    if ((Source != NULL) && (fread (Source, 1, FileSize, File) != (size_t) FileSize)) {
+      FreePool (Source);
+      Source = NULL;
+    }
+  }
+
+  fclose (File);
+  UT_ASSERT_NOT_NULL (Source);
+
+  Status = BenchmarkDecompress (mBenchmarkFile, Source, (UINT32) FileSize, &Destination);
+  FreePool (Source);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  FreePool (Destination);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  LZMA decompression benchmark and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      BenchmarkTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&BenchmarkTests, Framework, "LZMA Decompress Benchmark", "LzmaDecompress.Benchmark", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for BenchmarkTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (BenchmarkTests, "LzmaUefiDecompress throughput on the built-in buffer", "BuiltIn", BuiltInBenchmark, NULL, NULL, NULL);
+  if (mBenchmarkFile != NULL) {
+    AddTestCase (BenchmarkTests, "LzmaUefiDecompress throughput on the given file", "File", FileBenchmark, NULL, NULL, NULL);
+  }
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+  The optional argument is the name of an LZMA compressed file to benchmark.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  if (argc > 1) {
+    mBenchmarkFile = argv[1];
+  }
+
+  return UnitTestingEntry ();
+}
@@ -48,6 +48,383 @@ DISK_IO_PRIVATE_DATA        gDiskIoPrivateDataTemplate = {
   }
 };
 
+/**
+  Report the counters of the read cache of the Disk IO device instance.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoCacheReport (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "DiskIo: Read cache of %Lu blocks, hits/misses = %Lu/%Lu\n",
+    (UINT64) Instance->CacheBlockNum,
+    Instance->CacheHits,
+    Instance->CacheMisses
+    ));
+}
+
+/**
+  Report the counters of the read cache when the boot manager is about to
+  boot, which is when the disks and partitions have been discovered.
+
+  @param Event       The ReadyToBoot event.
+  @param Context     Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+EFIAPI
+DiskIoCacheOnReadyToBoot (
+  IN EFI_EVENT                Event,
+  IN VOID                     *Context
+  )
+{
+  DiskIoCacheReport ((DISK_IO_PRIVATE_DATA *) Context);
+}
+
+/**
+  Set up the read cache of the Disk IO device instance.
+
+  The cache is only created for a device which is not a logical partition:
+  the partitions and file systems read through the Disk IO of the whole
+  disk, so a single cache serves all of them. Failure to allocate the cache
+  is not fatal, the device is then accessed uncached.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoInitializeCache (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  EFI_BLOCK_IO_MEDIA          *Media;
+  UINTN                       CacheBlockNum;
+  UINTN                       HashSize;
+  UINTN                       Index;
+
+  InitializeListHead (&Instance->CacheLru);
+  EfiInitializeLock (&Instance->CacheLock, TPL_NOTIFY);
+
+  Media = Instance->BlockIo->Media;
+  if ((PcdGet32 (PcdDiskIoCacheSize) == 0) || Media->LogicalPartition || (Media->BlockSize == 0)) {
+    return;
+  }
+
+  CacheBlockNum = PcdGet32 (PcdDiskIoCacheSize) / Media->BlockSize;
+  if (CacheBlockNum == 0) {
+    return;
+  }
+
+  HashSize = GetPowerOfTwo32 ((UINT32) CacheBlockNum);
+  Instance->CacheEntries = AllocateZeroPool (CacheBlockNum * sizeof (DISK_IO_CACHE_ENTRY));
+  Instance->CacheData    = AllocatePool (CacheBlockNum * Media->BlockSize);
+  Instance->CacheHash    = AllocatePool (HashSize * sizeof (LIST_ENTRY));
+  if ((Instance->CacheEntries == NULL) || (Instance->CacheData == NULL) || (Instance->CacheHash == NULL)) {
+    DEBUG ((DEBUG_WARN, "DiskIo: No enough memory for the read cache\n"));
+    if (Instance->CacheEntries != NULL) {
+      FreePool (Instance->CacheEntries);
+      Instance->CacheEntries = NULL;
+    }
+    if (Instance->CacheData != NULL) {
+      FreePool (Instance->CacheData);
+      Instance->CacheData = NULL;
+    }
+    if (Instance->CacheHash != NULL) {
+      FreePool (Instance->CacheHash);
+      Instance->CacheHash = NULL;
+    }
+    return;
+  }
+
+  for (Index = 0; Index < HashSize; Index++) {
+    InitializeListHead (&Instance->CacheHash[Index]);
+  }
+
+  for (Index = 0; Index < CacheBlockNum; Index++) {
+    Instance->CacheEntries[Index].Data = Instance->CacheData + Index * Media->BlockSize;
+    InsertTailList (&Instance->CacheLru, &Instance->CacheEntries[Index].LruLink);
+  }
+
+  Instance->CacheBlockNum = CacheBlockNum;
+  Instance->CacheHashMask = HashSize - 1;
+  Instance->CacheMediaId  = Media->MediaId;
+
+  EfiCreateEventReadyToBootEx (
+    TPL_CALLBACK,
+    DiskIoCacheOnReadyToBoot,
+    Instance,
+    &Instance->CacheReportEvent
+    );
+}
+
+/**
+  Release the read cache of the Disk IO device instance.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoFreeCache (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  if (Instance->CacheEntries == NULL) {
+    return;
+  }
+
+  if (Instance->CacheReportEvent != NULL) {
+    gBS->CloseEvent (Instance->CacheReportEvent);
+    Instance->CacheReportEvent = NULL;
+  }
+
+  DiskIoCacheReport (Instance);
+
+  FreePool (Instance->CacheEntries);
+  FreePool (Instance->CacheData);
+  FreePool (Instance->CacheHash);
+  Instance->CacheEntries  = NULL;
+  Instance->CacheData     = NULL;
+  Instance->CacheHash     = NULL;
+  Instance->CacheBlockNum = 0;
+}
+
+/**
+  Look up a block in the read cache. The caller holds CacheLock.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Lba         The logical block address to look up.
+
+  @return The cache entry holding the block, or NULL if the block is not cached.
+**/
+DISK_IO_CACHE_ENTRY *
+DiskIoCacheLookup (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN EFI_LBA                  Lba
+  )
+{
+  LIST_ENTRY                  *Bucket;
+  LIST_ENTRY                  *Link;
+  DISK_IO_CACHE_ENTRY         *Entry;
+
+  Bucket = &Instance->CacheHash[(UINTN) Lba & Instance->CacheHashMask];
+  for (Link = GetFirstNode (Bucket); !IsNull (Bucket, Link); Link = GetNextNode (Bucket, Link)) {
+    Entry = DISK_IO_CACHE_ENTRY_FROM_HASHLINK (Link);
+    if (Entry->Lba == Lba) {
+      return Entry;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Drop a cache entry and make it the first one to be reused. The caller holds
+  CacheLock.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Entry       The cache entry to drop.
+**/
+VOID
+DiskIoCacheDropEntry (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN DISK_IO_CACHE_ENTRY      *Entry
+  )
+{
+  if (Entry->Valid) {
+    RemoveEntryList (&Entry->HashLink);
+    Entry->Valid = FALSE;
+  }
+
+  RemoveEntryList (&Entry->LruLink);
+  InsertTailList (&Instance->CacheLru, &Entry->LruLink);
+}
+
+/**
+  Invalidate the cached copies of a range of blocks.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+  @param Lba         The starting logical block address of the range.
+  @param Blocks      The number of blocks in the range.
+**/
+VOID
+DiskIoCacheInvalidate (
+  IN DISK_IO_PRIVATE_DATA     *Instance,
+  IN EFI_LBA                  Lba,
+  IN UINTN                    Blocks
+  )
+{
+  DISK_IO_CACHE_ENTRY         *Entry;
+  UINTN                       Index;
+
+  if (Instance->CacheEntries == NULL) {
+    return;
+  }
+
+  EfiAcquireLock (&Instance->CacheLock);
+  Instance->CacheGeneration++;
+  if (Blocks > Instance->CacheBlockNum) {
+    //
+    // Cheaper to check every cache entry than every block of the range.
+    //
+    for (Index = 0; Index < Instance->CacheBlockNum; Index++) {
+      Entry = &Instance->CacheEntries[Index];
+      if (Entry->Valid && (Entry->Lba >= Lba) && (Entry->Lba - Lba < Blocks)) {
+        DiskIoCacheDropEntry (Instance, Entry);
+      }
+    }
+  } else {
+    for (Index = 0; Index < Blocks; Index++) {
+      Entry = DiskIoCacheLookup (Instance, Lba + Index);
+      if (Entry != NULL) {
+        DiskIoCacheDropEntry (Instance, Entry);
+      }
+    }
+  }
+  EfiReleaseLock (&Instance->CacheLock);
+}
+
+/**
+  Invalidate the whole read cache. The caller holds CacheLock.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+**/
+VOID
+DiskIoCacheInvalidateAll (
+  IN DISK_IO_PRIVATE_DATA     *Instance
+  )
+{
+  UINTN                       Index;
+
+  Instance->CacheGeneration++;
+  for (Index = 0; Index < Instance->CacheBlockNum; Index++) {
+    if (Instance->CacheEntries[Index].Valid) {
+      DiskIoCacheDropEntry (Instance, &Instance->CacheEntries[Index]);
+    }
+  }
+}
+
+/**
+  Read blocks through the read cache.
+
+  The request is served from the cache when every block of it is cached.
+  Otherwise the blocks are read from the Block IO device and kept in the
+  cache, replacing the least recently used ones. The cache is dropped when
+  the media changes.
+
+  The Block IO read is done without holding CacheLock. Its data is only put
+  into the cache if no blocks were invalidated meanwhile.
+
+  @param Instance    Pointer to the DISK_IO_PRIVATE_DATA.
+  @param MediaId     ID of the medium to be read.
+  @param Lba         The starting logical block address to read from.
+  @param BufferSize  The size in bytes of Buffer, a multiple of the block size.
+  @param Buffer      A pointer to the destination buffer for the data.
+
+  @return The status returned by the Block IO ReadBlocks, or EFI_SUCCESS if
+          the data comes from the cache.
+**/
+EFI_STATUS
+DiskIoCachedReadBlocks (
+  IN  DISK_IO_PRIVATE_DATA    *Instance,
+  IN  UINT32                  MediaId,
+  IN  EFI_LBA                 Lba,
+  IN  UINTN                   BufferSize,
+  OUT UINT8                   *Buffer
+  )
+{
+  EFI_STATUS                  Status;
+  EFI_BLOCK_IO_PROTOCOL       *BlockIo;
+  EFI_BLOCK_IO_MEDIA          *Media;
+  DISK_IO_CACHE_ENTRY         *Entry;
+  UINTN                       Blocks;
+  UINTN                       Index;
+  UINT64                      Generation;
+
+  BlockIo = Instance->BlockIo;
+  Media   = BlockIo->Media;
+  Blocks  = BufferSize / Media->BlockSize;
+
+  if ((Instance->CacheEntries == NULL) || (Blocks == 0) ||
+      (BufferSize > DISK_IO_CACHE_MAX_REQUEST_SIZE) || (Blocks > Instance->CacheBlockNum)) {
+    return BlockIo->ReadBlocks (BlockIo, MediaId, Lba, BufferSize, Buffer);
+  }
+
+  EfiAcquireLock (&Instance->CacheLock);
+  if ((Instance->CacheMediaId != Media->MediaId) || !Media->MediaPresent) {
+    DiskIoCacheInvalidateAll (Instance);
+    Instance->CacheMediaId = Media->MediaId;
+  }
+
+  //
+  // Only serve the request from the cache if Block IO would accept it.
+  //
+  if ((MediaId == Media->MediaId) && Media->MediaPresent) {
+    for (Index = 0; Index < Blocks; Index++) {
+      if (DiskIoCacheLookup (Instance, Lba + Index) == NULL) {
+        break;
+      }
+    }
+
+    if (Index == Blocks) {
+      for (Index = 0; Index < Blocks; Index++) {
+        Entry = DiskIoCacheLookup (Instance, Lba + Index);
+        CopyMem (Buffer + Index * Media->BlockSize, Entry->Data, Media->BlockSize);
+        RemoveEntryList (&Entry->LruLink);
+        InsertHeadList (&Instance->CacheLru, &Entry->LruLink);
+      }
+
+      Instance->CacheHits++;
+      EfiReleaseLock (&Instance->CacheLock);
+      return EFI_SUCCESS;
+    }
+  }
+
+  Instance->CacheMisses++;
+  Generation = Instance->CacheGeneration;
+  EfiReleaseLock (&Instance->CacheLock);
+
+  Status = BlockIo->ReadBlocks (BlockIo, MediaId, Lba, BufferSize, Buffer);
+
+  EfiAcquireLock (&Instance->CacheLock);
+  if (EFI_ERROR (Status) || (Instance->CacheMediaId != Media->MediaId)) {
+    //
+    // The media may have changed under the read.
+    //
+    DiskIoCacheInvalidateAll (Instance);
+    Instance->CacheMediaId = Media->MediaId;
+    EfiReleaseLock (&Instance->CacheLock);
+    return Status;
+  }
+
+  if (Generation != Instance->CacheGeneration) {
+    //
+    // Blocks were written while the read was in progress, the data read may
+    // predate the write.
+    //
+    EfiReleaseLock (&Instance->CacheLock);
+    return Status;
+  }
+
+  for (Index = 0; Index < Blocks; Index++) {
+    Entry = DiskIoCacheLookup (Instance, Lba + Index);
+    if (Entry == NULL) {
+      Entry = DISK_IO_CACHE_ENTRY_FROM_LRULINK (GetPreviousNode (&Instance->CacheLru, &Instance->CacheLru));
+      DiskIoCacheDropEntry (Instance, Entry);
+      Entry->Lba   = Lba + Index;
+      Entry->Valid = TRUE;
+      InsertTailList (&Instance->CacheHash[(UINTN) Entry->Lba & Instance->CacheHashMask], &Entry->HashLink);
+    }
+
+    CopyMem (Entry->Data, Buffer + Index * Media->BlockSize, Media->BlockSize);
+    RemoveEntryList (&Entry->LruLink);
+    InsertHeadList (&Instance->CacheLru, &Entry->LruLink);
+  }
+  EfiReleaseLock (&Instance->CacheLock);
+
+  return Status;
+}
+
 /**
   Test to see if this driver supports ControllerHandle.
 
@@ -185,6 +562,8 @@ DiskIoDriverBindingStart (
     goto ErrorExit;
   }
 
+  DiskIoInitializeCache (Instance);
+
   //
   // Install protocol interfaces for the Disk IO device.
   //
@@ -213,6 +592,7 @@ ErrorExit:
     }
 
     if (Instance != NULL) {
+      DiskIoFreeCache (Instance);
       FreePool (Instance);
     }
 
@@ -320,6 +700,7 @@ DiskIoDriverBindingStop (
       Instance->SharedWorkingBuffer,
       EFI_SIZE_TO_PAGES (PcdGet32 (PcdDiskIoDataBufferBlockNum) * Instance->BlockIo->Media->BlockSize)
       );
+    DiskIoFreeCache (Instance);
 
     Status = gBS->CloseProtocol (
                     ControllerHandle,
@@ -877,6 +1258,12 @@ DiskIo2ReadWriteDisk (
       //
       // Write
       //
+      DiskIoCacheInvalidate (
+        Instance,
+        Subtask->Lba,
+        (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length / Media->BlockSize : 1
+        );
+
       if (Subtask->WorkingBuffer != NULL) {
         //
         // A sub task before this one should be a block read operation, causing the WorkingBuffer filled with the entire one block data.
@@ -908,13 +1295,13 @@ DiskIo2ReadWriteDisk (
       // Read
       //
       if (SubtaskBlocking) {
-        Status = BlockIo->ReadBlocks (
-                            BlockIo,
-                            MediaId,
-                            Subtask->Lba,
-                            (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
-                            (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
-                            );
+        Status = DiskIoCachedReadBlocks (
+                   Instance,
+                   MediaId,
+                   Subtask->Lba,
+                   (Subtask->Length % Media->BlockSize == 0) ? Subtask->Length : Media->BlockSize,
+                   (Subtask->WorkingBuffer != NULL) ? Subtask->WorkingBuffer : Subtask->Buffer
+                   );
         if (!EFI_ERROR (Status) && (Subtask->WorkingBuffer != NULL)) {
           CopyMem (Subtask->Buffer, Subtask->WorkingBuffer + Subtask->Offset, Subtask->Length);
         }
@@ -24,6 +24,25 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
+//
+// Blocking reads larger than this bypass the read cache.
+//
+#define DISK_IO_CACHE_MAX_REQUEST_SIZE  SIZE_64KB
+
+//
+// One block of the read cache.
+//
+typedef struct {
+  LIST_ENTRY                      HashLink;
+  LIST_ENTRY                      LruLink;
+  EFI_LBA                         Lba;
+  BOOLEAN                         Valid;
+  UINT8                           *Data;
+} DISK_IO_CACHE_ENTRY;
+
+#define DISK_IO_CACHE_ENTRY_FROM_HASHLINK(a)  BASE_CR (a, DISK_IO_CACHE_ENTRY, HashLink)
+#define DISK_IO_CACHE_ENTRY_FROM_LRULINK(a)   BASE_CR (a, DISK_IO_CACHE_ENTRY, LruLink)
+
 #define DISK_IO_PRIVATE_DATA_SIGNATURE  SIGNATURE_32 ('d', 's', 'k', 'I')
 typedef struct {
   UINT32                          Signature;
@@ -37,6 +56,29 @@ typedef struct {
 
   EFI_LOCK                        TaskQueueLock;
   LIST_ENTRY                      TaskQueue;
+
+  //
+  // Read cache of the blocking reads, only set up for the whole disk so the
+  // partitions and file systems stacked on it share one copy of each block.
+  // The entries are kept in most recently used order in CacheLru.
+  //
+  UINTN                           CacheBlockNum;
+  DISK_IO_CACHE_ENTRY             *CacheEntries;
+  UINT8                           *CacheData;
+  LIST_ENTRY                      *CacheHash;
+  UINTN                           CacheHashMask;
+  LIST_ENTRY                      CacheLru;
+  UINT32                          CacheMediaId;
+  UINT64                          CacheHits;
+  UINT64                          CacheMisses;
+  //
+  // CacheLock protects the cache entries and lists. CacheGeneration changes
+  // whenever blocks are invalidated, so a read that raced with a write does
+  // not put the old data back into the cache.
+  //
+  EFI_LOCK                        CacheLock;
+  UINT64                          CacheGeneration;
+  EFI_EVENT                       CacheReportEvent;
 } DISK_IO_PRIVATE_DATA;
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO(a)  CR (a, DISK_IO_PRIVATE_DATA, DiskIo,  DISK_IO_PRIVATE_DATA_SIGNATURE)
 #define DISK_IO_PRIVATE_DATA_FROM_DISK_IO2(a) CR (a, DISK_IO_PRIVATE_DATA, DiskIo2, DISK_IO_PRIVATE_DATA_SIGNATURE)
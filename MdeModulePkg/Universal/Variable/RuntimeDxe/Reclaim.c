@@ -86,14 +86,17 @@ GetLbaAndOffsetByAddress (
 }
 
 /**
-  Writes a buffer to variable storage space, in the working block.
+  Writes a range of a buffer to variable storage space, in the working block.
 
-  This function writes a buffer to variable storage space into a firmware
-  volume block device. The destination is specified by parameter
-  VariableBase. Fault Tolerant Write protocol is used for writing.
+  This function writes the bytes at Offset to Offset + Length of a buffer
+  holding the whole variable storage into a firmware volume block device.
+  Fault Tolerant Write protocol is used for writing, in one FTW record, so
+  the variable storage holds either the old or the new bytes after a reset.
 
   @param  VariableBase   Base address of variable to write
   @param  VariableBuffer Point to the variable data buffer.
+  @param  Offset         Offset of the range in the variable storage.
+  @param  Length         Length of the range in bytes.
 
   @retval EFI_SUCCESS    The function completed successfully.
   @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
@@ -101,18 +104,21 @@ GetLbaAndOffsetByAddress (
 
 **/
 EFI_STATUS
-FtwVariableSpace (
+FtwVariableSpaceRange (
   IN EFI_PHYSICAL_ADDRESS   VariableBase,
-  IN VARIABLE_STORE_HEADER  *VariableBuffer
+  IN VARIABLE_STORE_HEADER  *VariableBuffer,
+  IN UINTN                  Offset,
+  IN UINTN                  Length
   )
 {
   EFI_STATUS                         Status;
   EFI_HANDLE                         FvbHandle;
   EFI_LBA                            VarLba;
   UINTN                              VarOffset;
-  UINTN                              FtwBufferSize;
   EFI_FAULT_TOLERANT_WRITE_PROTOCOL  *FtwProtocol;
 
+  ASSERT (Offset + Length <= VariableBuffer->Size);
+
   //
   // Locate fault tolerant write protocol.
   //
@@ -127,17 +133,15 @@ FtwVariableSpace (
   if (EFI_ERROR (Status)) {
     return Status;
   }
+
   //
   // Get LBA and Offset by address.
   //
-  Status = GetLbaAndOffsetByAddress (VariableBase, &VarLba, &VarOffset);
+  Status = GetLbaAndOffsetByAddress (VariableBase + Offset, &VarLba, &VarOffset);
   if (EFI_ERROR (Status)) {
     return EFI_ABORTED;
   }
 
-  FtwBufferSize = ((VARIABLE_STORE_HEADER *) ((UINTN) VariableBase))->Size;
-  ASSERT (FtwBufferSize == VariableBuffer->Size);
-
   //
   // FTW write record.
   //
@@ -145,11 +149,72 @@ FtwVariableSpace (
                           FtwProtocol,
                           VarLba,         // LBA
                           VarOffset,      // Offset
-                          FtwBufferSize,  // NumBytes
+                          Length,         // NumBytes
                           NULL,           // PrivateData NULL
                           FvbHandle,      // Fvb Handle
-                          (VOID *) VariableBuffer // write buffer
+                          (VOID *) ((UINT8 *) VariableBuffer + Offset) // write buffer
                           );
+  return Status;
+}
+
+/**
+  Writes a buffer to variable storage space, in the working block.
+
+  This function writes a buffer to variable storage space into a firmware
+  volume block device. The destination is specified by parameter
+  VariableBase. Fault Tolerant Write protocol is used for writing.
+
+  Only the range from the first to the last byte that differs from the
+  current variable storage is written. Reclaim keeps the variables in front
+  of the first deleted one in place and both stores end with erased space,
+  so this range is usually much smaller than the whole store. It is still
+  written as one FTW record, so the update stays atomic.
+
+  @param  VariableBase   Base address of variable to write
+  @param  VariableBuffer Point to the variable data buffer.
+  @param  WrittenSize    Return the number of bytes written.
+
+  @retval EFI_SUCCESS    The function completed successfully.
+  @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
+  @retval EFI_ABORTED    The function could not complete successfully.
+
+**/
+EFI_STATUS
+FtwVariableSpace (
+  IN  EFI_PHYSICAL_ADDRESS   VariableBase,
+  IN  VARIABLE_STORE_HEADER  *VariableBuffer,
+  OUT UINTN                  *WrittenSize
+  )
+{
+  EFI_STATUS                         Status;
+  UINTN                              FtwBufferSize;
+  UINT8                              *StoreBytes;
+  UINT8                              *BufferBytes;
+  UINTN                              First;
+  UINTN                              Last;
+
+  *WrittenSize = 0;
+
+  FtwBufferSize = ((VARIABLE_STORE_HEADER *) ((UINTN) VariableBase))->Size;
+  ASSERT (FtwBufferSize == VariableBuffer->Size);
+
+  //
+  // Find the range that differs from the variable storage.
+  //
+  StoreBytes  = (UINT8 *) (UINTN) VariableBase;
+  BufferBytes = (UINT8 *) VariableBuffer;
+  for (First = 0; First < FtwBufferSize && StoreBytes[First] == BufferBytes[First]; First++) {
+  }
+  if (First == FtwBufferSize) {
+    return EFI_SUCCESS;
+  }
+  for (Last = FtwBufferSize; StoreBytes[Last - 1] == BufferBytes[Last - 1]; Last--) {
+  }
+
+  Status = FtwVariableSpaceRange (VariableBase, VariableBuffer, First, Last - First);
+  if (!EFI_ERROR (Status)) {
+    *WrittenSize = Last - First;
+  }
 
   return Status;
 }
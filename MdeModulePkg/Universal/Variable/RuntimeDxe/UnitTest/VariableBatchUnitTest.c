@@ -0,0 +1,539 @@
+/** @file
+  Host based unit tests of the batched SetVariable payload routines.
+
+  The real VariableBatch.c packs variables into batches, and the SMM side of
+  the batches is simulated by walking them with VariableBatchGetItem(), like
+  SmmVariableSetVariableBatch() does. Every batch walked by the SMM side lies
+  in a buffer of exactly its size, so an item read out of bounds is caught by
+  an address sanitizer build as well as by the explicit checks.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+
+#include "VariableBatch.h"
+
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "Variable Batch Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_ENTRY_COUNT          120
+#define TEST_NAME_LENGTH          8
+#define TEST_MAX_DATA_SIZE        300
+#define TEST_STOPPED_BATCH        1
+#define TEST_STOPPED_ITEM         2
+#define TEST_FUZZ_ROUNDS          50000
+#define TEST_FUZZ_MAX_BATCH_SIZE  512
+#define TEST_FUZZ_MAX_ITEMS       8
+
+EFI_GUID                    mTestGuids[2] = {
+  { 0x8be4df61, 0x93ca, 0x11d2, { 0xaa, 0x0d, 0x00, 0xe0, 0x98, 0x03, 0x2b, 0x8c } },
+  { 0x4b3082a3, 0x80c6, 0x4d7e, { 0x9c, 0xd0, 0x58, 0x39, 0x17, 0x26, 0x5d, 0xf1 } }
+};
+CHAR16                      mTestNames[TEST_ENTRY_COUNT][TEST_NAME_LENGTH + 1];
+UINT8                       mTestData[TEST_MAX_DATA_SIZE];
+EDKII_VARIABLE_BATCH_ENTRY  mTestEntries[TEST_ENTRY_COUNT];
+EFI_STATUS                  mTestExpected[TEST_ENTRY_COUNT];
+UINT32                      mTestRandom = 1;
+
+/**
+  Returns the next value of a fixed seed pseudo random sequence, so every
+  run of the tests walks the same batches.
+
+  @return A pseudo random number
+
+**/
+UINT32
+TestRandom (
+  VOID
+  )
+{
+  mTestRandom = mTestRandom * 1103515245 + 12345;
+  return mTestRandom >> 8;
+}
+
+/**
+  Returns the status the simulated SMM side gives to an entry.
+
+  @param[in] Index  Index of the entry.
+
+  @return The status of the entry.
+
+**/
+EFI_STATUS
+TestEntryStatus (
+  IN UINTN  Index
+  )
+{
+  return ((Index % 5) == 3) ? EFI_WRITE_PROTECTED : EFI_SUCCESS;
+}
+
+/**
+  Fills mTestEntries with Boot####-like variables of various sizes, and a few
+  invalid entries.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The entries are ready.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BuildTestEntries (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+  UINTN  Char;
+
+  for (Index = 0; Index < TEST_MAX_DATA_SIZE; Index++) {
+    mTestData[Index] = (UINT8) (Index * 7 + 1);
+  }
+
+  for (Index = 0; Index < TEST_ENTRY_COUNT; Index++) {
+    mTestNames[Index][0] = L'B';
+    mTestNames[Index][1] = L'o';
+    mTestNames[Index][2] = L'o';
+    mTestNames[Index][3] = L't';
+    for (Char = 0; Char < 4; Char++) {
+      mTestNames[Index][4 + Char] = L"0123456789ABCDEF"[(Index >> (12 - Char * 4)) & 0xF];
+    }
+    //
+    // Odd name lengths too, so items do not all end aligned.
+    //
+    mTestNames[Index][TEST_NAME_LENGTH - (Index % 3)] = L'\0';
+
+    mTestEntries[Index].VariableName = mTestNames[Index];
+    mTestEntries[Index].VendorGuid   = &mTestGuids[Index % 2];
+    mTestEntries[Index].Attributes   = EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS;
+    mTestEntries[Index].DataSize     = (Index * 37) % TEST_MAX_DATA_SIZE;
+    mTestEntries[Index].Data         = mTestData + (Index % 4);
+    mTestEntries[Index].Status       = EFI_ABORTED;
+  }
+
+  //
+  // Entries that must be rejected without being sent
+  //
+  mTestEntries[7].VariableName   = NULL;
+  mTestEntries[19].VendorGuid    = NULL;
+  mTestEntries[33].Data          = NULL;
+  mTestEntries[33].DataSize      = 1;
+  mTestEntries[58].DataSize      = MAX_UINTN - 1;
+  mTestEntries[91].VariableName  = L"";
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Walks a batch like SmmVariableSetVariableBatch(), until an item is found
+  not to lie within it.
+
+  @param[in]  Batch      The batch.
+  @param[in]  BatchSize  Size in bytes of the buffer holding the batch.
+  @param[out] Items      Offsets of the items found, may be NULL.
+
+  @return The number of items found within the batch, or MAX_UINTN if an
+          item found goes past the end of the batch.
+
+**/
+UINTN
+TestWalkBatch (
+  IN  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH  *Batch,
+  IN  UINTN                                        BatchSize,
+  OUT UINTN                                        *Items OPTIONAL
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  *Item;
+  UINTN                                             Index;
+  UINTN                                             Offset;
+  UINTN                                             Byte;
+  volatile UINT8                                    Sum;
+
+  Offset = VARIABLE_BATCH_FIRST_ITEM_OFFSET;
+  for (Index = 0; Index < Batch->VariableCount; Index++) {
+    if (Items != NULL) {
+      Items[Index] = Offset;
+    }
+    if (EFI_ERROR (VariableBatchGetItem (Batch, BatchSize, &Offset, &Item))) {
+      break;
+    }
+
+    //
+    // Touch the whole item, as the SMM side does when it sets the variable.
+    //
+    if ((UINT8 *) Item->Variable.Name + Item->Variable.NameSize + Item->Variable.DataSize > (UINT8 *) Batch + BatchSize) {
+      return MAX_UINTN;
+    }
+    Sum = 0;
+    for (Byte = 0; Byte < Item->Variable.NameSize + Item->Variable.DataSize; Byte++) {
+      Sum += ((UINT8 *) Item->Variable.Name)[Byte];
+    }
+  }
+
+  return Index;
+}
+
+/**
+  Packs all the entries into batches of the size given by the context,
+  processes every batch on a simulated SMM side, and checks that every entry
+  gets its own result back.
+
+  The batch TEST_STOPPED_BATCH is stopped at its item TEST_STOPPED_ITEM with
+  EFI_ACCESS_DENIED, like a malformed item would, so the entries after it get
+  that status.
+
+  @param[in] Context  Pointer to the payload size, a UINTN.
+
+  @retval UNIT_TEST_PASSED             Every entry got its expected status.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  An entry was packed or unpacked wrong.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PackedEntriesShouldRoundTrip (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH       *Batch;
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH       *Smm;
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  *Item;
+  UINTN                                             BatchSize;
+  UINTN                                             PayloadSize;
+  UINTN                                             Index;
+  UINTN                                             First;
+  UINTN                                             Count;
+  UINTN                                             ItemIndex;
+  UINTN                                             Batches;
+  UINTN                                             Sent;
+  UINTN                                             Items[TEST_ENTRY_COUNT];
+  EFI_STATUS                                        BatchStatus;
+
+  BatchSize = *(UINTN *) Context;
+  Batch     = AllocatePool (BatchSize);
+  UT_ASSERT_NOT_NULL (Batch);
+
+  Batches = 0;
+  Sent    = 0;
+  for (First = 0; First < TEST_ENTRY_COUNT; First += Count) {
+    Count = VariableBatchPack (&mTestEntries[First], TEST_ENTRY_COUNT - First, Batch, BatchSize, &PayloadSize);
+    UT_ASSERT_TRUE (Count > 0);
+    UT_ASSERT_TRUE (PayloadSize <= BatchSize);
+    if (Batch->VariableCount == 0) {
+      continue;
+    }
+
+    //
+    // SMM side, on a copy of exactly the payload sent
+    //
+    Smm = AllocateCopyPool (PayloadSize, Batch);
+    UT_ASSERT_NOT_NULL (Smm);
+    UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, Items), Smm->VariableCount);
+
+    BatchStatus = EFI_SUCCESS;
+    ItemIndex   = 0;
+    for (Index = First; Index < First + Count; Index++) {
+      if (mTestEntries[Index].Status != EFI_NOT_STARTED) {
+        UT_ASSERT_EQUAL (mTestEntries[Index].Status, EFI_INVALID_PARAMETER);
+        mTestExpected[Index] = EFI_INVALID_PARAMETER;
+        continue;
+      }
+
+      Item = (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM *) ((UINT8 *) Smm + Items[ItemIndex]);
+      UT_ASSERT_EQUAL (Item->ReturnStatus, EFI_NOT_STARTED);
+      UT_ASSERT_MEM_EQUAL (&Item->Variable.Guid, mTestEntries[Index].VendorGuid, sizeof (EFI_GUID));
+      UT_ASSERT_EQUAL (Item->Variable.Attributes, mTestEntries[Index].Attributes);
+      UT_ASSERT_EQUAL (Item->Variable.NameSize, StrSize (mTestEntries[Index].VariableName));
+      UT_ASSERT_MEM_EQUAL (Item->Variable.Name, mTestEntries[Index].VariableName, Item->Variable.NameSize);
+      UT_ASSERT_EQUAL (Item->Variable.DataSize, mTestEntries[Index].DataSize);
+      UT_ASSERT_MEM_EQUAL ((UINT8 *) Item->Variable.Name + Item->Variable.NameSize, mTestEntries[Index].Data, Item->Variable.DataSize);
+
+      if ((Batches == TEST_STOPPED_BATCH) && (ItemIndex >= TEST_STOPPED_ITEM)) {
+        BatchStatus          = EFI_ACCESS_DENIED;
+        mTestExpected[Index] = EFI_ACCESS_DENIED;
+      } else {
+        Item->ReturnStatus   = TestEntryStatus (Index);
+        mTestExpected[Index] = Item->ReturnStatus;
+      }
+      ItemIndex++;
+    }
+    UT_ASSERT_EQUAL (ItemIndex, Smm->VariableCount);
+
+    CopyMem (Batch, Smm, PayloadSize);
+    FreePool (Smm);
+    VariableBatchUnpack (&mTestEntries[First], Count, Batch, BatchStatus);
+
+    Batches++;
+    Sent += ItemIndex;
+  }
+
+  for (Index = 0; Index < TEST_ENTRY_COUNT; Index++) {
+    UT_ASSERT_EQUAL (mTestEntries[Index].Status, mTestExpected[Index]);
+  }
+  UT_ASSERT_TRUE (Batches > TEST_STOPPED_BATCH);
+
+  FreePool (Batch);
+
+  UT_LOG_INFO ("%d variables sent in %d batches of 0x%x bytes\n", (INT32) Sent, (INT32) Batches, (UINT32) BatchSize);
+  printf (
+    "SetVariableBatch: %u variables in %u SMIs instead of %u with a 0x%x byte payload\n",
+    (unsigned) Sent,
+    (unsigned) Batches,
+    (unsigned) Sent,
+    (unsigned) BatchSize
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks that items going past the end of the batch, or whose sizes overflow,
+  are rejected, and that an item ending exactly at the end is not.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             All malformed items were rejected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A malformed item was accepted.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+MalformedItemsShouldBeRejected (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH       *Batch;
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH       *Smm;
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  *Item;
+  UINTN                                             PayloadSize;
+  UINTN                                             Items[3];
+  UINTN                                             Size;
+  UINTN                                             Offset;
+
+  //
+  // Three valid items, the last one not ending aligned
+  //
+  Batch = AllocatePool (0x400);
+  UT_ASSERT_NOT_NULL (Batch);
+  UT_ASSERT_EQUAL (VariableBatchPack (&mTestEntries[1], 3, Batch, 0x400, &PayloadSize), 3);
+  UT_ASSERT_EQUAL (Batch->VariableCount, 3);
+  UT_ASSERT_TRUE ((PayloadSize % SMM_VARIABLE_BATCH_ITEM_ALIGNMENT) != 0);
+
+  Smm = AllocateCopyPool (PayloadSize, Batch);
+  UT_ASSERT_NOT_NULL (Smm);
+  UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, Items), 3);
+  FreePool (Smm);
+
+  //
+  // The last item one byte past the end, and every other truncation of it
+  //
+  for (Size = Items[2]; Size < PayloadSize; Size++) {
+    Smm = AllocateCopyPool (Size, Batch);
+    UT_ASSERT_NOT_NULL (Smm);
+    UT_ASSERT_EQUAL (TestWalkBatch (Smm, Size, NULL), 2);
+    FreePool (Smm);
+  }
+
+  //
+  // More items than the batch holds
+  //
+  Smm = AllocateCopyPool (PayloadSize, Batch);
+  UT_ASSERT_NOT_NULL (Smm);
+  Smm->VariableCount = 4;
+  UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, NULL), 3);
+  Smm->VariableCount = MAX_UINTN;
+  UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, NULL), 3);
+  Smm->VariableCount = 3;
+
+  //
+  // Sizes that overflow, or that wrap the item back into the batch
+  //
+  Item = (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM *) ((UINT8 *) Smm + Items[1]);
+  Item->Variable.NameSize = MAX_UINTN;
+  UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, NULL), 1);
+  Item->Variable.NameSize = MAX_UINTN - VARIABLE_BATCH_ITEM_HEADER_SIZE - Item->Variable.DataSize + 1;
+  UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, NULL), 1);
+  Item->Variable.NameSize = 2;
+  Item->Variable.DataSize = MAX_UINTN - 1;
+  UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, NULL), 1);
+  Item->Variable.DataSize = MAX_UINTN - VARIABLE_BATCH_ITEM_HEADER_SIZE + 1;
+  UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, NULL), 1);
+  Item->Variable.DataSize = PayloadSize - Items[1] - VARIABLE_BATCH_ITEM_HEADER_SIZE - 2 + 1;
+  UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, NULL), 1);
+
+  //
+  // The second item grown to end exactly at the end of the batch is accepted
+  //
+  Item->Variable.DataSize = PayloadSize - Items[1] - VARIABLE_BATCH_ITEM_HEADER_SIZE - 2;
+  Smm->VariableCount      = 2;
+  UT_ASSERT_EQUAL (TestWalkBatch (Smm, PayloadSize, NULL), 2);
+  FreePool (Smm);
+
+  //
+  // Batches too small for an item header
+  //
+  for (Size = sizeof (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH); Size < VARIABLE_BATCH_FIRST_ITEM_OFFSET + VARIABLE_BATCH_ITEM_HEADER_SIZE; Size++) {
+    Smm = AllocateCopyPool (Size, Batch);
+    UT_ASSERT_NOT_NULL (Smm);
+    UT_ASSERT_EQUAL (TestWalkBatch (Smm, Size, NULL), 0);
+    Offset = MAX_UINTN - 3;
+    UT_ASSERT_STATUS_EQUAL (VariableBatchGetItem (Smm, Size, &Offset, &Item), EFI_ACCESS_DENIED);
+    FreePool (Smm);
+  }
+
+  FreePool (Batch);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Returns a random item size, biased towards the values around the space
+  left in the batch and towards overflows.
+
+  @param[in] Left  The space left in the batch after the item header.
+
+  @return The size.
+
+**/
+UINTN
+TestRandomSize (
+  IN UINTN  Left
+  )
+{
+  switch (TestRandom () % 5) {
+    case 0:
+      return MAX_UINTN - (TestRandom () % 64);
+    case 1:
+      return Left - 8 + (TestRandom () % 16);
+    default:
+      return TestRandom () % 64;
+  }
+}
+
+/**
+  Walks random batches of random sizes, with item sizes biased towards the
+  bounds, and checks that every item found lies within its batch.
+
+  @param[in] Context  Unused.
+
+  @retval UNIT_TEST_PASSED             Every item found lies within its batch.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  An item goes past its batch.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RandomBatchesShouldStayInBounds (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH       *Smm;
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  *Item;
+  UINTN                                             Round;
+  UINTN                                             Size;
+  UINTN                                             Index;
+  UINTN                                             Offset;
+  UINTN                                             Found;
+  UINTN                                             Accepted;
+
+  Accepted = 0;
+  for (Round = 0; Round < TEST_FUZZ_ROUNDS; Round++) {
+    Size = sizeof (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH) + TestRandom () % TEST_FUZZ_MAX_BATCH_SIZE;
+    Smm  = AllocatePool (Size);
+    UT_ASSERT_NOT_NULL (Smm);
+    for (Index = 0; Index < Size; Index++) {
+      ((UINT8 *) Smm)[Index] = (UINT8) TestRandom ();
+    }
+
+    Smm->VariableCount = TestRandom () % TEST_FUZZ_MAX_ITEMS;
+    Offset = VARIABLE_BATCH_FIRST_ITEM_OFFSET;
+    for (Index = 0; Index < Smm->VariableCount; Index++) {
+      if ((Offset > Size) || (Size - Offset < VARIABLE_BATCH_ITEM_HEADER_SIZE)) {
+        break;
+      }
+      Item = (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM *) ((UINT8 *) Smm + Offset);
+      Item->Variable.NameSize = TestRandomSize (Size - Offset - VARIABLE_BATCH_ITEM_HEADER_SIZE);
+      Item->Variable.DataSize = TestRandomSize (Size - Offset - VARIABLE_BATCH_ITEM_HEADER_SIZE - (Item->Variable.NameSize & 0xFF));
+      Offset += ALIGN_VALUE (VARIABLE_BATCH_ITEM_HEADER_SIZE + Item->Variable.NameSize + Item->Variable.DataSize, SMM_VARIABLE_BATCH_ITEM_ALIGNMENT);
+    }
+
+    Found     = TestWalkBatch (Smm, Size, NULL);
+    Accepted += Found;
+    UT_ASSERT_TRUE (Found <= Smm->VariableCount);
+    FreePool (Smm);
+  }
+
+  UT_LOG_INFO ("%d random batches walked, %d items accepted\n", TEST_FUZZ_ROUNDS, (INT32) Accepted);
+  printf (
+    "SetVariableBatch: %u random batches walked, %u items accepted, none out of bounds\n",
+    (unsigned) TEST_FUZZ_ROUNDS,
+    (unsigned) Accepted
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the batched
+  SetVariable payload and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      BatchTests;
+  STATIC UINTN                SmallPayload = 0x400;
+  STATIC UINTN                LargePayload = 0x2000;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&BatchTests, Framework, "Variable Batch Tests", "Variable.Batch", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for BatchTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (BatchTests, "Packed entries should round trip (1KB payload)", "Small", PackedEntriesShouldRoundTrip, BuildTestEntries, NULL, &SmallPayload);
+  AddTestCase (BatchTests, "Packed entries should round trip (8KB payload)", "Large", PackedEntriesShouldRoundTrip, BuildTestEntries, NULL, &LargePayload);
+  AddTestCase (BatchTests, "Malformed items should be rejected", "Malformed", MalformedItemsShouldBeRejected, BuildTestEntries, NULL, NULL);
+  AddTestCase (BatchTests, "Random batches should stay in bounds", "Random", RandomBatchesShouldStayInBounds, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
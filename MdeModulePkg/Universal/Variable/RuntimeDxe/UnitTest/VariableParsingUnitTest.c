@@ -0,0 +1,787 @@
+/** @file
+  Host based unit tests of the variable lookup index of FindVariableEx() and
+  of the incremental compaction of CompactVariableStoreStep().
+
+  The real VariableParsing.c is run against variable stores built in host
+  memory. Every lookup through the index must return what a plain walk of
+  the store returns, also after the store changed behind the index. Every
+  compaction step must leave a store holding the same live variables in the
+  same order, and must change only the bytes it reports.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "VariableParsing.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "Variable Lookup Index Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// More variables than index slots, so slots are shared
+//
+#define TEST_VARIABLE_COUNT       600
+#define TEST_GUID_COUNT           4
+#define TEST_STORE_SIZE           SIZE_256KB
+#define TEST_NAME_LENGTH          8
+#define TEST_BENCHMARK_ROUNDS     100
+#define TEST_TAIL_DELETE_COUNT    40
+
+///
+/// Context of the compaction tests. AuthFormat comes first, so BuildTestStore()
+/// can take it too.
+///
+typedef struct {
+  BOOLEAN  AuthFormat;
+  UINTN    StepSize;
+} TEST_COMPACTION_CONTEXT;
+
+EFI_GUID  gEfiVariableGuid              = EFI_VARIABLE_GUID;
+EFI_GUID  gEfiAuthenticatedVariableGuid = EFI_AUTHENTICATED_VARIABLE_GUID;
+
+//
+// The variable store, and the names and GUIDs of the variables in it
+//
+VARIABLE_STORE_HEADER  *mTestStore;
+UINTN                  mTestStoreUsed;
+EFI_GUID               mTestGuids[TEST_GUID_COUNT];
+CHAR16                 mTestNames[TEST_VARIABLE_COUNT][TEST_NAME_LENGTH];
+BOOLEAN                mTestAtRuntime;
+
+//
+// Copies of the store and its live variables for the compaction tests
+//
+UINT8                  mTestExpected[TEST_STORE_SIZE];
+UINT8                  mTestLive[TEST_STORE_SIZE];
+UINT8                  mTestBefore[TEST_STORE_SIZE];
+
+/**
+  Stub of AtRuntime().
+
+  @retval mTestAtRuntime
+
+**/
+BOOLEAN
+AtRuntime (
+  VOID
+  )
+{
+  return mTestAtRuntime;
+}
+
+/**
+  Returns the name of test variable Index, L"Var" and four hex digits.
+
+  @param  Index  Number of the test variable
+
+  @return The name of the variable
+
+**/
+CHAR16 *
+TestVariableName (
+  IN UINTN  Index
+  )
+{
+  CHAR16  *Name;
+  UINTN   Digit;
+
+  Name = mTestNames[Index];
+  Name[0] = L'V';
+  Name[1] = L'a';
+  Name[2] = L'r';
+  for (Digit = 0; Digit < 4; Digit++) {
+    Name[3 + Digit] = L"0123456789ABCDEF"[(Index >> (12 - 4 * Digit)) & 0xF];
+  }
+  Name[7] = 0;
+  return Name;
+}
+
+/**
+  Appends a variable to the test store.
+
+  @param  Name        Name of the variable
+  @param  Guid        Vendor GUID of the variable
+  @param  State       State of the variable
+  @param  Attributes  Attributes of the variable
+  @param  AuthFormat  TRUE if the store holds authenticated variables
+
+  @return The header of the new variable
+
+**/
+VARIABLE_HEADER *
+TestAppendVariable (
+  IN CHAR16    *Name,
+  IN EFI_GUID  *Guid,
+  IN UINT8     State,
+  IN UINT32    Attributes,
+  IN BOOLEAN   AuthFormat
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  UINT64           Data;
+
+  Variable = (VARIABLE_HEADER *) ((UINTN) GetStartPointer (mTestStore) + mTestStoreUsed);
+  ZeroMem (Variable, GetVariableHeaderSize (AuthFormat));
+  Variable->StartId    = VARIABLE_DATA;
+  Variable->State      = State;
+  Variable->Attributes = Attributes;
+  SetNameSizeOfVariable (Variable, StrSize (Name), AuthFormat);
+  SetDataSizeOfVariable (Variable, sizeof (Data), AuthFormat);
+  CopyGuid (GetVendorGuidPtr (Variable, AuthFormat), Guid);
+  CopyMem (GetVariableNamePtr (Variable, AuthFormat), Name, StrSize (Name));
+  Data = mTestStoreUsed;
+  CopyMem (GetVariableDataPtr (Variable, AuthFormat), &Data, sizeof (Data));
+
+  mTestStoreUsed = (UINTN) GetNextVariablePtr (Variable, AuthFormat) - (UINTN) GetStartPointer (mTestStore);
+  ASSERT (mTestStoreUsed + sizeof (VARIABLE_STORE_HEADER) < TEST_STORE_SIZE);
+  return Variable;
+}
+
+/**
+  Finds a variable by walking the store, the way FindVariableEx() did before
+  the lookup index was added.
+
+  @param  VariableName   Name of the variable to be found
+  @param  VendorGuid     Vendor GUID to be found
+  @param  IgnoreRtCheck  Ignore EFI_VARIABLE_RUNTIME_ACCESS at runtime
+  @param  PtrTrack       Variable Track Pointer structure
+  @param  AuthFormat     TRUE if the store holds authenticated variables
+
+  @retval EFI_SUCCESS    The variable was found.
+  @retval EFI_NOT_FOUND  The variable was not found.
+
+**/
+EFI_STATUS
+TestWalkVariableStore (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat
+  )
+{
+  VARIABLE_HEADER  *InDeletedVariable;
+  VARIABLE_HEADER  *Variable;
+
+  PtrTrack->InDeletedTransitionPtr = NULL;
+  InDeletedVariable                = NULL;
+
+  for ( Variable = PtrTrack->StartPtr
+      ; IsValidVariableHeader (Variable, PtrTrack->EndPtr)
+      ; Variable = GetNextVariablePtr (Variable, AuthFormat)
+      ) {
+    if ((Variable->State != VAR_ADDED) && (Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+      continue;
+    }
+    if (!IgnoreRtCheck && mTestAtRuntime && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+      continue;
+    }
+    if (!CompareGuid (VendorGuid, GetVendorGuidPtr (Variable, AuthFormat)) ||
+        (CompareMem (VariableName, GetVariableNamePtr (Variable, AuthFormat), NameSizeOfVariable (Variable, AuthFormat)) != 0)) {
+      continue;
+    }
+    if (Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+      InDeletedVariable = Variable;
+    } else {
+      PtrTrack->CurrPtr                = Variable;
+      PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+      return EFI_SUCCESS;
+    }
+  }
+
+  PtrTrack->CurrPtr = InDeletedVariable;
+  return (InDeletedVariable == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+}
+
+/**
+  Checks that FindVariableEx() returns the same result as a walk of the
+  test store.
+
+  @param  VariableName   Name of the variable to be found
+  @param  VendorGuid     Vendor GUID to be found
+  @param  IgnoreRtCheck  Ignore EFI_VARIABLE_RUNTIME_ACCESS at runtime
+  @param  AuthFormat     TRUE if the store holds authenticated variables
+
+  @retval TRUE   The results are the same.
+  @retval FALSE  The results differ.
+
+**/
+BOOLEAN
+TestLookupMatchesWalk (
+  IN CHAR16    *VariableName,
+  IN EFI_GUID  *VendorGuid,
+  IN BOOLEAN   IgnoreRtCheck,
+  IN BOOLEAN   AuthFormat
+  )
+{
+  VARIABLE_POINTER_TRACK  Found;
+  VARIABLE_POINTER_TRACK  Expected;
+  EFI_STATUS              FoundStatus;
+  EFI_STATUS              ExpectedStatus;
+
+  Found.StartPtr = GetStartPointer (mTestStore);
+  Found.EndPtr   = GetEndPointer (mTestStore);
+  Found.Volatile = FALSE;
+  CopyMem (&Expected, &Found, sizeof (Found));
+
+  FoundStatus    = FindVariableEx (VariableName, VendorGuid, IgnoreRtCheck, &Found, AuthFormat);
+  ExpectedStatus = TestWalkVariableStore (VariableName, VendorGuid, IgnoreRtCheck, &Expected, AuthFormat);
+  if (FoundStatus != ExpectedStatus) {
+    return FALSE;
+  }
+  if (EFI_ERROR (FoundStatus)) {
+    return TRUE;
+  }
+
+  return (BOOLEAN) ((Found.CurrPtr == Expected.CurrPtr) &&
+                    (Found.InDeletedTransitionPtr == Expected.InDeletedTransitionPtr));
+}
+
+/**
+  Build a store of TEST_VARIABLE_COUNT variables. Some have a deleted copy,
+  some a copy in deleted transition and some no runtime access. Then build
+  the lookup index from the store.
+
+  @param  Context  TRUE for a store of authenticated variables
+
+  @retval UNIT_TEST_PASSED  Always.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BuildTestStore (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BOOLEAN  AuthFormat;
+  UINTN    Index;
+  UINT32   Attributes;
+
+  AuthFormat = *(BOOLEAN *) Context;
+
+  if (mTestStore == NULL) {
+    mTestStore = AllocatePool (TEST_STORE_SIZE);
+    UT_ASSERT_NOT_NULL (mTestStore);
+  }
+  SetMem (mTestStore, TEST_STORE_SIZE, 0xFF);
+  CopyGuid (&mTestStore->Signature, AuthFormat ? &gEfiAuthenticatedVariableGuid : &gEfiVariableGuid);
+  mTestStore->Size   = TEST_STORE_SIZE;
+  mTestStore->Format = VARIABLE_STORE_FORMATTED;
+  mTestStore->State  = VARIABLE_STORE_HEALTHY;
+  mTestStoreUsed     = 0;
+  mTestAtRuntime     = FALSE;
+
+  for (Index = 0; Index < TEST_GUID_COUNT; Index++) {
+    ZeroMem (&mTestGuids[Index], sizeof (EFI_GUID));
+    mTestGuids[Index].Data1 = 0xA5A50000 + (UINT32) Index;
+  }
+
+  for (Index = 0; Index < TEST_VARIABLE_COUNT; Index++) {
+    Attributes = ((Index % 7) == 0) ? VARIABLE_ATTRIBUTE_NV_BS : VARIABLE_ATTRIBUTE_NV_BS_RT;
+    if ((Index % 10) == 0) {
+      TestAppendVariable (TestVariableName (Index), &mTestGuids[Index % TEST_GUID_COUNT], VAR_ADDED & VAR_DELETED, Attributes, AuthFormat);
+    }
+    if ((Index % 50) == 0) {
+      TestAppendVariable (TestVariableName (Index), &mTestGuids[Index % TEST_GUID_COUNT], VAR_IN_DELETED_TRANSITION & VAR_ADDED, Attributes, AuthFormat);
+    }
+    TestAppendVariable (TestVariableName (Index), &mTestGuids[Index % TEST_GUID_COUNT], VAR_ADDED, Attributes, AuthFormat);
+  }
+
+  VariableIndexInvalidate ();
+  VariableIndexBuild (mTestStore, AuthFormat);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Every variable, and names and GUIDs that are not in the store, must be
+  looked up the same through the index as by a store walk, at boot time and
+  at runtime.
+
+  @param  Context  TRUE for a store of authenticated variables
+
+  @retval UNIT_TEST_PASSED             The lookups matched the store walk.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup differed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LookupsShouldMatchStoreWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BOOLEAN   AuthFormat;
+  UINTN     Round;
+  UINTN     Index;
+  EFI_GUID  Unknown;
+
+  AuthFormat = *(BOOLEAN *) Context;
+  ZeroMem (&Unknown, sizeof (Unknown));
+
+  //
+  // The first round fills the index from the walks, the next ones hit it
+  //
+  for (Round = 0; Round < 4; Round++) {
+    mTestAtRuntime = (BOOLEAN) (Round >= 2);
+    for (Index = 0; Index < TEST_VARIABLE_COUNT; Index++) {
+      UT_ASSERT_TRUE (TestLookupMatchesWalk (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], FALSE, AuthFormat));
+      UT_ASSERT_TRUE (TestLookupMatchesWalk (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], TRUE, AuthFormat));
+      UT_ASSERT_TRUE (TestLookupMatchesWalk (mTestNames[Index], &mTestGuids[(Index + 1) % TEST_GUID_COUNT], FALSE, AuthFormat));
+    }
+    UT_ASSERT_TRUE (TestLookupMatchesWalk (L"Var", &mTestGuids[0], FALSE, AuthFormat));
+    UT_ASSERT_TRUE (TestLookupMatchesWalk (L"Var0000X", &mTestGuids[0], FALSE, AuthFormat));
+    UT_ASSERT_TRUE (TestLookupMatchesWalk (mTestNames[1], &Unknown, FALSE, AuthFormat));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Change the store behind the index without telling it: delete variables,
+  put them in deleted transition, move them and overwrite them with other
+  variables. Lookups must still match a walk of the changed store.
+
+  @param  Context  TRUE for a store of authenticated variables
+
+  @retval UNIT_TEST_PASSED             The lookups matched the store walk.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup differed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StaleIndexShouldFallBackToWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BOOLEAN                 AuthFormat;
+  UINTN                   Index;
+  VARIABLE_POINTER_TRACK  PtrTrack;
+  VARIABLE_HEADER         *First;
+  UINTN                   FirstSize;
+
+  AuthFormat = *(BOOLEAN *) Context;
+  mTestAtRuntime = FALSE;
+
+  //
+  // Make sure every variable is in the index
+  //
+  for (Index = 0; Index < TEST_VARIABLE_COUNT; Index++) {
+    UT_ASSERT_TRUE (TestLookupMatchesWalk (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], FALSE, AuthFormat));
+  }
+
+  PtrTrack.StartPtr = GetStartPointer (mTestStore);
+  PtrTrack.EndPtr   = GetEndPointer (mTestStore);
+  for (Index = 1; Index < TEST_VARIABLE_COUNT; Index += 3) {
+    UT_ASSERT_NOT_EFI_ERROR (TestWalkVariableStore (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], FALSE, &PtrTrack, AuthFormat));
+    switch (Index % 4) {
+    case 0:
+      //
+      // Deleted
+      //
+      PtrTrack.CurrPtr->State &= VAR_DELETED;
+      break;
+    case 1:
+      //
+      // Updated: the old copy is in deleted transition, the new one added
+      //
+      PtrTrack.CurrPtr->State &= VAR_IN_DELETED_TRANSITION;
+      TestAppendVariable (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], VAR_ADDED, PtrTrack.CurrPtr->Attributes, AuthFormat);
+      break;
+    case 2:
+      //
+      // Updated and the old copy deleted
+      //
+      PtrTrack.CurrPtr->State &= VAR_DELETED;
+      TestAppendVariable (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], VAR_ADDED, PtrTrack.CurrPtr->Attributes, AuthFormat);
+      break;
+    default:
+      //
+      // Lost its runtime access
+      //
+      PtrTrack.CurrPtr->Attributes &= ~EFI_VARIABLE_RUNTIME_ACCESS;
+      break;
+    }
+  }
+
+  for (Index = 0; Index < TEST_VARIABLE_COUNT; Index++) {
+    mTestAtRuntime = FALSE;
+    UT_ASSERT_TRUE (TestLookupMatchesWalk (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], FALSE, AuthFormat));
+    mTestAtRuntime = TRUE;
+    UT_ASSERT_TRUE (TestLookupMatchesWalk (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], FALSE, AuthFormat));
+  }
+
+  //
+  // Reclaim-like move: drop the first variable and slide the others down,
+  // so recorded offsets now point into other variables
+  //
+  mTestAtRuntime = FALSE;
+  First     = GetStartPointer (mTestStore);
+  FirstSize = (UINTN) GetNextVariablePtr (First, AuthFormat) - (UINTN) First;
+  CopyMem (First, (UINT8 *) First + FirstSize, mTestStoreUsed - FirstSize);
+  SetMem ((UINT8 *) First + mTestStoreUsed - FirstSize, FirstSize, 0xFF);
+  mTestStoreUsed -= FirstSize;
+
+  for (Index = 0; Index < TEST_VARIABLE_COUNT; Index++) {
+    UT_ASSERT_TRUE (TestLookupMatchesWalk (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], FALSE, AuthFormat));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Time lookups of every variable through the index, and with the index
+  dropped before every lookup so each one walks the store, and log both.
+
+  @param  Context  TRUE for a store of authenticated variables
+
+  @retval UNIT_TEST_PASSED             All lookups succeeded.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A lookup failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LookupBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BOOLEAN                 AuthFormat;
+  UINTN                   Round;
+  UINTN                   Index;
+  UINTN                   Lookups;
+  VARIABLE_POINTER_TRACK  PtrTrack;
+  clock_t                 Start;
+  double                  IndexSeconds;
+  double                  WalkSeconds;
+
+  AuthFormat = *(BOOLEAN *) Context;
+  PtrTrack.StartPtr = GetStartPointer (mTestStore);
+  PtrTrack.EndPtr   = GetEndPointer (mTestStore);
+  Lookups = TEST_BENCHMARK_ROUNDS * TEST_VARIABLE_COUNT;
+
+  Start = clock ();
+  for (Round = 0; Round < TEST_BENCHMARK_ROUNDS; Round++) {
+    for (Index = 0; Index < TEST_VARIABLE_COUNT; Index++) {
+      UT_ASSERT_NOT_EFI_ERROR (FindVariableEx (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], FALSE, &PtrTrack, AuthFormat));
+    }
+  }
+  IndexSeconds = (double) (clock () - Start) / CLOCKS_PER_SEC;
+
+  Start = clock ();
+  for (Round = 0; Round < TEST_BENCHMARK_ROUNDS; Round++) {
+    for (Index = 0; Index < TEST_VARIABLE_COUNT; Index++) {
+      VariableIndexInvalidate ();
+      UT_ASSERT_NOT_EFI_ERROR (FindVariableEx (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], FALSE, &PtrTrack, AuthFormat));
+    }
+  }
+  WalkSeconds = (double) (clock () - Start) / CLOCKS_PER_SEC;
+
+  UT_LOG_INFO (
+    "%d lookups of %d variables: %d us through the index, %d us walking the store\n",
+    (INT32) Lookups,
+    TEST_VARIABLE_COUNT,
+    (INT32) (IndexSeconds * 1000000),
+    (INT32) (WalkSeconds * 1000000)
+    );
+  printf (
+    "FindVariableEx (%s): %.0f ns per lookup through the index, %.0f ns walking a store of %u variables\n",
+    AuthFormat ? "authenticated" : "normal",
+    IndexSeconds * 1e9 / Lookups,
+    WalkSeconds * 1e9 / Lookups,
+    (unsigned) TEST_VARIABLE_COUNT
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Copies the live variables of the test store, in order, to a buffer.
+
+  @param  Buffer      Buffer of TEST_STORE_SIZE bytes
+  @param  AuthFormat  TRUE if the store holds authenticated variables
+
+  @return The number of bytes copied
+
+**/
+UINTN
+TestCopyLiveVariables (
+  OUT UINT8    *Buffer,
+  IN  BOOLEAN  AuthFormat
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  VARIABLE_HEADER  *NextVariable;
+  UINTN            Size;
+
+  Size = 0;
+  for ( Variable = GetStartPointer (mTestStore)
+      ; IsValidVariableHeader (Variable, GetEndPointer (mTestStore))
+      ; Variable = NextVariable
+      ) {
+    NextVariable = GetNextVariablePtr (Variable, AuthFormat);
+    if ((Variable->State == VAR_ADDED) || (Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED))) {
+      CopyMem (Buffer + Size, Variable, (UINTN) NextVariable - (UINTN) Variable);
+      Size += (UINTN) NextVariable - (UINTN) Variable;
+    }
+  }
+
+  return Size;
+}
+
+/**
+  Compact the test store step by step. After every step the store must hold
+  the same live variables in the same order, and only the reported bytes may
+  have changed, no more than the step size or one variable. At the end no
+  deleted variable may be left, and the rest of the store must be erased.
+
+  @param  Compaction  Format of the store and size of the steps
+  @param  Steps       Returns the number of steps taken
+
+  @retval UNIT_TEST_PASSED             The store was compacted correctly.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A step was wrong.
+**/
+UNIT_TEST_STATUS
+TestCompactStore (
+  IN  TEST_COMPACTION_CONTEXT  *Compaction,
+  OUT UINTN                    *Steps
+  )
+{
+  BOOLEAN          AuthFormat;
+  UINTN            ExpectedSize;
+  UINTN            MaxChange;
+  UINTN            Index;
+  UINTN            ChangedOffset;
+  UINTN            ChangedSize;
+  UINTN            MovedSize;
+  UINTN            LastVariableOffset;
+  VARIABLE_HEADER  *Variable;
+
+  AuthFormat   = Compaction->AuthFormat;
+  ExpectedSize = TestCopyLiveVariables (mTestExpected, AuthFormat);
+
+  //
+  // All test variables have the same size, the first one tells it
+  //
+  Variable  = GetStartPointer (mTestStore);
+  MaxChange = (UINTN) GetNextVariablePtr (Variable, AuthFormat) - (UINTN) Variable + GetVariableHeaderSize (AuthFormat) + sizeof (CHAR16);
+  MaxChange = MAX (MaxChange, Compaction->StepSize);
+
+  for (*Steps = 0; *Steps < TEST_STORE_SIZE; (*Steps)++) {
+    CopyMem (mTestBefore, mTestStore, TEST_STORE_SIZE);
+    if (EFI_ERROR (CompactVariableStoreStep (mTestStore, Compaction->StepSize, AuthFormat, &ChangedOffset, &ChangedSize, &MovedSize, &LastVariableOffset))) {
+      break;
+    }
+
+    UT_ASSERT_TRUE (ChangedSize > 0);
+    UT_ASSERT_TRUE (ChangedSize <= MaxChange);
+    UT_ASSERT_TRUE (MovedSize < ChangedSize);
+    UT_ASSERT_TRUE (ChangedOffset >= (UINTN) GetStartPointer (mTestStore) - (UINTN) mTestStore);
+    UT_ASSERT_TRUE (ChangedOffset + ChangedSize <= TEST_STORE_SIZE);
+    UT_ASSERT_MEM_EQUAL (mTestBefore, mTestStore, ChangedOffset);
+    UT_ASSERT_MEM_EQUAL (
+      mTestBefore + ChangedOffset + ChangedSize,
+      (UINT8 *) mTestStore + ChangedOffset + ChangedSize,
+      TEST_STORE_SIZE - ChangedOffset - ChangedSize
+      );
+
+    UT_ASSERT_EQUAL (TestCopyLiveVariables (mTestLive, AuthFormat), ExpectedSize);
+    UT_ASSERT_MEM_EQUAL (mTestLive, mTestExpected, ExpectedSize);
+
+    for ( Variable = GetStartPointer (mTestStore)
+        ; IsValidVariableHeader (Variable, GetEndPointer (mTestStore))
+        ; Variable = GetNextVariablePtr (Variable, AuthFormat)
+        ) {
+    }
+    UT_ASSERT_EQUAL ((UINTN) Variable - (UINTN) mTestStore, LastVariableOffset);
+    for (Index = LastVariableOffset; Index < TEST_STORE_SIZE; Index++) {
+      UT_ASSERT_EQUAL (((UINT8 *) mTestStore)[Index], 0xFF);
+    }
+  }
+  UT_ASSERT_TRUE (*Steps > 0);
+
+  //
+  // Compacted: only live variables, then erased space
+  //
+  for ( Variable = GetStartPointer (mTestStore)
+      ; IsValidVariableHeader (Variable, GetEndPointer (mTestStore))
+      ; Variable = GetNextVariablePtr (Variable, AuthFormat)
+      ) {
+    UT_ASSERT_TRUE ((Variable->State == VAR_ADDED) || (Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)));
+  }
+  UT_ASSERT_EQUAL ((UINTN) Variable - (UINTN) GetStartPointer (mTestStore), ExpectedSize);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Fragment the test store and compact it step by step. Then delete the last
+  variables, so that only deleted variables at the end are left to erase, and
+  compact it again.
+
+  @param  Context  TEST_COMPACTION_CONTEXT
+
+  @retval UNIT_TEST_PASSED             The store was compacted correctly.
+  @retval UNIT_TEST_ERROR_TEST_FAILED  A step was wrong.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CompactionStepsShouldKeepVariables (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TEST_COMPACTION_CONTEXT  *Compaction;
+  BOOLEAN                  AuthFormat;
+  UNIT_TEST_STATUS         Status;
+  UINTN                    Index;
+  UINTN                    LiveCount;
+  UINTN                    Steps;
+  UINTN                    EraseSteps;
+  VARIABLE_POINTER_TRACK   PtrTrack;
+  VARIABLE_HEADER          *Variable;
+
+  Compaction = (TEST_COMPACTION_CONTEXT *) Context;
+  AuthFormat = Compaction->AuthFormat;
+
+  //
+  // Delete or update a third of the variables, and delete the last ones
+  //
+  PtrTrack.StartPtr = GetStartPointer (mTestStore);
+  PtrTrack.EndPtr   = GetEndPointer (mTestStore);
+  for (Index = 2; Index < TEST_VARIABLE_COUNT; Index += 3) {
+    UT_ASSERT_NOT_EFI_ERROR (TestWalkVariableStore (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], TRUE, &PtrTrack, AuthFormat));
+    PtrTrack.CurrPtr->State &= VAR_DELETED;
+    if ((Index % 2) == 0) {
+      TestAppendVariable (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], VAR_ADDED, PtrTrack.CurrPtr->Attributes, AuthFormat);
+    }
+  }
+  for (Index = TEST_VARIABLE_COUNT - 20; Index < TEST_VARIABLE_COUNT; Index++) {
+    if (!EFI_ERROR (TestWalkVariableStore (mTestNames[Index], &mTestGuids[Index % TEST_GUID_COUNT], TRUE, &PtrTrack, AuthFormat))) {
+      PtrTrack.CurrPtr->State &= VAR_DELETED;
+    }
+  }
+
+  Status = TestCompactStore (Compaction, &Steps);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  //
+  // Delete the last TEST_TAIL_DELETE_COUNT variables of the compacted store
+  //
+  LiveCount = 0;
+  for ( Variable = GetStartPointer (mTestStore)
+      ; IsValidVariableHeader (Variable, GetEndPointer (mTestStore))
+      ; Variable = GetNextVariablePtr (Variable, AuthFormat)
+      ) {
+    LiveCount++;
+  }
+  UT_ASSERT_TRUE (LiveCount > TEST_TAIL_DELETE_COUNT);
+  Index = 0;
+  for ( Variable = GetStartPointer (mTestStore)
+      ; IsValidVariableHeader (Variable, GetEndPointer (mTestStore))
+      ; Variable = GetNextVariablePtr (Variable, AuthFormat)
+      ) {
+    if (Index++ >= LiveCount - TEST_TAIL_DELETE_COUNT) {
+      Variable->State &= VAR_DELETED;
+    }
+  }
+
+  Status = TestCompactStore (Compaction, &EraseSteps);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  UT_LOG_INFO ("%d steps, then %d steps of at most %d bytes\n", (INT32) Steps, (INT32) EraseSteps, (INT32) Compaction->StepSize);
+  printf (
+    "CompactVariableStoreStep (%s, %u bytes): %u steps to compact the store, %u to erase %u variables at its end\n",
+    AuthFormat ? "authenticated" : "normal",
+    (unsigned) Compaction->StepSize,
+    (unsigned) Steps,
+    (unsigned) EraseSteps,
+    (unsigned) TEST_TAIL_DELETE_COUNT
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the variable
+  lookup index and the compaction steps and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      IndexTests;
+  UNIT_TEST_SUITE_HANDLE      CompactionTests;
+  STATIC BOOLEAN              NormalFormat = FALSE;
+  STATIC BOOLEAN              AuthFormat   = TRUE;
+  STATIC TEST_COMPACTION_CONTEXT  SingleVariable = { FALSE, 0x40 };
+  STATIC TEST_COMPACTION_CONTEXT  SmallSteps     = { FALSE, 0x200 };
+  STATIC TEST_COMPACTION_CONTEXT  LargeSteps     = { FALSE, 0x4000 };
+  STATIC TEST_COMPACTION_CONTEXT  AuthSteps      = { TRUE, 0x1000 };
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&IndexTests, Framework, "Variable Lookup Index Tests", "Variable.Index", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for IndexTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IndexTests, "Lookups should match a store walk", "Lookup", LookupsShouldMatchStoreWalk, BuildTestStore, NULL, &NormalFormat);
+  AddTestCase (IndexTests, "Lookups should match a store walk (authenticated)", "LookupAuth", LookupsShouldMatchStoreWalk, BuildTestStore, NULL, &AuthFormat);
+  AddTestCase (IndexTests, "Stale index should fall back to the walk", "Stale", StaleIndexShouldFallBackToWalk, BuildTestStore, NULL, &NormalFormat);
+  AddTestCase (IndexTests, "Stale index should fall back to the walk (authenticated)", "StaleAuth", StaleIndexShouldFallBackToWalk, BuildTestStore, NULL, &AuthFormat);
+  AddTestCase (IndexTests, "Lookup time with and without the index", "Benchmark", LookupBenchmark, BuildTestStore, NULL, &AuthFormat);
+
+  Status = CreateUnitTestSuite (&CompactionTests, Framework, "Variable Store Compaction Tests", "Variable.Compaction", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CompactionTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (CompactionTests, "Steps smaller than a variable should keep the variables", "OneVariable", CompactionStepsShouldKeepVariables, BuildTestStore, NULL, &SingleVariable);
+  AddTestCase (CompactionTests, "Small steps should keep the variables", "Small", CompactionStepsShouldKeepVariables, BuildTestStore, NULL, &SmallSteps);
+  AddTestCase (CompactionTests, "Large steps should keep the variables", "Large", CompactionStepsShouldKeepVariables, BuildTestStore, NULL, &LargeSteps);
+  AddTestCase (CompactionTests, "Steps should keep the variables (authenticated)", "Auth", CompactionStepsShouldKeepVariables, BuildTestStore, NULL, &AuthSteps);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
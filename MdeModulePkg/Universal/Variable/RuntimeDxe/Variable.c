@@ -490,6 +490,94 @@ InitializeVariableQuota (
   CalculateCommonUserVariableTotalSize ();
 }
 
+/**
+  Count the variables of the non-volatile variable store cache in the total
+  sizes that UpdateVariable() checks the free space against.
+
+  Deleted variables are counted too, they take space until it is reclaimed.
+  The deleted variables that ReclaimStep() leaves behind moved variables have
+  an empty name, which no variable set with SetVariable() can have, and are not
+  counted as user variables.
+
+  @return The offset of the end of the last variable from the store header.
+
+**/
+UINTN
+CalculateNvVariableTotalSize (
+  VOID
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  VARIABLE_HEADER  *NextVariable;
+  UINTN            VariableSize;
+  BOOLEAN          AuthFormat;
+
+  AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
+  mVariableModuleGlobal->HwErrVariableTotalSize      = 0;
+  mVariableModuleGlobal->CommonVariableTotalSize     = 0;
+  mVariableModuleGlobal->CommonUserVariableTotalSize = 0;
+
+  Variable = GetStartPointer (mNvVariableCache);
+  while (IsValidVariableHeader (Variable, GetEndPointer (mNvVariableCache))) {
+    NextVariable = GetNextVariablePtr (Variable, AuthFormat);
+    VariableSize = (UINTN) NextVariable - (UINTN) Variable;
+    if ((Variable->Attributes & EFI_VARIABLE_HARDWARE_ERROR_RECORD) == EFI_VARIABLE_HARDWARE_ERROR_RECORD) {
+      mVariableModuleGlobal->HwErrVariableTotalSize += VariableSize;
+    } else {
+      mVariableModuleGlobal->CommonVariableTotalSize += VariableSize;
+      if ((NameSizeOfVariable (Variable, AuthFormat) > sizeof (CHAR16)) && IsUserVariable (Variable)) {
+        mVariableModuleGlobal->CommonUserVariableTotalSize += VariableSize;
+      }
+    }
+
+    Variable = NextVariable;
+  }
+
+  return (UINTN) Variable - (UINTN) mNvVariableCache;
+}
+
+/**
+  Records one reclaim or reclaim step in the reclaim statistics.
+
+  The size of the FTW write is recorded rather than the time it took: the
+  statistics are also kept at OS runtime, where no timer may be used, and
+  the write size is what the flash time depends on.
+
+  @param[in] Step               TRUE for an incremental reclaim step, FALSE for a full reclaim.
+  @param[in] BytesCopied        Number of variable bytes copied or moved.
+  @param[in] BytesWritten       Number of bytes written to flash.
+
+**/
+VOID
+RecordReclaimStatistics (
+  IN BOOLEAN                    Step,
+  IN UINTN                      BytesCopied,
+  IN UINTN                      BytesWritten
+  )
+{
+  VARIABLE_RECLAIM_STATISTICS   *Statistics;
+
+  Statistics = &mVariableModuleGlobal->ReclaimStatistics;
+  if (Step) {
+    Statistics->StepCount += 1;
+  } else {
+    Statistics->Count     += 1;
+  }
+  Statistics->BytesCopied     += BytesCopied;
+  Statistics->BytesWritten    += BytesWritten;
+  Statistics->MaxBytesWritten  = MAX (Statistics->MaxBytesWritten, BytesWritten);
+
+  DEBUG ((
+    Step ? DEBUG_VERBOSE : DEBUG_INFO,
+    "Variable: %a #%Lu copied 0x%Lx bytes, wrote 0x%Lx bytes (max 0x%Lx)\n",
+    Step ? "Reclaim step" : "Reclaim",
+    Step ? Statistics->StepCount : Statistics->Count,
+    (UINT64) BytesCopied,
+    (UINT64) BytesWritten,
+    Statistics->MaxBytesWritten
+    ));
+}
+
 /**
 
   Variable store garbage collection and reclaim operation.
@@ -537,6 +625,9 @@ Reclaim (
   VARIABLE_HEADER       *UpdatingVariable;
   VARIABLE_HEADER       *UpdatingInDeletedTransition;
   BOOLEAN               AuthFormat;
+  UINTN                 WrittenSize;
+
+  WrittenSize = 0;
 
   AuthFormat = mVariableModuleGlobal->VariableGlobal.AuthFormat;
   UpdatingVariable = NULL;
@@ -743,7 +834,8 @@ Reclaim (
     //
     Status = FtwVariableSpace (
               VariableBase,
-              (VARIABLE_STORE_HEADER *) ValidBuffer
+              (VARIABLE_STORE_HEADER *) ValidBuffer,
+              &WrittenSize
               );
     if (!EFI_ERROR (Status)) {
       *LastVariableOffset = (UINTN) CurrPtr - (UINTN) ValidBuffer;
@@ -774,6 +866,17 @@ Reclaim (
   }
 
 Done:
+  //
+  // The variables have moved, so the lookup index no longer applies.
+  //
+  VariableIndexInvalidate ();
+
+  RecordReclaimStatistics (
+    FALSE,
+    (UINTN) CurrPtr - (UINTN) GetStartPointer ((VARIABLE_STORE_HEADER *) ValidBuffer),
+    WrittenSize
+    );
+
   if (IsVolatile || mVariableModuleGlobal->VariableGlobal.EmuNvMode) {
     Status =  SynchronizeRuntimeVariableCache (
                 &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeVolatileCache,
@@ -798,6 +901,84 @@ Done:
   return Status;
 }
 
+/**
+  Performs one incremental reclaim step on the non-volatile variable store.
+
+  A step moves live variables over the first run of deleted ones, or erases
+  deleted variables at the end of the store, changing at most
+  PcdVariableReclaimStepSize bytes (or one variable if that is larger) in a
+  single FTW write. Doing a step after every update of a non-volatile variable
+  keeps the store compacted, so the full Reclaim() that a SetVariable() finding
+  the store full has to do is rarely needed and has little to move when it is.
+  The variable total sizes are counted again after the step, so that the bytes
+  it erased are free for the next SetVariable().
+
+  Every step leaves a store holding the same variables, so a reset between
+  steps does not lose data.
+
+  Like Reclaim(), it does nothing at runtime.
+
+**/
+VOID
+ReclaimStep (
+  VOID
+  )
+{
+  EFI_STATUS            Status;
+  EFI_PHYSICAL_ADDRESS  VariableBase;
+  UINTN                 ChangedOffset;
+  UINTN                 ChangedSize;
+  UINTN                 MovedSize;
+  UINTN                 LastVariableOffset;
+
+  if ((PcdGet32 (PcdVariableReclaimStepSize) == 0) ||
+      mVariableModuleGlobal->VariableGlobal.EmuNvMode ||
+      !mVariableModuleGlobal->ReclaimStepPending ||
+      AtRuntime ()) {
+    return;
+  }
+  mVariableModuleGlobal->ReclaimStepPending = FALSE;
+
+  Status = CompactVariableStoreStep (
+             mNvVariableCache,
+             PcdGet32 (PcdVariableReclaimStepSize),
+             mVariableModuleGlobal->VariableGlobal.AuthFormat,
+             &ChangedOffset,
+             &ChangedSize,
+             &MovedSize,
+             &LastVariableOffset
+             );
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  //
+  // The variables have moved, so the lookup index no longer applies.
+  //
+  VariableIndexInvalidate ();
+
+  VariableBase = mVariableModuleGlobal->VariableGlobal.NonVolatileVariableBase;
+  Status = FtwVariableSpaceRange (VariableBase, mNvVariableCache, ChangedOffset, ChangedSize);
+  if (EFI_ERROR (Status)) {
+    //
+    // Take back what is in flash; it is either the old or the new content.
+    //
+    CopyMem ((UINT8 *) mNvVariableCache + ChangedOffset, (UINT8 *) (UINTN) VariableBase + ChangedOffset, ChangedSize);
+    mVariableModuleGlobal->NonVolatileLastVariableOffset = CalculateNvVariableTotalSize ();
+  } else {
+    RecordReclaimStatistics (TRUE, MovedSize, ChangedSize);
+    mVariableModuleGlobal->NonVolatileLastVariableOffset = CalculateNvVariableTotalSize ();
+    ASSERT (mVariableModuleGlobal->NonVolatileLastVariableOffset == LastVariableOffset);
+  }
+
+  Status = SynchronizeRuntimeVariableCache (
+             &mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache,
+             ChangedOffset,
+             ChangedSize
+             );
+  ASSERT_EFI_ERROR (Status);
+}
+
 /**
   Finds variable in storage blocks of volatile and non-volatile storage areas.
 
@@ -2297,6 +2478,11 @@ UpdateVariable (
   }
 
 Done:
+  //
+  // The variable has a new copy or none, let the next lookup find it again.
+  //
+  VariableIndexRemove (VariableName, VendorGuid);
+
   if (!EFI_ERROR (Status)) {
     if ((Variable->CurrPtr != NULL && !Variable->Volatile) || (Attributes & EFI_VARIABLE_NON_VOLATILE) != 0) {
       VolatileCacheInstance = &(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.VariableRuntimeNvCache);
@@ -2782,6 +2968,14 @@ VariableServiceSetVariable (
     Status = UpdateVariable (VariableName, VendorGuid, Data, DataSize, Attributes, 0, 0, &Variable, NULL);
   }
 
+  if (!EFI_ERROR (Status) &&
+      (((Attributes & EFI_VARIABLE_NON_VOLATILE) != 0) || ((Variable.CurrPtr != NULL) && !Variable.Volatile))) {
+    mVariableModuleGlobal->ReclaimStepPending = TRUE;
+    if (!mVariableModuleGlobal->ReclaimStepDeferred) {
+      ReclaimStep ();
+    }
+  }
+
 Done:
   InterlockedDecrement (&mVariableModuleGlobal->VariableGlobal.ReentrantState);
   ReleaseLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
@@ -3652,6 +3846,11 @@ VariableCommonInitialize (
   VolatileVariableStore->Reserved    = 0;
   VolatileVariableStore->Reserved1   = 0;
 
+  //
+  // Index the non-volatile variables for FindVariableEx().
+  //
+  VariableIndexBuild (mNvVariableCache, mVariableModuleGlobal->VariableGlobal.AuthFormat);
+
   return EFI_SUCCESS;
 }
 
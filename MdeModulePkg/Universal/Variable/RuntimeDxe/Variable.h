@@ -105,6 +105,17 @@ typedef struct {
   BOOLEAN                         EmuNvMode;
 } VARIABLE_GLOBAL;
 
+///
+/// Reclaim statistics, reported through DEBUG after every reclaim and reclaim step.
+///
+typedef struct {
+  UINT64          Count;              ///< Number of full reclaims done.
+  UINT64          StepCount;          ///< Number of incremental reclaim steps done.
+  UINT64          BytesCopied;        ///< Variable bytes copied or moved.
+  UINT64          BytesWritten;       ///< Bytes written to flash through FTW.
+  UINT64          MaxBytesWritten;    ///< Largest single FTW write.
+} VARIABLE_RECLAIM_STATISTICS;
+
 typedef struct {
   VARIABLE_GLOBAL VariableGlobal;
   UINTN           VolatileLastVariableOffset;
@@ -124,6 +135,16 @@ typedef struct {
   CHAR8           *PlatformLang;
   CHAR8           Lang[ISO_639_2_ENTRY_SIZE + 1];
   EFI_FIRMWARE_VOLUME_BLOCK_PROTOCOL *FvbInstance;
+  VARIABLE_RECLAIM_STATISTICS        ReclaimStatistics;
+  ///
+  /// TRUE while a batch of SetVariable() is processed: the reclaim step is
+  /// done once at the end of the batch instead of after every variable.
+  ///
+  BOOLEAN                            ReclaimStepDeferred;
+  ///
+  /// TRUE when a non-volatile variable was updated since the last reclaim step.
+  ///
+  BOOLEAN                            ReclaimStepPending;
 } VARIABLE_MODULE_GLOBAL;
 
 /**
@@ -145,9 +166,11 @@ FlushHobVariableToFlash (
   This function writes a buffer to variable storage space into a firmware
   volume block device. The destination is specified by the parameter
   VariableBase. Fault Tolerant Write protocol is used for writing.
+  Only the range of bytes that differs from the current content is written.
 
   @param  VariableBase   Base address of the variable to write.
   @param  VariableBuffer Point to the variable data buffer.
+  @param  WrittenSize    Return the number of bytes written.
 
   @retval EFI_SUCCESS    The function completed successfully.
   @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
@@ -156,8 +179,34 @@ FlushHobVariableToFlash (
 **/
 EFI_STATUS
 FtwVariableSpace (
+  IN  EFI_PHYSICAL_ADDRESS   VariableBase,
+  IN  VARIABLE_STORE_HEADER  *VariableBuffer,
+  OUT UINTN                  *WrittenSize
+  );
+
+/**
+  Writes a range of a buffer to variable storage space, in the working block.
+
+  This function writes the bytes at Offset to Offset + Length of a buffer
+  holding the whole variable storage into a firmware volume block device.
+  Fault Tolerant Write protocol is used for writing, in one FTW record.
+
+  @param  VariableBase   Base address of the variable to write.
+  @param  VariableBuffer Point to the variable data buffer.
+  @param  Offset         Offset of the range in the variable storage.
+  @param  Length         Length of the range in bytes.
+
+  @retval EFI_SUCCESS    The function completed successfully.
+  @retval EFI_NOT_FOUND  Fail to locate Fault Tolerant Write protocol.
+  @retval EFI_ABORTED    The function could not complete successfully.
+
+**/
+EFI_STATUS
+FtwVariableSpaceRange (
   IN EFI_PHYSICAL_ADDRESS   VariableBase,
-  IN VARIABLE_STORE_HEADER  *VariableBuffer
+  IN VARIABLE_STORE_HEADER  *VariableBuffer,
+  IN UINTN                  Offset,
+  IN UINTN                  Length
   );
 
 /**
@@ -536,6 +585,19 @@ VariableServiceSetVariable (
   IN VOID                    *Data
   );
 
+/**
+  Performs one incremental reclaim step on the non-volatile variable store.
+
+  VariableServiceSetVariable() calls it after every successful update of a
+  non-volatile variable, unless ReclaimStepDeferred is set, in which case the
+  caller does it once afterwards. Nothing is done at runtime.
+
+**/
+VOID
+ReclaimStep (
+  VOID
+  );
+
 /**
 
   This code returns information about the EFI variables.
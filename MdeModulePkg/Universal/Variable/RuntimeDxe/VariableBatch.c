@@ -0,0 +1,201 @@
+/** @file
+  Functions to build and parse the payload of a batched SetVariable request.
+  They are shared by the DXE_RUNTIME variable wrapper module, that packs the
+  variables, and the SMM variable module, that parses them.
+
+  Caution: This module requires additional review when modified.
+  The SMM variable module gets the batch from the communicate buffer. This
+  external input must be validated carefully to avoid security issue like
+  buffer overflow, integer overflow.
+
+Copyright (c) 2020, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "VariableBatch.h"
+
+/**
+  Packs variables into the payload of a batched SetVariable request.
+
+  The entries are consumed in order, as long as their item fits into BatchSize
+  bytes. An entry whose parameters are invalid, or whose item would not fit
+  into BatchSize bytes even alone, gets EFI_INVALID_PARAMETER and is not packed.
+  A packed entry gets EFI_NOT_STARTED, until VariableBatchUnpack() sets its
+  result.
+
+  @param[in, out] Entries       The variables to set.
+  @param[in]      EntryCount    Number of entries in Entries.
+  @param[out]     Batch         The batch payload to fill.
+  @param[in]      BatchSize     Size in bytes of Batch.
+  @param[out]     PayloadSize   Number of bytes of Batch filled.
+
+  @return The number of entries consumed, either packed or rejected. It is
+          only smaller than EntryCount when Batch is full.
+
+**/
+UINTN
+VariableBatchPack (
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY                   *Entries,
+  IN     UINTN                                        EntryCount,
+  OUT    SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH  *Batch,
+  IN     UINTN                                        BatchSize,
+  OUT    UINTN                                        *PayloadSize
+  )
+{
+  EDKII_VARIABLE_BATCH_ENTRY                        *Entry;
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  *Item;
+  UINTN                                             Index;
+  UINTN                                             Offset;
+  UINTN                                             NameSize;
+  UINTN                                             InfoSize;
+  UINTN                                             MaxInfoSize;
+
+  ASSERT (BatchSize > VARIABLE_BATCH_FIRST_ITEM_OFFSET + VARIABLE_BATCH_ITEM_HEADER_SIZE);
+
+  Batch->VariableCount = 0;
+  Offset               = VARIABLE_BATCH_FIRST_ITEM_OFFSET;
+  *PayloadSize         = sizeof (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH);
+  MaxInfoSize          = BatchSize - VARIABLE_BATCH_FIRST_ITEM_OFFSET;
+
+  for (Index = 0; Index < EntryCount; Index++) {
+    Entry = &Entries[Index];
+    if ((Entry->VariableName == NULL) || (Entry->VariableName[0] == 0) || (Entry->VendorGuid == NULL) ||
+        ((Entry->DataSize != 0) && (Entry->Data == NULL))) {
+      Entry->Status = EFI_INVALID_PARAMETER;
+      continue;
+    }
+
+    NameSize = StrSize (Entry->VariableName);
+    if ((NameSize > MaxInfoSize - VARIABLE_BATCH_ITEM_HEADER_SIZE) ||
+        (Entry->DataSize > MaxInfoSize - VARIABLE_BATCH_ITEM_HEADER_SIZE - NameSize)) {
+      Entry->Status = EFI_INVALID_PARAMETER;
+      continue;
+    }
+
+    InfoSize = VARIABLE_BATCH_ITEM_HEADER_SIZE + NameSize + Entry->DataSize;
+    if ((Offset > BatchSize) || (InfoSize > BatchSize - Offset)) {
+      //
+      // The batch is full, this entry goes into the next one.
+      //
+      break;
+    }
+
+    Item = (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM *) ((UINT8 *) Batch + Offset);
+    Item->ReturnStatus         = EFI_NOT_STARTED;
+    CopyGuid (&Item->Variable.Guid, Entry->VendorGuid);
+    Item->Variable.DataSize    = Entry->DataSize;
+    Item->Variable.NameSize    = NameSize;
+    Item->Variable.Attributes  = Entry->Attributes;
+    CopyMem (Item->Variable.Name, Entry->VariableName, NameSize);
+    CopyMem ((UINT8 *) Item->Variable.Name + NameSize, Entry->Data, Entry->DataSize);
+
+    Entry->Status = EFI_NOT_STARTED;
+    Batch->VariableCount++;
+    *PayloadSize  = Offset + InfoSize;
+    Offset       += ALIGN_VALUE (InfoSize, SMM_VARIABLE_BATCH_ITEM_ALIGNMENT);
+  }
+
+  return Index;
+}
+
+/**
+  Copies the result of every variable of a processed batch back to the entries
+  it was packed from.
+
+  @param[in, out] Entries       The entries given to VariableBatchPack().
+  @param[in]      EntryCount    Number of entries VariableBatchPack() consumed.
+  @param[in]      Batch         The batch payload, as returned by SMM.
+  @param[in]      BatchStatus   The status of the whole batch. It is the result of
+                                the variables that SMM did not process.
+
+**/
+VOID
+VariableBatchUnpack (
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY                   *Entries,
+  IN     UINTN                                        EntryCount,
+  IN     SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH  *Batch,
+  IN     EFI_STATUS                                   BatchStatus
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  *Item;
+  UINTN                                             Index;
+  UINTN                                             Offset;
+  UINTN                                             InfoSize;
+
+  //
+  // The item offsets are recomputed from the entries rather than read back
+  // from the communicate buffer.
+  //
+  Offset = VARIABLE_BATCH_FIRST_ITEM_OFFSET;
+  for (Index = 0; Index < EntryCount; Index++) {
+    if (Entries[Index].Status != EFI_NOT_STARTED) {
+      continue;
+    }
+
+    Item = (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM *) ((UINT8 *) Batch + Offset);
+    if ((Item->ReturnStatus == EFI_NOT_STARTED) && EFI_ERROR (BatchStatus)) {
+      Entries[Index].Status = BatchStatus;
+    } else {
+      Entries[Index].Status = Item->ReturnStatus;
+    }
+
+    InfoSize = VARIABLE_BATCH_ITEM_HEADER_SIZE + StrSize (Entries[Index].VariableName) + Entries[Index].DataSize;
+    Offset  += ALIGN_VALUE (InfoSize, SMM_VARIABLE_BATCH_ITEM_ALIGNMENT);
+  }
+}
+
+/**
+  Gets an item of a batched SetVariable request, and checks that the item,
+  including its variable name and data, lies within the batch.
+
+  Caution: This function may receive untrusted input.
+  Only the bounds of the item are checked, the caller still has to check its
+  variable name after a speculation barrier.
+
+  @param[in]      Batch         The batch payload.
+  @param[in]      BatchSize     Size in bytes of Batch.
+  @param[in, out] Offset        On input, the offset of the item in Batch, which
+                                is VARIABLE_BATCH_FIRST_ITEM_OFFSET for the first
+                                one. On output, the offset of the next item.
+  @param[out]     Item          The item.
+
+  @retval EFI_SUCCESS           The item lies within the batch.
+  @retval EFI_ACCESS_DENIED     The item does not lie within the batch.
+
+**/
+EFI_STATUS
+VariableBatchGetItem (
+  IN     SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH       *Batch,
+  IN     UINTN                                             BatchSize,
+  IN OUT UINTN                                             *Offset,
+  OUT    SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  **Item
+  )
+{
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  *BatchItem;
+  UINTN                                             InfoSize;
+
+  if ((*Offset > BatchSize) || (BatchSize - *Offset < VARIABLE_BATCH_ITEM_HEADER_SIZE)) {
+    DEBUG ((DEBUG_ERROR, "SetVariableBatch: Item exceeds communication buffer size limit!\n"));
+    return EFI_ACCESS_DENIED;
+  }
+
+  BatchItem = (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM *) ((UINT8 *) Batch + *Offset);
+  if (((UINTN)(~0) - BatchItem->Variable.DataSize < VARIABLE_BATCH_ITEM_HEADER_SIZE) ||
+      ((UINTN)(~0) - BatchItem->Variable.NameSize < VARIABLE_BATCH_ITEM_HEADER_SIZE + BatchItem->Variable.DataSize)) {
+    //
+    // Prevent InfoSize overflow happen
+    //
+    return EFI_ACCESS_DENIED;
+  }
+  InfoSize = VARIABLE_BATCH_ITEM_HEADER_SIZE + BatchItem->Variable.DataSize + BatchItem->Variable.NameSize;
+
+  if (InfoSize > BatchSize - *Offset) {
+    DEBUG ((DEBUG_ERROR, "SetVariableBatch: Data size exceed communication buffer size limit!\n"));
+    return EFI_ACCESS_DENIED;
+  }
+
+  *Item    = BatchItem;
+  *Offset += ALIGN_VALUE (InfoSize, SMM_VARIABLE_BATCH_ITEM_ALIGNMENT);
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,109 @@
+/** @file
+  The batched SetVariable payload routines shared by the DXE_RUNTIME variable
+  wrapper module and the SMM variable module.
+
+Copyright (c) 2020, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _VARIABLE_BATCH_H_
+#define _VARIABLE_BATCH_H_
+
+#include <Uefi.h>
+
+#include <Protocol/VariableBatch.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+
+#include <Guid/SmmVariableCommon.h>
+
+///
+/// Offset of the first item from the start of the batch.
+///
+#define VARIABLE_BATCH_FIRST_ITEM_OFFSET  \
+  ALIGN_VALUE (sizeof (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH), SMM_VARIABLE_BATCH_ITEM_ALIGNMENT)
+
+///
+/// Size of an item without its variable name and data.
+///
+#define VARIABLE_BATCH_ITEM_HEADER_SIZE  \
+  OFFSET_OF (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM, Variable.Name)
+
+/**
+  Packs variables into the payload of a batched SetVariable request.
+
+  The entries are consumed in order, as long as their item fits into BatchSize
+  bytes. An entry whose parameters are invalid, or whose item would not fit
+  into BatchSize bytes even alone, gets EFI_INVALID_PARAMETER and is not packed.
+  A packed entry gets EFI_NOT_STARTED, until VariableBatchUnpack() sets its
+  result.
+
+  @param[in, out] Entries       The variables to set.
+  @param[in]      EntryCount    Number of entries in Entries.
+  @param[out]     Batch         The batch payload to fill.
+  @param[in]      BatchSize     Size in bytes of Batch.
+  @param[out]     PayloadSize   Number of bytes of Batch filled.
+
+  @return The number of entries consumed, either packed or rejected. It is
+          only smaller than EntryCount when Batch is full.
+
+**/
+UINTN
+VariableBatchPack (
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY                   *Entries,
+  IN     UINTN                                        EntryCount,
+  OUT    SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH  *Batch,
+  IN     UINTN                                        BatchSize,
+  OUT    UINTN                                        *PayloadSize
+  );
+
+/**
+  Copies the result of every variable of a processed batch back to the entries
+  it was packed from.
+
+  @param[in, out] Entries       The entries given to VariableBatchPack().
+  @param[in]      EntryCount    Number of entries VariableBatchPack() consumed.
+  @param[in]      Batch         The batch payload, as returned by SMM.
+  @param[in]      BatchStatus   The status of the whole batch. It is the result of
+                                the variables that SMM did not process.
+
+**/
+VOID
+VariableBatchUnpack (
+  IN OUT EDKII_VARIABLE_BATCH_ENTRY                   *Entries,
+  IN     UINTN                                        EntryCount,
+  IN     SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH  *Batch,
+  IN     EFI_STATUS                                   BatchStatus
+  );
+
+/**
+  Gets an item of a batched SetVariable request, and checks that the item,
+  including its variable name and data, lies within the batch.
+
+  Caution: This function may receive untrusted input.
+  Only the bounds of the item are checked, the caller still has to check its
+  variable name after a speculation barrier.
+
+  @param[in]      Batch         The batch payload.
+  @param[in]      BatchSize     Size in bytes of Batch.
+  @param[in, out] Offset        On input, the offset of the item in Batch, which
+                                is VARIABLE_BATCH_FIRST_ITEM_OFFSET for the first
+                                one. On output, the offset of the next item.
+  @param[out]     Item          The item.
+
+  @retval EFI_SUCCESS           The item lies within the batch.
+  @retval EFI_ACCESS_DENIED     The item does not lie within the batch.
+
+**/
+EFI_STATUS
+VariableBatchGetItem (
+  IN     SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH       *Batch,
+  IN     UINTN                                             BatchSize,
+  IN OUT UINTN                                             *Offset,
+  OUT    SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  **Item
+  );
+
+#endif
@@ -9,6 +9,34 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "VariableParsing.h"
 
+//
+// The variable lookup index is set associative: a name and GUID hash to one
+// set, and can be recorded in any slot of it. The number of sets must be a
+// power of two.
+//
+#define VARIABLE_INDEX_SET_COUNT    256
+#define VARIABLE_INDEX_WAY_COUNT    4
+
+//
+// A slot of the variable lookup index. It remembers where a variable was
+// last found in a variable store.
+//
+typedef struct {
+  VARIABLE_HEADER   *StartPtr;
+  UINT32            Hash;
+  UINT32            Offset;
+} VARIABLE_INDEX_ENTRY;
+
+//
+// The index is only a hint in front of the store walk done by
+// FindVariableEx(): hits are checked against the store and fall back to the
+// walk, misses always walk. It is enabled by VariableIndexBuild() in the
+// drivers that own the variable stores.
+//
+STATIC VARIABLE_INDEX_ENTRY  mVariableIndex[VARIABLE_INDEX_SET_COUNT][VARIABLE_INDEX_WAY_COUNT];
+STATIC UINT8                 mVariableIndexVictim[VARIABLE_INDEX_SET_COUNT];
+STATIC BOOLEAN               mVariableIndexEnabled = FALSE;
+
 /**
 
   This code checks if variable header is valid or not.
@@ -437,6 +465,284 @@ VariableCompareTimeStampInternal (
   return (BOOLEAN) (FirstTime->Second <= SecondTime->Second);
 }
 
+/**
+  Computes the lookup index hash of a variable name and vendor GUID.
+
+  @param[in] VariableName       Name of the variable.
+  @param[in] NameSize           Maximum size in bytes of VariableName.
+  @param[in] VendorGuid         Vendor GUID of the variable.
+
+  @return The hash value.
+
+**/
+STATIC
+UINT32
+VariableIndexHash (
+  IN CHAR16                     *VariableName,
+  IN UINTN                      NameSize,
+  IN EFI_GUID                   *VendorGuid
+  )
+{
+  UINT32  Hash;
+  UINTN   Index;
+
+  //
+  // FNV-1a over the CHAR16 name and the four UINT32 of the GUID.
+  //
+  Hash = 0x811C9DC5;
+  for (Index = 0; Index < NameSize / sizeof (CHAR16) && VariableName[Index] != 0; Index++) {
+    Hash = (Hash ^ VariableName[Index]) * 0x01000193;
+  }
+  for (Index = 0; Index < sizeof (EFI_GUID) / sizeof (UINT32); Index++) {
+    Hash = (Hash ^ ReadUnaligned32 ((UINT32 *) VendorGuid + Index)) * 0x01000193;
+  }
+
+  return Hash;
+}
+
+/**
+  Looks up a variable of a variable store in the lookup index.
+
+  @param[in] Hash               Hash of the name and vendor GUID of the variable.
+  @param[in] StartPtr           Start of the variable store.
+
+  @return The index slot of the variable, or NULL if it is not in the index.
+
+**/
+STATIC
+VARIABLE_INDEX_ENTRY *
+VariableIndexLookup (
+  IN UINT32                     Hash,
+  IN VARIABLE_HEADER            *StartPtr
+  )
+{
+  VARIABLE_INDEX_ENTRY  *Set;
+  UINTN                 Way;
+
+  Set = mVariableIndex[Hash & (VARIABLE_INDEX_SET_COUNT - 1)];
+  for (Way = 0; Way < VARIABLE_INDEX_WAY_COUNT; Way++) {
+    if ((Set[Way].StartPtr == StartPtr) && (Set[Way].Hash == Hash)) {
+      return &Set[Way];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Drops every variable whose name and vendor GUID have the given hash from
+  the lookup index, in all variable stores.
+
+  @param[in] Hash               Hash of the name and vendor GUID.
+
+**/
+STATIC
+VOID
+VariableIndexDrop (
+  IN UINT32                     Hash
+  )
+{
+  VARIABLE_INDEX_ENTRY  *Set;
+  UINTN                 Way;
+
+  Set = mVariableIndex[Hash & (VARIABLE_INDEX_SET_COUNT - 1)];
+  for (Way = 0; Way < VARIABLE_INDEX_WAY_COUNT; Way++) {
+    if (Set[Way].Hash == Hash) {
+      Set[Way].StartPtr = NULL;
+    }
+  }
+}
+
+/**
+  Records the variable PtrTrack->CurrPtr in the lookup index. It takes the
+  slot the variable already has, else a free slot of its set, else the slots
+  of the set are reused in turn.
+
+  @param[in] Hash               Hash of the name and vendor GUID of the variable.
+  @param[in] PtrTrack           Variable Track Pointer structure of the variable.
+
+**/
+STATIC
+VOID
+VariableIndexRecord (
+  IN UINT32                     Hash,
+  IN VARIABLE_POINTER_TRACK     *PtrTrack
+  )
+{
+  VARIABLE_INDEX_ENTRY  *Entry;
+  VARIABLE_INDEX_ENTRY  *Set;
+  UINTN                 SetIndex;
+  UINTN                 Way;
+
+  Entry = VariableIndexLookup (Hash, PtrTrack->StartPtr);
+  if (Entry == NULL) {
+    SetIndex = Hash & (VARIABLE_INDEX_SET_COUNT - 1);
+    Set      = mVariableIndex[SetIndex];
+    for (Way = 0; Way < VARIABLE_INDEX_WAY_COUNT; Way++) {
+      if (Set[Way].StartPtr == NULL) {
+        Entry = &Set[Way];
+        break;
+      }
+    }
+    if (Entry == NULL) {
+      Entry = &Set[mVariableIndexVictim[SetIndex]];
+      mVariableIndexVictim[SetIndex] = (UINT8) ((mVariableIndexVictim[SetIndex] + 1) % VARIABLE_INDEX_WAY_COUNT);
+    }
+  }
+
+  Entry->StartPtr = PtrTrack->StartPtr;
+  Entry->Hash     = Hash;
+  Entry->Offset   = (UINT32) ((UINTN) PtrTrack->CurrPtr - (UINTN) PtrTrack->StartPtr);
+}
+
+/**
+  Checks that the variable found through the lookup index at PtrTrack->CurrPtr
+  is still the one FindVariableEx() would return.
+
+  @param[in] VariableName       Name of the variable to be found.
+  @param[in] VendorGuid         Vendor GUID to be found.
+  @param[in] IgnoreRtCheck      Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                check at runtime when searching variable.
+  @param[in] PtrTrack           Variable Track Pointer structure of the candidate.
+  @param[in] AuthFormat         TRUE indicates authenticated variables are used.
+                                FALSE indicates authenticated variables are not used.
+
+  @retval TRUE                  The candidate is the variable searched for.
+  @retval FALSE                 The index is stale for this variable.
+
+**/
+STATIC
+BOOLEAN
+VariableIndexMatch (
+  IN CHAR16                     *VariableName,
+  IN EFI_GUID                   *VendorGuid,
+  IN BOOLEAN                    IgnoreRtCheck,
+  IN VARIABLE_POINTER_TRACK     *PtrTrack,
+  IN BOOLEAN                    AuthFormat
+  )
+{
+  VARIABLE_HEADER  *Variable;
+  VARIABLE_HEADER  *NextVariable;
+  UINTN            NameSize;
+
+  Variable = PtrTrack->CurrPtr;
+  if (!IsValidVariableHeader (Variable, PtrTrack->EndPtr) || Variable->State != VAR_ADDED) {
+    return FALSE;
+  }
+
+  NextVariable = GetNextVariablePtr (Variable, AuthFormat);
+  if ((NextVariable <= Variable) || (NextVariable > PtrTrack->EndPtr)) {
+    return FALSE;
+  }
+
+  if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+    return FALSE;
+  }
+
+  NameSize = NameSizeOfVariable (Variable, AuthFormat);
+  return (BOOLEAN) (NameSize != 0 &&
+                    CompareGuid (VendorGuid, GetVendorGuidPtr (Variable, AuthFormat)) &&
+                    CompareMem (VariableName, GetVariableNamePtr (Variable, AuthFormat), NameSize) == 0);
+}
+
+/**
+  Enables the variable lookup index and fills it with the variables of a
+  variable store.
+
+  @param[in] VariableStore      Pointer to the variable store to index.
+  @param[in] AuthFormat         TRUE indicates authenticated variables are used.
+                                FALSE indicates authenticated variables are not used.
+
+**/
+VOID
+VariableIndexBuild (
+  IN VARIABLE_STORE_HEADER      *VariableStore,
+  IN BOOLEAN                    AuthFormat
+  )
+{
+  VARIABLE_POINTER_TRACK  PtrTrack;
+  UINT32                  Hash;
+
+  mVariableIndexEnabled = TRUE;
+
+  PtrTrack.StartPtr = GetStartPointer (VariableStore);
+  PtrTrack.EndPtr   = GetEndPointer (VariableStore);
+
+  for ( PtrTrack.CurrPtr = PtrTrack.StartPtr
+      ; IsValidVariableHeader (PtrTrack.CurrPtr, PtrTrack.EndPtr)
+      ; PtrTrack.CurrPtr = GetNextVariablePtr (PtrTrack.CurrPtr, AuthFormat)
+      ) {
+    if (PtrTrack.CurrPtr->State != VAR_ADDED) {
+      continue;
+    }
+
+    Hash = VariableIndexHash (
+             GetVariableNamePtr (PtrTrack.CurrPtr, AuthFormat),
+             NameSizeOfVariable (PtrTrack.CurrPtr, AuthFormat),
+             GetVendorGuidPtr (PtrTrack.CurrPtr, AuthFormat)
+             );
+    if (VariableIndexLookup (Hash, PtrTrack.StartPtr) != NULL) {
+      //
+      // Keep the first copy, as the store walk does.
+      //
+      continue;
+    }
+
+    VariableIndexRecord (Hash, &PtrTrack);
+  }
+
+  //
+  // A variable that also has a copy in deleted transition is left to the
+  // store walk, which reports both copies.
+  //
+  for ( PtrTrack.CurrPtr = PtrTrack.StartPtr
+      ; IsValidVariableHeader (PtrTrack.CurrPtr, PtrTrack.EndPtr)
+      ; PtrTrack.CurrPtr = GetNextVariablePtr (PtrTrack.CurrPtr, AuthFormat)
+      ) {
+    if (PtrTrack.CurrPtr->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+      Hash = VariableIndexHash (
+               GetVariableNamePtr (PtrTrack.CurrPtr, AuthFormat),
+               NameSizeOfVariable (PtrTrack.CurrPtr, AuthFormat),
+               GetVendorGuidPtr (PtrTrack.CurrPtr, AuthFormat)
+               );
+      VariableIndexDrop (Hash);
+    }
+  }
+}
+
+/**
+  Drops a variable from the variable lookup index.
+
+  @param[in] VariableName       Name of the variable.
+  @param[in] VendorGuid         Vendor GUID of the variable.
+
+**/
+VOID
+VariableIndexRemove (
+  IN CHAR16                     *VariableName,
+  IN EFI_GUID                   *VendorGuid
+  )
+{
+  if (!mVariableIndexEnabled || VariableName[0] == 0) {
+    return;
+  }
+
+  VariableIndexDrop (VariableIndexHash (VariableName, MAX_UINTN, VendorGuid));
+}
+
+/**
+  Drops all variables from the variable lookup index, for example after the
+  variables of a store have been moved.
+
+**/
+VOID
+VariableIndexInvalidate (
+  VOID
+  )
+{
+  ZeroMem (mVariableIndex, sizeof (mVariableIndex));
+}
+
 /**
   Find the variable in the specified variable store.
 
@@ -462,9 +768,31 @@ FindVariableEx (
 {
   VARIABLE_HEADER                *InDeletedVariable;
   VOID                           *Point;
+  VARIABLE_INDEX_ENTRY           *Entry;
+  UINT32                         Hash;
 
   PtrTrack->InDeletedTransitionPtr = NULL;
 
+  //
+  // Try the lookup index first.
+  //
+  Hash = 0;
+  if (mVariableIndexEnabled && VariableName[0] != 0) {
+    Hash  = VariableIndexHash (VariableName, MAX_UINTN, VendorGuid);
+    Entry = VariableIndexLookup (Hash, PtrTrack->StartPtr);
+    if (Entry != NULL) {
+      PtrTrack->CurrPtr = (VARIABLE_HEADER *) ((UINTN) PtrTrack->StartPtr + Entry->Offset);
+      if (VariableIndexMatch (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack, AuthFormat)) {
+        return EFI_SUCCESS;
+      }
+
+      //
+      // The store has changed under the index, walk it instead.
+      //
+      Entry->StartPtr = NULL;
+    }
+  }
+
   //
   // Find the variable by walk through HOB, volatile and non-volatile variable store.
   //
@@ -495,6 +823,9 @@ FindVariableEx (
                 InDeletedVariable     = PtrTrack->CurrPtr;
               } else {
                 PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+                if (mVariableIndexEnabled && InDeletedVariable == NULL) {
+                  VariableIndexRecord (Hash, PtrTrack);
+                }
                 return EFI_SUCCESS;
               }
             }
@@ -689,6 +1020,190 @@ Done:
   return Status;
 }
 
+/**
+  Checks whether a variable is live, that is added or in deleted transition.
+
+  @param[in] Variable   Pointer to the Variable Header.
+
+  @retval TRUE          The variable is live.
+  @retval FALSE         The variable is deleted or was not completely written.
+
+**/
+STATIC
+BOOLEAN
+IsLiveVariable (
+  IN VARIABLE_HEADER        *Variable
+  )
+{
+  return (BOOLEAN) ((Variable->State == VAR_ADDED) ||
+                    (Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)));
+}
+
+/**
+  Performs one bounded step of an incremental compaction of a variable store.
+
+  The first run of variables that are not live is shrunk to one deleted
+  variable, and the live variables behind it are moved in front of it. When
+  no live variable follows the run, the deleted variables at the end of the
+  store are erased instead, from the back, so that the store can be walked up
+  to its end after every step. A step changes at most MaxStepSize bytes, or
+  if that is smaller, the size of one variable and a variable header.
+
+  Live variables keep their order, so the store holds the same variables
+  after every step, and the changed bytes are contiguous so that they can be
+  written with a single fault tolerant write.
+
+  @param[in, out] VariableStore       Pointer to the variable store to compact.
+  @param[in]      MaxStepSize         Maximum number of bytes to change.
+  @param[in]      AuthFormat          TRUE indicates authenticated variables are used.
+                                      FALSE indicates authenticated variables are not used.
+  @param[out]     ChangedOffset       Offset of the changed bytes from the store header.
+  @param[out]     ChangedSize         Number of changed bytes.
+  @param[out]     MovedSize           Number of bytes of live variables moved.
+  @param[out]     LastVariableOffset  Offset of the end of the last variable from
+                                      the store header after the step.
+
+  @retval EFI_SUCCESS             The store was changed.
+  @retval EFI_NOT_FOUND           The store holds no deleted variables that can
+                                  be compacted incrementally.
+
+**/
+EFI_STATUS
+CompactVariableStoreStep (
+  IN OUT VARIABLE_STORE_HEADER  *VariableStore,
+  IN     UINTN                  MaxStepSize,
+  IN     BOOLEAN                AuthFormat,
+  OUT    UINTN                  *ChangedOffset,
+  OUT    UINTN                  *ChangedSize,
+  OUT    UINTN                  *MovedSize,
+  OUT    UINTN                  *LastVariableOffset
+  )
+{
+  VARIABLE_HEADER   *StoreEnd;
+  VARIABLE_HEADER   *Variable;
+  VARIABLE_HEADER   *NextVariable;
+  VARIABLE_HEADER   *GapStart;
+  VARIABLE_HEADER   *GapEnd;
+  VARIABLE_HEADER   *Filler;
+  UINT8             *Erased;
+  UINT8             *EraseStart;
+  UINTN             HeaderSize;
+  UINTN             FillerSize;
+  UINTN             GapSize;
+
+  StoreEnd   = GetEndPointer (VariableStore);
+  HeaderSize = GetVariableHeaderSize (AuthFormat);
+  FillerSize = HeaderSize + sizeof (CHAR16) + GET_PAD_SIZE (sizeof (CHAR16));
+
+  //
+  // Find the first run of variables that are not live.
+  //
+  Variable = GetStartPointer (VariableStore);
+  while (IsValidVariableHeader (Variable, StoreEnd) && IsLiveVariable (Variable)) {
+    Variable = GetNextVariablePtr (Variable, AuthFormat);
+  }
+  if (!IsValidVariableHeader (Variable, StoreEnd)) {
+    return EFI_NOT_FOUND;
+  }
+
+  GapStart = Variable;
+  while (IsValidVariableHeader (Variable, StoreEnd) && !IsLiveVariable (Variable)) {
+    Variable = GetNextVariablePtr (Variable, AuthFormat);
+  }
+  GapEnd  = Variable;
+  GapSize = (UINTN) GapEnd - (UINTN) GapStart;
+  if ((GapEnd > StoreEnd) || (GapSize < FillerSize)) {
+    //
+    // A torn variable, leave it to a full reclaim.
+    //
+    return EFI_NOT_FOUND;
+  }
+
+  *MovedSize = 0;
+  if (!IsValidVariableHeader (GapEnd, StoreEnd)) {
+    //
+    // Nothing live follows, erase the deleted variables at the end of the
+    // store. Erase from the back, behind what earlier steps erased, and keep
+    // the headers in front of the erased bytes, so the store is still walked
+    // over them to its old end until they are erased too.
+    //
+    Erased = (UINT8 *) GapEnd;
+    while ((Erased > (UINT8 *) GapStart) && (Erased[-1] == 0xff)) {
+      Erased--;
+    }
+
+    if ((UINTN) Erased - (UINTN) GapStart <= MaxStepSize) {
+      EraseStart = (UINT8 *) GapStart;
+      GapEnd     = GapStart;
+    } else {
+      EraseStart   = Erased - MaxStepSize;
+      Variable     = GapStart;
+      NextVariable = GetNextVariablePtr (Variable, AuthFormat);
+      while ((UINT8 *) NextVariable <= EraseStart) {
+        Variable     = NextVariable;
+        NextVariable = GetNextVariablePtr (Variable, AuthFormat);
+      }
+      if (EraseStart < (UINT8 *) Variable + HeaderSize) {
+        //
+        // Do not cut into the header of a variable that stays in the walk.
+        //
+        if (Erased > (UINT8 *) Variable + HeaderSize) {
+          EraseStart = (UINT8 *) Variable + HeaderSize;
+        } else {
+          EraseStart = (UINT8 *) Variable;
+        }
+      }
+
+      //
+      // The walk now ends at the first variable whose header is erased.
+      //
+      GapEnd = (EraseStart == (UINT8 *) Variable) ? Variable : NextVariable;
+    }
+
+    *ChangedOffset      = (UINTN) EraseStart - (UINTN) VariableStore;
+    *ChangedSize        = (UINTN) Erased - (UINTN) EraseStart;
+    *LastVariableOffset = (UINTN) GapEnd - (UINTN) VariableStore;
+    SetMem (EraseStart, *ChangedSize, 0xff);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Move the live variables behind the run in front of it, skipping the
+  // deleted ones between them, and put a deleted variable covering the rest
+  // of the moved over range behind them. The moved variables only ever land
+  // on bytes that were already moved over, so this can be done in place.
+  //
+  Variable = GapEnd;
+  while (IsValidVariableHeader (Variable, StoreEnd)) {
+    NextVariable = GetNextVariablePtr (Variable, AuthFormat);
+    if (IsLiveVariable (Variable)) {
+      if ((*MovedSize > 0) &&
+          (*MovedSize + ((UINTN) NextVariable - (UINTN) Variable) + FillerSize > MaxStepSize)) {
+        break;
+      }
+      CopyMem ((UINT8 *) GapStart + *MovedSize, Variable, (UINTN) NextVariable - (UINTN) Variable);
+      *MovedSize += (UINTN) NextVariable - (UINTN) Variable;
+    }
+    Variable = NextVariable;
+  }
+
+  Filler = (VARIABLE_HEADER *) ((UINTN) GapStart + *MovedSize);
+  ZeroMem (Filler, FillerSize);
+  Filler->StartId = VARIABLE_DATA;
+  Filler->State   = VAR_ADDED & VAR_DELETED;
+  SetNameSizeOfVariable (Filler, sizeof (CHAR16), AuthFormat);
+  SetDataSizeOfVariable (Filler, (UINTN) Variable - (UINTN) Filler - FillerSize, AuthFormat);
+
+  *ChangedOffset = (UINTN) GapStart - (UINTN) VariableStore;
+  *ChangedSize   = *MovedSize + FillerSize;
+
+  while (IsValidVariableHeader (Variable, StoreEnd)) {
+    Variable = GetNextVariablePtr (Variable, AuthFormat);
+  }
+  *LastVariableOffset = (UINTN) Variable - (UINTN) VariableStore;
+  return EFI_SUCCESS;
+}
+
 /**
   Routine used to track statistical information about variable usage.
   The data is stored in the EFI system table so it can be accessed later.
@@ -10,8 +10,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef _VARIABLE_PARSING_H_
 #define _VARIABLE_PARSING_H_
 
-#include <Guid/ImageAuthentication.h>
 #include "Variable.h"
+#include <Guid/ImageAuthentication.h>
 
 /**
 
@@ -257,6 +257,44 @@ VariableCompareTimeStampInternal (
   IN EFI_TIME               *SecondTime
   );
 
+/**
+  Enables the variable lookup index and fills it with the variables of a
+  variable store.
+
+  @param[in] VariableStore      Pointer to the variable store to index.
+  @param[in] AuthFormat         TRUE indicates authenticated variables are used.
+                                FALSE indicates authenticated variables are not used.
+
+**/
+VOID
+VariableIndexBuild (
+  IN VARIABLE_STORE_HEADER      *VariableStore,
+  IN BOOLEAN                    AuthFormat
+  );
+
+/**
+  Drops a variable from the variable lookup index.
+
+  @param[in] VariableName       Name of the variable.
+  @param[in] VendorGuid         Vendor GUID of the variable.
+
+**/
+VOID
+VariableIndexRemove (
+  IN CHAR16                     *VariableName,
+  IN EFI_GUID                   *VendorGuid
+  );
+
+/**
+  Drops all variables from the variable lookup index, for example after the
+  variables of a store have been moved.
+
+**/
+VOID
+VariableIndexInvalidate (
+  VOID
+  );
+
 /**
   Find the variable in the specified variable store.
 
@@ -311,6 +349,46 @@ VariableServiceGetNextVariableInternal (
   IN  BOOLEAN               AuthFormat
   );
 
+/**
+  Performs one bounded step of an incremental compaction of a variable store.
+
+  The first run of variables that are not live is shrunk to one deleted
+  variable, and the live variables behind it are moved in front of it. When
+  no live variable follows the run, the deleted variables at the end of the
+  store are erased instead, from the back, so that the store can be walked up
+  to its end after every step. A step changes at most MaxStepSize bytes, or
+  if that is smaller, the size of one variable and a variable header.
+
+  Live variables keep their order, so the store holds the same variables
+  after every step, and the changed bytes are contiguous so that they can be
+  written with a single fault tolerant write.
+
+  @param[in, out] VariableStore       Pointer to the variable store to compact.
+  @param[in]      MaxStepSize         Maximum number of bytes to change.
+  @param[in]      AuthFormat          TRUE indicates authenticated variables are used.
+                                      FALSE indicates authenticated variables are not used.
+  @param[out]     ChangedOffset       Offset of the changed bytes from the store header.
+  @param[out]     ChangedSize         Number of changed bytes.
+  @param[out]     MovedSize           Number of bytes of live variables moved.
+  @param[out]     LastVariableOffset  Offset of the end of the last variable from
+                                      the store header after the step.
+
+  @retval EFI_SUCCESS             The store was changed.
+  @retval EFI_NOT_FOUND           The store holds no deleted variables that can
+                                  be compacted incrementally.
+
+**/
+EFI_STATUS
+CompactVariableStoreStep (
+  IN OUT VARIABLE_STORE_HEADER  *VariableStore,
+  IN     UINTN                  MaxStepSize,
+  IN     BOOLEAN                AuthFormat,
+  OUT    UINTN                  *ChangedOffset,
+  OUT    UINTN                  *ChangedSize,
+  OUT    UINTN                  *MovedSize,
+  OUT    UINTN                  *LastVariableOffset
+  );
+
 /**
   Routine used to track statistical information about variable usage.
   The data is stored in the EFI system table so it can be accessed later.
@@ -32,6 +32,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "Variable.h"
 #include "VariableParsing.h"
 #include "VariableRuntimeCache.h"
+#include "VariableBatch.h"
 
 extern VARIABLE_STORE_HEADER                         *mNvVariableCache;
 
@@ -424,6 +425,85 @@ SmmVariableGetStatistics (
   return EFI_SUCCESS;
 }
 
+/**
+  Sets all the variables of a batched SetVariable request.
+
+  Caution: This function may receive untrusted input.
+  Every item is validated like a single SMM_VARIABLE_FUNCTION_SET_VARIABLE
+  request before it is used. Processing stops at the first malformed item.
+
+  The incremental reclaim step that VariableServiceSetVariable() does after
+  every update is done once for the whole batch.
+
+  @param[in, out] Batch         The batch copied from the communicate buffer.
+  @param[in]      BatchSize     Size in bytes of Batch.
+
+  @retval EFI_SUCCESS           All the items were processed, their status is
+                                in their ReturnStatus field.
+  @retval EFI_ACCESS_DENIED     An item is malformed. The items before it were
+                                processed, the following ones were not.
+
+**/
+EFI_STATUS
+SmmVariableSetVariableBatch (
+  IN OUT SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH  *Batch,
+  IN     UINTN                                        BatchSize
+  )
+{
+  EFI_STATUS                                        Status;
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH_ITEM  *Item;
+  SMM_VARIABLE_COMMUNICATE_ACCESS_VARIABLE          *SmmVariableHeader;
+  UINTN                                             VariableCount;
+  UINTN                                             Index;
+  UINTN                                             Offset;
+
+  Status        = EFI_SUCCESS;
+  VariableCount = Batch->VariableCount;
+  Offset        = VARIABLE_BATCH_FIRST_ITEM_OFFSET;
+
+  mVariableModuleGlobal->ReclaimStepDeferred = TRUE;
+  for (Index = 0; Index < VariableCount; Index++) {
+    Status = VariableBatchGetItem (Batch, BatchSize, &Offset, &Item);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    //
+    // The VariableSpeculationBarrier() call here is to ensure the previous
+    // range/content checks for the CommBuffer have been completed before the
+    // subsequent consumption of the CommBuffer content.
+    //
+    VariableSpeculationBarrier ();
+    SmmVariableHeader = &Item->Variable;
+    if (SmmVariableHeader->NameSize < sizeof (CHAR16) || SmmVariableHeader->Name[SmmVariableHeader->NameSize/sizeof (CHAR16) - 1] != L'\0') {
+      //
+      // Make sure VariableName is A Null-terminated string.
+      //
+      Status = EFI_ACCESS_DENIED;
+      break;
+    }
+
+    Item->ReturnStatus = VariableServiceSetVariable (
+                           SmmVariableHeader->Name,
+                           &SmmVariableHeader->Guid,
+                           SmmVariableHeader->Attributes,
+                           SmmVariableHeader->DataSize,
+                           (UINT8 *)SmmVariableHeader->Name + SmmVariableHeader->NameSize
+                           );
+  }
+  mVariableModuleGlobal->ReclaimStepDeferred = FALSE;
+
+  //
+  // A failed update leaves the store as it was, so the step is safe to do even
+  // if the batch stopped early. It does nothing if no non-volatile variable was
+  // updated.
+  //
+  AcquireLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
+  ReclaimStep ();
+  ReleaseLockOnlyAtBootTime (&mVariableModuleGlobal->VariableGlobal.VariableServicesLock);
+
+  return Status;
+}
 
 /**
   Communication service SMI Handler entry.
@@ -657,6 +737,23 @@ SmmVariableHandler (
                  );
       break;
 
+    case SMM_VARIABLE_FUNCTION_SET_VARIABLE_BATCH:
+      if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH)) {
+        DEBUG ((DEBUG_ERROR, "SetVariableBatch: SMM communication buffer size invalid!\n"));
+        return EFI_SUCCESS;
+      }
+      //
+      // Copy the input communicate buffer payload to pre-allocated SMM variable buffer payload.
+      // All the variables are set in this one SMI, and the per-variable status is copied back.
+      //
+      CopyMem (mVariableBufferPayload, SmmVariableFunctionHeader->Data, CommBufferPayloadSize);
+      Status = SmmVariableSetVariableBatch (
+                 (SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH *) mVariableBufferPayload,
+                 CommBufferPayloadSize
+                 );
+      CopyMem (SmmVariableFunctionHeader->Data, mVariableBufferPayload, CommBufferPayloadSize);
+      break;
+
     case SMM_VARIABLE_FUNCTION_QUERY_VARIABLE_INFO:
       if (CommBufferPayloadSize < sizeof (SMM_VARIABLE_COMMUNICATE_QUERY_VARIABLE_INFO)) {
         DEBUG ((EFI_D_ERROR, "QueryVariableInfo: SMM communication buffer size invalid!\n"));
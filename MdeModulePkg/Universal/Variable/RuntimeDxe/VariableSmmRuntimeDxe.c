@@ -41,6 +41,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "PrivilegePolymorphic.h"
 #include "VariableParsing.h"
+#include "VariableBatch.h"
 
 EFI_HANDLE                       mHandle                    = NULL;
 EFI_SMM_VARIABLE_PROTOCOL       *mSmmVariable               = NULL;
@@ -64,6 +65,7 @@ BOOLEAN                          mHobFlushComplete;
 EFI_LOCK                         mVariableServicesLock;
 EDKII_VARIABLE_LOCK_PROTOCOL     mVariableLock;
 EDKII_VAR_CHECK_PROTOCOL         mVarCheck;
+EDKII_VARIABLE_BATCH_PROTOCOL    mVariableBatch;
 
 /**
   Some Secure Boot Policy Variable may update following other variable changes(SecureBoot follows PK change, etc).
@@ -1147,6 +1149,77 @@ Done:
   return Status;
 }
 
+/**
+  Set several variables, in the order of Entries, as if SetVariable() was
+  called for each of them.
+
+  The variables are packed into as few SMM_VARIABLE_FUNCTION_SET_VARIABLE_BATCH
+  requests as the SMM payload size allows, instead of one SMI per variable.
+
+  @param[in]      This          The EDKII_VARIABLE_BATCH_PROTOCOL instance.
+  @param[in]      EntryCount    Number of entries in Entries.
+  @param[in, out] Entries       The variables to set. On return, the Status
+                                field of every entry holds the result of
+                                setting it.
+
+  @retval EFI_SUCCESS           All the entries were processed, their result is
+                                in their Status field.
+  @retval EFI_INVALID_PARAMETER Entries is NULL and EntryCount is not 0.
+**/
+EFI_STATUS
+EFIAPI
+VariableBatchSetVariables (
+  IN CONST EDKII_VARIABLE_BATCH_PROTOCOL  *This,
+  IN       UINTN                          EntryCount,
+  IN OUT   EDKII_VARIABLE_BATCH_ENTRY     *Entries
+  )
+{
+  EFI_STATUS                                   Status;
+  SMM_VARIABLE_COMMUNICATE_SET_VARIABLE_BATCH  *Batch;
+  UINTN                                        Index;
+  UINTN                                        Count;
+  UINTN                                        PayloadSize;
+
+  if ((Entries == NULL) && (EntryCount != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  AcquireLockOnlyAtBootTime (&mVariableServicesLock);
+
+  for (Index = 0; Index < EntryCount; Index += Count) {
+    Batch  = NULL;
+    Status = InitCommunicateBuffer ((VOID **)&Batch, mVariableBufferPayloadSize, SMM_VARIABLE_FUNCTION_SET_VARIABLE_BATCH);
+    ASSERT_EFI_ERROR (Status);
+    ASSERT (Batch != NULL);
+
+    Count = VariableBatchPack (&Entries[Index], EntryCount - Index, Batch, mVariableBufferPayloadSize, &PayloadSize);
+    if (Batch->VariableCount == 0) {
+      continue;
+    }
+
+    //
+    // The message length has to match the data actually sent.
+    //
+    InitCommunicateBuffer (NULL, PayloadSize, SMM_VARIABLE_FUNCTION_SET_VARIABLE_BATCH);
+    Status = SendCommunicateBuffer (PayloadSize);
+    VariableBatchUnpack (&Entries[Index], Count, Batch, Status);
+  }
+
+  ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
+
+  if (!EfiAtRuntime ()) {
+    for (Index = 0; Index < EntryCount; Index++) {
+      if (!EFI_ERROR (Entries[Index].Status)) {
+        SecureBootHook (
+          Entries[Index].VariableName,
+          Entries[Index].VendorGuid
+          );
+      }
+    }
+  }
+  return EFI_SUCCESS;
+}
+
 
 /**
   This code returns information about the EFI variables.
@@ -1652,6 +1725,15 @@ SmmVariableReady (
                   );
   ASSERT_EFI_ERROR (Status);
 
+  mVariableBatch.SetVariables = VariableBatchSetVariables;
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &mHandle,
+                  &gEdkiiVariableBatchProtocolGuid,
+                  &mVariableBatch,
+                  NULL
+                  );
+  ASSERT_EFI_ERROR (Status);
+
   gBS->CloseEvent (Event);
 }
 
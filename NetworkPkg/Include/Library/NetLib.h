@@ -2149,6 +2149,28 @@ NetAddChecksum (
   IN UINT16                 Checksum2
   );
 
+/**
+  Update a checksum stored in a header after one 16-bit field of the
+  header changed, without summing the whole header again (RFC 1624).
+  A zero result is returned as 0xFFFF, so an all-zero header verifies.
+
+  @param[in]   Checksum              The checksum as stored in the header.
+  @param[in]   OldData               The 16-bit field before the change, in
+                                     the same byte order as in the header.
+  @param[in]   NewData               The 16-bit field after the change, in
+                                     the same byte order as in the header.
+
+  @return         The checksum to store in the header.
+
+**/
+UINT16
+EFIAPI
+NetUpdateChecksum (
+  IN UINT16                 Checksum,
+  IN UINT16                 OldData,
+  IN UINT16                 NewData
+  );
+
 /**
   Compute the checksum for a NET_BUF.
 
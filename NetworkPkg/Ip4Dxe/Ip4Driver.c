@@ -408,6 +408,13 @@ Ip4CleanService (
 {
   EFI_STATUS                Status;
 
+  DEBUG ((
+    DEBUG_INFO,
+    "Ip4CleanService: %ld bytes delivered, %ld bytes copied.\n",
+    IpSb->RxByteCount,
+    IpSb->RxCopyByteCount
+    ));
+
   IpSb->State     = IP4_SERVICE_DESTROY;
 
   if (IpSb->Timer != NULL) {
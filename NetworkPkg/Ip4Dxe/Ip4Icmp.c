@@ -215,6 +215,7 @@ Ip4IcmpReplyEcho (
   NET_BUF                   *Data;
   EFI_STATUS                Status;
   IP4_HEAD                  ReplyHead;
+  UINT16                    TypeCode;
 
   //
   // make a copy the packet, it is really a bad idea to
@@ -235,9 +236,19 @@ Ip4IcmpReplyEcho (
   //
   Icmp                = (IP4_ICMP_QUERY_HEAD *) NetbufGetByte (Data, 0, NULL);
   ASSERT (Icmp != NULL);
+  TypeCode            = *(UINT16 *) &Icmp->Head;
   Icmp->Head.Type     = ICMP_ECHO_REPLY;
-  Icmp->Head.Checksum = 0;
-  Icmp->Head.Checksum = (UINT16) (~NetblockChecksum ((UINT8 *) Icmp, Data->TotalSize));
+
+  //
+  // Only the type is changed, so update the verified checksum of
+  // the request instead of summing the whole message again. A zero
+  // checksum isn't verified by Ip4IcmpHandle, compute it instead.
+  //
+  if (Icmp->Head.Checksum != 0) {
+    Icmp->Head.Checksum = NetUpdateChecksum (Icmp->Head.Checksum, TypeCode, *(UINT16 *) &Icmp->Head);
+  } else {
+    Icmp->Head.Checksum = (UINT16) (~NetblockChecksum ((UINT8 *) Icmp, Data->TotalSize));
+  }
 
   ReplyHead.Tos       = 0;
   ReplyHead.Fragment  = 0;
@@ -219,6 +219,13 @@ struct _IP4_SERVICE {
 
   UINT32                          MaxPacketSize;
   UINT32                          OldMaxPacketSize; ///< The MTU before IPsec enable.
+
+  //
+  // Received bytes delivered to the IP children, and the bytes that had
+  // to be duplicated because the packet was shared by several children.
+  //
+  UINT64                          RxByteCount;
+  UINT64                          RxCopyByteCount;
 };
 
 #define IP4_INSTANCE_FROM_PROTOCOL(Ip4) \
@@ -1338,8 +1338,11 @@ Ip4InstanceDeliverPacket (
       NetbufFree (Packet);
 
       Packet = Dup;
+      IpInstance->Service->RxCopyByteCount += Packet->TotalSize;
     }
 
+    IpInstance->Service->RxByteCount += Packet->TotalSize;
+
     //
     // Insert it into the delivered packet, then get a user's
     // receive token, pass the wrapped packet up.
@@ -0,0 +1,406 @@
+/** @file
+  Host based unit tests of the DxeNetLib checksum routines.
+
+  NetblockChecksum() sums the data as wide words whenever the start is
+  even, so it is checked against a plain RFC1071 byte-wise sum across
+  every start alignment and odd and even lengths.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <time.h>
+
+#include <Uefi.h>
+
+#include <Library/NetLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "DxeNetLib Checksum Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define CHECKSUM_TEST_MAX_LEN     9000
+#define CHECKSUM_TEST_ALIGN       8
+#define CHECKSUM_BENCHMARK_BYTES  (256 * 1024 * 1024)
+
+EFI_BOOT_SERVICES  mTestBootServices;
+EFI_BOOT_SERVICES  *gBS = &mTestBootServices;
+
+UINT8   *mTestBuffer;
+UINT32  mTestRandom = 1;
+
+/**
+  Stub of gBS->FreePool() that returns the buffer to the host heap,
+  the net buffer library frees its blocks through it.
+
+  @param[in]  Buffer  The buffer to free.
+
+  @retval EFI_SUCCESS  The buffer is freed.
+
+**/
+EFI_STATUS
+EFIAPI
+TestFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of NetListRemoveHead(), which the net buffer library links to.
+
+  @param[in, out]  Head  The list header.
+
+  @return The first node entry that is removed from the list, NULL if the list is empty.
+
+**/
+LIST_ENTRY *
+EFIAPI
+NetListRemoveHead (
+  IN OUT LIST_ENTRY  *Head
+  )
+{
+  LIST_ENTRY  *First;
+
+  if (IsListEmpty (Head)) {
+    return NULL;
+  }
+
+  First = Head->ForwardLink;
+  RemoveEntryList (First);
+  return First;
+}
+
+/**
+  Free function for the external blocks of a net buffer, they belong
+  to the test buffer.
+
+  @param[in]  Arg  Unused.
+
+**/
+VOID
+EFIAPI
+TestExtFree (
+  IN VOID  *Arg
+  )
+{
+}
+
+/**
+  Return a pseudo random number, the sequence is the same on every run.
+
+  @return The random number.
+
+**/
+UINT32
+TestRandom (
+  VOID
+  )
+{
+  mTestRandom = mTestRandom * 1103515245 + 12345;
+  return mTestRandom >> 8;
+}
+
+/**
+  Compute the checksum of a bulk of data the RFC1071 way: network order
+  16-bit words, one byte at a time, and the odd byte padded with zero.
+  The result is in host order.
+
+  @param[in]  Bulk  Pointer to the data.
+  @param[in]  Len   Length of the data, in bytes.
+
+  @return The folded 16-bit sum, in host order.
+
+**/
+UINT16
+ReferenceChecksum (
+  IN UINT8   *Bulk,
+  IN UINT32  Len
+  )
+{
+  UINT32  Sum;
+  UINT32  Index;
+
+  Sum = 0;
+  for (Index = 0; Index + 1 < Len; Index += 2) {
+    Sum += (UINT32) (Bulk[Index] << 8) | Bulk[Index + 1];
+    Sum  = (Sum & 0xffff) + (Sum >> 16);
+  }
+
+  if ((Len & 1) != 0) {
+    Sum += (UINT32) (Bulk[Len - 1] << 8);
+    Sum  = (Sum & 0xffff) + (Sum >> 16);
+  }
+
+  return (UINT16) Sum;
+}
+
+/**
+  NetblockChecksum() should equal the byte-wise sum for every start
+  alignment, for odd and even lengths, on random data and on all-ones
+  data that carries on every addition.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BlockChecksumShouldMatchReference (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  Pass;
+  UINT32  Align;
+  UINT32  Len;
+  UINT32  Index;
+
+  for (Pass = 0; Pass < 2; Pass++) {
+    for (Index = 0; Index < CHECKSUM_TEST_MAX_LEN + CHECKSUM_TEST_ALIGN; Index++) {
+      mTestBuffer[Index] = (UINT8) ((Pass == 0) ? TestRandom () : 0xFF);
+    }
+
+    for (Align = 0; Align < CHECKSUM_TEST_ALIGN; Align++) {
+      for (Len = 0; Len <= CHECKSUM_TEST_MAX_LEN; Len += (Len < 300) ? 1 : 1 + TestRandom () % 97) {
+        UT_ASSERT_EQUAL (
+          NetblockChecksum (mTestBuffer + Align, Len),
+          HTONS (ReferenceChecksum (mTestBuffer + Align, Len))
+          );
+      }
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  NetbufChecksum() should equal the byte-wise sum of a net buffer made
+  of external blocks of odd and even sizes at any alignment.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+NetbufChecksumShouldMatchReference (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  NET_FRAGMENT  Fragment[8];
+  NET_BUF       *Nbuf;
+  UINT32        Iteration;
+  UINT32        Count;
+  UINT32        Index;
+  UINT32        Offset;
+  UINT32        Total;
+
+  for (Index = 0; Index < CHECKSUM_TEST_MAX_LEN + CHECKSUM_TEST_ALIGN; Index++) {
+    mTestBuffer[Index] = (UINT8) TestRandom ();
+  }
+
+  for (Iteration = 0; Iteration < 10000; Iteration++) {
+    Count  = 1 + TestRandom () % 8;
+    Offset = TestRandom () % CHECKSUM_TEST_ALIGN;
+    Total  = 0;
+
+    for (Index = 0; Index < Count; Index++) {
+      Fragment[Index].Bulk = mTestBuffer + Offset + Total;
+      Fragment[Index].Len  = 1 + TestRandom () % 1000;
+      Total               += Fragment[Index].Len;
+    }
+
+    Nbuf = NetbufFromExt (Fragment, Count, 0, 0, TestExtFree, NULL);
+    UT_ASSERT_NOT_NULL (Nbuf);
+
+    UT_ASSERT_EQUAL (NetbufChecksum (Nbuf), HTONS (ReferenceChecksum (mTestBuffer + Offset, Total)));
+    NetbufFree (Nbuf);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  NetUpdateChecksum() should give a checksum that verifies after one
+  16-bit field of a header is rewritten, as an ICMP echo request is
+  turned into an echo reply, and equals the checksum summed again up
+  to the representation of zero. Rewriting fields to zero covers the
+  header that sums to zero, which only verifies with 0xFFFF.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UpdatedChecksumShouldVerify (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT16  Head[32];
+  UINT32  Iteration;
+  UINT32  Words;
+  UINT32  Field;
+  UINT16  OldData;
+  UINT16  Expected;
+
+  for (Iteration = 0; Iteration < 100000; Iteration++) {
+    Words = 2 + TestRandom () % 31;
+    for (Field = 0; Field < Words; Field++) {
+      Head[Field] = (UINT16) ((Iteration < 1000) ? 0xFFFF : TestRandom ());
+    }
+
+    //
+    // Head[1] holds the checksum, rewrite one of the other words.
+    //
+    Head[1] = 0;
+    Head[1] = (UINT16) ~NetblockChecksum ((UINT8 *) Head, Words * 2);
+    UT_ASSERT_EQUAL (NetblockChecksum ((UINT8 *) Head, Words * 2), 0xFFFF);
+
+    Field = TestRandom () % Words;
+    if (Field == 1) {
+      Field = 0;
+    }
+
+    OldData     = Head[Field];
+    Head[Field] = (UINT16) ((Iteration % 3 == 0) ? 0 : TestRandom ());
+    Head[1]     = NetUpdateChecksum (Head[1], OldData, Head[Field]);
+
+    UT_ASSERT_EQUAL (NetblockChecksum ((UINT8 *) Head, Words * 2), 0xFFFF);
+
+    OldData  = Head[1];
+    Head[1]  = 0;
+    Expected = (UINT16) ~NetblockChecksum ((UINT8 *) Head, Words * 2);
+    UT_ASSERT_TRUE ((OldData == Expected) || ((OldData == 0xFFFF) && (Expected == 0)));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Report the NetblockChecksum() throughput on frame sized and large
+  aligned buffers. Nothing is asserted.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BlockChecksumBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32   Sizes[2];
+  UINT32   Size;
+  UINT32   Round;
+  UINT32   Rounds;
+  UINT16   Sum;
+  clock_t  Start;
+  double   Seconds;
+
+  Sizes[0] = 1500;
+  Sizes[1] = CHECKSUM_TEST_MAX_LEN;
+
+  for (Size = 0; Size < ARRAY_SIZE (Sizes); Size++) {
+    Rounds = CHECKSUM_BENCHMARK_BYTES / Sizes[Size];
+    Sum    = 0;
+    Start  = clock ();
+    for (Round = 0; Round < Rounds; Round++) {
+      Sum = (UINT16) (Sum + NetblockChecksum (mTestBuffer, Sizes[Size]));
+    }
+
+    Seconds = (double) (clock () - Start) / CLOCKS_PER_SEC;
+    DEBUG ((DEBUG_INFO, "NetblockChecksum %u bytes: %u MB/s (%04x)\n", Sizes[Size], (UINT32)(CHECKSUM_BENCHMARK_BYTES / Seconds / 1000000), Sum));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  checksum routines and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ChecksumTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  mTestBootServices.FreePool = TestFreePool;
+
+  //
+  // The pool is 8-byte aligned, so the start alignments tested are
+  // the offsets into it.
+  //
+  mTestBuffer = AllocatePool (CHECKSUM_TEST_MAX_LEN + CHECKSUM_TEST_ALIGN);
+  if (mTestBuffer == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ChecksumTests, Framework, "DxeNetLib Checksum Tests", "DxeNetLib.Checksum", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ChecksumTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ChecksumTests, "NetblockChecksum should match the byte-wise sum", "Block", BlockChecksumShouldMatchReference, NULL, NULL, NULL);
+  AddTestCase (ChecksumTests, "NetbufChecksum should match the byte-wise sum", "Netbuf", NetbufChecksumShouldMatchReference, NULL, NULL, NULL);
+  AddTestCase (ChecksumTests, "NetUpdateChecksum result should verify", "Update", UpdatedChecksumShouldVerify, NULL, NULL, NULL);
+  AddTestCase (ChecksumTests, "NetblockChecksum throughput", "Benchmark", BlockChecksumBenchmark, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  if (mTestBuffer != NULL) {
+    FreePool (mTestBuffer);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -624,6 +624,22 @@ MnpDestroyDeviceData (
 
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
+  DEBUG ((
+    DEBUG_INFO,
+    "MnpDestroyDeviceData: %ld bytes delivered, %ld bytes copied.\n",
+    MnpDeviceData->RxByteCount,
+    MnpDeviceData->RxCopyByteCount
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "MnpDestroyDeviceData: %ld polls received %ld packets, %ld system polls with %ld us average interval.\n",
+    MnpDeviceData->PollCount,
+    MnpDeviceData->PollPacketCount,
+    MnpDeviceData->SysPollCount,
+    (MnpDeviceData->SysPollCount == 0) ? 0 :
+      DivU64x64Remainder (MnpDeviceData->SysPollIntervalSum, MnpDeviceData->SysPollCount, NULL) / 10
+    ));
+
   //
   // Free Vlan Config variable name string
   //
@@ -1280,6 +1296,8 @@ MnpStart (
     }
 
     MnpDeviceData->EnableSystemPoll = EnableSystemPoll;
+    MnpDeviceData->PollInterval     = MNP_SYS_POLL_INTERVAL;
+    MnpDeviceData->IdlePollCount    = 0;
   }
 
   //
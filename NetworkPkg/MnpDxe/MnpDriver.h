@@ -69,6 +69,18 @@ typedef struct {
 
   EFI_EVENT                     PollTimer;
   BOOLEAN                       EnableSystemPoll;
+  UINT64                        PollInterval;       ///< Current period of PollTimer.
+  UINT32                        IdlePollCount;      ///< Fast polls without any packet.
+
+  //
+  // Poll statistics: all the polls and the packets received by them,
+  // and the system polls and the sum of their intervals, which bounds
+  // the average latency added by the system poll.
+  //
+  UINT64                        PollCount;
+  UINT64                        PollPacketCount;
+  UINT64                        SysPollCount;
+  UINT64                        SysPollIntervalSum;
 
   EFI_EVENT                     TimeoutCheckTimer;
   EFI_EVENT                     MediaDetectTimer;
@@ -85,6 +97,13 @@ typedef struct {
   UINT32                        BufferLength;
   UINT32                        PaddingSize;
   NET_BUF                       *RxNbufCache;
+
+  //
+  // Received bytes delivered to the instances, and the bytes that had to
+  // be duplicated because the packet was shared by several instances.
+  //
+  UINT64                        RxByteCount;
+  UINT64                        RxCopyByteCount;
 } MNP_DEVICE_DATA;
 
 #define MNP_DEVICE_DATA_FROM_THIS(a) \
@@ -14,6 +14,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define NET_ETHER_FCS_SIZE            4
 
 #define MNP_SYS_POLL_INTERVAL         (10 * TICKS_PER_MS)   // 10 milliseconds
+#define MNP_SYS_POLL_INTERVAL_FAST    (1 * TICKS_PER_MS)    // 1 millisecond
+#define MNP_SYS_POLL_IDLE_COUNT       20    // Idle fast polls before backing off.
+#define MNP_RX_BATCH_SIZE             32    // Max packets received in one poll.
 #define MNP_TIMEOUT_CHECK_INTERVAL    (50 * TICKS_PER_MS)   // 50 milliseconds
 #define MNP_MEDIA_DETECT_INTERVAL     (500 * TICKS_PER_MS)  // 500 milliseconds
 #define MNP_TX_TIMEOUT_TIME           (500 * TICKS_PER_MS)  // 500 milliseconds
@@ -430,6 +433,27 @@ MnpReceivePacket (
   IN OUT MNP_DEVICE_DATA   *MnpDeviceData
   );
 
+/**
+  Try to receive a batch of packets and deliver them.
+
+  Up to MNP_RX_BATCH_SIZE packets are drained from the Snp in one call, so
+  that a burst of frames does not have to wait for further polls.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[out]      PacketCount          The number of packets received.
+
+  @retval EFI_SUCCESS           At least one packet is received.
+  @retval EFI_NOT_STARTED       The simple network protocol is not started.
+  @retval EFI_NOT_READY         No packet received.
+  @retval EFI_DEVICE_ERROR      An unexpected error occurs.
+
+**/
+EFI_STATUS
+MnpReceivePacketBatch (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+     OUT UINT32            *PacketCount
+  );
+
 /**
   Allocate a free NET_BUF from MnpDeviceData->FreeNbufQue. If there is none
   in the queue, first try to allocate some and add them into the queue, then
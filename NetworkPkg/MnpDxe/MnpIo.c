@@ -349,8 +349,12 @@ MnpInstanceDeliverPacket (
     NetbufDuplicate (RxDataWrap->Nbuf, DupNbuf, 0);
     MnpFreeNbuf (MnpDeviceData, RxDataWrap->Nbuf);
     RxDataWrap->Nbuf = DupNbuf;
+
+    MnpDeviceData->RxCopyByteCount += DupNbuf->TotalSize;
   }
 
+  MnpDeviceData->RxByteCount += RxDataWrap->Nbuf->TotalSize;
+
   //
   // All resources are OK, remove the packet from the queue.
   //
@@ -1001,6 +1005,47 @@ EXIT:
 }
 
 
+/**
+  Try to receive a batch of packets and deliver them.
+
+  Up to MNP_RX_BATCH_SIZE packets are drained from the Snp in one call, so
+  that a burst of frames does not have to wait for further polls.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+  @param[out]      PacketCount          The number of packets received.
+
+  @retval EFI_SUCCESS           At least one packet is received.
+  @retval EFI_NOT_STARTED       The simple network protocol is not started.
+  @retval EFI_NOT_READY         No packet received.
+  @retval EFI_DEVICE_ERROR      An unexpected error occurs.
+
+**/
+EFI_STATUS
+MnpReceivePacketBatch (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData,
+     OUT UINT32            *PacketCount
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Count;
+
+  Status = EFI_NOT_READY;
+
+  for (Count = 0; Count < MNP_RX_BATCH_SIZE; Count++) {
+    Status = MnpReceivePacket (MnpDeviceData);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  MnpDeviceData->PollCount++;
+  MnpDeviceData->PollPacketCount += Count;
+
+  *PacketCount = Count;
+  return (Count != 0) ? EFI_SUCCESS : Status;
+}
+
+
 /**
   Remove the received packets if timeout occurs.
 
@@ -1117,6 +1162,8 @@ MnpSystemPoll (
   )
 {
   MNP_DEVICE_DATA  *MnpDeviceData;
+  UINT32           PacketCount;
+  UINT64           Interval;
 
   MnpDeviceData = (MNP_DEVICE_DATA *) Context;
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
@@ -1124,7 +1171,28 @@ MnpSystemPoll (
   //
   // Try to receive packets from Snp.
   //
-  MnpReceivePacket (MnpDeviceData);
+  MnpReceivePacketBatch (MnpDeviceData, &PacketCount);
+
+  MnpDeviceData->SysPollCount++;
+  MnpDeviceData->SysPollIntervalSum += MnpDeviceData->PollInterval;
+
+  //
+  // Poll fast while the traffic is flowing, and back off to the
+  // normal rate after a number of idle polls.
+  //
+  Interval = MnpDeviceData->PollInterval;
+  if (PacketCount != 0) {
+    MnpDeviceData->IdlePollCount = 0;
+    Interval = MNP_SYS_POLL_INTERVAL_FAST;
+  } else if (++MnpDeviceData->IdlePollCount >= MNP_SYS_POLL_IDLE_COUNT) {
+    Interval = MNP_SYS_POLL_INTERVAL;
+  }
+
+  if (Interval != MnpDeviceData->PollInterval) {
+    if (!EFI_ERROR (gBS->SetTimer (MnpDeviceData->PollTimer, TimerPeriodic, Interval))) {
+      MnpDeviceData->PollInterval = Interval;
+    }
+  }
 
   //
   // Dispatch the DPC queued by the NotifyFunction of rx token's events.
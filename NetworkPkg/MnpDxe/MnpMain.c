@@ -758,6 +758,7 @@ MnpPoll (
   EFI_STATUS         Status;
   MNP_INSTANCE_DATA  *Instance;
   EFI_TPL            OldTpl;
+  UINT32             PacketCount;
 
   if (This == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -775,7 +776,7 @@ MnpPoll (
   //
   // Try to receive packets.
   //
-  Status = MnpReceivePacket (Instance->MnpServiceData->MnpDeviceData);
+  Status = MnpReceivePacketBatch (Instance->MnpServiceData->MnpDeviceData, &PacketCount);
 
   //
   // Dispatch the DPC queued by the NotifyFunction of rx token's events.
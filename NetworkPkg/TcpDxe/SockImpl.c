@@ -220,6 +220,7 @@ SockSetTcpRxData (
       Fragment->FragmentBuffer
       );
 
+    Sock->RcvCopyByteCount  += CopyBytes;
     Fragment->FragmentLength = CopyBytes;
     RcvdBytes -= CopyBytes;
     OffSet += CopyBytes;
@@ -824,6 +825,13 @@ SockDestroy (
 {
   ASSERT (SockStream == Sock->Type);
 
+  DEBUG ((
+    DEBUG_INFO,
+    "SockDestroy: %ld bytes received, %ld bytes copied to receive tokens.\n",
+    Sock->RcvByteCount,
+    Sock->RcvCopyByteCount
+    ));
+
   //
   // Flush the completion token buffered
   // by sock and rcv, snd buffer
@@ -1156,6 +1164,7 @@ SockDataRcvd (
   ((TCP_RSV_DATA *) (NetBuffer->ProtoData))->UrgLen = UrgLen;
 
   NetbufQueAppend (Sock->RcvBuffer.DataQueue, NetBuffer);
+  Sock->RcvByteCount += NetBuffer->TotalSize;
 
   SockWakeRcvToken (Sock);
 }
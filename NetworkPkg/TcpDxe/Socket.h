@@ -470,6 +470,8 @@ struct _TCP_SOCKET {
   EFI_LOCK                  Lock;           ///< The lock of socket
   SOCK_BUFFER               SndBuffer;      ///< Send buffer of application's data
   SOCK_BUFFER               RcvBuffer;      ///< Receive buffer of received data
+  UINT64                    RcvByteCount;   ///< Bytes queued in the receive buffer
+  UINT64                    RcvCopyByteCount; ///< Bytes copied to application's receive tokens
   EFI_STATUS                SockError;      ///< The error returned by low layer protocol
   BOOLEAN                   InDestroy;
 
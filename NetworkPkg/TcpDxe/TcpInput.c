@@ -42,8 +42,10 @@ TcpFastRecover (
   IN     TCP_SEG *Seg
   )
 {
-  UINT32  FlightSize;
-  UINT32  Acked;
+  UINT32     FlightSize;
+  UINT32     Acked;
+  TCP_SEQNO  Seq;
+  TCP_SEQNO  HoleEnd;
 
   //
   // Step 1: Three duplicate ACKs and not in fast recovery
@@ -64,6 +66,7 @@ TcpFastRecover (
     //
     // Step 2: Entering fast retransmission
     //
+    Tcb->SndSackRexmit = Tcb->SndUna;
     TcpRetransmit (Tcb, Tcb->SndUna);
     Tcb->CWnd = Tcb->Ssthresh + 3 * Tcb->SndMss;
 
@@ -89,7 +92,18 @@ TcpFastRecover (
     // Step 4 is skipped here only to be executed later
     // by TcpToSendData
     //
-    Tcb->CWnd += Tcb->SndMss;
+    // If the peer has SACKed data above a hole not yet
+    // retransmitted, spend the segment that has left the
+    // network on repairing the hole instead of sending
+    // new data, as in RFC6675.
+    //
+    Seq = TCP_SEQ_GT (Tcb->SndSackRexmit, Tcb->SndUna) ? Tcb->SndSackRexmit : Tcb->SndUna;
+
+    if (TcpGetSackHole (Tcb, &Seq, &HoleEnd)) {
+      TcpRetransmit (Tcb, Seq);
+    } else {
+      Tcb->CWnd += Tcb->SndMss;
+    }
     DEBUG (
       (EFI_D_NET,
       "TcpFastRecover: received another duplicated ACK (%d) for TCB %p\n",
@@ -1254,6 +1268,13 @@ TcpInput (
     TCP_CLEAR_FLG (Tcb->CtrlFlag, TCP_CTRL_RTT_ON);
   }
 
+  //
+  // Update the SACK scoreboard before the fast recovery uses it.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK)) {
+    TcpProcessSackOption (Tcb, &Option, Seg->Ack);
+  }
+
   if (Seg->Ack == Tcb->SndNxt) {
 
     TcpClearTimer (Tcb, TCP_TIMER_REXMIT);
@@ -1549,6 +1570,14 @@ StepSix:
       goto RESET_THEN_DROP;
     }
 
+    //
+    // Remember the latest out-of-order segment, its
+    // block is reported first in the SACK option.
+    //
+    if (TCP_SEQ_GT (Seg->Seq, Tcb->RcvNxt)) {
+      Tcb->RcvSackSeq = Seg->Seq;
+    }
+
     if (TcpQueueData (Tcb, Nbuf) == 0) {
       DEBUG (
         (EFI_D_ERROR,
@@ -81,6 +81,7 @@ TcpInitTcbLocal (
   //
   Tcb->RcvWndScale  = 0;
   Tcb->RetxmitSeqMax = 0;
+  Tcb->SndSackCount  = 0;
 
   Tcb->ProbeTimerOn = FALSE;
 }
@@ -165,6 +166,11 @@ TcpInitTcbPeer (
     //
     Tcb->SndMss -= TCP_OPTION_TS_ALIGNED_LEN;
   }
+
+  if (TCP_FLG_ON (Opt->Flag, TCP_OPTION_RCVD_SACK_PERM) && !TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK)) {
+
+    TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_SND_SACK);
+  }
 }
 
 /**
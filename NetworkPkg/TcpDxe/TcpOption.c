@@ -159,6 +159,28 @@ TcpSynBuildOption (
     TcpPutUint32 (Data, TCP_OPTION_WS_FAST | TcpComputeScale (Tcb));
   }
 
+  //
+  // Build SACK permitted option, only when configured
+  // to use SACK, and either we are doing active open
+  // or we have received SACK permitted option from peer.
+  //
+  if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK) &&
+      (!TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_ACK) ||
+        TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK))
+      ) {
+
+    Data = NetbufAllocSpace (
+             Nbuf,
+             TCP_OPTION_SACK_PERM_ALIGNED_LEN,
+             NET_BUF_HEAD
+             );
+
+    ASSERT (Data != NULL);
+
+    Len += TCP_OPTION_SACK_PERM_ALIGNED_LEN;
+    TcpPutUint32 (Data, TCP_OPTION_SACK_PERM_FAST);
+  }
+
   //
   // Build the MSS option.
   //
@@ -171,6 +193,281 @@ TcpSynBuildOption (
   return Len;
 }
 
+/**
+  Get the next SACK block from the reassemble queue. The queue is
+  sorted and holds no overlapped segments, so the adjacent segments
+  are merged into one block.
+
+  @param[in]       Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in, out]  Entry   On input, the queue entry to start from. On output,
+                           the entry following the returned block.
+  @param[out]      Left    The left edge of the block.
+  @param[out]      Right   The right edge of the block.
+
+  @retval TRUE             A block is returned.
+  @retval FALSE            No more blocks in the queue.
+
+**/
+BOOLEAN
+TcpGetSackBlock (
+  IN     TCP_CB     *Tcb,
+  IN OUT LIST_ENTRY **Entry,
+     OUT TCP_SEQNO  *Left,
+     OUT TCP_SEQNO  *Right
+  )
+{
+  TCP_SEG  *Seg;
+
+  while (*Entry != &Tcb->RcvQue) {
+    Seg    = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (*Entry, NET_BUF, List));
+    *Entry = (*Entry)->ForwardLink;
+
+    if (TCP_SEQ_LEQ (Seg->End, Tcb->RcvNxt)) {
+      continue;
+    }
+
+    *Left  = Seg->Seq;
+    *Right = Seg->End;
+
+    while (*Entry != &Tcb->RcvQue) {
+      Seg = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (*Entry, NET_BUF, List));
+
+      if (TCP_SEQ_GT (Seg->Seq, *Right)) {
+        break;
+      }
+
+      if (TCP_SEQ_GT (Seg->End, *Right)) {
+        *Right = Seg->End;
+      }
+
+      *Entry = (*Entry)->ForwardLink;
+    }
+
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+  Build the SACK option to report the out-of-order segments
+  queued in the reassemble queue, per RFC2018.
+
+  The first block is the one holding the most recently received
+  segment, as RFC2018 requires. The other blocks follow in sequence
+  order, so the blocks nearest to RcvNxt, which are most useful to
+  the peer's retransmission, are repeated in every ACK.
+
+  @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]  Nbuf    Pointer to the buffer to store the options.
+  @param[in]  Room    The option space left in the segment.
+
+  @return             The total length of the SACK option.
+
+**/
+UINT16
+TcpBuildSackOption (
+  IN TCP_CB  *Tcb,
+  IN NET_BUF *Nbuf,
+  IN UINT16  Room
+  )
+{
+  TCP_SEQNO   Left[TCP_SACK_MAX_BLOCK];
+  TCP_SEQNO   Right[TCP_SACK_MAX_BLOCK];
+  TCP_SEQNO   BlockLeft;
+  TCP_SEQNO   BlockRight;
+  UINT32      MaxBlock;
+  UINT32      Count;
+  UINT32      Index;
+  LIST_ENTRY  *Entry;
+  UINT8       *Data;
+  UINT16      Len;
+
+  if (Room < TCP_OPTION_SACK_ALIGNED_LEN + TCP_OPTION_SACK_BLOCK_LEN) {
+    return 0;
+  }
+
+  MaxBlock = MIN ((Room - TCP_OPTION_SACK_ALIGNED_LEN) / TCP_OPTION_SACK_BLOCK_LEN, TCP_SACK_MAX_BLOCK);
+  Count    = 0;
+
+  Entry = Tcb->RcvQue.ForwardLink;
+  while (TcpGetSackBlock (Tcb, &Entry, &BlockLeft, &BlockRight)) {
+    if (TCP_SEQ_LEQ (BlockLeft, Tcb->RcvSackSeq) && TCP_SEQ_LT (Tcb->RcvSackSeq, BlockRight)) {
+      Left[0]  = BlockLeft;
+      Right[0] = BlockRight;
+      Count    = 1;
+      break;
+    }
+  }
+
+  Entry = Tcb->RcvQue.ForwardLink;
+  while ((Count < MaxBlock) && TcpGetSackBlock (Tcb, &Entry, &BlockLeft, &BlockRight)) {
+    if ((Count > 0) && (BlockLeft == Left[0])) {
+      continue;
+    }
+
+    Left[Count]  = BlockLeft;
+    Right[Count] = BlockRight;
+    Count++;
+  }
+
+  if (Count == 0) {
+    return 0;
+  }
+
+  Len  = (UINT16) (TCP_OPTION_SACK_ALIGNED_LEN + Count * TCP_OPTION_SACK_BLOCK_LEN);
+  Data = NetbufAllocSpace (Nbuf, Len, NET_BUF_HEAD);
+  ASSERT (Data != NULL);
+
+  TcpPutUint32 (Data, TCP_OPTION_SACK_FAST | (Len - 2));
+
+  for (Index = 0; Index < Count; Index++) {
+    TcpPutUint32 (Data + TCP_OPTION_SACK_ALIGNED_LEN + Index * TCP_OPTION_SACK_BLOCK_LEN, Left[Index]);
+    TcpPutUint32 (Data + TCP_OPTION_SACK_ALIGNED_LEN + Index * TCP_OPTION_SACK_BLOCK_LEN + 4, Right[Index]);
+  }
+
+  return Len;
+}
+
+/**
+  Merge the SACK blocks received from the peer into the scoreboard,
+  and drop the blocks that are cumulatively acknowledged.
+
+  The scoreboard is sorted and its blocks don't overlap. When it is
+  full, the highest block is dropped, since the holes below the lower
+  blocks are repaired first. SACK is advisory, losing a block only
+  causes the data in it to be retransmitted.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Option  Pointer to the options parsed from the segment.
+  @param[in]       Ack     The ACK field in the segment.
+
+**/
+VOID
+TcpProcessSackOption (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_OPTION *Option,
+  IN     TCP_SEQNO  Ack
+  )
+{
+  UINT32     Count;
+  UINT32     Index;
+  UINT32     Block;
+  TCP_SEQNO  Left;
+  TCP_SEQNO  Right;
+
+  //
+  // Drop the blocks which are acknowledged.
+  //
+  Count = 0;
+  for (Index = 0; Index < Tcb->SndSackCount; Index++) {
+    if (TCP_SEQ_LEQ (Tcb->SndSackRight[Index], Ack)) {
+      continue;
+    }
+
+    Tcb->SndSackLeft[Count]  = TCP_SEQ_LT (Tcb->SndSackLeft[Index], Ack) ? Ack : Tcb->SndSackLeft[Index];
+    Tcb->SndSackRight[Count] = Tcb->SndSackRight[Index];
+    Count++;
+  }
+
+  if (!TCP_FLG_ON (Option->Flag, TCP_OPTION_RCVD_SACK)) {
+    Tcb->SndSackCount = (UINT8) Count;
+    return;
+  }
+
+  for (Block = 0; Block < Option->SackCount; Block++) {
+    Left  = Option->SackLeft[Block];
+    Right = Option->SackRight[Block];
+
+    //
+    // Ignore the blocks that are empty, already acknowledged
+    // (D-SACK) or beyond the data sent.
+    //
+    if (!TCP_SEQ_LT (Left, Right) || !TCP_SEQ_GT (Left, Ack) || TCP_SEQ_GT (Right, Tcb->SndNxt)) {
+      continue;
+    }
+
+    //
+    // Absorb the blocks overlapping or adjacent to [Left, Right).
+    //
+    Index = 0;
+    while (Index < Count) {
+      if (TCP_SEQ_LT (Tcb->SndSackRight[Index], Left)) {
+        Index++;
+        continue;
+      }
+
+      if (TCP_SEQ_GT (Tcb->SndSackLeft[Index], Right)) {
+        break;
+      }
+
+      if (TCP_SEQ_LT (Tcb->SndSackLeft[Index], Left)) {
+        Left = Tcb->SndSackLeft[Index];
+      }
+
+      if (TCP_SEQ_GT (Tcb->SndSackRight[Index], Right)) {
+        Right = Tcb->SndSackRight[Index];
+      }
+
+      Count--;
+      CopyMem (&Tcb->SndSackLeft[Index], &Tcb->SndSackLeft[Index + 1], (Count - Index) * sizeof (TCP_SEQNO));
+      CopyMem (&Tcb->SndSackRight[Index], &Tcb->SndSackRight[Index + 1], (Count - Index) * sizeof (TCP_SEQNO));
+    }
+
+    if (Count == TCP_SACK_MAX_BLOCK) {
+      if (Index == Count) {
+        continue;
+      }
+
+      Count--;
+    }
+
+    CopyMem (&Tcb->SndSackLeft[Index + 1], &Tcb->SndSackLeft[Index], (Count - Index) * sizeof (TCP_SEQNO));
+    CopyMem (&Tcb->SndSackRight[Index + 1], &Tcb->SndSackRight[Index], (Count - Index) * sizeof (TCP_SEQNO));
+    Tcb->SndSackLeft[Index]  = Left;
+    Tcb->SndSackRight[Index] = Right;
+    Count++;
+  }
+
+  Tcb->SndSackCount = (UINT8) Count;
+}
+
+/**
+  Find the first hole at or above Seq that lies below a SACKed block.
+
+  @param[in]       Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in, out]  Seq     On input, the sequence to start from. On output,
+                           the start of the hole.
+  @param[out]      End     The end of the hole, which is the left edge of
+                           the next SACKed block.
+
+  @retval TRUE             A hole is found.
+  @retval FALSE            No SACKed data above Seq.
+
+**/
+BOOLEAN
+TcpGetSackHole (
+  IN     TCP_CB    *Tcb,
+  IN OUT TCP_SEQNO *Seq,
+     OUT TCP_SEQNO *End
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < Tcb->SndSackCount; Index++) {
+    if (TCP_SEQ_LT (*Seq, Tcb->SndSackLeft[Index])) {
+      *End = Tcb->SndSackLeft[Index];
+      return TRUE;
+    }
+
+    if (TCP_SEQ_LT (*Seq, Tcb->SndSackRight[Index])) {
+      *Seq = Tcb->SndSackRight[Index];
+    }
+  }
+
+  return FALSE;
+}
+
 /**
   Build the TCP option in synchronized states.
 
@@ -188,9 +485,11 @@ TcpBuildOption (
 {
   UINT8   *Data;
   UINT16  Len;
+  UINT32  DataLen;
 
   ASSERT ((Tcb != NULL) && (Nbuf != NULL) && (Nbuf->Tcp == NULL));
-  Len = 0;
+  Len     = 0;
+  DataLen = Nbuf->TotalSize;
 
   //
   // Build the Timestamp option.
@@ -213,6 +512,19 @@ TcpBuildOption (
     TcpPutUint32 (Data + 8, Tcb->TsRecent);
   }
 
+  //
+  // Build the SACK option in pure ACKs if there are
+  // out-of-order segments in the reassemble queue.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_SND_SACK) &&
+      !TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_RST) &&
+      (DataLen == 0) &&
+      !IsListEmpty (&Tcb->RcvQue)
+      ) {
+
+    Len = (UINT16) (Len + TcpBuildSackOption (Tcb, Nbuf, (UINT16) (TCP_OPTION_MAX_LEN - Len)));
+  }
+
   return Len;
 }
 
@@ -238,10 +550,12 @@ TcpParseOption (
   UINT8 Cur;
   UINT8 Type;
   UINT8 Len;
+  UINT8 Index;
 
   ASSERT ((Tcp != NULL) && (Option != NULL));
 
-  Option->Flag  = 0;
+  Option->Flag      = 0;
+  Option->SackCount = 0;
 
   TotalLen      = (UINT8) ((Tcp->HeadLen << 2) - sizeof (TCP_HEAD));
   if (TotalLen <= 0) {
@@ -313,6 +627,40 @@ TcpParseOption (
       Cur += TCP_OPTION_TS_LEN;
       break;
 
+    case TCP_OPTION_SACK_PERM:
+      Len = Head[Cur + 1];
+
+      if ((Len != TCP_OPTION_SACK_PERM_LEN) || (TotalLen - Cur < TCP_OPTION_SACK_PERM_LEN)) {
+
+        return -1;
+      }
+
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK_PERM);
+
+      Cur += TCP_OPTION_SACK_PERM_LEN;
+      break;
+
+    case TCP_OPTION_SACK:
+      Len = Head[Cur + 1];
+
+      if ((Len < 2 + TCP_OPTION_SACK_BLOCK_LEN) ||
+          ((Len - 2) % TCP_OPTION_SACK_BLOCK_LEN != 0) ||
+          (TotalLen - Cur < Len)) {
+
+        return -1;
+      }
+
+      for (Index = 0; (Index < (Len - 2) / TCP_OPTION_SACK_BLOCK_LEN) && (Option->SackCount < TCP_SACK_MAX_BLOCK); Index++) {
+        Option->SackLeft[Option->SackCount]  = TcpGetUint32 (&Head[Cur + 2 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+        Option->SackRight[Option->SackCount] = TcpGetUint32 (&Head[Cur + 6 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+        Option->SackCount++;
+      }
+
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK);
+
+      Cur = (UINT8) (Cur + Len);
+      break;
+
     case TCP_OPTION_NOP:
       Cur++;
       break;
@@ -17,12 +17,19 @@
 #define TCP_OPTION_NOP             1  ///< No-Option.
 #define TCP_OPTION_MSS             2  ///< Maximum Segment Size
 #define TCP_OPTION_WS              3  ///< Window scale
+#define TCP_OPTION_SACK_PERM       4  ///< SACK permitted
+#define TCP_OPTION_SACK            5  ///< SACK
 #define TCP_OPTION_TS              8  ///< Timestamp
 #define TCP_OPTION_MSS_LEN         4  ///< Length of MSS option
 #define TCP_OPTION_WS_LEN          3  ///< Length of window scale option
+#define TCP_OPTION_SACK_PERM_LEN   2  ///< Length of SACK permitted option
+#define TCP_OPTION_SACK_BLOCK_LEN  8  ///< Length of one SACK block
 #define TCP_OPTION_TS_LEN          10 ///< Length of timestamp option
 #define TCP_OPTION_WS_ALIGNED_LEN  4  ///< Length of window scale option, aligned
+#define TCP_OPTION_SACK_PERM_ALIGNED_LEN  4  ///< Length of SACK permitted option, aligned
+#define TCP_OPTION_SACK_ALIGNED_LEN       4  ///< Length of SACK option without blocks, aligned
 #define TCP_OPTION_TS_ALIGNED_LEN  12 ///< Length of timestamp option, aligned
+#define TCP_OPTION_MAX_LEN         40 ///< Max length of all the options in a segment
 
 //
 // recommend format of timestamp window scale
@@ -39,12 +46,23 @@
 
 #define TCP_OPTION_MSS_FAST  ((TCP_OPTION_MSS << 24) | (TCP_OPTION_MSS_LEN << 16))
 
+#define TCP_OPTION_SACK_PERM_FAST  ((TCP_OPTION_NOP << 24) | \
+                                    (TCP_OPTION_NOP << 16) | \
+                                    (TCP_OPTION_SACK_PERM << 8) | \
+                                    (TCP_OPTION_SACK_PERM_LEN))
+
+#define TCP_OPTION_SACK_FAST ((TCP_OPTION_NOP << 24) | \
+                              (TCP_OPTION_NOP << 16) | \
+                              (TCP_OPTION_SACK << 8))
+
 //
 // Other misc definitions
 //
 #define TCP_OPTION_RCVD_MSS        0x01
 #define TCP_OPTION_RCVD_WS         0x02
 #define TCP_OPTION_RCVD_TS         0x04
+#define TCP_OPTION_RCVD_SACK_PERM  0x08
+#define TCP_OPTION_RCVD_SACK       0x10
 #define TCP_OPTION_MAX_WS          14      ///< Maximum window scale value
 #define TCP_OPTION_MAX_WIN         0xffff  ///< Max window size in TCP header
 
@@ -58,6 +76,9 @@ typedef struct _TCP_OPTION {
   UINT16  Mss;      ///< The Mss received
   UINT32  TSVal;    ///< The TSVal field in a timestamp option
   UINT32  TSEcr;    ///< The TSEcr field in a timestamp option
+  UINT8   SackCount;                     ///< The number of SACK blocks received
+  UINT32  SackLeft[TCP_SACK_MAX_BLOCK];  ///< The left edges of the SACK blocks
+  UINT32  SackRight[TCP_SACK_MAX_BLOCK]; ///< The right edges of the SACK blocks
 } TCP_OPTION;
 
 /**
@@ -88,6 +109,60 @@ TcpSynBuildOption (
   IN NET_BUF *Nbuf
   );
 
+/**
+  Build the SACK option to report the out-of-order segments
+  queued in the reassemble queue, per RFC2018.
+
+  @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]  Nbuf    Pointer to the buffer to store the options.
+  @param[in]  Room    The option space left in the segment.
+
+  @return             The total length of the SACK option.
+
+**/
+UINT16
+TcpBuildSackOption (
+  IN TCP_CB  *Tcb,
+  IN NET_BUF *Nbuf,
+  IN UINT16  Room
+  );
+
+/**
+  Merge the SACK blocks received from the peer into the scoreboard,
+  and drop the blocks that are cumulatively acknowledged.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Option  Pointer to the options parsed from the segment.
+  @param[in]       Ack     The ACK field in the segment.
+
+**/
+VOID
+TcpProcessSackOption (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_OPTION *Option,
+  IN     TCP_SEQNO  Ack
+  );
+
+/**
+  Find the first hole at or above Seq that lies below a SACKed block.
+
+  @param[in]       Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in, out]  Seq     On input, the sequence to start from. On output,
+                           the start of the hole.
+  @param[out]      End     The end of the hole, which is the left edge of
+                           the next SACKed block.
+
+  @retval TRUE             A hole is found.
+  @retval FALSE            No SACKed data above Seq.
+
+**/
+BOOLEAN
+TcpGetSackHole (
+  IN     TCP_CB    *Tcb,
+  IN OUT TCP_SEQNO *Seq,
+     OUT TCP_SEQNO *End
+  );
+
 /**
   Build the TCP option in synchronized states.
 
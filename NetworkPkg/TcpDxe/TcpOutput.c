@@ -656,8 +656,11 @@ TcpRetransmit (
   IN TCP_SEQNO Seq
   )
 {
-  NET_BUF *Nbuf;
-  UINT32  Len;
+  NET_BUF   *Nbuf;
+  UINT32    Len;
+  TCP_SEQNO Hole;
+  TCP_SEQNO HoleEnd;
+  TCP_SEQNO End;
 
   //
   // Compute the maximum length of retransmission. It is
@@ -698,11 +701,21 @@ TcpRetransmit (
 
   Len = MIN (Len, Tcb->SndMss);
 
+  //
+  // Don't resend the data the peer has SACKed.
+  //
+  Hole = Seq;
+  if (TcpGetSackHole (Tcb, &Hole, &HoleEnd) && (Hole == Seq)) {
+    Len = MIN (Len, TCP_SUB_SEQ (HoleEnd, Seq));
+  }
+
   Nbuf = TcpGetSegmentSndQue (Tcb, Seq, Len);
   if (Nbuf == NULL) {
     return -1;
   }
 
+  End = TCPSEG_NETBUF (Nbuf)->End;
+
   if (TcpVerifySegment (Nbuf) == 0) {
     goto OnError;
   }
@@ -715,6 +728,10 @@ TcpRetransmit (
     Tcb->RetxmitSeqMax = Seq;
   }
 
+  if (TCP_SEQ_GT (End, Tcb->SndSackRexmit)) {
+    Tcb->SndSackRexmit = End;
+  }
+
   //
   // The retransmitted buffer may be on the SndQue,
   // trim TCP head because all the buffers on SndQue
@@ -72,6 +72,14 @@
 #define TCP_CTRL_TIMER_ON        0x1000 ///< At least one of the timer is on.
 #define TCP_CTRL_RTT_ON          0x2000 ///< The RTT measurement is on.
 #define TCP_CTRL_ACK_NOW         0x4000 ///< Send the ACK now, don't delay.
+#define TCP_CTRL_NO_SACK         0x8000 ///< Disable SACK option.
+#define TCP_CTRL_SND_SACK        0x10000 ///< Received SACK permitted in syn, send SACK to remote.
+
+//
+// Max number of SACK blocks in one segment, it is
+// also the size of the sender's SACK scoreboard.
+//
+#define TCP_SACK_MAX_BLOCK       4
 
 //
 // Timer related values
@@ -113,8 +121,10 @@
 //
 #define TCP_RCV_BUF_SIZE         (2 * 1024 * 1024)
 #define TCP_RCV_BUF_SIZE_MIN     (8 * 1024)
+#define TCP_RCV_BUF_SIZE_MAX     (32 * 1024 * 1024)
 #define TCP_SND_BUF_SIZE         (2 * 1024 * 1024)
 #define TCP_SND_BUF_SIZE_MIN     (8 * 1024)
+#define TCP_SND_BUF_SIZE_MAX     (32 * 1024 * 1024)
 #define TCP_BACKLOG              10
 #define TCP_BACKLOG_MIN          5
 #define TCP_MAX_LOSS_MIN         6
@@ -315,6 +325,15 @@ struct _TCP_CONTROL_BLOCK {
   //
   TCP_SEQNO         RetxmitSeqMax;       ///< Max Seq number in previous retransmission.
 
+  //
+  // RFC2018 selective acknowledgment.
+  //
+  TCP_SEQNO         RcvSackSeq;                        ///< Seq of the last out-of-order segment received.
+  UINT8             SndSackCount;                      ///< Number of blocks in the SACK scoreboard.
+  TCP_SEQNO         SndSackLeft[TCP_SACK_MAX_BLOCK];   ///< Left edges of the SACKed blocks, sorted.
+  TCP_SEQNO         SndSackRight[TCP_SACK_MAX_BLOCK];  ///< Right edges of the SACKed blocks.
+  TCP_SEQNO         SndSackRexmit;                     ///< Highest seq retransmitted in this recovery.
+
   //
   // configuration parameters, for EFI_TCP4_PROTOCOL specification
   //
@@ -220,6 +220,12 @@ TcpRexmitTimeout (
     return ;
   }
 
+  //
+  // The peer may renege on the SACKed data, forget the
+  // scoreboard as RFC2018 requires after a timeout.
+  //
+  Tcb->SndSackCount = 0;
+
   TcpBackoffRto (Tcb);
   TcpRetransmit (Tcb, Tcb->SndUna);
   TcpSetTimer (Tcb, TCP_TIMER_REXMIT, Tcb->Rto);
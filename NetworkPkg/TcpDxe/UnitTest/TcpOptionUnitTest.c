@@ -0,0 +1,665 @@
+/** @file
+  Host based unit tests of the TCP SACK option.
+
+  The real TcpOption.c and the net buffer library are linked together,
+  so the SACK option built by a receiver from its reassemble queue is
+  parsed and merged into a sender's scoreboard exactly as it is on the
+  wire, with the sequence numbers wrapping around zero.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+
+#include "TcpMain.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "TcpDxe SACK Option Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define SACK_TEST_WINDOW          2048
+#define SACK_TEST_ITERATIONS      20000
+
+UINT32             mTcpTick = 1000;
+EFI_BOOT_SERVICES  mTestBootServices;
+EFI_BOOT_SERVICES  *gBS = &mTestBootServices;
+
+//
+// Receiver and sender of the loopback, and the bytes the receiver
+// holds above RcvNxt.
+//
+TCP_CB  mRcvTcb;
+TCP_CB  mSndTcb;
+UINT8   mRcvMap[SACK_TEST_WINDOW];
+UINT32  mTestRandom = 1;
+
+/**
+  Stub of gBS->FreePool() that returns the buffer to the host heap,
+  the net buffer library frees its blocks through it.
+
+  @param[in]  Buffer  The buffer to free.
+
+  @retval EFI_SUCCESS  The buffer is freed.
+
+**/
+EFI_STATUS
+EFIAPI
+TestFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of NetListRemoveHead(), which the net buffer library links to.
+
+  @param[in, out]  Head  The list header.
+
+  @return The first node entry that is removed from the list, NULL if the list is empty.
+
+**/
+LIST_ENTRY *
+EFIAPI
+NetListRemoveHead (
+  IN OUT LIST_ENTRY  *Head
+  )
+{
+  LIST_ENTRY  *First;
+
+  if (IsListEmpty (Head)) {
+    return NULL;
+  }
+
+  First = Head->ForwardLink;
+  RemoveEntryList (First);
+  return First;
+}
+
+/**
+  Return a pseudo random number, the sequence is the same on every run.
+
+  @return The random number.
+
+**/
+UINT32
+TestRandom (
+  VOID
+  )
+{
+  mTestRandom = mTestRandom * 1103515245 + 12345;
+  return mTestRandom >> 8;
+}
+
+/**
+  Free the segments in the reassemble queue of the receiver.
+
+**/
+VOID
+FreeRcvQue (
+  VOID
+  )
+{
+  NET_BUF  *Nbuf;
+
+  while (!IsListEmpty (&mRcvTcb.RcvQue)) {
+    Nbuf = NET_LIST_HEAD (&mRcvTcb.RcvQue, NET_BUF, List);
+    RemoveEntryList (&Nbuf->List);
+    NetbufFree (Nbuf);
+  }
+}
+
+/**
+  Reset the receiver and the sender around a new base sequence.
+
+  @param[in]  Base  The RcvNxt of the receiver and SndUna of the sender.
+
+**/
+VOID
+ResetTcbs (
+  IN TCP_SEQNO  Base
+  )
+{
+  FreeRcvQue ();
+  ZeroMem (&mRcvTcb, sizeof (mRcvTcb));
+  ZeroMem (&mSndTcb, sizeof (mSndTcb));
+  ZeroMem (mRcvMap, sizeof (mRcvMap));
+
+  InitializeListHead (&mRcvTcb.RcvQue);
+  mRcvTcb.RcvNxt   = Base;
+  mRcvTcb.CtrlFlag = TCP_CTRL_SND_SACK | TCP_CTRL_SND_TS;
+
+  mSndTcb.SndUna   = Base;
+  mSndTcb.SndNxt   = Base + SACK_TEST_WINDOW;
+  mSndTcb.CtrlFlag = TCP_CTRL_SND_SACK | TCP_CTRL_SND_TS;
+}
+
+/**
+  Queue an out-of-order segment on the receiver, the segments must be
+  queued in sequence order and not overlap, as TcpQueueData() keeps them.
+
+  @param[in]  Offset  The offset of the segment above RcvNxt.
+  @param[in]  Len     The length of the segment.
+
+**/
+VOID
+QueueSegment (
+  IN UINT32  Offset,
+  IN UINT32  Len
+  )
+{
+  NET_BUF  *Nbuf;
+
+  Nbuf = NetbufAlloc (Len);
+  ASSERT (Nbuf != NULL);
+  NetbufAllocSpace (Nbuf, Len, NET_BUF_TAIL);
+
+  TCPSEG_NETBUF (Nbuf)->Seq = mRcvTcb.RcvNxt + Offset;
+  TCPSEG_NETBUF (Nbuf)->End = mRcvTcb.RcvNxt + Offset + Len;
+  InsertTailList (&mRcvTcb.RcvQue, &Nbuf->List);
+
+  SetMem (&mRcvMap[Offset], Len, 1);
+}
+
+/**
+  Build a segment of the receiver with TcpBuildOption(), and parse its
+  options back with TcpParseOption().
+
+  @param[in]   DataLen  The payload length of the segment.
+  @param[out]  Option   The options parsed from the segment.
+
+  @return The length of the options built.
+
+**/
+UINT16
+LoopbackOption (
+  IN  UINT32      DataLen,
+  OUT TCP_OPTION  *Option
+  )
+{
+  NET_BUF   *Nbuf;
+  TCP_HEAD  *Head;
+  UINT16    Len;
+  INTN      Result;
+
+  Nbuf = NetbufAlloc (TCP_MAX_HEAD + DataLen);
+  ASSERT (Nbuf != NULL);
+  NetbufReserve (Nbuf, TCP_MAX_HEAD);
+  if (DataLen != 0) {
+    NetbufAllocSpace (Nbuf, DataLen, NET_BUF_TAIL);
+  }
+
+  TCPSEG_NETBUF (Nbuf)->Flag = TCP_FLG_ACK;
+
+  Len  = TcpBuildOption (&mRcvTcb, Nbuf);
+  Head = (TCP_HEAD *) NetbufAllocSpace (Nbuf, sizeof (TCP_HEAD), NET_BUF_HEAD);
+  ASSERT (Head != NULL);
+  ZeroMem (Head, sizeof (TCP_HEAD));
+  Head->HeadLen = (UINT8) ((sizeof (TCP_HEAD) + Len) >> 2);
+
+  Result = TcpParseOption (Head, Option);
+  ASSERT (Result == 0);
+
+  NetbufFree (Nbuf);
+  return Len;
+}
+
+/**
+  Check whether [Left, Right) is a maximal run of bytes held by the receiver.
+
+  @param[in]  Left   The left edge of the block.
+  @param[in]  Right  The right edge of the block.
+
+  @retval TRUE   The block is a run.
+  @retval FALSE  The block is not a run.
+
+**/
+BOOLEAN
+IsRcvRun (
+  IN TCP_SEQNO  Left,
+  IN TCP_SEQNO  Right
+  )
+{
+  UINT32  Start;
+  UINT32  End;
+  UINT32  Index;
+
+  Start = TCP_SUB_SEQ (Left, mRcvTcb.RcvNxt);
+  End   = TCP_SUB_SEQ (Right, mRcvTcb.RcvNxt);
+  if ((Start == 0) || (Start >= End) || (End > SACK_TEST_WINDOW)) {
+    return FALSE;
+  }
+
+  for (Index = Start; Index < End; Index++) {
+    if (mRcvMap[Index] == 0) {
+      return FALSE;
+    }
+  }
+
+  return (BOOLEAN) ((mRcvMap[Start - 1] == 0) && ((End == SACK_TEST_WINDOW) || (mRcvMap[End] == 0)));
+}
+
+/**
+  Random out-of-order queues are reported by the receiver and merged by
+  the sender. Every block is a run of the queue, the run holding the last
+  segment comes first, and the holes the sender finds are all missing.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SackLoopbackShouldReportTheQueue (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TCP_OPTION  Option;
+  UINT32      Iteration;
+  UINT32      Offset;
+  UINT32      Len;
+  UINT32      Runs;
+  UINT32      Index;
+  UINT32      Block;
+  UINT32      Last;
+  UINT32      MaxBlock;
+  UINT32      Count;
+  TCP_SEQNO   Seq;
+  TCP_SEQNO   HoleEnd;
+  TCP_SEQNO   Lowest[SACK_TEST_WINDOW];
+
+  for (Iteration = 0; Iteration < SACK_TEST_ITERATIONS; Iteration++) {
+    ResetTcbs ((TCP_SEQNO) (0xFFFFF800 + (TestRandom () % 4096)));
+
+    if ((Iteration & 1) != 0) {
+      mRcvTcb.CtrlFlag &= ~TCP_CTRL_SND_TS;
+    }
+
+    //
+    // Queue segments of 1 to 200 bytes with random gaps, some of them
+    // adjacent, and pick one of them as the last received.
+    //
+    Offset = 1 + TestRandom () % 64;
+    Last   = 0;
+    Index  = 0;
+    while (Offset < SACK_TEST_WINDOW) {
+      Len = 1 + TestRandom () % 200;
+      Len = MIN (Len, SACK_TEST_WINDOW - Offset);
+      QueueSegment (Offset, Len);
+      if ((Index == 0) || (TestRandom () % (Index + 1) == 0)) {
+        Last = Offset + TestRandom () % Len;
+      }
+
+      Index++;
+      Offset += Len + ((TestRandom () % 3 == 0) ? 0 : 1 + TestRandom () % 300);
+    }
+
+    mRcvTcb.RcvSackSeq = mRcvTcb.RcvNxt + Last;
+
+    //
+    // The runs in sequence order.
+    //
+    Runs = 0;
+    for (Index = 1; Index < SACK_TEST_WINDOW; Index++) {
+      if ((mRcvMap[Index] != 0) && (mRcvMap[Index - 1] == 0)) {
+        Lowest[Runs++] = mRcvTcb.RcvNxt + Index;
+      }
+    }
+
+    Len      = LoopbackOption (0, &Option);
+    MaxBlock = TCP_FLG_ON (mRcvTcb.CtrlFlag, TCP_CTRL_SND_TS) ? 3 : 4;
+
+    UT_ASSERT_TRUE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_SACK));
+    UT_ASSERT_EQUAL (Option.SackCount, MIN (Runs, MaxBlock));
+    UT_ASSERT_TRUE (Len <= TCP_OPTION_MAX_LEN);
+
+    for (Block = 0; Block < Option.SackCount; Block++) {
+      UT_ASSERT_TRUE (IsRcvRun (Option.SackLeft[Block], Option.SackRight[Block]));
+    }
+
+    //
+    // RFC2018: the first block holds the most recent segment,
+    // the others are the lowest runs in sequence order.
+    //
+    UT_ASSERT_TRUE (TCP_SEQ_LEQ (Option.SackLeft[0], mRcvTcb.RcvSackSeq));
+    UT_ASSERT_TRUE (TCP_SEQ_LT (mRcvTcb.RcvSackSeq, Option.SackRight[0]));
+
+    Index = 0;
+    for (Block = 1; Block < Option.SackCount; Block++) {
+      if (Lowest[Index] == Option.SackLeft[0]) {
+        Index++;
+      }
+
+      UT_ASSERT_EQUAL (Option.SackLeft[Block], Lowest[Index]);
+      Index++;
+    }
+
+    //
+    // The sender's scoreboard holds the reported blocks, sorted.
+    //
+    TcpProcessSackOption (&mSndTcb, &Option, mRcvTcb.RcvNxt);
+    UT_ASSERT_EQUAL (mSndTcb.SndSackCount, Option.SackCount);
+
+    for (Index = 0; Index < mSndTcb.SndSackCount; Index++) {
+      UT_ASSERT_TRUE (IsRcvRun (mSndTcb.SndSackLeft[Index], mSndTcb.SndSackRight[Index]));
+      if (Index > 0) {
+        UT_ASSERT_TRUE (TCP_SEQ_LT (mSndTcb.SndSackRight[Index - 1], mSndTcb.SndSackLeft[Index]));
+      }
+    }
+
+    //
+    // The first hole is the data missing at RcvNxt. The others may hold
+    // runs the receiver had no room to report, unless all were reported.
+    //
+    Seq   = mSndTcb.SndUna;
+    Block = 0;
+    while (TcpGetSackHole (&mSndTcb, &Seq, &HoleEnd)) {
+      if (Block == 0) {
+        UT_ASSERT_EQUAL (Seq, mRcvTcb.RcvNxt);
+        UT_ASSERT_EQUAL (HoleEnd, Lowest[0]);
+      }
+
+      UT_ASSERT_TRUE (TCP_SEQ_LT (Seq, HoleEnd));
+      for (Offset = TCP_SUB_SEQ (Seq, mRcvTcb.RcvNxt); (Option.SackCount == Runs) && (Offset < TCP_SUB_SEQ (HoleEnd, mRcvTcb.RcvNxt)); Offset++) {
+        UT_ASSERT_EQUAL (mRcvMap[Offset], 0);
+      }
+
+      Seq = HoleEnd;
+      Block++;
+    }
+
+    UT_ASSERT_EQUAL (Block, mSndTcb.SndSackCount);
+
+    //
+    // A cumulative ACK past the first block drops it.
+    //
+    if (mSndTcb.SndSackCount > 0) {
+      Option.Flag = 0;
+      Count = mSndTcb.SndSackCount;
+      TcpProcessSackOption (&mSndTcb, &Option, mSndTcb.SndSackRight[0]);
+      UT_ASSERT_EQUAL (mSndTcb.SndSackCount, Count - 1);
+    }
+  }
+
+  FreeRcvQue ();
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The SACK option is only sent in pure ACKs, so it never pushes a full
+  sized data segment over the MSS. The payload size is taken before the
+  timestamp option is added.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SackShouldOnlyBeSentInPureAcks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TCP_OPTION  Option;
+
+  ResetTcbs (0xFFFFFFF0);
+  QueueSegment (100, 50);
+  QueueSegment (200, 50);
+  mRcvTcb.RcvSackSeq = mRcvTcb.RcvNxt + 200;
+
+  UT_ASSERT_EQUAL (LoopbackOption (0, &Option), TCP_OPTION_TS_ALIGNED_LEN + TCP_OPTION_SACK_ALIGNED_LEN + 2 * TCP_OPTION_SACK_BLOCK_LEN);
+  UT_ASSERT_EQUAL (Option.SackCount, 2);
+  UT_ASSERT_EQUAL (Option.SackLeft[0], mRcvTcb.RcvNxt + 200);
+  UT_ASSERT_EQUAL (Option.SackLeft[1], mRcvTcb.RcvNxt + 100);
+
+  UT_ASSERT_EQUAL (LoopbackOption (1, &Option), TCP_OPTION_TS_ALIGNED_LEN);
+  UT_ASSERT_FALSE (TCP_FLG_ON (Option.Flag, TCP_OPTION_RCVD_SACK));
+
+  mRcvTcb.CtrlFlag &= ~TCP_CTRL_SND_SACK;
+  UT_ASSERT_EQUAL (LoopbackOption (0, &Option), TCP_OPTION_TS_ALIGNED_LEN);
+
+  FreeRcvQue ();
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Build a segment with a single raw option and parse it.
+
+  @param[in]  Raw     The option bytes.
+  @param[in]  RawLen  The length of the option bytes, a multiple of 4.
+  @param[out] Option  The options parsed.
+
+  @return The result of TcpParseOption().
+
+**/
+INTN
+ParseRawOption (
+  IN  UINT8       *Raw,
+  IN  UINT32      RawLen,
+  OUT TCP_OPTION  *Option
+  )
+{
+  UINT8  Buffer[sizeof (TCP_HEAD) + TCP_OPTION_MAX_LEN];
+
+  ZeroMem (Buffer, sizeof (Buffer));
+  CopyMem (Buffer + sizeof (TCP_HEAD), Raw, RawLen);
+  ((TCP_HEAD *) Buffer)->HeadLen = (UINT8) ((sizeof (TCP_HEAD) + RawLen) >> 2);
+
+  return TcpParseOption ((TCP_HEAD *) Buffer, Option);
+}
+
+/**
+  SACK options with a bad length are rejected, and the blocks that are
+  already acknowledged, empty or beyond SndNxt are not merged.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BadSackBlocksShouldBeIgnored (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TCP_OPTION  Option;
+  UINT8       Raw[TCP_OPTION_MAX_LEN];
+
+  ZeroMem (Raw, sizeof (Raw));
+  Raw[0] = TCP_OPTION_NOP;
+  Raw[1] = TCP_OPTION_NOP;
+  Raw[2] = TCP_OPTION_SACK;
+
+  Raw[3] = 2;
+  UT_ASSERT_EQUAL (ParseRawOption (Raw, 4, &Option), -1);
+  Raw[3] = 2 + TCP_OPTION_SACK_BLOCK_LEN + 1;
+  UT_ASSERT_EQUAL (ParseRawOption (Raw, 20, &Option), -1);
+  Raw[3] = 2 + 2 * TCP_OPTION_SACK_BLOCK_LEN;
+  UT_ASSERT_EQUAL (ParseRawOption (Raw, 12, &Option), -1);
+  Raw[3] = 2 + TCP_OPTION_SACK_BLOCK_LEN;
+  UT_ASSERT_EQUAL (ParseRawOption (Raw, 12, &Option), 0);
+  UT_ASSERT_EQUAL (Option.SackCount, 1);
+
+  ResetTcbs (0xFFFFFF00);
+  Option.Flag         = TCP_OPTION_RCVD_SACK;
+  Option.SackCount    = 4;
+  Option.SackLeft[0]  = mSndTcb.SndUna - 100;
+  Option.SackRight[0] = mSndTcb.SndUna + 100;
+  Option.SackLeft[1]  = mSndTcb.SndUna + 200;
+  Option.SackRight[1] = mSndTcb.SndUna + 200;
+  Option.SackLeft[2]  = mSndTcb.SndNxt - 10;
+  Option.SackRight[2] = mSndTcb.SndNxt + 10;
+  Option.SackLeft[3]  = mSndTcb.SndUna + 300;
+  Option.SackRight[3] = mSndTcb.SndNxt;
+
+  TcpProcessSackOption (&mSndTcb, &Option, mSndTcb.SndUna);
+  UT_ASSERT_EQUAL (mSndTcb.SndSackCount, 1);
+  UT_ASSERT_EQUAL (mSndTcb.SndSackLeft[0], mSndTcb.SndUna + 300);
+  UT_ASSERT_EQUAL (mSndTcb.SndSackRight[0], mSndTcb.SndNxt);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Random blocks reported over several ACKs are merged into a sorted
+  scoreboard of disjoint blocks. It holds only SACKed bytes, and all of
+  them while they fit in the scoreboard.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ScoreboardShouldMergeBlocks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TCP_OPTION  Option;
+  UINT32      Iteration;
+  UINT32      Ack;
+  UINT32      Index;
+  UINT32      Block;
+  UINT32      Offset;
+  UINT32      Start;
+  UINT32      End;
+  UINT32      Runs;
+  UINT32      Covered;
+  BOOLEAN     Overflow;
+  UINT8       Sacked[SACK_TEST_WINDOW];
+
+  for (Iteration = 0; Iteration < SACK_TEST_ITERATIONS; Iteration++) {
+    ResetTcbs ((TCP_SEQNO) (0xFFFFF800 + (TestRandom () % 4096)));
+    ZeroMem (Sacked, sizeof (Sacked));
+    Overflow = FALSE;
+
+    for (Ack = 0; Ack < 8; Ack++) {
+      Option.Flag      = TCP_OPTION_RCVD_SACK;
+      Option.SackCount = (UINT8) (1 + TestRandom () % TCP_SACK_MAX_BLOCK);
+      for (Block = 0; Block < Option.SackCount; Block++) {
+        Start = 1 + TestRandom () % (SACK_TEST_WINDOW / 4);
+        End   = Start + 1 + TestRandom () % 64;
+        Option.SackLeft[Block]  = mSndTcb.SndUna + Start;
+        Option.SackRight[Block] = mSndTcb.SndUna + End;
+        SetMem (&Sacked[Start], End - Start, 1);
+
+        //
+        // Once the SACKed bytes don't fit the scoreboard, a block is
+        // dropped and is not known again until it is reported again.
+        //
+        Runs = 0;
+        for (Index = 1; Index < SACK_TEST_WINDOW; Index++) {
+          if ((Sacked[Index] != 0) && (Sacked[Index - 1] == 0)) {
+            Runs++;
+          }
+        }
+
+        if (Runs > TCP_SACK_MAX_BLOCK) {
+          Overflow = TRUE;
+        }
+      }
+
+      TcpProcessSackOption (&mSndTcb, &Option, mSndTcb.SndUna);
+
+      Covered = 0;
+      for (Index = 0; Index < mSndTcb.SndSackCount; Index++) {
+        Start = TCP_SUB_SEQ (mSndTcb.SndSackLeft[Index], mSndTcb.SndUna);
+        End   = TCP_SUB_SEQ (mSndTcb.SndSackRight[Index], mSndTcb.SndUna);
+        UT_ASSERT_TRUE (Start < End);
+        UT_ASSERT_TRUE (End <= SACK_TEST_WINDOW);
+        if (Index > 0) {
+          UT_ASSERT_TRUE (TCP_SEQ_LT (mSndTcb.SndSackRight[Index - 1], mSndTcb.SndSackLeft[Index]));
+        }
+
+        for (Offset = Start; Offset < End; Offset++) {
+          UT_ASSERT_EQUAL (Sacked[Offset], 1);
+        }
+
+        Covered += End - Start;
+      }
+
+      if (!Overflow) {
+        UT_ASSERT_EQUAL (mSndTcb.SndSackCount, Runs);
+        for (Index = 0, Offset = 0; Index < SACK_TEST_WINDOW; Index++) {
+          Offset += Sacked[Index];
+        }
+
+        UT_ASSERT_EQUAL (Covered, Offset);
+      }
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  TCP SACK option and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      SackTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  InitializeListHead (&mRcvTcb.RcvQue);
+  mTestBootServices.FreePool = TestFreePool;
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&SackTests, Framework, "TcpDxe SACK Option Tests", "TcpDxe.Sack", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for SackTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (SackTests, "SACK blocks should loop back to the sender's scoreboard", "Loopback", SackLoopbackShouldReportTheQueue, NULL, NULL, NULL);
+  AddTestCase (SackTests, "SACK should only be sent in pure ACKs", "PureAck", SackShouldOnlyBeSentInPureAcks, NULL, NULL, NULL);
+  AddTestCase (SackTests, "Bad SACK blocks should be ignored", "BadBlock", BadSackBlocksShouldBeIgnored, NULL, NULL, NULL);
+  AddTestCase (SackTests, "The scoreboard should merge blocks", "Merge", ScoreboardShouldMergeBlocks, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
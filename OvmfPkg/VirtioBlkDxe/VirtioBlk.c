@@ -6,9 +6,11 @@
 
   - No attach/detach (ie. removable media).
 
-  - Although the non-blocking interfaces of EFI_BLOCK_IO2_PROTOCOL could be a
-    good match for multiple in-flight virtio-blk requests, we stick to
-    synchronous requests and EFI_BLOCK_IO_PROTOCOL for now.
+  - EFI_BLOCK_IO2_PROTOCOL is implemented by keeping multiple virtio-blk
+    requests in flight. The descriptor table is partitioned into chains of
+    three descriptors; large transfers are split into several chains, and the
+    used ring is polled from a timer. The blocking interfaces use the same
+    chains and poll until their own request completes.
 
   Copyright (C) 2012, Red Hat, Inc.
   Copyright (c) 2012 - 2018, Intel Corporation. All rights reserved.<BR>
@@ -178,15 +180,451 @@ VerifyReadWriteRequest (
 
 /**
 
-  Format a read / write / flush request as three consecutive virtio
-  descriptors, push them to the host, and poll for the response.
+  Complete a request whose chains have all been processed by the host. The
+  token of a non-blocking request is signaled and the request is freed; a
+  blocking request is only marked as done, for its waiter.
 
-  This is the main workhorse function. Two use cases are supported, read/write
-  and flush. The function may only be called after the request parameters have
-  been verified by
+  The caller is responsible for running at TPL_NOTIFY.
+
+  @param[in out] Dev  The virtio-blk device the request was submitted to.
+
+  @param[in out] Io   The request to complete.
+
+**/
+
+STATIC
+VOID
+VirtioBlkCompleteIo (
+  IN OUT VBLK_DEV *Dev,
+  IN OUT VBLK_IO  *Io
+  )
+{
+  ASSERT (Io->InFlight == 0);
+  ASSERT (Io->Remaining == 0 && !Io->Flush);
+
+  RemoveEntryList (&Io->Link);
+  if (Io->Token != NULL) {
+    Io->Token->TransactionStatus = Io->Status;
+    gBS->SignalEvent (Io->Token->Event);
+    FreePool (Io);
+  } else {
+    Io->Done = TRUE;
+  }
+}
+
+
+/**
+
+  Format the next part of a read / write request, or a flush request, as a
+  chain of consecutive virtio descriptors, and append the chain to the
+  available ring. The device is not notified.
+
+  The caller is responsible for running at TPL_NOTIFY, and for ensuring that
+  a free chain exists.
+
+  @param[in out] Dev           The virtio-blk device the request is targeted
+                               at.
+
+  @param[in out] Io            The request to take the next part from. On
+                               success, the part is accounted for as in-flight.
+
+  @param[in out] NextAvailIdx  The available ring index the chain is published
+                               at. Incremented on success.
+
+  @retval EFI_SUCCESS       The chain was appended to the available ring.
+
+  @retval EFI_DEVICE_ERROR  Failed to map the data buffer for a bus master
+                            operation.
+
+**/
+
+STATIC
+EFI_STATUS
+VirtioBlkSubmitChain (
+  IN OUT VBLK_DEV *Dev,
+  IN OUT VBLK_IO  *Io,
+  IN OUT UINT16   *NextAvailIdx
+  )
+{
+  UINT32               BlockSize;
+  UINTN                ChainSize;
+  UINT16               ChainIdx;
+  VBLK_SHARED_REQ      *SharedReq;
+  EFI_PHYSICAL_ADDRESS SharedReqAddress;
+  EFI_PHYSICAL_ADDRESS BufferDeviceAddress;
+  VOID                 *BufferMapping;
+  DESC_INDICES         Indices;
+  EFI_STATUS           Status;
+
+  ASSERT (Dev->FreeChainCount > 0);
+
+  BlockSize = Dev->BlockIoMedia.BlockSize;
+
+  //
+  // Zero size for flush, otherwise the next part of the transfer, in whole
+  // blocks.
+  //
+  ChainSize = 0;
+  if (!Io->Flush) {
+    ChainSize = MIN (Io->Remaining,
+                  VBLK_MAX_CHAIN_SIZE - VBLK_MAX_CHAIN_SIZE % BlockSize);
+  }
+
+  BufferMapping       = NULL;
+  BufferDeviceAddress = 0;
+  if (ChainSize > 0) {
+    Status = VirtioMapAllBytesInSharedBuffer (
+               Dev->VirtIo,
+               (Io->RequestIsWrite ?
+                VirtioOperationBusMasterRead :
+                VirtioOperationBusMasterWrite),
+               Io->Buffer,
+               ChainSize,
+               &BufferDeviceAddress,
+               &BufferMapping
+               );
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+  }
+
+  ChainIdx = Dev->FreeChainStack[--Dev->FreeChainCount];
+  Dev->Chains[ChainIdx].Io            = Io;
+  Dev->Chains[ChainIdx].BufferMapping = BufferMapping;
+
+  //
+  // Prepare virtio-blk request header, setting zero size for flush.
+  // IO Priority is homogeneously 0. Preset a host status for ourselves that
+  // we do not accept as success.
+  //
+  SharedReq        = &Dev->SharedReq[ChainIdx];
+  SharedReqAddress = Dev->SharedReqAddress +
+                     ChainIdx * sizeof (VBLK_SHARED_REQ);
+  SharedReq->Request.Type   = Io->RequestIsWrite ?
+                              (Io->Flush ? VIRTIO_BLK_T_FLUSH :
+                               VIRTIO_BLK_T_OUT) :
+                              VIRTIO_BLK_T_IN;
+  SharedReq->Request.IoPrio = 0;
+  SharedReq->Request.Sector = MultU64x32 (Io->Lba, BlockSize / 512);
+  SharedReq->HostStatus     = VIRTIO_BLK_S_IOERR;
+
+  Indices.HeadDescIdx = (UINT16) (ChainIdx * VBLK_DESC_PER_CHAIN);
+  Indices.NextDescIdx = Indices.HeadDescIdx;
+
+  //
+  // virtio-blk header in first desc
+  //
+  VirtioAppendDesc (
+    &Dev->Ring,
+    SharedReqAddress + OFFSET_OF (VBLK_SHARED_REQ, Request),
+    sizeof (VIRTIO_BLK_REQ),
+    VRING_DESC_F_NEXT,
+    &Indices
+    );
+
+  //
+  // data buffer for read/write in second desc. VRING_DESC_F_WRITE is
+  // interpreted from the host's point of view.
+  //
+  if (ChainSize > 0) {
+    VirtioAppendDesc (
+      &Dev->Ring,
+      BufferDeviceAddress,
+      (UINT32) ChainSize,
+      VRING_DESC_F_NEXT | (Io->RequestIsWrite ? 0 : VRING_DESC_F_WRITE),
+      &Indices
+      );
+  }
+
+  //
+  // host status in last (second or third) desc
+  //
+  VirtioAppendDesc (
+    &Dev->Ring,
+    SharedReqAddress + OFFSET_OF (VBLK_SHARED_REQ, HostStatus),
+    sizeof (UINT8),
+    VRING_DESC_F_WRITE,
+    &Indices
+    );
+
+  //
+  // virtio-0.9.5, 2.4.1.2 Updating the Available Ring; each entry references
+  // the head descriptor of a chain.
+  //
+  Dev->Ring.Avail.Ring[(*NextAvailIdx)++ % Dev->Ring.QueueSize] =
+    Indices.HeadDescIdx;
+
+  Io->Flush      = FALSE;
+  Io->Lba       += ChainSize / BlockSize;
+  Io->Buffer    += ChainSize;
+  Io->Remaining -= ChainSize;
+  Io->InFlight++;
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Submit as many parts of the queued requests as there are free chains, in
+  queueing order, and notify the device once.
+
+  A request that cannot be submitted fails with EFI_DEVICE_ERROR; its parts
+  already in flight are still waited for.
+
+  The caller is responsible for running at TPL_NOTIFY.
+
+  @param[in out] Dev  The virtio-blk device to submit the requests to.
+
+**/
+
+STATIC
+VOID
+VirtioBlkSubmitPending (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  LIST_ENTRY *Link;
+  LIST_ENTRY *NextLink;
+  VBLK_IO    *Io;
+  UINT16     NextAvailIdx;
+  EFI_STATUS Status;
+
+  NextAvailIdx = *Dev->Ring.Avail.Idx;
+  for (Link = GetFirstNode (&Dev->IoList);
+       Link != &Dev->IoList && Dev->FreeChainCount > 0;
+       Link = NextLink) {
+    NextLink = Link->ForwardLink;
+    Io       = BASE_CR (Link, VBLK_IO, Link);
+
+    while ((Io->Remaining > 0 || Io->Flush) && Dev->FreeChainCount > 0) {
+      Status = VirtioBlkSubmitChain (Dev, Io, &NextAvailIdx);
+      if (EFI_ERROR (Status)) {
+        Io->Status    = Status;
+        Io->Remaining = 0;
+        Io->Flush     = FALSE;
+        if (Io->InFlight == 0) {
+          VirtioBlkCompleteIo (Dev, Io);
+        }
+        break;
+      }
+    }
+  }
+
+  if (NextAvailIdx == *Dev->Ring.Avail.Idx) {
+    return;
+  }
+
+  //
+  // virtio-0.9.5, 2.4.1.3 Updating the Index Field
+  //
+  MemoryFence ();
+  *Dev->Ring.Avail.Idx = NextAvailIdx;
+
+  //
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device -- gratuitous notifications are
+  // OK. virtio-blk's only virtqueue is #0, called "requestq" (see Appendix D).
+  //
+  MemoryFence ();
+  Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, 0);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: SetQueueNotify(): %r\n", __FUNCTION__, Status));
+  }
+}
+
+
+/**
+
+  Process the chains the host has returned on the used ring, complete the
+  requests whose chains have all been processed, and submit further queued
+  parts in the freed chains.
+
+  The caller is responsible for running at TPL_NOTIFY.
+
+  @param[in out] Dev  The virtio-blk device to poll.
+
+**/
+
+STATIC
+VOID
+VirtioBlkReapChains (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  UINT16                         UsedIdx;
+  UINT32                         DescIdx;
+  UINT16                         ChainIdx;
+  VBLK_CHAIN                     *Chain;
+  VBLK_IO                        *Io;
+  volatile CONST VRING_USED_ELEM *UsedElem;
+  EFI_STATUS                     UnmapStatus;
+
+  MemoryFence ();
+  UsedIdx = *Dev->Ring.Used.Idx;
+  MemoryFence ();
+
+  while (Dev->LastUsedIdx != UsedIdx) {
+    UsedElem = &Dev->Ring.Used.UsedElem[Dev->LastUsedIdx++ %
+                                        Dev->Ring.QueueSize];
+    DescIdx  = UsedElem->Id;
+    ChainIdx = (UINT16) (DescIdx / VBLK_DESC_PER_CHAIN);
+    if (DescIdx % VBLK_DESC_PER_CHAIN != 0 || ChainIdx >= Dev->ChainCount ||
+        Dev->Chains[ChainIdx].Io == NULL) {
+      DEBUG ((DEBUG_ERROR, "%a: invalid used descriptor %u\n", __FUNCTION__,
+        DescIdx));
+      continue;
+    }
+
+    Chain = &Dev->Chains[ChainIdx];
+    Io    = Chain->Io;
+    if (*(volatile UINT8 *) &Dev->SharedReq[ChainIdx].HostStatus !=
+        VIRTIO_BLK_S_OK) {
+      Io->Status = EFI_DEVICE_ERROR;
+    }
+
+    if (Chain->BufferMapping != NULL) {
+      UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo,
+                                   Chain->BufferMapping);
+      if (EFI_ERROR (UnmapStatus) && !Io->RequestIsWrite) {
+        //
+        // Data from the bus master may not reach the caller; fail the
+        // request.
+        //
+        Io->Status = EFI_DEVICE_ERROR;
+      }
+    }
+
+    Chain->Io            = NULL;
+    Chain->BufferMapping = NULL;
+    Dev->FreeChainStack[Dev->FreeChainCount++] = ChainIdx;
+
+    Io->InFlight--;
+    if (Io->InFlight == 0 && Io->Remaining == 0 && !Io->Flush) {
+      VirtioBlkCompleteIo (Dev, Io);
+    }
+  }
+
+  VirtioBlkSubmitPending (Dev);
+}
+
+
+/**
+
+  Timer notification function polling the used ring for the completion of
+  non-blocking requests.
+
+  @param[in] Event    Event whose notification function is being invoked.
+
+  @param[in] Context  Pointer to the VBLK_DEV structure.
+
+**/
+
+STATIC
+VOID
+EFIAPI
+VirtioBlkAsyncPoll (
+  IN  EFI_EVENT Event,
+  IN  VOID      *Context
+  )
+{
+  VBLK_DEV *Dev;
+
+  Dev = Context;
+  if (!IsListEmpty (&Dev->IoList)) {
+    VirtioBlkReapChains (Dev);
+  }
+}
+
+
+/**
+
+  Queue a request for submission to the host.
+
+  @param[in out] Dev  The virtio-blk device the request is targeted at.
+
+  @param[in out] Io   The request to queue. Its Token, Lba, Buffer, Remaining,
+                      RequestIsWrite and Flush fields must be set up.
+
+**/
+
+STATIC
+VOID
+VirtioBlkQueueIo (
+  IN OUT VBLK_DEV *Dev,
+  IN OUT VBLK_IO  *Io
+  )
+{
+  EFI_TPL OldTpl;
+
+  Io->InFlight = 0;
+  Io->Done     = FALSE;
+  Io->Status   = EFI_SUCCESS;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  InsertTailList (&Dev->IoList, &Io->Link);
+  VirtioBlkSubmitPending (Dev);
+  gBS->RestoreTPL (OldTpl);
+}
+
+
+/**
+
+  Poll the used ring until the specified blocking request completes, or, if
+  no request is specified, until all queued requests complete.
+
+  Keep slowing down until we reach a poll period of slightly above 1 ms.
+
+  @param[in out] Dev  The virtio-blk device to poll.
+
+  @param[in]     Io   The blocking request to wait for, or NULL.
+
+**/
+
+STATIC
+VOID
+VirtioBlkWaitIo (
+  IN OUT VBLK_DEV *Dev,
+  IN     VBLK_IO  *Io     OPTIONAL
+  )
+{
+  EFI_TPL OldTpl;
+  BOOLEAN Done;
+  UINTN   PollPeriodUsecs;
+
+  PollPeriodUsecs = 1;
+  while (TRUE) {
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    if (!IsListEmpty (&Dev->IoList)) {
+      VirtioBlkReapChains (Dev);
+    }
+    Done = (Io == NULL) ? IsListEmpty (&Dev->IoList) : Io->Done;
+    gBS->RestoreTPL (OldTpl);
+
+    if (Done) {
+      break;
+    }
+
+    gBS->Stall (PollPeriodUsecs); // calls AcpiTimerLib::MicroSecondDelay
+
+    if (PollPeriodUsecs < 1024) {
+      PollPeriodUsecs *= 2;
+    }
+  }
+}
+
+
+/**
+
+  Submit a read / write / flush request to the host in one or more descriptor
+  chains, and poll for the response.
+
+  This is the main workhorse function of the blocking interfaces. Two use
+  cases are supported, read/write and flush. The function may only be called
+  after the request parameters have been verified by
   - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks(), and
   - VerifyReadWriteRequest() (for read/write only).
 
+  Requests queued by the non-blocking interfaces are completed first.
+
   Parameters handled commonly:
 
     @param[in] Dev             The virtio-blk device the request is targeted
@@ -224,8 +662,7 @@ VerifyReadWriteRequest (
 
   @retval EFI_SUCCESS          Transfer complete.
 
-  @retval EFI_DEVICE_ERROR     Failed to notify host side via VirtIo write, or
-                               unable to parse host response, or host response
+  @retval EFI_DEVICE_ERROR     Unable to parse host response, or host response
                                is not VIRTIO_BLK_S_OK or failed to map Buffer
                                for a bus master operation.
 
@@ -242,216 +679,84 @@ SynchronousRequest (
   IN              BOOLEAN  RequestIsWrite
   )
 {
-  UINT32                  BlockSize;
-  volatile VIRTIO_BLK_REQ Request;
-  volatile UINT8          *HostStatus;
-  VOID                    *HostStatusBuffer;
-  DESC_INDICES            Indices;
-  VOID                    *RequestMapping;
-  VOID                    *StatusMapping;
-  VOID                    *BufferMapping;
-  EFI_PHYSICAL_ADDRESS    BufferDeviceAddress;
-  EFI_PHYSICAL_ADDRESS    HostStatusDeviceAddress;
-  EFI_PHYSICAL_ADDRESS    RequestDeviceAddress;
-  EFI_STATUS              Status;
-  EFI_STATUS              UnmapStatus;
-
-  BlockSize = Dev->BlockIoMedia.BlockSize;
-
-  //
-  // Set BufferMapping and BufferDeviceAddress to suppress incorrect
-  // compiler/analyzer warnings.
-  //
-  BufferMapping       = NULL;
-  BufferDeviceAddress = 0;
+  VBLK_IO Io;
 
   //
   // ensured by VirtioBlkInit()
   //
-  ASSERT (BlockSize > 0);
-  ASSERT (BlockSize % 512 == 0);
+  ASSERT (Dev->BlockIoMedia.BlockSize > 0);
+  ASSERT (Dev->BlockIoMedia.BlockSize % 512 == 0);
 
   //
   // ensured by contract above, plus VerifyReadWriteRequest()
   //
-  ASSERT (BufferSize % BlockSize == 0);
+  ASSERT (BufferSize % Dev->BlockIoMedia.BlockSize == 0);
+  ASSERT (BufferSize <= SIZE_1GB);
 
-  //
-  // Prepare virtio-blk request header, setting zero size for flush.
-  // IO Priority is homogeneously 0.
-  //
-  Request.Type   = RequestIsWrite ?
-                   (BufferSize == 0 ? VIRTIO_BLK_T_FLUSH : VIRTIO_BLK_T_OUT) :
-                   VIRTIO_BLK_T_IN;
-  Request.IoPrio = 0;
-  Request.Sector = MultU64x32(Lba, BlockSize / 512);
+  VirtioBlkWaitIo (Dev, NULL);
 
-  //
-  // Host status is bi-directional (we preset with a value and expect the
-  // device to update it). Allocate a host status buffer which can be mapped
-  // to access equally by both processor and the device.
-  //
-  Status = Dev->VirtIo->AllocateSharedPages (
-                          Dev->VirtIo,
-                          EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                          &HostStatusBuffer
-                          );
-  if (EFI_ERROR (Status)) {
-    return EFI_DEVICE_ERROR;
-  }
+  Io.Token          = NULL;
+  Io.Lba            = Lba;
+  Io.Buffer         = (UINT8 *) Buffer;
+  Io.Remaining      = BufferSize;
+  Io.RequestIsWrite = RequestIsWrite;
+  Io.Flush          = (BOOLEAN) (BufferSize == 0);
+  VirtioBlkQueueIo (Dev, &Io);
+  VirtioBlkWaitIo (Dev, &Io);
 
-  HostStatus = HostStatusBuffer;
+  return Io.Status;
+}
 
-  //
-  // Map virtio-blk request header (must be done after request header is
-  // populated)
-  //
-  Status = VirtioMapAllBytesInSharedBuffer (
-             Dev->VirtIo,
-             VirtioOperationBusMasterRead,
-             (VOID *) &Request,
-             sizeof Request,
-             &RequestDeviceAddress,
-             &RequestMapping
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto FreeHostStatusBuffer;
-  }
 
-  //
-  // Map data buffer
-  //
-  if (BufferSize > 0) {
-    Status = VirtioMapAllBytesInSharedBuffer (
-               Dev->VirtIo,
-               (RequestIsWrite ?
-                VirtioOperationBusMasterRead :
-                VirtioOperationBusMasterWrite),
-               (VOID *) Buffer,
-               BufferSize,
-               &BufferDeviceAddress,
-               &BufferMapping
-               );
-    if (EFI_ERROR (Status)) {
-      Status = EFI_DEVICE_ERROR;
-      goto UnmapRequestBuffer;
-    }
-  }
+/**
 
-  //
-  // preset a host status for ourselves that we do not accept as success
-  //
-  *HostStatus = VIRTIO_BLK_S_IOERR;
+  Queue a non-blocking read / write request. The parameters must have been
+  verified with VerifyReadWriteRequest().
 
-  //
-  // Map the Status Buffer with VirtioOperationBusMasterCommonBuffer so that
-  // both processor and device can access it.
-  //
-  Status = VirtioMapAllBytesInSharedBuffer (
-             Dev->VirtIo,
-             VirtioOperationBusMasterCommonBuffer,
-             HostStatusBuffer,
-             sizeof *HostStatus,
-             &HostStatusDeviceAddress,
-             &StatusMapping
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto UnmapDataBuffer;
-  }
+  @param[in] Dev             The virtio-blk device the request is targeted at.
 
-  VirtioPrepare (&Dev->Ring, &Indices);
-
-  //
-  // ensured by VirtioBlkInit() -- this predicate, in combination with the
-  // lock-step progress, ensures we don't have to track free descriptors.
-  //
-  ASSERT (Dev->Ring.QueueSize >= 3);
+  @param[in] Lba             Logical Block Address of the transfer.
 
-  //
-  // virtio-blk header in first desc
-  //
-  VirtioAppendDesc (
-    &Dev->Ring,
-    RequestDeviceAddress,
-    sizeof Request,
-    VRING_DESC_F_NEXT,
-    &Indices
-    );
+  @param[in] BufferSize      Size of buffer to transfer, in bytes, positive.
 
-  //
-  // data buffer for read/write in second desc
-  //
-  if (BufferSize > 0) {
-    //
-    // From virtio-0.9.5, 2.3.2 Descriptor Table:
-    // "no descriptor chain may be more than 2^32 bytes long in total".
-    //
-    // The predicate is ensured by the call contract above (for flush), or
-    // VerifyReadWriteRequest() (for read/write). It also implies that
-    // converting BufferSize to UINT32 will not truncate it.
-    //
-    ASSERT (BufferSize <= SIZE_1GB);
+  @param[in out] Buffer      The guest side area to transfer data with.
 
-    //
-    // VRING_DESC_F_WRITE is interpreted from the host's point of view.
-    //
-    VirtioAppendDesc (
-      &Dev->Ring,
-      BufferDeviceAddress,
-      (UINT32) BufferSize,
-      VRING_DESC_F_NEXT | (RequestIsWrite ? 0 : VRING_DESC_F_WRITE),
-      &Indices
-      );
-  }
+  @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to device.
 
-  //
-  // host status in last (second or third) desc
-  //
-  VirtioAppendDesc (
-    &Dev->Ring,
-    HostStatusDeviceAddress,
-    sizeof *HostStatus,
-    VRING_DESC_F_WRITE,
-    &Indices
-    );
+  @param[in out] Token       The token whose event is signaled on completion.
 
-  //
-  // virtio-blk's only virtqueue is #0, called "requestq" (see Appendix D).
-  //
-  if (VirtioFlush (Dev->VirtIo, 0, &Dev->Ring, &Indices,
-        NULL) == EFI_SUCCESS &&
-      *HostStatus == VIRTIO_BLK_S_OK) {
-    Status = EFI_SUCCESS;
-  } else {
-    Status = EFI_DEVICE_ERROR;
-  }
+  @retval EFI_SUCCESS           The request was queued.
 
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, StatusMapping);
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
 
-UnmapDataBuffer:
-  if (BufferSize > 0) {
-    UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, BufferMapping);
-    if (EFI_ERROR (UnmapStatus) && !RequestIsWrite && !EFI_ERROR (Status)) {
-      //
-      // Data from the bus master may not reach the caller; fail the request.
-      //
-      Status = EFI_DEVICE_ERROR;
-    }
-  }
+**/
 
-UnmapRequestBuffer:
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, RequestMapping);
+STATIC
+EFI_STATUS
+AsynchronousRequest (
+  IN     VBLK_DEV            *Dev,
+  IN     EFI_LBA             Lba,
+  IN     UINTN               BufferSize,
+  IN OUT VOID                *Buffer,
+  IN     BOOLEAN             RequestIsWrite,
+  IN OUT EFI_BLOCK_IO2_TOKEN *Token
+  )
+{
+  VBLK_IO *Io;
 
-FreeHostStatusBuffer:
-  Dev->VirtIo->FreeSharedPages (
-                 Dev->VirtIo,
-                 EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                 HostStatusBuffer
-                 );
+  Io = AllocatePool (sizeof *Io);
+  if (Io == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-  return Status;
+  Io->Token          = Token;
+  Io->Lba            = Lba;
+  Io->Buffer         = Buffer;
+  Io->Remaining      = BufferSize;
+  Io->RequestIsWrite = RequestIsWrite;
+  Io->Flush          = FALSE;
+  VirtioBlkQueueIo (Dev, Io);
+  return EFI_SUCCESS;
 }
 
 
@@ -604,6 +909,189 @@ VirtioBlkFlushBlocks (
 }
 
 
+//
+// UEFI Spec 2.4, 13.10 Block I/O 2 Protocol
+//
+// Requests in flight cannot be aborted without resetting the device, so they
+// are waited for.
+//
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  VirtioBlkWaitIo (VIRTIO_BLK_FROM_BLOCK_IO2 (This), NULL);
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Common implementation of ReadBlocksEx() and WriteBlocksEx().
+
+  @param[in] Dev             The virtio-blk device the request is targeted at.
+
+  @param[in] Lba             Logical Block Address of the transfer.
+
+  @param[in out] Token       The token of the request, or NULL.
+
+  @param[in] BufferSize      Size of buffer to transfer, in bytes.
+
+  @param[in out] Buffer      The guest side area to transfer data with.
+
+  @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to device.
+
+
+  @return  Status codes as required by ReadBlocksEx() / WriteBlocksEx().
+
+**/
+
+STATIC
+EFI_STATUS
+VirtioBlkReadWriteEx (
+  IN     VBLK_DEV            *Dev,
+  IN     EFI_LBA             Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN *Token,
+  IN     UINTN               BufferSize,
+  IN OUT VOID                *Buffer,
+  IN     BOOLEAN             RequestIsWrite
+  )
+{
+  EFI_STATUS Status;
+
+  if (BufferSize == 0) {
+    if (Token != NULL && Token->Event != NULL) {
+      Token->TransactionStatus = EFI_SUCCESS;
+      gBS->SignalEvent (Token->Event);
+    }
+    return EFI_SUCCESS;
+  }
+
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Token == NULL || Token->Event == NULL) {
+    return SynchronousRequest (Dev, Lba, BufferSize, Buffer, RequestIsWrite);
+  }
+
+  return AsynchronousRequest (Dev, Lba, BufferSize, Buffer, RequestIsWrite,
+           Token);
+}
+
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.4, 13.10 Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+
+  If Token is NULL, or Token->Event is NULL, the request is blocking.
+  Otherwise the request is split into descriptor chains that are submitted
+  to the host, and Token->Event is signaled once all of them have completed.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  )
+{
+  return VirtioBlkReadWriteEx (
+           VIRTIO_BLK_FROM_BLOCK_IO2 (This),
+           Lba,
+           Token,
+           BufferSize,
+           Buffer,
+           FALSE       // RequestIsWrite
+           );
+}
+
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.4, 13.10 Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+
+  If Token is NULL, or Token->Event is NULL, the request is blocking.
+  Otherwise the request is split into descriptor chains that are submitted
+  to the host, and Token->Event is signaled once all of them have completed.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  return VirtioBlkReadWriteEx (
+           VIRTIO_BLK_FROM_BLOCK_IO2 (This),
+           Lba,
+           Token,
+           BufferSize,
+           Buffer,
+           TRUE        // RequestIsWrite
+           );
+}
+
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.4, 13.10 Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+
+  The flush waits for all outstanding requests and completes before
+  returning; Token->Event, if any, is signaled before returning.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  )
+{
+  VBLK_DEV   *Dev;
+  EFI_STATUS Status;
+
+  Dev    = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  Status = VirtioBlkFlushBlocks (&Dev->BlockIo);
+  if (Token != NULL && Token->Event != NULL) {
+    Token->TransactionStatus = Status;
+    gBS->SignalEvent (Token->Event);
+    return EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+
 /**
 
   Device probe function for this driver.
@@ -685,6 +1173,140 @@ VirtioBlkDriverBindingSupported (
 }
 
 
+/**
+
+  Set up the descriptor chains for in-flight requests: the free chain stack
+  and the request headers / host statuses shared with the host.
+
+  @param[in out] Dev  The driver instance to configure. Dev->Ring must be
+                      initialized.
+
+  @retval EFI_SUCCESS           Setup complete.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Error codes from AllocateSharedPages() or
+                                VirtioMapAllBytesInSharedBuffer().
+
+**/
+
+STATIC
+EFI_STATUS
+VirtioBlkInitChains (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  EFI_STATUS Status;
+  UINT16     ChainIdx;
+  UINTN      SharedReqSize;
+  VOID       *SharedReq;
+
+  Dev->ChainCount     = Dev->Ring.QueueSize / VBLK_DESC_PER_CHAIN;
+  Dev->FreeChainCount = Dev->ChainCount;
+
+  Dev->Chains = AllocateZeroPool (Dev->ChainCount * sizeof *Dev->Chains);
+  if (Dev->Chains == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Dev->FreeChainStack = AllocatePool (Dev->ChainCount *
+                          sizeof *Dev->FreeChainStack);
+  if (Dev->FreeChainStack == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeChains;
+  }
+
+  //
+  // Pop chains from the stack starting at chain #0.
+  //
+  for (ChainIdx = 0; ChainIdx < Dev->ChainCount; ChainIdx++) {
+    Dev->FreeChainStack[Dev->ChainCount - 1 - ChainIdx] = ChainIdx;
+  }
+
+  //
+  // The request headers and host statuses are written by the processor and
+  // read / written by the device, so map them as a common buffer.
+  //
+  SharedReqSize = Dev->ChainCount * sizeof (VBLK_SHARED_REQ);
+  Status = Dev->VirtIo->AllocateSharedPages (
+                          Dev->VirtIo,
+                          EFI_SIZE_TO_PAGES (SharedReqSize),
+                          &SharedReq
+                          );
+  if (EFI_ERROR (Status)) {
+    goto FreeFreeChainStack;
+  }
+  ZeroMem (SharedReq, SharedReqSize);
+
+  Status = VirtioMapAllBytesInSharedBuffer (
+             Dev->VirtIo,
+             VirtioOperationBusMasterCommonBuffer,
+             SharedReq,
+             SharedReqSize,
+             &Dev->SharedReqAddress,
+             &Dev->SharedReqMap
+             );
+  if (EFI_ERROR (Status)) {
+    goto FreeSharedReq;
+  }
+
+  Dev->SharedReq = SharedReq;
+
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device. We're going
+  // to poll the answers, the host should not send interrupts.
+  //
+  *Dev->Ring.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+  MemoryFence ();
+  Dev->LastUsedIdx = *Dev->Ring.Used.Idx;
+  InitializeListHead (&Dev->IoList);
+  return EFI_SUCCESS;
+
+FreeSharedReq:
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (SharedReqSize),
+                 SharedReq
+                 );
+
+FreeFreeChainStack:
+  FreePool (Dev->FreeChainStack);
+
+FreeChains:
+  FreePool (Dev->Chains);
+
+  return Status;
+}
+
+
+/**
+
+  Release the resources set up by VirtioBlkInitChains(). No request may be in
+  flight.
+
+  @param[in out] Dev  The driver instance to clean up.
+
+**/
+
+STATIC
+VOID
+VirtioBlkUninitChains (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  ASSERT (IsListEmpty (&Dev->IoList));
+
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->SharedReqMap);
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (Dev->ChainCount * sizeof (VBLK_SHARED_REQ)),
+                 Dev->SharedReq
+                 );
+  FreePool (Dev->FreeChainStack);
+  FreePool (Dev->Chains);
+}
+
+
 /**
 
   Set up all BlockIo and virtio-blk aspects of this driver for the specified
@@ -841,7 +1463,7 @@ VirtioBlkInit (
   if (EFI_ERROR (Status)) {
     goto Failed;
   }
-  if (QueueSize < 3) { // SynchronousRequest() uses at most three descriptors
+  if (QueueSize < VBLK_DESC_PER_CHAIN) { // a request uses up to three descs
     Status = EFI_UNSUPPORTED;
     goto Failed;
   }
@@ -890,6 +1512,15 @@ VirtioBlkInit (
     goto UnmapQueue;
   }
 
+  //
+  // Partition the ring into descriptor chains. If anything fails from here
+  // on, we must release the chain resources.
+  //
+  Status = VirtioBlkInitChains (Dev);
+  if (EFI_ERROR (Status)) {
+    goto UnmapQueue;
+  }
+
 
   //
   // step 5 -- Report understood features.
@@ -898,7 +1529,7 @@ VirtioBlkInit (
     Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM);
     Status = Dev->VirtIo->SetGuestFeatures (Dev->VirtIo, Features);
     if (EFI_ERROR (Status)) {
-      goto UnmapQueue;
+      goto UninitChains;
     }
   }
 
@@ -908,7 +1539,7 @@ VirtioBlkInit (
   NextDevStat |= VSTAT_DRIVER_OK;
   Status = Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, NextDevStat);
   if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    goto UninitChains;
   }
 
   //
@@ -921,6 +1552,11 @@ VirtioBlkInit (
   Dev->BlockIo.ReadBlocks            = &VirtioBlkReadBlocks;
   Dev->BlockIo.WriteBlocks           = &VirtioBlkWriteBlocks;
   Dev->BlockIo.FlushBlocks           = &VirtioBlkFlushBlocks;
+  Dev->BlockIo2.Media                = &Dev->BlockIoMedia;
+  Dev->BlockIo2.Reset                = &VirtioBlkResetEx;
+  Dev->BlockIo2.ReadBlocksEx         = &VirtioBlkReadBlocksEx;
+  Dev->BlockIo2.WriteBlocksEx        = &VirtioBlkWriteBlocksEx;
+  Dev->BlockIo2.FlushBlocksEx        = &VirtioBlkFlushBlocksEx;
   Dev->BlockIoMedia.MediaId          = 0;
   Dev->BlockIoMedia.RemovableMedia   = FALSE;
   Dev->BlockIoMedia.MediaPresent     = TRUE;
@@ -951,6 +1587,9 @@ VirtioBlkInit (
   }
   return EFI_SUCCESS;
 
+UninitChains:
+  VirtioBlkUninitChains (Dev);
+
 UnmapQueue:
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
 
@@ -992,10 +1631,12 @@ VirtioBlkUninit (
   //
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
 
+  VirtioBlkUninitChains (Dev);
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
   VirtioRingUninit (Dev->VirtIo, &Dev->Ring);
 
   SetMem (&Dev->BlockIo,      sizeof Dev->BlockIo,      0x00);
+  SetMem (&Dev->BlockIo2,     sizeof Dev->BlockIo2,     0x00);
   SetMem (&Dev->BlockIoMedia, sizeof Dev->BlockIoMedia, 0x00);
 }
 
@@ -1099,18 +1740,38 @@ VirtioBlkDriverBindingStart (
   }
 
   //
-  // Setup complete, attempt to export the driver instance's BlockIo interface.
+  // Poll the used ring for non-blocking requests.
   //
-  Dev->Signature = VBLK_SIG;
-  Status = gBS->InstallProtocolInterface (&DeviceHandle,
-                  &gEfiBlockIoProtocolGuid, EFI_NATIVE_INTERFACE,
-                  &Dev->BlockIo);
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_NOTIFY,
+                  &VirtioBlkAsyncPoll, Dev, &Dev->AsyncTimer);
   if (EFI_ERROR (Status)) {
     goto CloseExitBoot;
   }
 
+  Status = gBS->SetTimer (Dev->AsyncTimer, TimerPeriodic,
+                  VBLK_ASYNC_POLL_PERIOD);
+  if (EFI_ERROR (Status)) {
+    goto CloseAsyncTimer;
+  }
+
+  //
+  // Setup complete, attempt to export the driver instance's BlockIo and
+  // BlockIo2 interfaces.
+  //
+  Dev->Signature = VBLK_SIG;
+  Status = gBS->InstallMultipleProtocolInterfaces (&DeviceHandle,
+                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
+                  NULL);
+  if (EFI_ERROR (Status)) {
+    goto CloseAsyncTimer;
+  }
+
   return EFI_SUCCESS;
 
+CloseAsyncTimer:
+  gBS->CloseEvent (Dev->AsyncTimer);
+
 CloseExitBoot:
   gBS->CloseEvent (Dev->ExitBoot);
 
@@ -1181,12 +1842,20 @@ VirtioBlkDriverBindingStop (
   //
   // Handle Stop() requests for in-use driver instances gracefully.
   //
-  Status = gBS->UninstallProtocolInterface (DeviceHandle,
-                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo);
+  Status = gBS->UninstallMultipleProtocolInterfaces (DeviceHandle,
+                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
+                  NULL);
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
+  //
+  // Complete the non-blocking requests still in flight.
+  //
+  VirtioBlkWaitIo (Dev, NULL);
+  gBS->CloseEvent (Dev->AsyncTimer);
+
   gBS->CloseEvent (Dev->ExitBoot);
 
   VirtioBlkUninit (Dev);
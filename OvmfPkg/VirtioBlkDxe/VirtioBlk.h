@@ -13,14 +13,67 @@
 #define _VIRTIO_BLK_DXE_H_
 
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/ComponentName.h>
 #include <Protocol/DriverBinding.h>
 
 #include <IndustryStandard/Virtio.h>
+#include <IndustryStandard/VirtioBlk.h>
 
 
 #define VBLK_SIG SIGNATURE_32 ('V', 'B', 'L', 'K')
 
+//
+// Every request is a chain of at most three descriptors (request header, data
+// buffer, host status). The descriptor table is statically partitioned between
+// the chains, chain N owning descriptors [3*N, 3*N+2].
+//
+#define VBLK_DESC_PER_CHAIN 3
+
+//
+// Transfers larger than this are split into several chains. Each chain is a
+// separate virtio-blk request, that the host may complete on its own.
+//
+#define VBLK_MAX_CHAIN_SIZE SIZE_1MB
+
+//
+// Period of polling the used ring for completed non-blocking requests.
+//
+#define VBLK_ASYNC_POLL_PERIOD EFI_TIMER_PERIOD_MILLISECONDS (1)
+
+//
+// Request header and host status of one chain, in memory shared with the host.
+//
+typedef struct {
+  VIRTIO_BLK_REQ Request;
+  UINT8          HostStatus;
+} VBLK_SHARED_REQ;
+
+//
+// A read, write or flush request submitted to the driver, possibly split into
+// several chains.
+//
+typedef struct {
+  LIST_ENTRY          Link;           // Linked in VBLK_DEV.IoList
+  EFI_BLOCK_IO2_TOKEN *Token;         // NULL for blocking requests
+  EFI_LBA             Lba;            // First block not submitted yet
+  UINT8               *Buffer;        // First byte not submitted yet
+  UINTN               Remaining;      // Bytes not submitted yet
+  UINTN               InFlight;       // Chains submitted and not completed
+  BOOLEAN             RequestIsWrite;
+  BOOLEAN             Flush;          // Flush not submitted yet
+  BOOLEAN             Done;           // Set on completion of blocking requests
+  EFI_STATUS          Status;
+} VBLK_IO;
+
+//
+// An in-flight descriptor chain.
+//
+typedef struct {
+  VBLK_IO             *Io;
+  VOID                *BufferMapping; // NULL for flush
+} VBLK_CHAIN;
+
 typedef struct {
   //
   // Parts of this structure are initialized / torn down in various functions
@@ -36,11 +89,25 @@ typedef struct {
   EFI_BLOCK_IO_PROTOCOL  BlockIo;              // VirtioBlkInit       1
   EFI_BLOCK_IO_MEDIA     BlockIoMedia;         // VirtioBlkInit       1
   VOID                   *RingMap;             // VirtioRingMap       2
+  EFI_BLOCK_IO2_PROTOCOL BlockIo2;             // VirtioBlkInit       1
+  UINT16                 ChainCount;           // VirtioBlkInitChains 2
+  UINT16                 FreeChainCount;       // VirtioBlkInitChains 2
+  UINT16                 *FreeChainStack;      // VirtioBlkInitChains 2
+  VBLK_CHAIN             *Chains;              // VirtioBlkInitChains 2
+  VBLK_SHARED_REQ        *SharedReq;           // VirtioBlkInitChains 2
+  EFI_PHYSICAL_ADDRESS   SharedReqAddress;     // VirtioBlkInitChains 2
+  VOID                   *SharedReqMap;        // VirtioBlkInitChains 2
+  UINT16                 LastUsedIdx;          // VirtioBlkInitChains 2
+  LIST_ENTRY             IoList;               // VirtioBlkInitChains 2
+  EFI_EVENT              AsyncTimer;           // DriverBindingStart  0
 } VBLK_DEV;
 
 #define VIRTIO_BLK_FROM_BLOCK_IO(BlockIoPointer) \
         CR (BlockIoPointer, VBLK_DEV, BlockIo, VBLK_SIG)
 
+#define VIRTIO_BLK_FROM_BLOCK_IO2(BlockIo2Pointer) \
+        CR (BlockIo2Pointer, VBLK_DEV, BlockIo2, VBLK_SIG)
+
 
 /**
 
@@ -253,6 +320,87 @@ VirtioBlkFlushBlocks (
   );
 
 
+//
+// UEFI Spec 2.4, 13.10 Block I/O 2 Protocol
+//
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  );
+
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.4, 13.10 Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+
+  If Token is NULL, or Token->Event is NULL, the request is blocking.
+  Otherwise the request is split into descriptor chains that are submitted
+  to the host, and Token->Event is signaled once all of them have completed.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  );
+
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.4, 13.10 Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+
+  If Token is NULL, or Token->Event is NULL, the request is blocking.
+  Otherwise the request is split into descriptor chains that are submitted
+  to the host, and Token->Event is signaled once all of them have completed.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  );
+
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See UEFI Spec 2.4, 13.10 Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+
+  The flush waits for all outstanding requests and completes before
+  returning; Token->Event, if any, is signaled before returning.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  );
+
+
 //
 // The purpose of the following scaffolding (EFI_COMPONENT_NAME_PROTOCOL and
 // EFI_COMPONENT_NAME2_PROTOCOL implementation) is to format the driver's name
@@ -170,11 +170,8 @@ RecycleDesc:
   Dev->RxRing.Avail.Ring[AvailIdx++ % Dev->RxRing.QueueSize] =
     (UINT16) DescIdx;
 
-  MemoryFence ();
-  *Dev->RxRing.Avail.Idx = AvailIdx;
-
-  MemoryFence ();
-  NotifyStatus = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_RX);
+  NotifyStatus = VirtioNetKickQueue (Dev, &Dev->RxRing, VIRTIO_NET_Q_RX,
+                   AvailIdx);
   if (!EFI_ERROR (Status)) { // earlier error takes precedence
     Status = NotifyStatus;
   }
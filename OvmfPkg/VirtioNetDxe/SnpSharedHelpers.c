@@ -8,7 +8,9 @@
 
 **/
 
+#include <Library/BaseLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/SynchronizationLib.h>
 
 #include "VirtioNet.h"
 
@@ -104,6 +106,49 @@ VirtioNetUninitRing (
 }
 
 
+/**
+  Publish the new available index of a virtio ring, and notify the device of
+  the new buffers, unless the device has asked not to be notified.
+
+  The device sets VRING_USED_F_NO_NOTIFY while it is processing the ring
+  anyway (virtio-0.9.5, 2.4.1.4), so honoring it saves a VM exit per frame
+  while traffic is flowing.
+
+  @param[in] Dev        The VNET_DEV driver instance owning the ring.
+  @param[in] Ring       The virtio ring whose available ring was updated.
+  @param[in] QueueIndex The index of the virtio queue of the ring.
+  @param[in] AvailIdx   The new available index to publish.
+
+  @retval EFI_SUCCESS   The device was notified, or didn't need to be.
+  @return               Status codes from VIRTIO_DEVICE_PROTOCOL.SetQueueNotify().
+*/
+EFI_STATUS
+EFIAPI
+VirtioNetKickQueue (
+  IN VNET_DEV *Dev,
+  IN VRING    *Ring,
+  IN UINT16   QueueIndex,
+  IN UINT16   AvailIdx
+  )
+{
+  //
+  // Publish the index with a locked operation, which is a full barrier. It
+  // orders the available ring entry before the index, and the read of the
+  // used ring flags after it. MemoryFence() only stops the compiler on x86;
+  // with a plain store the CPU could read a stale VRING_USED_F_NO_NOTIFY
+  // that the device has just cleared, and never notify it of the new
+  // buffers. We are the only writer of the index, so the exchange always
+  // succeeds.
+  //
+  InterlockedCompareExchange16 (Ring->Avail.Idx, *Ring->Avail.Idx, AvailIdx);
+
+  if ((*Ring->Used.Flags & (UINT16) VRING_USED_F_NO_NOTIFY) != 0) {
+    return EFI_SUCCESS;
+  }
+  return Dev->VirtIo->SetQueueNotify (Dev->VirtIo, QueueIndex);
+}
+
+
 /**
   Map Caller-supplied TxBuf buffer to the device-mapped address
 
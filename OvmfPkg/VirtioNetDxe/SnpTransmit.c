@@ -166,11 +166,7 @@ VirtioNetTransmit (
   AvailIdx = *Dev->TxRing.Avail.Idx;
   Dev->TxRing.Avail.Ring[AvailIdx++ % Dev->TxRing.QueueSize] = DescIdx;
 
-  MemoryFence ();
-  *Dev->TxRing.Avail.Idx = AvailIdx;
-
-  MemoryFence ();
-  Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_TX);
+  Status = VirtioNetKickQueue (Dev, &Dev->TxRing, VIRTIO_NET_Q_TX, AvailIdx);
 
 Exit:
   gBS->RestoreTPL (OldTpl);
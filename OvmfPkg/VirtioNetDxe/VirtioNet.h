@@ -276,6 +276,15 @@ VirtioNetUninitRing (
   IN     VOID     *RingMap
   );
 
+EFI_STATUS
+EFIAPI
+VirtioNetKickQueue (
+  IN VNET_DEV *Dev,
+  IN VRING    *Ring,
+  IN UINT16   QueueIndex,
+  IN UINT16   AvailIdx
+  );
+
 //
 // utility functions to map caller-supplied Tx buffer system physical address
 // to a device address and vice versa
@@ -36,6 +36,14 @@ UINT8                               *mImageBase       = NULL;
 UINT8                               mImageDigest[MAX_DIGEST_SIZE];
 UINTN                               mImageDigestSize;
 
+//
+// Digests of the current PE/COFF image already calculated by HashPeImage(),
+// indexed by hash algorithm, so that an image carrying several signatures
+// with the same digest algorithm is only hashed once per algorithm.
+//
+UINT8                               mImageDigestCache[HASHALG_MAX][MAX_DIGEST_SIZE];
+BOOLEAN                             mImageDigestCached[HASHALG_MAX];
+
 //
 // Notify string for authorization UI.
 //
@@ -68,6 +76,14 @@ HASH_TABLE mHash[] = {
 
 EFI_STRING mHashTypeStr;
 
+//
+// Signature databases searched by IsSignatureFoundInDatabase().
+//
+SIGNATURE_DB_CACHE mSignatureDbCache[] = {
+  { EFI_IMAGE_SECURITY_DATABASE,  FALSE, NULL, 0, NULL, 0 },
+  { EFI_IMAGE_SECURITY_DATABASE1, FALSE, NULL, 0, NULL, 0 }
+};
+
 /**
   SecureBoot Hook for processing image verification.
 
@@ -340,6 +356,12 @@ HashPeImage (
   }
 
   mHashTypeStr = mHash[HashAlg].Name;
+
+  if (mImageDigestCached[HashAlg]) {
+    CopyMem (mImageDigest, mImageDigestCache[HashAlg], mImageDigestSize);
+    return TRUE;
+  }
+
   CtxSize   = mHash[HashAlg].GetContextSize();
 
   HashCtx = AllocatePool (CtxSize);
@@ -347,6 +369,8 @@ HashPeImage (
     return FALSE;
   }
 
+  PERF_START (NULL, "HashPeImage", "DxeImageVerificationLib", 0);
+
   // 1.  Load the image header into memory.
 
   // 2.  Initialize a SHA hash context.
@@ -583,8 +607,14 @@ HashPeImage (
   }
 
   Status  = mHash[HashAlg].HashFinal(HashCtx, mImageDigest);
+  if (Status) {
+    CopyMem (mImageDigestCache[HashAlg], mImageDigest, mImageDigestSize);
+    mImageDigestCached[HashAlg] = TRUE;
+  }
 
 Done:
+  PERF_END (NULL, "HashPeImage", "DxeImageVerificationLib", 0);
+
   if (HashCtx != NULL) {
     FreePool (HashCtx);
   }
@@ -948,9 +978,102 @@ Done:
   return Status;
 }
 
+/**
+  Read a signature database variable into its cache, and rebuild the
+  sorted entries if the variable changed since it was last read.
+
+  @param[in, out]  Cache          The cache of the signature database.
+
+  @retval EFI_SUCCESS             The cache matches the variable.
+  @retval EFI_INVALID_PARAMETER   The variable holds a malformed signature list.
+  @retval EFI_OUT_OF_RESOURCES    No enough resource to read the variable.
+  @retval Others                  Error occurred reading the variable.
+
+**/
+EFI_STATUS
+RefreshSignatureDbCache (
+  IN OUT SIGNATURE_DB_CACHE  *Cache
+  )
+{
+  EFI_STATUS          Status;
+  SIGNATURE_DB_ENTRY  *Entry;
+  UINTN               EntryCount;
+  UINTN               DataSize;
+  UINT8               *Data;
+
+  Data      = NULL;
+  DataSize  = 0;
+  Status    = gRT->GetVariable (Cache->VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, NULL);
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    Data = (UINT8 *) AllocateZeroPool (DataSize);
+    if (Data == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Status = gRT->GetVariable (Cache->VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, Data);
+    if (EFI_ERROR (Status)) {
+      FreePool (Data);
+      return Status;
+    }
+  } else if (Status == EFI_NOT_FOUND) {
+    //
+    // No database, nothing to search.
+    //
+    DataSize = 0;
+  } else {
+    return Status;
+  }
+
+  if ((Data == Cache->Data) ||
+      ((Data != NULL) && (Cache->Data != NULL) &&
+       (DataSize == Cache->DataSize) && (CompareMem (Data, Cache->Data, DataSize) == 0))) {
+    //
+    // The database is unchanged; keep the sorted entries.
+    //
+    if (Data != NULL) {
+      FreePool (Data);
+    }
+    Cache->Checked = TRUE;
+    return EFI_SUCCESS;
+  }
+
+  Status = BuildSignatureDbIndex (Data, DataSize, &Entry, &EntryCount);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "DxeImageVerificationLib: %s can't be indexed - %r\n", Cache->VariableName, Status));
+    if (Data != NULL) {
+      FreePool (Data);
+    }
+    return Status;
+  }
+
+  if (Cache->Data != NULL) {
+    FreePool (Cache->Data);
+  }
+  if (Cache->Entry != NULL) {
+    FreePool (Cache->Entry);
+  }
+  Cache->Data       = Data;
+  Cache->DataSize   = DataSize;
+  Cache->Entry      = Entry;
+  Cache->EntryCount = EntryCount;
+  Cache->Checked    = TRUE;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "DxeImageVerificationLib: %s has %Lu signatures.\n",
+    Cache->VariableName,
+    (UINT64) EntryCount
+    ));
+
+  return EFI_SUCCESS;
+}
+
 /**
   Check whether signature is in specified database.
 
+  The database is searched with a binary search over its sorted entries.
+  It is read again for every image, see RefreshSignatureDbCache().
+
   @param[in]  VariableName        Name of database variable that is searched in.
   @param[in]  Signature           Pointer to signature that is searched for.
   @param[in]  CertType            Pointer to hash algorithm.
@@ -971,81 +1094,48 @@ IsSignatureFoundInDatabase (
   )
 {
   EFI_STATUS          Status;
-  EFI_SIGNATURE_LIST  *CertList;
-  EFI_SIGNATURE_DATA  *Cert;
-  UINTN               DataSize;
-  UINT8               *Data;
+  SIGNATURE_DB_CACHE  *Cache;
+  SIGNATURE_DB_ENTRY  *Entry;
   UINTN               Index;
-  UINTN               CertCount;
 
-  //
-  // Read signature database variable.
-  //
-  *IsFound  = FALSE;
-  Data      = NULL;
-  DataSize  = 0;
-  Status    = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, NULL);
-  if (Status != EFI_BUFFER_TOO_SMALL) {
-    if (Status == EFI_NOT_FOUND) {
-      //
-      // No database, no need to search.
-      //
-      Status = EFI_SUCCESS;
-    }
+  *IsFound = FALSE;
 
-    return Status;
+  Cache = NULL;
+  for (Index = 0; Index < ARRAY_SIZE (mSignatureDbCache); Index++) {
+    if (StrCmp (VariableName, mSignatureDbCache[Index].VariableName) == 0) {
+      Cache = &mSignatureDbCache[Index];
+      break;
+    }
   }
-
-  Data = (UINT8 *) AllocateZeroPool (DataSize);
-  if (Data == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  if (Cache == NULL) {
+    ASSERT (FALSE);
+    return EFI_UNSUPPORTED;
   }
 
-  Status = gRT->GetVariable (VariableName, &gEfiImageSecurityDatabaseGuid, NULL, &DataSize, Data);
-  if (EFI_ERROR (Status)) {
-    goto Done;
-  }
-  //
-  // Enumerate all signature data in SigDB to check if signature exists for executable.
-  //
-  CertList = (EFI_SIGNATURE_LIST *) Data;
-  while ((DataSize > 0) && (DataSize >= CertList->SignatureListSize)) {
-    CertCount = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
-    Cert      = (EFI_SIGNATURE_DATA *) ((UINT8 *) CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
-    if ((CertList->SignatureSize == sizeof(EFI_SIGNATURE_DATA) - 1 + SignatureSize) && (CompareGuid(&CertList->SignatureType, CertType))) {
-      for (Index = 0; Index < CertCount; Index++) {
-        if (CompareMem (Cert->SignatureData, Signature, SignatureSize) == 0) {
-          //
-          // Find the signature in database.
-          //
-          *IsFound = TRUE;
-          //
-          // Entries in UEFI_IMAGE_SECURITY_DATABASE that are used to validate image should be measured
-          //
-          if (StrCmp(VariableName, EFI_IMAGE_SECURITY_DATABASE) == 0) {
-            SecureBootHook (VariableName, &gEfiImageSecurityDatabaseGuid, CertList->SignatureSize, Cert);
-          }
-          break;
-        }
-
-        Cert = (EFI_SIGNATURE_DATA *) ((UINT8 *) Cert + CertList->SignatureSize);
-      }
-
-      if (*IsFound) {
-        break;
-      }
+  if (!Cache->Checked) {
+    Status = RefreshSignatureDbCache (Cache);
+    if (EFI_ERROR (Status)) {
+      return Status;
     }
+  }
 
-    DataSize -= CertList->SignatureListSize;
-    CertList = (EFI_SIGNATURE_LIST *) ((UINT8 *) CertList + CertList->SignatureListSize);
+  Entry = FindSignatureDbEntry (Cache->Entry, Cache->EntryCount, Signature, CertType, SignatureSize);
+  if (Entry == NULL) {
+    return EFI_SUCCESS;
   }
 
-Done:
-  if (Data != NULL) {
-    FreePool (Data);
+  //
+  // Find the signature in database.
+  //
+  *IsFound = TRUE;
+  //
+  // Entries in UEFI_IMAGE_SECURITY_DATABASE that are used to validate image should be measured
+  //
+  if (StrCmp(VariableName, EFI_IMAGE_SECURITY_DATABASE) == 0) {
+    SecureBootHook (VariableName, &gEfiImageSecurityDatabaseGuid, Entry->CertList->SignatureSize, Entry->Cert);
   }
 
-  return Status;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -1658,6 +1748,7 @@ DxeImageVerificationHandler (
   EFI_STATUS                           HashStatus;
   EFI_STATUS                           DbStatus;
   BOOLEAN                              IsFound;
+  UINTN                                Index;
 
   SignatureList     = NULL;
   SignatureListSize = 0;
@@ -1738,6 +1829,16 @@ DxeImageVerificationHandler (
 
   mImageBase  = (UINT8 *) FileBuffer;
   mImageSize  = FileSize;
+  ZeroMem (mImageDigestCached, sizeof (mImageDigestCached));
+
+  //
+  // db and dbx may be written through paths that don't go through gRT,
+  // such as SMM, so they are read again for every image. The sorted
+  // entries are only rebuilt when a database changed.
+  //
+  for (Index = 0; Index < ARRAY_SIZE (mSignatureDbCache); Index++) {
+    mSignatureDbCache[Index].Checked = FALSE;
+  }
 
   ZeroMem (&ImageContext, sizeof (ImageContext));
   ImageContext.Handle    = (VOID *) FileBuffer;
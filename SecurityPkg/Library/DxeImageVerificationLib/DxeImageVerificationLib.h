@@ -23,6 +23,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DevicePathLib.h>
 #include <Library/SecurityManagementLib.h>
 #include <Library/PeCoffLib.h>
+#include <Library/PerformanceLib.h>
 #include <Protocol/FirmwareVolume2.h>
 #include <Protocol/DevicePath.h>
 #include <Protocol/BlockIo.h>
@@ -198,4 +199,88 @@ typedef struct {
   HASH_FINAL               HashFinal;
 } HASH_TABLE;
 
+//
+// One EFI_SIGNATURE_DATA entry of a signature database, with the list that
+// holds it.
+//
+typedef struct {
+  EFI_SIGNATURE_LIST       *CertList;
+  EFI_SIGNATURE_DATA       *Cert;
+} SIGNATURE_DB_ENTRY;
+
+//
+// Copy of a signature database variable, and its entries sorted by
+// signature size, signature type and signature data.
+//
+typedef struct {
+  //
+  // Name of the database variable
+  //
+  CHAR16                   *VariableName;
+  //
+  // TRUE if the copy has been checked against the variable for the
+  // image being verified
+  //
+  BOOLEAN                  Checked;
+  //
+  // Contents of the variable, NULL if the variable doesn't exist
+  //
+  UINT8                    *Data;
+  UINTN                    DataSize;
+  //
+  // Sorted entries of all signature lists in Data
+  //
+  SIGNATURE_DB_ENTRY       *Entry;
+  UINTN                    EntryCount;
+} SIGNATURE_DB_CACHE;
+
+/**
+  Build the sorted index of all entries of a signature database.
+
+  Every signature list is validated first, a malformed database is not
+  indexed at all.
+
+  @param[in]  Data                The signature database, a sequence of
+                                  EFI_SIGNATURE_LIST.
+  @param[in]  DataSize            Size of Data.
+  @param[out] Entry               The entries of the database, sorted by
+                                  signature size, type and data. NULL if it has
+                                  none, otherwise the caller frees it.
+  @param[out] EntryCount          Number of entries in Entry.
+
+  @retval EFI_SUCCESS             The index was built.
+  @retval EFI_INVALID_PARAMETER   The database is malformed.
+  @retval EFI_OUT_OF_RESOURCES    No enough resource to build the index.
+
+**/
+EFI_STATUS
+BuildSignatureDbIndex (
+  IN  UINT8               *Data,
+  IN  UINTN               DataSize,
+  OUT SIGNATURE_DB_ENTRY  **Entry,
+  OUT UINTN               *EntryCount
+  );
+
+/**
+  Find a signature in the sorted index of a signature database.
+
+  @param[in]  Entry               The sorted entries of the database.
+  @param[in]  EntryCount          Number of entries in Entry.
+  @param[in]  Signature           Pointer to signature that is searched for.
+  @param[in]  CertType            Pointer to the signature type.
+  @param[in]  SignatureSize       Size of Signature.
+
+  @return The matching entry that comes first in the database, or NULL if the
+          signature isn't in the database.
+
+**/
+SIGNATURE_DB_ENTRY *
+FindSignatureDbEntry (
+  IN SIGNATURE_DB_ENTRY  *Entry,
+  IN UINTN               EntryCount,
+  IN UINT8               *Signature,
+  IN EFI_GUID            *CertType,
+  IN UINTN               SignatureSize
+  );
+
 #endif
@@ -0,0 +1,297 @@
+/** @file
+  Sorted index of the entries of a signature database (db or dbx), used to
+  look up image and certificate hashes with a binary search.
+
+  Caution: This file requires additional review when modified.
+  This library will have external input - the signature database variables.
+  This external input must be validated carefully to avoid security issue like
+  buffer overflow, integer overflow.
+
+  BuildSignatureDbIndex() validates every signature list of the database
+  before any of its entries is used.
+
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeImageVerificationLib.h"
+
+#include <Library/SafeIntLib.h>
+
+/**
+  Compare a signature with an entry of a signature database.
+
+  Signatures are ordered by size, then by type, then by contents.
+
+  @param[in]  Signature           Pointer to the signature data.
+  @param[in]  CertType            Pointer to the signature type.
+  @param[in]  SignatureSize       Size of Signature.
+  @param[in]  Entry               The database entry to compare with.
+
+  @retval 0                       The signature matches the entry.
+  @retval <0                      The signature sorts before the entry.
+  @retval >0                      The signature sorts after the entry.
+
+**/
+INTN
+CompareSignatureDbEntry (
+  IN UINT8               *Signature,
+  IN EFI_GUID            *CertType,
+  IN UINTN               SignatureSize,
+  IN SIGNATURE_DB_ENTRY  *Entry
+  )
+{
+  UINTN  EntrySize;
+  INTN   Result;
+
+  EntrySize = Entry->CertList->SignatureSize - (sizeof (EFI_SIGNATURE_DATA) - 1);
+  if (SignatureSize != EntrySize) {
+    return (SignatureSize < EntrySize) ? -1 : 1;
+  }
+
+  Result = CompareMem (CertType, &Entry->CertList->SignatureType, sizeof (EFI_GUID));
+  if (Result != 0) {
+    return Result;
+  }
+
+  return CompareMem (Signature, Entry->Cert->SignatureData, SignatureSize);
+}
+
+/**
+  Compare two entries of a signature database. Equal signatures keep the
+  order they have in the database.
+
+  @param[in]  Entry1              The first entry.
+  @param[in]  Entry2              The second entry.
+
+  @retval 0                       The entries are the same.
+  @retval <0                      Entry1 sorts before Entry2.
+  @retval >0                      Entry1 sorts after Entry2.
+
+**/
+INTN
+CompareSignatureDbEntries (
+  IN SIGNATURE_DB_ENTRY  *Entry1,
+  IN SIGNATURE_DB_ENTRY  *Entry2
+  )
+{
+  INTN  Result;
+
+  Result = CompareSignatureDbEntry (
+             Entry1->Cert->SignatureData,
+             &Entry1->CertList->SignatureType,
+             Entry1->CertList->SignatureSize - (sizeof (EFI_SIGNATURE_DATA) - 1),
+             Entry2
+             );
+  if (Result != 0) {
+    return Result;
+  }
+
+  if (Entry1->Cert == Entry2->Cert) {
+    return 0;
+  }
+  return ((UINTN) Entry1->Cert < (UINTN) Entry2->Cert) ? -1 : 1;
+}
+
+/**
+  Validate the signature list at the start of a signature database buffer
+  and return the number of entries it holds.
+
+  @param[in]  CertList            The signature list.
+  @param[in]  DataSize            Size of the database from CertList to its end.
+  @param[out] CertCount           Number of EFI_SIGNATURE_DATA entries in the list.
+
+  @retval EFI_SUCCESS             The list is well formed.
+  @retval EFI_INVALID_PARAMETER   The list is malformed or doesn't fit in DataSize.
+
+**/
+EFI_STATUS
+GetSignatureListCertCount (
+  IN  EFI_SIGNATURE_LIST  *CertList,
+  IN  UINTN               DataSize,
+  OUT UINTN               *CertCount
+  )
+{
+  RETURN_STATUS  Status;
+  UINTN          BodySize;
+
+  if ((DataSize < sizeof (EFI_SIGNATURE_LIST)) ||
+      (CertList->SignatureListSize > DataSize) ||
+      (CertList->SignatureSize < sizeof (EFI_SIGNATURE_DATA))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = SafeUintnSub (CertList->SignatureListSize, sizeof (EFI_SIGNATURE_LIST), &BodySize);
+  if (!RETURN_ERROR (Status)) {
+    Status = SafeUintnSub (BodySize, CertList->SignatureHeaderSize, &BodySize);
+  }
+  if (RETURN_ERROR (Status) || ((BodySize % CertList->SignatureSize) != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *CertCount = BodySize / CertList->SignatureSize;
+  return EFI_SUCCESS;
+}
+
+/**
+  Build the sorted index of all entries of a signature database.
+
+  Every signature list is validated first, a malformed database is not
+  indexed at all.
+
+  @param[in]  Data                The signature database, a sequence of
+                                  EFI_SIGNATURE_LIST.
+  @param[in]  DataSize            Size of Data.
+  @param[out] Entry               The entries of the database, sorted by
+                                  signature size, type and data. NULL if it has
+                                  none, otherwise the caller frees it.
+  @param[out] EntryCount          Number of entries in Entry.
+
+  @retval EFI_SUCCESS             The index was built.
+  @retval EFI_INVALID_PARAMETER   The database is malformed.
+  @retval EFI_OUT_OF_RESOURCES    No enough resource to build the index.
+
+**/
+EFI_STATUS
+BuildSignatureDbIndex (
+  IN  UINT8               *Data,
+  IN  UINTN               DataSize,
+  OUT SIGNATURE_DB_ENTRY  **Entry,
+  OUT UINTN               *EntryCount
+  )
+{
+  EFI_STATUS          Status;
+  EFI_SIGNATURE_LIST  *CertList;
+  EFI_SIGNATURE_DATA  *Cert;
+  SIGNATURE_DB_ENTRY  *Index;
+  SIGNATURE_DB_ENTRY  Temp;
+  UINTN               Remaining;
+  UINTN               CertCount;
+  UINTN               Count;
+  UINTN               AllocSize;
+  UINTN               Gap;
+  UINTN               Pos;
+  UINTN               Loop;
+
+  *Entry      = NULL;
+  *EntryCount = 0;
+
+  //
+  // Validate the lists and count their entries.
+  //
+  Count     = 0;
+  Remaining = DataSize;
+  CertList  = (EFI_SIGNATURE_LIST *) Data;
+  while (Remaining > 0) {
+    Status = GetSignatureListCertCount (CertList, Remaining, &CertCount);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    if (RETURN_ERROR (SafeUintnAdd (Count, CertCount, &Count))) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Remaining -= CertList->SignatureListSize;
+    CertList   = (EFI_SIGNATURE_LIST *) ((UINT8 *) CertList + CertList->SignatureListSize);
+  }
+
+  if (Count == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if (RETURN_ERROR (SafeUintnMult (Count, sizeof (SIGNATURE_DB_ENTRY), &AllocSize))) {
+    return EFI_INVALID_PARAMETER;
+  }
+  Index = AllocatePool (AllocSize);
+  if (Index == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Collect the entries. The lists have been validated above.
+  //
+  Count     = 0;
+  Remaining = DataSize;
+  CertList  = (EFI_SIGNATURE_LIST *) Data;
+  while (Remaining > 0) {
+    GetSignatureListCertCount (CertList, Remaining, &CertCount);
+    Cert = (EFI_SIGNATURE_DATA *) ((UINT8 *) CertList + sizeof (EFI_SIGNATURE_LIST) + CertList->SignatureHeaderSize);
+    for (Loop = 0; Loop < CertCount; Loop++) {
+      Index[Count].CertList = CertList;
+      Index[Count].Cert     = Cert;
+      Count++;
+      Cert = (EFI_SIGNATURE_DATA *) ((UINT8 *) Cert + CertList->SignatureSize);
+    }
+
+    Remaining -= CertList->SignatureListSize;
+    CertList   = (EFI_SIGNATURE_LIST *) ((UINT8 *) CertList + CertList->SignatureListSize);
+  }
+
+  //
+  // Shell sort the entries, so that FindSignatureDbEntry() can use a
+  // binary search.
+  //
+  for (Gap = Count / 2; Gap > 0; Gap /= 2) {
+    for (Loop = Gap; Loop < Count; Loop++) {
+      CopyMem (&Temp, &Index[Loop], sizeof (Temp));
+      for (Pos = Loop;
+           (Pos >= Gap) && (CompareSignatureDbEntries (&Index[Pos - Gap], &Temp) > 0);
+           Pos -= Gap) {
+        CopyMem (&Index[Pos], &Index[Pos - Gap], sizeof (Temp));
+      }
+      CopyMem (&Index[Pos], &Temp, sizeof (Temp));
+    }
+  }
+
+  *Entry      = Index;
+  *EntryCount = Count;
+  return EFI_SUCCESS;
+}
+
+/**
+  Find a signature in the sorted index of a signature database.
+
+  @param[in]  Entry               The sorted entries of the database.
+  @param[in]  EntryCount          Number of entries in Entry.
+  @param[in]  Signature           Pointer to signature that is searched for.
+  @param[in]  CertType            Pointer to the signature type.
+  @param[in]  SignatureSize       Size of Signature.
+
+  @return The matching entry that comes first in the database, or NULL if the
+          signature isn't in the database.
+
+**/
+SIGNATURE_DB_ENTRY *
+FindSignatureDbEntry (
+  IN SIGNATURE_DB_ENTRY  *Entry,
+  IN UINTN               EntryCount,
+  IN UINT8               *Signature,
+  IN EFI_GUID            *CertType,
+  IN UINTN               SignatureSize
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  //
+  // Find the lowest matching entry, equal entries are in database order.
+  //
+  Low  = 0;
+  High = EntryCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (CompareSignatureDbEntry (Signature, CertType, SignatureSize, &Entry[Middle]) > 0) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if ((Low == EntryCount) ||
+      (CompareSignatureDbEntry (Signature, CertType, SignatureSize, &Entry[Low]) != 0)) {
+    return NULL;
+  }
+
+  return &Entry[Low];
+}
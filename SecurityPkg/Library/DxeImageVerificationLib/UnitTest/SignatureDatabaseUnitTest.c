@@ -0,0 +1,518 @@
+/** @file
+  Host based unit tests of the sorted signature database index used by
+  DxeImageVerificationLib to look up db and dbx entries.
+
+  The index is checked against a linear scan of the database, the way
+  IsSignatureFoundInDatabase() used to search it, and malformed databases
+  are checked to be rejected without reading outside the buffer.
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../DxeImageVerificationLib.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "DxeImageVerificationLib Signature Database Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_DB_MAX_SIZE          SIZE_256KB
+#define TEST_X509_SIZE            600
+
+UINT8   *mTestDb;
+UINTN   mTestDbSize;
+UINT32  mTestRandom = 1;
+
+/**
+  Return a pseudo random number, the sequence is the same on every run.
+
+  @return The random number.
+
+**/
+UINT32
+TestRandom (
+  VOID
+  )
+{
+  mTestRandom = mTestRandom * 1103515245 + 12345;
+  return mTestRandom >> 8;
+}
+
+/**
+  Append a signature list with random signatures to the test database.
+
+  @param[in]  Type            The signature type.
+  @param[in]  HeaderSize      Size of the signature header.
+  @param[in]  DataSize        Size of each signature, without the owner GUID.
+  @param[in]  Count           Number of signatures.
+
+  @return The list appended.
+
+**/
+EFI_SIGNATURE_LIST *
+AppendSignatureList (
+  IN EFI_GUID  *Type,
+  IN UINT32    HeaderSize,
+  IN UINT32    DataSize,
+  IN UINTN     Count
+  )
+{
+  EFI_SIGNATURE_LIST  *CertList;
+  UINT8               *Byte;
+  UINTN               Index;
+
+  CertList                      = (EFI_SIGNATURE_LIST *) (mTestDb + mTestDbSize);
+  CertList->SignatureType       = *Type;
+  CertList->SignatureHeaderSize = HeaderSize;
+  CertList->SignatureSize       = (UINT32) (sizeof (EFI_SIGNATURE_DATA) - 1 + DataSize);
+  CertList->SignatureListSize   = (UINT32) (sizeof (EFI_SIGNATURE_LIST) + HeaderSize + Count * CertList->SignatureSize);
+  ASSERT (mTestDbSize + CertList->SignatureListSize <= TEST_DB_MAX_SIZE);
+
+  Byte = (UINT8 *) (CertList + 1);
+  for (Index = 0; Index < CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST); Index++) {
+    Byte[Index] = (UINT8) (TestRandom () >> 16);
+  }
+
+  mTestDbSize += CertList->SignatureListSize;
+  return CertList;
+}
+
+/**
+  Return a signature of a list.
+
+  @param[in]  CertList        The signature list.
+  @param[in]  Index           The index of the signature in the list.
+
+  @return The signature.
+
+**/
+EFI_SIGNATURE_DATA *
+GetSignature (
+  IN EFI_SIGNATURE_LIST  *CertList,
+  IN UINTN               Index
+  )
+{
+  return (EFI_SIGNATURE_DATA *) ((UINT8 *) CertList + sizeof (EFI_SIGNATURE_LIST) +
+                                 CertList->SignatureHeaderSize + Index * CertList->SignatureSize);
+}
+
+/**
+  Search the test database for a signature one entry at a time.
+
+  @param[in]  Signature       Pointer to signature that is searched for.
+  @param[in]  CertType        Pointer to the signature type.
+  @param[in]  SignatureSize   Size of Signature.
+
+  @return The first matching signature in the database, NULL if none matches.
+
+**/
+EFI_SIGNATURE_DATA *
+ReferenceFind (
+  IN UINT8     *Signature,
+  IN EFI_GUID  *CertType,
+  IN UINTN     SignatureSize
+  )
+{
+  EFI_SIGNATURE_LIST  *CertList;
+  UINTN               Remaining;
+  UINTN               Count;
+  UINTN               Index;
+
+  Remaining = mTestDbSize;
+  CertList  = (EFI_SIGNATURE_LIST *) mTestDb;
+  while (Remaining > 0) {
+    Count = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
+    if ((CertList->SignatureSize == sizeof (EFI_SIGNATURE_DATA) - 1 + SignatureSize) &&
+        CompareGuid (&CertList->SignatureType, CertType)) {
+      for (Index = 0; Index < Count; Index++) {
+        if (CompareMem (GetSignature (CertList, Index)->SignatureData, Signature, SignatureSize) == 0) {
+          return GetSignature (CertList, Index);
+        }
+      }
+    }
+
+    Remaining -= CertList->SignatureListSize;
+    CertList   = (EFI_SIGNATURE_LIST *) ((UINT8 *) CertList + CertList->SignatureListSize);
+  }
+
+  return NULL;
+}
+
+/**
+  Look a signature up in the index and check the result against the
+  linear scan of the test database.
+
+  @param[in]  Entry           The sorted entries of the test database.
+  @param[in]  EntryCount      Number of entries in Entry.
+  @param[in]  Signature       Pointer to signature that is searched for.
+  @param[in]  CertType        Pointer to the signature type.
+  @param[in]  SignatureSize   Size of Signature.
+
+  @return TRUE if both searches agree.
+
+**/
+BOOLEAN
+LookupMatchesReference (
+  IN SIGNATURE_DB_ENTRY  *Entry,
+  IN UINTN               EntryCount,
+  IN UINT8               *Signature,
+  IN EFI_GUID            *CertType,
+  IN UINTN               SignatureSize
+  )
+{
+  SIGNATURE_DB_ENTRY  *Found;
+  EFI_SIGNATURE_DATA  *Expected;
+
+  Found    = FindSignatureDbEntry (Entry, EntryCount, Signature, CertType, SignatureSize);
+  Expected = ReferenceFind (Signature, CertType, SignatureSize);
+
+  if (Found == NULL) {
+    return (BOOLEAN) (Expected == NULL);
+  }
+
+  return (BOOLEAN) (Found->Cert == Expected);
+}
+
+/**
+  Build a dbx of 2,000 entries in SHA-256, SHA-1, SHA-384 and X.509 lists,
+  with signatures repeated across lists, and check that every entry, and
+  signatures that are not in it, are found as a linear scan finds them.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LookupShouldMatchLinearScan (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_SIGNATURE_LIST  *Lists[8];
+  EFI_SIGNATURE_LIST  *CertList;
+  SIGNATURE_DB_ENTRY  *Entry;
+  UINTN               EntryCount;
+  UINTN               ListCount;
+  UINTN               List;
+  UINTN               Count;
+  UINTN               Index;
+  UINTN               DataSize;
+  UINT8               Signature[TEST_X509_SIZE];
+  EFI_STATUS          Status;
+
+  mTestDbSize = 0;
+  ListCount   = 0;
+  Lists[ListCount++] = AppendSignatureList (&gEfiCertSha256Guid, 0, SHA256_DIGEST_SIZE, 1000);
+  Lists[ListCount++] = AppendSignatureList (&gEfiCertSha1Guid, 0, SHA1_DIGEST_SIZE, 200);
+  Lists[ListCount++] = AppendSignatureList (&gEfiCertX509Guid, 0, TEST_X509_SIZE, 1);
+  Lists[ListCount++] = AppendSignatureList (&gEfiCertSha256Guid, 8, SHA256_DIGEST_SIZE, 697);
+  Lists[ListCount++] = AppendSignatureList (&gEfiCertX509Guid, 0, TEST_X509_SIZE, 1);
+  Lists[ListCount++] = AppendSignatureList (&gEfiCertSha384Guid, 0, SHA384_DIGEST_SIZE, 100);
+  Lists[ListCount++] = AppendSignatureList (&gEfiCertX509Guid, 0, TEST_X509_SIZE, 1);
+
+  //
+  // Repeat signatures of the first list in the second SHA-256 list, and a
+  // SHA-1 signature as the start of a SHA-256 one.
+  //
+  for (Index = 0; Index < 100; Index++) {
+    CopyMem (
+      GetSignature (Lists[3], TestRandom () % 697)->SignatureData,
+      GetSignature (Lists[0], TestRandom () % 1000)->SignatureData,
+      SHA256_DIGEST_SIZE
+      );
+  }
+  CopyMem (GetSignature (Lists[0], 7)->SignatureData, GetSignature (Lists[1], 3)->SignatureData, SHA1_DIGEST_SIZE);
+
+  Status = BuildSignatureDbIndex (mTestDb, mTestDbSize, &Entry, &EntryCount);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (EntryCount, 2000);
+
+  for (Index = 1; Index < EntryCount; Index++) {
+    UT_ASSERT_TRUE (CompareSignatureDbEntries (&Entry[Index - 1], &Entry[Index]) < 0);
+  }
+
+  //
+  // Every entry, looked up with its own type and the others.
+  //
+  for (List = 0; List < ListCount; List++) {
+    CertList = Lists[List];
+    Count    = (CertList->SignatureListSize - sizeof (EFI_SIGNATURE_LIST) - CertList->SignatureHeaderSize) / CertList->SignatureSize;
+    DataSize = CertList->SignatureSize - (sizeof (EFI_SIGNATURE_DATA) - 1);
+    for (Index = 0; Index < Count; Index++) {
+      CopyMem (Signature, GetSignature (CertList, Index)->SignatureData, DataSize);
+      UT_ASSERT_NOT_NULL (FindSignatureDbEntry (Entry, EntryCount, Signature, &CertList->SignatureType, DataSize));
+      UT_ASSERT_TRUE (LookupMatchesReference (Entry, EntryCount, Signature, &CertList->SignatureType, DataSize));
+      UT_ASSERT_TRUE (LookupMatchesReference (Entry, EntryCount, Signature, &gEfiCertSha256Guid, DataSize));
+      UT_ASSERT_TRUE (LookupMatchesReference (Entry, EntryCount, Signature, &gEfiCertSha1Guid, SHA1_DIGEST_SIZE));
+
+      //
+      // One byte changed is a miss, unless the change makes another entry.
+      //
+      Signature[TestRandom () % DataSize] ^= (UINT8) (1 + TestRandom () % 255);
+      UT_ASSERT_TRUE (LookupMatchesReference (Entry, EntryCount, Signature, &CertList->SignatureType, DataSize));
+    }
+  }
+
+  //
+  // Signatures that are not in the database.
+  //
+  for (Index = 0; Index < 10000; Index++) {
+    for (DataSize = 0; DataSize < SHA384_DIGEST_SIZE; DataSize++) {
+      Signature[DataSize] = (UINT8) (TestRandom () >> 16);
+    }
+    UT_ASSERT_EQUAL (FindSignatureDbEntry (Entry, EntryCount, Signature, &gEfiCertSha256Guid, SHA256_DIGEST_SIZE), NULL);
+    UT_ASSERT_EQUAL (FindSignatureDbEntry (Entry, EntryCount, Signature, &gEfiCertSha384Guid, SHA384_DIGEST_SIZE), NULL);
+  }
+
+  FreePool (Entry);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  An empty database, and lists without entries, should index to nothing.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+EmptyDatabaseShouldHaveNoEntries (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  SIGNATURE_DB_ENTRY  *Entry;
+  UINTN               EntryCount;
+  UINT8               Signature[SHA256_DIGEST_SIZE];
+
+  UT_ASSERT_NOT_EFI_ERROR (BuildSignatureDbIndex (NULL, 0, &Entry, &EntryCount));
+  UT_ASSERT_EQUAL (Entry, NULL);
+  UT_ASSERT_EQUAL (EntryCount, 0);
+
+  mTestDbSize = 0;
+  AppendSignatureList (&gEfiCertSha256Guid, 0, SHA256_DIGEST_SIZE, 0);
+  AppendSignatureList (&gEfiCertX509Guid, 16, TEST_X509_SIZE, 0);
+  UT_ASSERT_NOT_EFI_ERROR (BuildSignatureDbIndex (mTestDb, mTestDbSize, &Entry, &EntryCount));
+  UT_ASSERT_EQUAL (Entry, NULL);
+  UT_ASSERT_EQUAL (EntryCount, 0);
+
+  ZeroMem (Signature, sizeof (Signature));
+  UT_ASSERT_EQUAL (FindSignatureDbEntry (Entry, EntryCount, Signature, &gEfiCertSha256Guid, SHA256_DIGEST_SIZE), NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Malformed signature lists should make the whole database rejected.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+MalformedDatabaseShouldBeRejected (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_SIGNATURE_LIST  *CertList;
+  SIGNATURE_DB_ENTRY  *Entry;
+  UINTN               EntryCount;
+  UINTN               Case;
+  UINTN               DbSize;
+
+  for (Case = 0; Case < 9; Case++) {
+    mTestDbSize = 0;
+    AppendSignatureList (&gEfiCertSha256Guid, 0, SHA256_DIGEST_SIZE, 10);
+    CertList = AppendSignatureList (&gEfiCertSha1Guid, 4, SHA1_DIGEST_SIZE, 5);
+    DbSize   = mTestDbSize;
+
+    switch (Case) {
+    case 0:
+      //
+      // No progress through the database.
+      //
+      CertList->SignatureListSize = 0;
+      break;
+    case 1:
+      CertList->SignatureListSize = sizeof (EFI_SIGNATURE_LIST) - 1;
+      break;
+    case 2:
+      //
+      // The header is larger than the list.
+      //
+      CertList->SignatureHeaderSize = MAX_UINT32;
+      break;
+    case 3:
+      CertList->SignatureSize = 0;
+      break;
+    case 4:
+      CertList->SignatureSize = sizeof (EFI_SIGNATURE_DATA) - 1;
+      break;
+    case 5:
+      //
+      // The entries don't fill the list.
+      //
+      CertList->SignatureListSize -= 1;
+      DbSize                      -= 1;
+      break;
+    case 6:
+      //
+      // The list goes beyond the database.
+      //
+      DbSize -= 1;
+      break;
+    case 7:
+      //
+      // Part of a list header at the end.
+      //
+      DbSize += sizeof (EFI_SIGNATURE_LIST) - 1;
+      break;
+    case 8:
+      CertList->SignatureListSize = MAX_UINT32;
+      break;
+    }
+
+    Entry      = (SIGNATURE_DB_ENTRY *) mTestDb;
+    EntryCount = 1;
+    UT_ASSERT_STATUS_EQUAL (BuildSignatureDbIndex (mTestDb, DbSize, &Entry, &EntryCount), EFI_INVALID_PARAMETER);
+    UT_ASSERT_EQUAL (Entry, NULL);
+    UT_ASSERT_EQUAL (EntryCount, 0);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Random corruption of the list headers should either be rejected or give
+  entries inside the database.
+
+  @param[in]  Context  Unused.
+
+  @retval UNIT_TEST_PASSED  The test passed.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+CorruptedDatabaseShouldStayInBounds (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_SIGNATURE_LIST  *Lists[3];
+  SIGNATURE_DB_ENTRY  *Entry;
+  UINTN               EntryCount;
+  UINTN               Iteration;
+  UINTN               Index;
+  UINT8               *Field;
+  UINT8               *Buffer;
+
+  for (Iteration = 0; Iteration < 20000; Iteration++) {
+    mTestDbSize = 0;
+    Lists[0] = AppendSignatureList (&gEfiCertSha256Guid, 0, SHA256_DIGEST_SIZE, 3);
+    Lists[1] = AppendSignatureList (&gEfiCertSha1Guid, 2, SHA1_DIGEST_SIZE, 2);
+    Lists[2] = AppendSignatureList (&gEfiCertX509Guid, 0, 40, 1);
+
+    //
+    // Corrupt a byte of the sizes in a list header.
+    //
+    Field  = (UINT8 *) &Lists[TestRandom () % 3]->SignatureListSize;
+    Field += TestRandom () % (3 * sizeof (UINT32));
+    *Field = (UINT8) (TestRandom () >> 16);
+
+    //
+    // Build from an exact size copy, so that ASAN catches any read beyond it.
+    //
+    Buffer = AllocateCopyPool (mTestDbSize, mTestDb);
+    UT_ASSERT_NOT_NULL (Buffer);
+
+    if (!EFI_ERROR (BuildSignatureDbIndex (Buffer, mTestDbSize, &Entry, &EntryCount))) {
+      for (Index = 0; Index < EntryCount; Index++) {
+        UT_ASSERT_TRUE ((UINT8 *) Entry[Index].Cert >= Buffer);
+        UT_ASSERT_TRUE ((UINT8 *) Entry[Index].Cert + Entry[Index].CertList->SignatureSize <= Buffer + mTestDbSize);
+      }
+      if (Entry != NULL) {
+        FreePool (Entry);
+      }
+    }
+
+    FreePool (Buffer);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  signature database index and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      IndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  mTestDb = AllocatePool (TEST_DB_MAX_SIZE);
+  if (mTestDb == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&IndexTests, Framework, "Signature Database Index Tests", "DxeImageVerificationLib.SignatureDb", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for IndexTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IndexTests, "Lookups in a 2,000-entry dbx should match a linear scan", "Lookup", LookupShouldMatchLinearScan, NULL, NULL, NULL);
+  AddTestCase (IndexTests, "Empty databases should have no entries", "Empty", EmptyDatabaseShouldHaveNoEntries, NULL, NULL, NULL);
+  AddTestCase (IndexTests, "Malformed databases should be rejected", "Malformed", MalformedDatabaseShouldBeRejected, NULL, NULL, NULL);
+  AddTestCase (IndexTests, "Corrupted databases should be indexed in bounds", "Corrupted", CorruptedDatabaseShouldStayInBounds, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  if (mTestDb != NULL) {
+    FreePool (mTestDb);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int argc,
+  char *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
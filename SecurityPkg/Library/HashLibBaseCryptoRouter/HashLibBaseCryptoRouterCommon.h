@@ -9,6 +9,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef _HASH_LIB_BASE_CRYPTO_ROUTER_COMMON_H_
 #define _HASH_LIB_BASE_CRYPTO_ROUTER_COMMON_H_
 
+//
+// HashUpdate() feeds the data to all active hash algorithms one chunk at a
+// time, so that each chunk is read from memory once and then stays in the
+// data cache for the remaining algorithms.
+//
+#define HASH_UPDATE_CHUNK_SIZE  SIZE_16KB
+
 /**
   The function get hash mask info from algorithm.
 
@@ -105,6 +105,9 @@ HashUpdate (
   HASH_HANDLE  *HashCtx;
   UINTN        Index;
   UINT32       HashMask;
+  BOOLEAN      IsActive[HASH_COUNT];
+  UINT8        *Buffer;
+  UINTN        ChunkSize;
 
   if (mHashInterfaceCount == 0) {
     return EFI_UNSUPPORTED;
@@ -115,10 +118,20 @@ HashUpdate (
   HashCtx = (HASH_HANDLE *)HashHandle;
 
   for (Index = 0; Index < mHashInterfaceCount; Index++) {
-    HashMask = Tpm2GetHashMaskFromAlgo (&mHashInterface[Index].HashGuid);
-    if ((HashMask & PcdGet32 (PcdTpm2HashMask)) != 0) {
-      mHashInterface[Index].HashUpdate (HashCtx[Index], DataToHash, DataToHashLen);
+    HashMask        = Tpm2GetHashMaskFromAlgo (&mHashInterface[Index].HashGuid);
+    IsActive[Index] = (BOOLEAN) ((HashMask & PcdGet32 (PcdTpm2HashMask)) != 0);
+  }
+
+  Buffer = DataToHash;
+  while (DataToHashLen > 0) {
+    ChunkSize = MIN (DataToHashLen, HASH_UPDATE_CHUNK_SIZE);
+    for (Index = 0; Index < mHashInterfaceCount; Index++) {
+      if (IsActive[Index]) {
+        mHashInterface[Index].HashUpdate (HashCtx[Index], Buffer, ChunkSize);
+      }
     }
+    Buffer        += ChunkSize;
+    DataToHashLen -= ChunkSize;
   }
 
   return EFI_SUCCESS;
@@ -160,10 +173,11 @@ HashCompleteAndExtend (
   HashCtx = (HASH_HANDLE *)HashHandle;
   ZeroMem (DigestList, sizeof(*DigestList));
 
+  HashUpdate (HashHandle, DataToHash, DataToHashLen);
+
   for (Index = 0; Index < mHashInterfaceCount; Index++) {
     HashMask = Tpm2GetHashMaskFromAlgo (&mHashInterface[Index].HashGuid);
     if ((HashMask & PcdGet32 (PcdTpm2HashMask)) != 0) {
-      mHashInterface[Index].HashUpdate (HashCtx[Index], DataToHash, DataToHashLen);
       mHashInterface[Index].HashFinal (HashCtx[Index], &Digest);
       Tpm2SetHashToDigestList (DigestList, &Digest);
     }
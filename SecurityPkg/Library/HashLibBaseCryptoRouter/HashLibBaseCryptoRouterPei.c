@@ -184,6 +184,9 @@ HashUpdate (
   HASH_HANDLE        *HashCtx;
   UINTN              Index;
   UINT32             HashMask;
+  BOOLEAN            IsActive[HASH_COUNT];
+  UINT8              *Buffer;
+  UINTN              ChunkSize;
 
   HashInterfaceHob = InternalGetHashInterfaceHob (&gEfiCallerIdGuid);
   if (HashInterfaceHob == NULL) {
@@ -199,10 +202,20 @@ HashUpdate (
   HashCtx = (HASH_HANDLE *)HashHandle;
 
   for (Index = 0; Index < HashInterfaceHob->HashInterfaceCount; Index++) {
-    HashMask = Tpm2GetHashMaskFromAlgo (&HashInterfaceHob->HashInterface[Index].HashGuid);
-    if ((HashMask & PcdGet32 (PcdTpm2HashMask)) != 0) {
-      HashInterfaceHob->HashInterface[Index].HashUpdate (HashCtx[Index], DataToHash, DataToHashLen);
+    HashMask        = Tpm2GetHashMaskFromAlgo (&HashInterfaceHob->HashInterface[Index].HashGuid);
+    IsActive[Index] = (BOOLEAN) ((HashMask & PcdGet32 (PcdTpm2HashMask)) != 0);
+  }
+
+  Buffer = DataToHash;
+  while (DataToHashLen > 0) {
+    ChunkSize = MIN (DataToHashLen, HASH_UPDATE_CHUNK_SIZE);
+    for (Index = 0; Index < HashInterfaceHob->HashInterfaceCount; Index++) {
+      if (IsActive[Index]) {
+        HashInterfaceHob->HashInterface[Index].HashUpdate (HashCtx[Index], Buffer, ChunkSize);
+      }
     }
+    Buffer        += ChunkSize;
+    DataToHashLen -= ChunkSize;
   }
 
   return EFI_SUCCESS;
@@ -250,10 +263,11 @@ HashCompleteAndExtend (
   HashCtx = (HASH_HANDLE *)HashHandle;
   ZeroMem (DigestList, sizeof(*DigestList));
 
+  HashUpdate (HashHandle, DataToHash, DataToHashLen);
+
   for (Index = 0; Index < HashInterfaceHob->HashInterfaceCount; Index++) {
     HashMask = Tpm2GetHashMaskFromAlgo (&HashInterfaceHob->HashInterface[Index].HashGuid);
     if ((HashMask & PcdGet32 (PcdTpm2HashMask)) != 0) {
-      HashInterfaceHob->HashInterface[Index].HashUpdate (HashCtx[Index], DataToHash, DataToHashLen);
       HashInterfaceHob->HashInterface[Index].HashFinal (HashCtx[Index], &Digest);
       Tpm2SetHashToDigestList (DigestList, &Digest);
     }
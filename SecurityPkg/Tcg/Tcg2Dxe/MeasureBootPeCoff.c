@@ -22,6 +22,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/PeCoffLib.h>
 #include <Library/Tpm2CommandLib.h>
 #include <Library/HashLib.h>
+#include <Library/PerformanceLib.h>
 
 UINTN  mTcg2DxeImageSize = 0;
 
@@ -121,6 +122,8 @@ MeasurePeImageAndExtend (
   Status        = EFI_UNSUPPORTED;
   SectionHeader = NULL;
 
+  PERF_START (NULL, "MeasurePeImage", "Tcg2Dxe", 0);
+
   //
   // Check PE/COFF image
   //
@@ -402,5 +405,7 @@ Finish:
     FreePool (SectionHeader);
   }
 
+  PERF_END (NULL, "MeasurePeImage", "Tcg2Dxe", 0);
+
   return Status;
 }